@@ -0,0 +1,231 @@
+#include "Benchmark.h"
+#include "gs/Math/Angle.h"
+#include "gs/Math/Geometry.h"
+#include "gs/Math/GeometryBatch.h"
+#include "gs/Math/Random.h"
+#include <vector>
+
+namespace
+{
+	const size_t kNumInputs = 1024;
+	const size_t kInputMask = kNumInputs - 1;
+
+	struct GeometryInputs
+	{
+		Frustum frustum;
+		std::vector<AABB> boxes;
+		std::vector<Sphere> spheres;
+		std::vector<OBB> obbs;
+		std::vector<Ray> rays;
+		std::vector<Matrix43> matrices;
+		std::vector<AABBx8> boxes8;
+		std::vector<Spherex8> spheres8;
+		std::vector<AABBx4> boxes4;
+
+		GeometryInputs()
+		{
+			// Fixed seed so that every build benchmarks the same inputs, with roughly half of the
+			// volumes inside the frustum so that branches are unpredictable
+			Random random(5678);
+
+			Matrix43 mCamera;
+			mCamera.SetFromAxisAngle(Vector3::UnitY(), Angle::FromDeg(30.f), Vector3(0.f, 10.f, -100.f));
+			frustum.SetPerspective(Angle::FromDeg(60.f), 16.f / 9.f, 1.f, 1000.f, mCamera);
+
+			for (size_t i = 0; i < kNumInputs; ++i)
+			{
+				const Vector3 center = random.Vector(Vector3(-600.f, -300.f, -200.f), Vector3(600.f, 300.f, 1000.f));
+				const Vector3 halfExtents = random.Vector(Vector3(1.f, 1.f, 1.f), Vector3(50.f, 50.f, 50.f));
+				boxes.push_back(AABB::FromCenterHalfExtents(center, halfExtents));
+				spheres.push_back(Sphere(center, halfExtents.x));
+
+				Matrix43 m;
+				m.SetFromAxisAngle(random.UnitVector(), random.Float(-kPi, kPi), random.Vector(Vector3(-100.f, -100.f, -100.f), Vector3(100.f, 100.f, 100.f)));
+				matrices.push_back(m);
+				obbs.push_back(OBB::FromAABB(AABB::FromCenterHalfExtents(Vector3::Zero(), halfExtents)) * m);
+
+				rays.push_back(Ray(random.Vector(Vector3(-100.f, -100.f, -100.f), Vector3(100.f, 100.f, 100.f)), random.UnitVector()));
+			}
+
+			boxes8.resize(kNumInputs / 8);
+			spheres8.resize(kNumInputs / 8);
+			for (size_t i = 0; i < kNumInputs; ++i)
+			{
+				boxes8[i / 8].Set(i % 8, boxes[i]);
+				spheres8[i / 8].Set(i % 8, spheres[i]);
+			}
+
+			boxes4.resize(kNumInputs / 4);
+			for (size_t i = 0; i < kNumInputs; ++i)
+				boxes4[i / 4].Set(i % 4, boxes[i]);
+		}
+	};
+}
+
+extern void Bench_Geometry(BenchmarkRunner& runner)
+{
+	static GeometryInputs in;
+
+	// Frustum culling
+
+	runner.Run("Frustum::Intersects(AABB)", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			count += in.frustum.Intersects(in.boxes[i & kInputMask]) ? 1 : 0;
+		Bench::Consume(count);
+	});
+
+	runner.Run("FrustumIntersectsAABBx8", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			for (const auto& boxes8 : in.boxes8)
+				count += FrustumIntersectsAABBx8(in.frustum, boxes8);
+		}
+		Bench::Consume(count);
+	}, kNumInputs);
+
+	runner.Run("Frustum::Test(AABB)", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			count += in.frustum.Test(in.boxes[i & kInputMask]);
+		Bench::Consume(count);
+	});
+
+	runner.Run("Frustum::Intersects(Sphere)", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			count += in.frustum.Intersects(in.spheres[i & kInputMask]) ? 1 : 0;
+		Bench::Consume(count);
+	});
+
+	// Sphere tests
+
+	runner.Run("Intersects(Sphere, Sphere)", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			count += Intersects(in.spheres[i & kInputMask], in.spheres[(i * 7 + 1) & kInputMask]) ? 1 : 0;
+		Bench::Consume(count);
+	});
+
+	runner.Run("SphereIntersectsSpherex8", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Sphere& sphere = in.spheres[i & kInputMask];
+			for (const auto& spheres8 : in.spheres8)
+				count += SphereIntersectsSpherex8(sphere, spheres8);
+		}
+		Bench::Consume(count);
+	}, kNumInputs);
+
+	// Box tests
+
+	runner.Run("Intersects(AABB, AABB)", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			count += Intersects(in.boxes[i & kInputMask], in.boxes[(i * 7 + 1) & kInputMask]) ? 1 : 0;
+		Bench::Consume(count);
+	});
+
+	runner.Run("Intersects(OBB, OBB)", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			count += Intersects(in.obbs[i & kInputMask], in.obbs[(i * 7 + 1) & kInputMask]) ? 1 : 0;
+		Bench::Consume(count);
+	});
+
+	// Ray tests
+
+	runner.Run("Intersects(Ray, AABB)", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		float32 tHit;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			if (Intersects(in.rays[i & kInputMask], in.boxes[(i * 7 + 1) & kInputMask], tHit))
+				sum += tHit;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("RayIntersectsAABBx4", [] (uint64 iterations)
+	{
+		uint64 count = 0;
+		float32 tHits[4];
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Ray& ray = in.rays[i & kInputMask];
+			for (const auto& boxes4 : in.boxes4)
+				count += RayIntersectsAABBx4(ray, boxes4, tHits);
+		}
+		Bench::Consume(count);
+	}, kNumInputs);
+
+	runner.Run("Intersects(Ray, Sphere)", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		float32 tHit;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			if (Intersects(in.rays[i & kInputMask], in.spheres[(i * 7 + 1) & kInputMask], tHit))
+				sum += tHit;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Intersects(Ray, OBB)", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		float32 tHit;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			if (Intersects(in.rays[i & kInputMask], in.obbs[(i * 7 + 1) & kInputMask], tHit))
+				sum += tHit;
+		}
+		Bench::Consume(sum);
+	});
+
+	// Transforms
+
+	runner.Run("AABB * Matrix43", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const AABB aabb = in.boxes[i & kInputMask] * in.matrices[(i + 1) & kInputMask];
+			sum += aabb.min.x + aabb.max.y;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("OBB * Matrix43", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const OBB obb = in.obbs[i & kInputMask] * in.matrices[(i + 1) & kInputMask];
+			sum += obb.center.x + obb.axisX.y;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Frustum * Matrix43", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Frustum frustum = in.frustum * in.matrices[i & kInputMask];
+			sum += frustum.planes[Frustum::Near].d;
+		}
+		Bench::Consume(sum);
+	});
+}
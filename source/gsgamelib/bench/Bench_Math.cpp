@@ -0,0 +1,454 @@
+#include "Benchmark.h"
+#include "gs/Math/Matrix43.h"
+#include "gs/Math/Quaternion.h"
+#include "gs/Math/QuaternionBatch.h"
+#include "gs/Math/QTS.h"
+#include "gs/Math/Vector3.h"
+#include "gs/Math/EulerAngles.h"
+#include "gs/Math/Random.h"
+#include <vector>
+
+namespace
+{
+	// Inputs are cycled through so that results depend on data the compiler can't see. Small
+	// enough to stay in L1/L2 so that we measure computation rather than memory bandwidth.
+	const size_t kNumInputs = 1024;
+	const size_t kInputMask = kNumInputs - 1;
+	static_assert(MathEx::IsPowerOfTwoCT<kNumInputs>::Value, "kNumInputs must be a power of two");
+
+	Vector3 RandVector3(Random& random, float32 min, float32 max)
+	{
+		return random.Vector(Vector3(min, min, min), Vector3(max, max, max));
+	}
+
+	Quaternion RandQuaternion(Random& random)
+	{
+		Quaternion q;
+		q.SetFromAxisAngle(random.UnitVector(), random.Float(-kPi, kPi));
+		return q;
+	}
+
+	struct MathInputs
+	{
+		std::vector<Vector3> vectors;
+		std::vector<Quaternion> quats1;
+		std::vector<Quaternion> quats2;
+		std::vector<EulerAngles> eulers;
+		std::vector<float32> scalars;		// [-10, 10]
+		std::vector<float32> unitScalars;	// [0, 1]
+		std::vector<Matrix43> rMatrices;	// Rotation only
+		std::vector<Matrix43> rtMatrices;	// Rotation and translation
+		std::vector<Matrix43> usrtMatrices;	// Uniform scale, rotation and translation
+		std::vector<Matrix43> srtMatrices;	// Non-uniform scale, rotation and translation
+		std::vector<Matrix43> affineMatrices; // Includes shear
+
+		MathInputs()
+		{
+			// Fixed seed so that every build benchmarks the same inputs
+			Random random(1234);
+
+			for (size_t i = 0; i < kNumInputs; ++i)
+			{
+				vectors.push_back(RandVector3(random, -100.f, 100.f));
+				quats1.push_back(RandQuaternion(random));
+				quats2.push_back(RandQuaternion(random));
+				const float32 yaw = random.Float(-kPi, kPi);
+				const float32 pitch = random.Float(-kPiOver2, kPiOver2);
+				const float32 roll = random.Float(-kPi, kPi);
+				eulers.push_back(EulerAngles(yaw, pitch, roll));
+				scalars.push_back(random.Float(-10.f, 10.f));
+				unitScalars.push_back(random.Float01());
+
+				Matrix43 mR, mScale;
+				mR.SetFromQuaternion(quats1.back());
+				rMatrices.push_back(mR);
+
+				const Vector3 trans = RandVector3(random, -100.f, 100.f);
+				mR.Translation() = trans;
+				rtMatrices.push_back(mR);
+
+				const float32 uniformScale = random.Float(0.5f, 2.f);
+				mScale.SetFromScaleVector(Vector3(uniformScale, uniformScale, uniformScale));
+				usrtMatrices.push_back(mScale * mR);
+
+				mScale.SetFromScaleVector(RandVector3(random, 0.5f, 5.f));
+				srtMatrices.push_back(mScale * mR);
+
+				Matrix43 mShear(mScale * mR);
+				mShear.AxisY() += mShear.AxisX() * 0.25f;
+				affineMatrices.push_back(mShear);
+			}
+		}
+	};
+
+	template <typename InvertFunc>
+	BenchmarkFunc MakeInvertBenchmark(const std::vector<Matrix43>& matrices, InvertFunc invert)
+	{
+		return [&matrices, invert] (uint64 iterations)
+		{
+			float32 sum = 0.f;
+			for (uint64 i = 0; i < iterations; ++i)
+			{
+				Matrix43 m = matrices[i & kInputMask];
+				invert(m);
+				sum += m.m11 + m.m42;
+			}
+			Bench::Consume(sum);
+		};
+	}
+}
+
+extern void Bench_Math(BenchmarkRunner& runner)
+{
+	static MathInputs in;
+
+	// Matrix43
+
+	runner.Run("Matrix43::Mul (operator*)", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Matrix43 m = in.srtMatrices[i & kInputMask] * in.rtMatrices[(i + 1) & kInputMask];
+			sum += m.m11 + m.m42;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Matrix43::Invert", MakeInvertBenchmark(in.affineMatrices, [] (Matrix43& m) { m.Invert(); }));
+	runner.Run("Matrix43::InvertSRT", MakeInvertBenchmark(in.srtMatrices, [] (Matrix43& m) { m.InvertSRT(); }));
+	runner.Run("Matrix43::InvertUniformSRT", MakeInvertBenchmark(in.usrtMatrices, [] (Matrix43& m) { m.InvertUniformSRT(); }));
+	runner.Run("Matrix43::InvertRT", MakeInvertBenchmark(in.rtMatrices, [] (Matrix43& m) { m.InvertRT(); }));
+	runner.Run("Matrix43::InvertR", MakeInvertBenchmark(in.rMatrices, [] (Matrix43& m) { m.InvertR(); }));
+
+	runner.Run("Matrix43::SetFromQuaternion", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		Matrix43 m;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			m.SetFromQuaternion(in.quats1[i & kInputMask]);
+			sum += m.m11 + m.m23;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Matrix43::SetFromEulerAngles", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		Matrix43 m;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			m.SetFromEulerAngles(in.eulers[i & kInputMask]);
+			sum += m.m11 + m.m23;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("PositionVector * Matrix43", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Vector3 v = PositionVector(in.vectors[i & kInputMask]) * in.usrtMatrices[(i + 1) & kInputMask];
+			sum += v.x + v.y;
+		}
+		Bench::Consume(sum);
+	});
+
+	// EulerAngles
+
+	runner.Run("EulerAngles::SetFromMatrix", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		EulerAngles e;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			e.SetFromMatrix(in.rtMatrices[i & kInputMask]);
+			sum += e.yaw + e.pitch;
+		}
+		Bench::Consume(sum);
+	});
+
+	// Quaternion
+
+	runner.Run("Quaternion::SetFromMatrix", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		Quaternion q;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			q.SetFromMatrix(in.rtMatrices[i & kInputMask]);
+			sum += q.x + q.w;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Quaternion::SetFromEulerAngles", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		Quaternion q;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			q.SetFromEulerAngles(in.eulers[i & kInputMask]);
+			sum += q.x + q.w;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Quaternion::Invert", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Quaternion q = Invert(in.quats1[i & kInputMask]);
+			sum += q.x + q.w;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Quaternion * Quaternion", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Quaternion q = in.quats1[i & kInputMask] * in.quats2[i & kInputMask];
+			sum += q.x + q.w;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Slerp", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const size_t index = i & kInputMask;
+			const Quaternion q = Slerp(in.quats1[index], in.quats2[index], in.unitScalars[index]);
+			sum += q.x + q.w;
+		}
+		Bench::Consume(sum);
+	});
+
+	// Batched quaternion functions: one iteration processes all inputs, results are per quaternion
+
+	static std::vector<Quaternion> quatsOut(kNumInputs);
+	static std::vector<Matrix43> matricesOut(kNumInputs);
+
+	runner.Run("SlerpArray", [] (uint64 iterations)
+	{
+		for (uint64 i = 0; i < iterations; ++i)
+			SlerpArray(in.quats1.data(), in.quats2.data(), in.unitScalars.data(), quatsOut.data(), kNumInputs);
+		Bench::Consume(quatsOut[0].x);
+	}, kNumInputs);
+
+	runner.Run("FastSlerpArray", [] (uint64 iterations)
+	{
+		for (uint64 i = 0; i < iterations; ++i)
+			FastSlerpArray(in.quats1.data(), in.quats2.data(), in.unitScalars.data(), quatsOut.data(), kNumInputs);
+		Bench::Consume(quatsOut[0].x);
+	}, kNumInputs);
+
+	runner.Run("NlerpArray", [] (uint64 iterations)
+	{
+		for (uint64 i = 0; i < iterations; ++i)
+			NlerpArray(in.quats1.data(), in.quats2.data(), in.unitScalars.data(), quatsOut.data(), kNumInputs);
+		Bench::Consume(quatsOut[0].x);
+	}, kNumInputs);
+
+	runner.Run("QuaternionsToMatrices", [] (uint64 iterations)
+	{
+		for (uint64 i = 0; i < iterations; ++i)
+			QuaternionsToMatrices(in.quats1.data(), in.vectors.data(), matricesOut.data(), kNumInputs);
+		Bench::Consume(matricesOut[0].m11);
+	}, kNumInputs);
+
+	runner.Run("MatricesToQuaternions", [] (uint64 iterations)
+	{
+		for (uint64 i = 0; i < iterations; ++i)
+			MatricesToQuaternions(in.rtMatrices.data(), quatsOut.data(), kNumInputs);
+		Bench::Consume(quatsOut[0].x);
+	}, kNumInputs);
+
+	// QTS
+
+	runner.Run("QTS * QTS", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const size_t index = i & kInputMask;
+			const QTS qts = QTS(in.quats1[index], in.vectors[index]) * QTS(in.quats2[index], in.vectors[(i + 1) & kInputMask]);
+			sum += qts.rot.x + qts.trans.x;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("QTS::Invert", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const size_t index = i & kInputMask;
+			const QTS qts = Invert(QTS(in.quats1[index], in.vectors[index], 2.f));
+			sum += qts.rot.x + qts.trans.x;
+		}
+		Bench::Consume(sum);
+	});
+
+	// Vector3
+
+	runner.Run("Vector3::Normalize", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			Vector3 v = in.vectors[i & kInputMask];
+			v.Normalize();
+			sum += v.x;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Vector3::SafeNormalize", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			Vector3 v = in.vectors[i & kInputMask];
+			v.SafeNormalize(Vector3::UnitY());
+			sum += v.x;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Vector3::Cross", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			const Vector3 v = in.vectors[i & kInputMask].Cross(in.vectors[(i + 1) & kInputMask]);
+			sum += v.x;
+		}
+		Bench::Consume(sum);
+	});
+
+	// MathEx
+
+	runner.Run("MathEx::Sqrt", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += MathEx::Sqrt(MathEx::Abs(in.scalars[i & kInputMask]));
+		Bench::Consume(sum);
+	});
+
+	runner.Run("MathEx::SinCos", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		float32 s, c;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			MathEx::SinCos(in.scalars[i & kInputMask], s, c);
+			sum += s + c;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("MathEx::ATan2", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += MathEx::ATan2(in.scalars[i & kInputMask], in.scalars[(i + 1) & kInputMask]);
+		Bench::Consume(sum);
+	});
+
+	runner.Run("MathEx::SafeACos", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += MathEx::SafeACos(in.scalars[i & kInputMask] * 0.11f);
+		Bench::Consume(sum);
+	});
+
+	runner.Run("MathEx::WrapPI", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += MathEx::WrapPI(in.scalars[i & kInputMask]);
+		Bench::Consume(sum);
+	});
+
+	runner.Run("MathEx::Clamp", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += MathEx::Clamp(in.scalars[i & kInputMask], -5.f, 5.f);
+		Bench::Consume(sum);
+	});
+
+	runner.Run("MathEx::Rand", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += MathEx::Rand(0.f, 1.f);
+		Bench::Consume(sum);
+	});
+
+	// Random
+
+	runner.Run("Random::NextUInt32", [] (uint64 iterations)
+	{
+		Random random;
+		uint64 sum = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += random.NextUInt32();
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Random::Int", [] (uint64 iterations)
+	{
+		Random random;
+		uint64 sum = 0;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += random.Int(-500, 500);
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Random::Float", [] (uint64 iterations)
+	{
+		Random random;
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += random.Float(-500.f, 500.f);
+		Bench::Consume(sum);
+	});
+
+	runner.Run("Random::UnitVector", [] (uint64 iterations)
+	{
+		Random random;
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += random.UnitVector().x;
+		Bench::Consume(sum);
+	});
+
+	static std::vector<uint32> uintsOut(kNumInputs);
+	static std::vector<float32> floatsOut(kNumInputs);
+
+	runner.Run("RandomFillUInt32", [] (uint64 iterations)
+	{
+		Random random;
+		for (uint64 i = 0; i < iterations; ++i)
+			RandomFillUInt32(random, uintsOut.data(), kNumInputs);
+		Bench::Consume(static_cast<uint64>(uintsOut[0]));
+	}, kNumInputs);
+
+	runner.Run("RandomFillFloat", [] (uint64 iterations)
+	{
+		Random random;
+		for (uint64 i = 0; i < iterations; ++i)
+			RandomFillFloat(random, floatsOut.data(), kNumInputs, -500.f, 500.f);
+		Bench::Consume(floatsOut[0]);
+	}, kNumInputs);
+}
@@ -0,0 +1,143 @@
+#include "Benchmark.h"
+#include "gs/Rendering/VertexFormat.h"
+#include "gs/Math/Random.h"
+#include <vector>
+#include <cstring>
+
+namespace
+{
+	const size_t kNumVertices = 4096;
+
+	// Same size and layout as the full precision vertex used by the game (56 bytes)
+	struct FloatVertex
+	{
+		float32 position[4];
+		float32 normal[4];
+		float32 color[4];
+		float32 texCoord[2];
+	};
+
+	template <typename Streams, typename Vertex>
+	Streams GetStreams(Vertex* pVertices)
+	{
+		Streams streams;
+		streams.position = pVertices->position;
+		streams.normal = pVertices->normal;
+		streams.color = pVertices->color;
+		streams.texCoord = pVertices->texCoord;
+		streams.stride = sizeof(FloatVertex);
+		return streams;
+	}
+
+	struct VertexInputs
+	{
+		AABB bounds;
+		std::vector<FloatVertex> vertices;
+		std::vector<FloatVertex> unpacked;
+		VertexLayout layoutQuantized;
+		VertexLayout layoutFloatPosition;
+		std::vector<uint8> packedQuantized;
+		std::vector<uint8> packedFloatPosition;
+
+		VertexInputs()
+			: bounds(Vector3(-1000.f, 0.f, -1000.f), Vector3(1000.f, 200.f, 1000.f))
+			, vertices(kNumVertices)
+			, unpacked(kNumVertices)
+		{
+			Random random(4321);
+			for (auto& vertex : vertices)
+			{
+				const Vector3 position = random.Vector(bounds.min, bounds.max);
+				const Vector3 normal = random.UnitVector();
+				for (int c = 0; c < 3; ++c)
+				{
+					vertex.position[c] = position.v[c];
+					vertex.normal[c] = normal.v[c];
+				}
+				vertex.position[3] = 1.f;
+				vertex.normal[3] = 0.f;
+				for (int c = 0; c < 4; ++c)
+					vertex.color[c] = random.Float01();
+				vertex.texCoord[0] = random.Float(0.f, 4.f);
+				vertex.texCoord[1] = random.Float(0.f, 4.f);
+			}
+
+			layoutQuantized = VertexLayout::Create(VertexLayoutFlags::All, bounds);
+			layoutFloatPosition = VertexLayout::Create(VertexLayoutFlags::All & ~VertexLayoutFlags::QuantizePosition);
+
+			packedQuantized.resize(kNumVertices * layoutQuantized.stride);
+			packedFloatPosition.resize(kNumVertices * layoutFloatPosition.stride);
+			PackVertices(layoutQuantized, GetStreams<ConstVertexStreams>(vertices.data()), kNumVertices, packedQuantized.data());
+			PackVertices(layoutFloatPosition, GetStreams<ConstVertexStreams>(vertices.data()), kNumVertices, packedFloatPosition.data());
+		}
+	};
+}
+
+extern void Bench_VertexFormat(BenchmarkRunner& runner)
+{
+	static VertexInputs in;
+
+	// Baseline: copying full precision vertices
+	runner.Run("Vertex copy (56 bytes)", [] (uint64 iterations)
+	{
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			memcpy(in.unpacked.data(), in.vertices.data(), kNumVertices * sizeof(FloatVertex));
+			Bench::Consume(in.unpacked[i % kNumVertices].position[0]);
+		}
+	}, kNumVertices);
+
+	runner.Run("UnpackVertices (18 bytes, quantized)", [] (uint64 iterations)
+	{
+		const VertexStreams dst = GetStreams<VertexStreams>(in.unpacked.data());
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			UnpackVertices(in.layoutQuantized, in.packedQuantized.data(), kNumVertices, dst);
+			Bench::Consume(in.unpacked[i % kNumVertices].position[0]);
+		}
+	}, kNumVertices);
+
+	runner.Run("UnpackVertices (24 bytes, float position)", [] (uint64 iterations)
+	{
+		const VertexStreams dst = GetStreams<VertexStreams>(in.unpacked.data());
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			UnpackVertices(in.layoutFloatPosition, in.packedFloatPosition.data(), kNumVertices, dst);
+			Bench::Consume(in.unpacked[i % kNumVertices].position[0]);
+		}
+	}, kNumVertices);
+
+	runner.Run("PackVertices (18 bytes, quantized)", [] (uint64 iterations)
+	{
+		const ConstVertexStreams src = GetStreams<ConstVertexStreams>(in.vertices.data());
+		std::vector<uint8> packed(in.packedQuantized.size());
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			PackVertices(in.layoutQuantized, src, kNumVertices, packed.data());
+			Bench::Consume(static_cast<uint64>(packed[i % packed.size()]));
+		}
+	}, kNumVertices);
+
+	// Individual decoders
+
+	runner.Run("VertexPacking::OctDecode", [] (uint64 iterations)
+	{
+		const uint8* pPacked = in.packedQuantized.data() + in.layoutQuantized.offsets[VertexAttribute::Normal];
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+		{
+			int16 encoded[2];
+			memcpy(encoded, pPacked + (i % kNumVertices) * in.layoutQuantized.stride, sizeof(encoded));
+			sum += VertexPacking::OctDecode(encoded).x;
+		}
+		Bench::Consume(sum);
+	});
+
+	runner.Run("VertexPacking::HalfToFloat", [] (uint64 iterations)
+	{
+		float32 sum = 0.f;
+		for (uint64 i = 0; i < iterations; ++i)
+			sum += VertexPacking::HalfToFloat(static_cast<uint16>(i & 0x7BFF));
+		Bench::Consume(sum);
+	});
+}
@@ -0,0 +1,146 @@
+#include "Benchmark.h"
+#include "gs/Math/SIMD.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <ctime>
+
+namespace Bench
+{
+	static volatile float32 g_floatSink;
+	static volatile uint64 g_intSink;
+
+	void Consume(float32 value) { g_floatSink = value; }
+	void Consume(uint64 value) { g_intSink = value; }
+}
+
+namespace
+{
+	float64 TimeIterations(const BenchmarkFunc& func, uint64 iterations)
+	{
+		typedef std::chrono::steady_clock Clock;
+		const Clock::time_point start = Clock::now();
+		func(iterations);
+		const Clock::time_point end = Clock::now();
+		return std::chrono::duration<float64>(end - start).count();
+	}
+
+	const char* GetCompilerName()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		static std::string name = "msvc " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+		static std::string name = "clang " __clang_version__;
+#elif defined(__GNUC__)
+		static std::string name = "gcc " __VERSION__;
+#else
+		static std::string name = "unknown";
+#endif
+		return name.c_str();
+	}
+
+	std::string EscapeJson(const std::string& str)
+	{
+		std::string result;
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result;
+	}
+}
+
+BenchmarkRunner::BenchmarkRunner()
+	: m_minSampleTime(0.05)
+	, m_numSamples(7)
+{
+}
+
+void BenchmarkRunner::Run(const std::string& name, const BenchmarkFunc& func, uint64 itemsPerIteration)
+{
+	if (!m_filter.empty() && name.find(m_filter) == std::string::npos)
+		return;
+
+	assert(itemsPerIteration > 0);
+
+	// Warm up caches, then double the iteration count until a sample takes long enough that
+	// timer resolution is negligible.
+	uint64 iterations = 1;
+	func(iterations);
+	for (;;)
+	{
+		const float64 elapsed = TimeIterations(func, iterations);
+		if (elapsed >= m_minSampleTime)
+			break;
+
+		// Jump close to the target once we have a meaningful measurement
+		uint64 next = iterations * 2;
+		if (elapsed > 1e-4)
+			next = std::max(next, static_cast<uint64>(iterations * (m_minSampleTime * 1.2 / elapsed)));
+		iterations = next;
+	}
+
+	std::vector<float64> samples(m_numSamples);
+	for (auto& sample : samples)
+		sample = TimeIterations(func, iterations) * 1e9 / static_cast<float64>(iterations * itemsPerIteration);
+	std::sort(samples.begin(), samples.end());
+
+	BenchmarkResult result;
+	result.name = name;
+	result.itemsPerIteration = itemsPerIteration;
+	result.iterations = iterations;
+	result.nsPerOp = samples[samples.size() / 2];
+	result.nsPerOpMin = samples.front();
+	result.opsPerSec = result.nsPerOp > 0.0 ? 1e9 / result.nsPerOp : 0.0;
+	m_results.push_back(result);
+
+	printf("%-48s %12.3f %12.3f %14.2f\n", name.c_str(), result.nsPerOp, result.nsPerOpMin, result.opsPerSec / 1e6);
+	fflush(stdout);
+}
+
+void BenchmarkRunner::PrintHeader(FILE* pFile) const
+{
+	fprintf(pFile, "compiler: %s, simd: %s\n\n", GetCompilerName(), GS_SIMD_SSE ? "sse2" : "none");
+	fprintf(pFile, "%-48s %12s %12s %14s\n", "benchmark", "ns/op", "min ns/op", "Mops/s");
+	fprintf(pFile, "%s\n", std::string(48 + 13 * 2 + 15, '-').c_str());
+}
+
+bool BenchmarkRunner::WriteJson(const char* filePath) const
+{
+	FILE* pFile = fopen(filePath, "w");
+	if (!pFile)
+		return false;
+
+	char date[32];
+	const time_t now = time(nullptr);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	fprintf(pFile, "{\n");
+	fprintf(pFile, "\t\"context\": {\n");
+	fprintf(pFile, "\t\t\"date\": \"%s\",\n", date);
+	fprintf(pFile, "\t\t\"compiler\": \"%s\",\n", EscapeJson(GetCompilerName()).c_str());
+#ifdef NDEBUG // Set by CMake's release configurations with every compiler; _DEBUG is MSVC only
+	fprintf(pFile, "\t\t\"build_type\": \"release\",\n");
+#else
+	fprintf(pFile, "\t\t\"build_type\": \"debug\",\n");
+#endif
+	fprintf(pFile, "\t\t\"simd\": \"%s\",\n", GS_SIMD_SSE ? "sse2" : "none");
+	fprintf(pFile, "\t\t\"min_sample_time_s\": %g,\n", m_minSampleTime);
+	fprintf(pFile, "\t\t\"num_samples\": %u\n", m_numSamples);
+	fprintf(pFile, "\t},\n");
+	fprintf(pFile, "\t\"benchmarks\": [\n");
+	for (size_t i = 0; i < m_results.size(); ++i)
+	{
+		const BenchmarkResult& r = m_results[i];
+		fprintf(pFile, "\t\t{ \"name\": \"%s\", \"items_per_iteration\": %llu, \"iterations\": %llu, \"ns_per_op\": %.4f, \"ns_per_op_min\": %.4f, \"ops_per_sec\": %.1f }%s\n",
+			EscapeJson(r.name).c_str(), r.itemsPerIteration, r.iterations, r.nsPerOp, r.nsPerOpMin, r.opsPerSec,
+			i + 1 < m_results.size() ? "," : "");
+	}
+	fprintf(pFile, "\t]\n");
+	fprintf(pFile, "}\n");
+
+	fclose(pFile);
+	return true;
+}
@@ -0,0 +1,62 @@
+#ifndef _GS_BENCHMARK_H_
+#define _GS_BENCHMARK_H_
+
+// Minimal micro-benchmark harness used by gsgamelib_bench. Each benchmark is a function that
+// performs its operation 'iterations' times; the runner calibrates the iteration count so that
+// each sample runs for at least the minimum sample time, takes several samples, and reports the
+// median. Results can be written as JSON to track regressions between builds.
+
+#include "gs/Base/Base.h"
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+	// Consumes a value so that the compiler can't optimize away the work that produced it.
+	// Benchmarks should accumulate results into a local and consume it once at the end.
+	void Consume(float32 value);
+	void Consume(uint64 value);
+}
+
+typedef std::function<void (uint64 iterations)> BenchmarkFunc;
+
+struct BenchmarkResult
+{
+	std::string name;
+	uint64 itemsPerIteration;	// Number of ops performed by one iteration (i.e. array size for batched functions)
+	uint64 iterations;			// Iterations per sample
+	float64 nsPerOp;			// Median over samples
+	float64 nsPerOpMin;			// Fastest sample
+	float64 opsPerSec;			// Throughput computed from median
+};
+
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner();
+
+	// Only benchmarks whose name contains this string are run (empty runs all)
+	void SetFilter(const std::string& filter)		{ m_filter = filter; }
+	void SetMinSampleTime(float64 seconds)			{ m_minSampleTime = seconds; }
+	void SetNumSamples(uint32 numSamples)			{ m_numSamples = numSamples; }
+
+	// Runs benchmark and prints its result. Set itemsPerIteration when func processes a batch
+	// of items per iteration so that ns/op and throughput are reported per item, which makes
+	// batched and scalar versions of the same operation directly comparable.
+	void Run(const std::string& name, const BenchmarkFunc& func, uint64 itemsPerIteration = 1);
+
+	const std::vector<BenchmarkResult>& GetResults() const { return m_results; }
+
+	void PrintHeader(FILE* pFile) const;
+	bool WriteJson(const char* filePath) const;
+
+private:
+	std::string m_filter;
+	float64 m_minSampleTime;
+	uint32 m_numSamples;
+	std::vector<BenchmarkResult> m_results;
+};
+
+#endif // _GS_BENCHMARK_H_
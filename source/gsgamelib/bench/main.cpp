@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+#include "gs/Math/MathEx.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// gsgamelib_bench: micro-benchmarks for gsgamelib.
+// Usage: gsgamelib_bench [--filter <substring>] [--json <file>] [--min-time <seconds>] [--samples <count>]
+// Build in release for meaningful numbers. Compare JSON output from different builds to track regressions.
+
+static void PrintUsage()
+{
+	printf("Usage: gsgamelib_bench [options]\n");
+	printf("  --filter <substring>  Only run benchmarks whose name contains substring\n");
+	printf("  --json <file>         Write results as JSON to file\n");
+	printf("  --min-time <seconds>  Minimum duration of each sample (default 0.05)\n");
+	printf("  --samples <count>     Number of samples per benchmark, median is reported (default 7)\n");
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkRunner runner;
+	const char* jsonFilePath = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--filter") == 0 && hasValue)
+		{
+			runner.SetFilter(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--json") == 0 && hasValue)
+		{
+			jsonFilePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--min-time") == 0 && hasValue)
+		{
+			runner.SetMinSampleTime(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--samples") == 0 && hasValue)
+		{
+			runner.SetNumSamples(static_cast<uint32>(MathEx::Max(1, atoi(argv[++i]))));
+		}
+		else
+		{
+			PrintUsage();
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	runner.PrintHeader(stdout);
+
+	extern void Bench_Math(BenchmarkRunner& runner);
+	Bench_Math(runner);
+
+	extern void Bench_Geometry(BenchmarkRunner& runner);
+	Bench_Geometry(runner);
+
+	extern void Bench_VertexFormat(BenchmarkRunner& runner);
+	Bench_VertexFormat(runner);
+
+	if (jsonFilePath)
+	{
+		if (!runner.WriteJson(jsonFilePath))
+		{
+			fprintf(stderr, "Failed to write %s\n", jsonFilePath);
+			return 1;
+		}
+		printf("\nResults written to %s\n", jsonFilePath);
+	}
+
+	return 0;
+}
@@ -51,15 +51,12 @@ To safe_static_cast(const From& v)
 	return safe_static_cast<To>( const_cast<From&>(v) );
 }
 
-// More efficient but non-portable way to return whether pw.lock() == ps
+// More efficient way to return whether pw.lock() == ps (for non-null ps), as it doesn't
+// lock pw: pointers that share ownership of the same object share its control block.
 template <typename T>
 inline bool is_weak_to_shared_ptr(const std::weak_ptr<T>& pw, const std::shared_ptr<T>& ps)
 {
-#ifdef _MSC_VER
-	return pw._Get() != nullptr && pw._Get() == ps._Get();
-#else
-	#error "Implement for this platform"
-#endif
+	return !pw.expired() && !pw.owner_before(ps) && !ps.owner_before(pw);
 }
 
 // Returns number of elements of C-style array
@@ -75,7 +72,11 @@ inline bool is_weak_to_shared_ptr(const std::weak_ptr<T>& pw, const std::shared_
 #define TWEAKABLE const
 #endif
 
+#ifdef _MSC_VER
 #define FORCE_INLINE __forceinline
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
 
 // Disable warnings
 #ifdef _MSC_VER
@@ -24,7 +24,6 @@ protected:
 
 private:
 	// Declare a destroyer for the singleton instance
-	template <class T>
 	class InstanceDestroyer
 	{
 	public:
@@ -41,14 +40,14 @@ private:
 
 	// This destroyer instance will be destructed on program exit, deleting 
 	// the singleton instance with it (if any)
-	static InstanceDestroyer<T> m_destroyer;
+	static InstanceDestroyer m_destroyer;
 };
 
 template <class T>
 T* Singleton<T>::m_pInstance = nullptr;
 
 template <class T>
-typename Singleton<T>::InstanceDestroyer<T> Singleton<T>::m_destroyer;
+typename Singleton<T>::InstanceDestroyer Singleton<T>::m_destroyer;
 
 template <class T>
 inline bool Singleton<T>::IsInstantiated()
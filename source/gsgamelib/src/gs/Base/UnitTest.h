@@ -0,0 +1,19 @@
+#ifndef _UNIT_TEST_H_
+#define _UNIT_TEST_H_
+
+#include <cstdio>
+#include <cstdlib>
+
+// Like assert, but also checked in release builds, so that unit tests run in every configuration
+#define CHECK(condition) ((condition)? (void)0 : UnitTest::CheckFailed(#condition, __FILE__, __LINE__))
+
+namespace UnitTest
+{
+	inline void CheckFailed(const char* condition, const char* file, int line)
+	{
+		fprintf(stderr, "%s(%d): Check failed: %s\n", file, line, condition);
+		abort();
+	}
+}
+
+#endif // _UNIT_TEST_H_
@@ -3,6 +3,7 @@
 #include "gs/Base/string_helpers.h"
 #include "ImageFuncs.h" // Internal
 #include <stdio.h>
+#include <string.h>
 #include <stdexcept>
 #include <cassert>
 
@@ -1,11 +1,15 @@
 #include "ImageFuncs.h"
 #include "ImageData.h"
+#include "gs/System/Profiler.h"
 #include <math.h>
+#include <string.h>
 #include <stdexcept>
 #include <cassert>
 
 std::shared_ptr<UBYTE> ImageFuncs::LoadTGA(const std::string& strFileName, ImageInfo& rImageInfo)
 {
+	PROFILE_SCOPE("ImageFuncs::LoadTGA");
+
 	// These defines are used to tell us about the type of TARGA file it is
 //	const UBYTE TGA_RGB	= 2;	// This tells us it's a normal RGB (really BGR) file
 //	const UBYTE TGA_A	= 3;	// This tells us it's a ALPHA file
@@ -254,6 +258,51 @@ std::shared_ptr<UBYTE> ImageFuncs::LoadTGA(const std::string& strFileName, Image
 	return pResultData;
 }
 
+void ImageFuncs::SaveTGA(const std::string& strFileName, const UBYTE* pData, const ImageInfo& rImageInfo)
+{
+	const int iChannels = rImageInfo.GetChannels();
+	assert((iChannels == 3 || iChannels == 4) && "Only RGB and RGBA images can be saved");
+
+	FILE* pFile = fopen(strFileName.c_str(), "wb");
+	if (pFile == nullptr)
+	{
+		throw std::invalid_argument("Failed to open file " + strFileName);
+	}
+
+	// Uncompressed true color image with a bottom-left origin
+	UBYTE header[18] = {};
+	header[2] = 2;
+	header[12] = static_cast<UBYTE>(rImageInfo.GetWidth() & 0xFF);
+	header[13] = static_cast<UBYTE>(rImageInfo.GetWidth() >> 8);
+	header[14] = static_cast<UBYTE>(rImageInfo.GetHeight() & 0xFF);
+	header[15] = static_cast<UBYTE>(rImageInfo.GetHeight() >> 8);
+	header[16] = static_cast<UBYTE>(iChannels * 8);
+	header[17] = iChannels == 4? 8 : 0; // Alpha bits
+	fwrite(header, sizeof(header), 1, pFile);
+
+	// Swap R and B, since TGA files are stored as BGR
+	const int iPitch = rImageInfo.GetPitch();
+	std::unique_ptr<UBYTE[]> pLine(new UBYTE[iPitch]);
+	for (int y = 0; y < rImageInfo.GetHeight(); ++y)
+	{
+		memcpy(pLine.get(), pData + y * iPitch, iPitch);
+		for (int i = 0; i < iPitch; i += iChannels)
+		{
+			UBYTE temp		= pLine[i];
+			pLine[i]		= pLine[i + 2];
+			pLine[i + 2]	= temp;
+		}
+		fwrite(pLine.get(), iPitch, 1, pFile);
+	}
+
+	const bool bFailed = ferror(pFile) != 0;
+	fclose(pFile);
+	if (bFailed)
+	{
+		throw std::runtime_error("Failed to write file " + strFileName);
+	}
+}
+
 std::shared_ptr<UBYTE> ImageFuncs::LoadRAW(const std::string& strFileName, int iWidth, int iHeight, int iChannels, ImageInfo& rImageInfo)
 {
 	FILE *pFile = nullptr;
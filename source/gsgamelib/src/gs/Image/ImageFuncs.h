@@ -15,6 +15,10 @@ namespace ImageFuncs
 	// Loads TGA file, returning allocated data and filling up rImageInfo
 	std::shared_ptr<UBYTE> LoadTGA(const std::string& strFileName, ImageInfo& rImageInfo);
 
+	// Saves uncompressed 24 or 32-bit TGA file from RGB or RGBA data whose rows are ordered the
+	// way LoadTGA returns them (bottom to top)
+	void SaveTGA(const std::string& strFileName, const UBYTE* pData, const ImageInfo& rImageInfo);
+
 	// Loads up RAW file, returning allocate data and filling up rImageInfo
 	std::shared_ptr<UBYTE> LoadRAW(
 		const std::string& strFileName,
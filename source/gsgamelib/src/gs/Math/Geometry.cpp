@@ -0,0 +1,325 @@
+#include "Geometry.h"
+#include <utility>
+
+namespace
+{
+	// Transforms plane given the matrix and its inverse. Normals transform by the inverse
+	// transpose, which for row vectors means dotting with the rows of the inverse.
+	Plane TransformPlane(const Plane& plane, const Matrix43& m, const Matrix43& mInv)
+	{
+		const Vector3 pointOnPlane = PositionVector(plane.normal * (-plane.d / plane.normal.LengthSquared())) * m;
+		const Vector3 normal(plane.normal.Dot(mInv.AxisX()), plane.normal.Dot(mInv.AxisY()), plane.normal.Dot(mInv.AxisZ()));
+		return Plane::FromPointNormal(pointOnPlane, Normalize(normal));
+	}
+
+	// Slab test against box [boxMin, boxMax] in the ray's space
+	bool IntersectsSlabs(const Vector3& origin, const Vector3& dir, const Vector3& boxMin, const Vector3& boxMax, float32& tHit, float32 tMax)
+	{
+		float32 tNear = 0.f;
+		float32 tFar = tMax;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			if (MathEx::Abs(dir.v[i]) < kEpsilon)
+			{
+				// Parallel to slab: no hit if origin is outside it
+				if (origin.v[i] < boxMin.v[i] || origin.v[i] > boxMax.v[i])
+					return false;
+			}
+			else
+			{
+				const float32 invDir = 1.f / dir.v[i];
+				float32 t1 = (boxMin.v[i] - origin.v[i]) * invDir;
+				float32 t2 = (boxMax.v[i] - origin.v[i]) * invDir;
+				if (t1 > t2)
+					std::swap(t1, t2);
+
+				tNear = MathEx::Max(tNear, t1);
+				tFar = MathEx::Min(tFar, t2);
+				if (tNear > tFar)
+					return false;
+			}
+		}
+
+		tHit = tNear;
+		return true;
+	}
+}
+
+void Plane::Normalize()
+{
+	const float32 length = normal.Length();
+	assert(length > 0.f);
+	const float32 invLength = 1.f / length;
+	normal *= invLength;
+	d *= invLength;
+}
+
+bool OBB::Contains(const Vector3& v) const
+{
+	const Vector3 local = v - center;
+	return MathEx::Abs(local.Dot(axisX)) <= halfExtents.x
+		&& MathEx::Abs(local.Dot(axisY)) <= halfExtents.y
+		&& MathEx::Abs(local.Dot(axisZ)) <= halfExtents.z;
+}
+
+AABB OBB::GetAABB() const
+{
+	const Vector3 extents(
+		MathEx::Abs(axisX.x) * halfExtents.x + MathEx::Abs(axisY.x) * halfExtents.y + MathEx::Abs(axisZ.x) * halfExtents.z,
+		MathEx::Abs(axisX.y) * halfExtents.x + MathEx::Abs(axisY.y) * halfExtents.y + MathEx::Abs(axisZ.y) * halfExtents.z,
+		MathEx::Abs(axisX.z) * halfExtents.x + MathEx::Abs(axisY.z) * halfExtents.y + MathEx::Abs(axisZ.z) * halfExtents.z);
+	return AABB::FromCenterHalfExtents(center, extents);
+}
+
+void Frustum::SetFromViewVolume(float32 left, float32 right, float32 bottom, float32 top, float32 nearDist, float32 farDist, bool isPerspective, const Matrix43& cameraToWorld)
+{
+	assert(left < right && bottom < top && nearDist < farDist);
+
+	if (isPerspective)
+	{
+		assert(nearDist > 0.f);
+
+		// Side planes go through the eye and the edges of the near plane, i.e. a point is
+		// inside the left plane if x/z >= left/near
+		planes[Left] = Plane(Vector3(nearDist, 0.f, -left), 0.f);
+		planes[Right] = Plane(Vector3(-nearDist, 0.f, right), 0.f);
+		planes[Bottom] = Plane(Vector3(0.f, nearDist, -bottom), 0.f);
+		planes[Top] = Plane(Vector3(0.f, -nearDist, top), 0.f);
+	}
+	else
+	{
+		planes[Left] = Plane(Vector3::UnitX(), -left);
+		planes[Right] = Plane(-Vector3::UnitX(), right);
+		planes[Bottom] = Plane(Vector3::UnitY(), -bottom);
+		planes[Top] = Plane(-Vector3::UnitY(), top);
+	}
+	planes[Near] = Plane(Vector3::UnitZ(), -nearDist);
+	planes[Far] = Plane(-Vector3::UnitZ(), farDist);
+
+	for (auto& plane : planes)
+		plane.Normalize();
+
+	*this = *this * cameraToWorld;
+}
+
+void Frustum::SetPerspective(float32 vertFovRadians, float32 aspectRatio, float32 nearDist, float32 farDist, const Matrix43& cameraToWorld)
+{
+	const float32 top = MathEx::Tan(vertFovRadians * 0.5f) * nearDist;
+	const float32 right = top * aspectRatio;
+	SetFromViewVolume(-right, right, -top, top, nearDist, farDist, true, cameraToWorld);
+}
+
+bool Frustum::Contains(const Vector3& v) const
+{
+	for (const auto& plane : planes)
+	{
+		if (plane.SignedDistance(v) < 0.f)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const AABB& aabb) const
+{
+	return Test(aabb) != Containment::Outside;
+}
+
+bool Frustum::Intersects(const Sphere& sphere) const
+{
+	for (const auto& plane : planes)
+	{
+		if (plane.SignedDistance(sphere.center) < -sphere.radius)
+			return false;
+	}
+	return true;
+}
+
+Containment::Type Frustum::Test(const AABB& aabb) const
+{
+	const Vector3 center = aabb.GetCenter();
+	const Vector3 halfExtents = aabb.GetHalfExtents();
+
+	Containment::Type result = Containment::Inside;
+	for (const auto& plane : planes)
+	{
+		// Project box extents onto plane normal
+		const float32 radius = MathEx::Abs(plane.normal.x) * halfExtents.x + MathEx::Abs(plane.normal.y) * halfExtents.y + MathEx::Abs(plane.normal.z) * halfExtents.z;
+		const float32 distance = plane.SignedDistance(center);
+		if (distance < -radius)
+			return Containment::Outside;
+		if (distance < radius)
+			result = Containment::Intersecting;
+	}
+	return result;
+}
+
+bool Intersects(const OBB& a, const OBB& b)
+{
+	// Separating axis test (Ericson, Real-Time Collision Detection, 4.4.1)
+	const float32 kParallelEpsilon = 1e-6f;
+
+	float32 R[3][3], absR[3][3];
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			R[i][j] = a.GetAxis(i).Dot(b.GetAxis(j));
+			absR[i][j] = MathEx::Abs(R[i][j]) + kParallelEpsilon;
+		}
+	}
+
+	const Vector3 tWorld = b.center - a.center;
+	const float32 t[3] = { tWorld.Dot(a.axisX), tWorld.Dot(a.axisY), tWorld.Dot(a.axisZ) };
+	const float32* ea = a.halfExtents.v;
+	const float32* eb = b.halfExtents.v;
+	float32 ra, rb;
+
+	// Axes of a
+	for (int i = 0; i < 3; ++i)
+	{
+		ra = ea[i];
+		rb = eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2];
+		if (MathEx::Abs(t[i]) > ra + rb)
+			return false;
+	}
+
+	// Axes of b
+	for (int i = 0; i < 3; ++i)
+	{
+		ra = ea[0] * absR[0][i] + ea[1] * absR[1][i] + ea[2] * absR[2][i];
+		rb = eb[i];
+		if (MathEx::Abs(t[0] * R[0][i] + t[1] * R[1][i] + t[2] * R[2][i]) > ra + rb)
+			return false;
+	}
+
+	// Cross products of axes: a[i] x b[j]
+	for (int i = 0; i < 3; ++i)
+	{
+		const int i1 = (i + 1) % 3;
+		const int i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; ++j)
+		{
+			const int j1 = (j + 1) % 3;
+			const int j2 = (j + 2) % 3;
+			ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+			rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+			if (MathEx::Abs(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool Intersects(const Ray& ray, const AABB& aabb, float32& tHit, float32 tMax)
+{
+	return IntersectsSlabs(ray.origin, ray.dir, aabb.min, aabb.max, tHit, tMax);
+}
+
+bool Intersects(const Ray& ray, const Sphere& sphere, float32& tHit, float32 tMax)
+{
+	const Vector3 m = ray.origin - sphere.center;
+	const float32 a = ray.dir.LengthSquared();
+	const float32 b = m.Dot(ray.dir);
+	const float32 c = m.LengthSquared() - sphere.radius * sphere.radius;
+
+	// Origin outside sphere and pointing away from it
+	if (c > 0.f && b > 0.f)
+		return false;
+
+	const float32 discriminant = b*b - a*c;
+	if (discriminant < 0.f || a == 0.f)
+		return false;
+
+	const float32 t = MathEx::Max(0.f, (-b - MathEx::Sqrt(discriminant)) / a);
+	if (t > tMax)
+		return false;
+
+	tHit = t;
+	return true;
+}
+
+bool Intersects(const Ray& ray, const Plane& plane, float32& tHit, float32 tMax)
+{
+	const float32 denom = plane.normal.Dot(ray.dir);
+	if (MathEx::Abs(denom) < kEpsilon)
+		return false;
+
+	const float32 t = -plane.SignedDistance(ray.origin) / denom;
+	if (t < 0.f || t > tMax)
+		return false;
+
+	tHit = t;
+	return true;
+}
+
+bool Intersects(const Ray& ray, const OBB& obb, float32& tHit, float32 tMax)
+{
+	// Express ray in the box's local space, where the box is an AABB
+	const Vector3 originLocal = ray.origin - obb.center;
+	const Vector3 origin(originLocal.Dot(obb.axisX), originLocal.Dot(obb.axisY), originLocal.Dot(obb.axisZ));
+	const Vector3 dir(ray.dir.Dot(obb.axisX), ray.dir.Dot(obb.axisY), ray.dir.Dot(obb.axisZ));
+	return IntersectsSlabs(origin, dir, -obb.halfExtents, obb.halfExtents, tHit, tMax);
+}
+
+AABB operator*(const AABB& aabb, const Matrix43& m)
+{
+	if (aabb.IsEmpty())
+		return aabb;
+
+	// Arvo's method: transform center, and project extents onto each world axis
+	const Vector3 center = PositionVector(aabb.GetCenter()) * m;
+	const Vector3 h = aabb.GetHalfExtents();
+	const Vector3 halfExtents(
+		MathEx::Abs(m.m11) * h.x + MathEx::Abs(m.m21) * h.y + MathEx::Abs(m.m31) * h.z,
+		MathEx::Abs(m.m12) * h.x + MathEx::Abs(m.m22) * h.y + MathEx::Abs(m.m32) * h.z,
+		MathEx::Abs(m.m13) * h.x + MathEx::Abs(m.m23) * h.y + MathEx::Abs(m.m33) * h.z);
+	return AABB::FromCenterHalfExtents(center, halfExtents);
+}
+
+Sphere operator*(const Sphere& sphere, const Matrix43& m)
+{
+	const float32 maxScaleSquared = MathEx::Max(m.AxisX().LengthSquared(), MathEx::Max(m.AxisY().LengthSquared(), m.AxisZ().LengthSquared()));
+	return Sphere(PositionVector(sphere.center) * m, sphere.radius * MathEx::Sqrt(maxScaleSquared));
+}
+
+OBB operator*(const OBB& obb, const Matrix43& m)
+{
+	OBB result;
+	result.center = PositionVector(obb.center) * m;
+
+	// Axes may be scaled by the matrix: fold the scale into the extents
+	for (int i = 0; i < 3; ++i)
+	{
+		Vector3 axis = DirectionVector(obb.GetAxis(i)) * m;
+		const float32 length = axis.Length();
+		assert(length > 0.f);
+		(&result.axisX)[i] = axis / length;
+		result.halfExtents.v[i] = obb.halfExtents.v[i] * length;
+	}
+	return result;
+}
+
+Plane operator*(const Plane& plane, const Matrix43& m)
+{
+	Matrix43 mInv;
+	mInv.SetInverseFrom(m);
+	return TransformPlane(plane, m, mInv);
+}
+
+Ray operator*(const Ray& ray, const Matrix43& m)
+{
+	return Ray(PositionVector(ray.origin) * m, DirectionVector(ray.dir) * m);
+}
+
+Frustum operator*(const Frustum& frustum, const Matrix43& m)
+{
+	Matrix43 mInv;
+	mInv.SetInverseFrom(m);
+
+	Frustum result;
+	for (int i = 0; i < Frustum::NumPlanes; ++i)
+		result.planes[i] = TransformPlane(frustum.planes[i], m, mInv);
+	return result;
+}
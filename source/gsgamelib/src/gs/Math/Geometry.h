@@ -0,0 +1,233 @@
+#ifndef _GS_GEOMETRY_H_
+#define _GS_GEOMETRY_H_
+
+// Geometric primitives used for culling, collision and picking, along with intersection tests
+// and transformation by Matrix43. Like the rest of the math lib, primitives are transformed by
+// post-multiplying with a matrix (i.e. AABB worldBox = localBox * mLocalToWorld).
+// See GeometryBatch.h for SIMD versions of the most common intersection tests.
+
+#include "gs/Base/Base.h"
+#include "MathEx.h"
+#include "Vector3.h"
+#include "Matrix43.h"
+
+// Use as tMax for unbounded ray tests
+const float32 kInfiniteDistance = std::numeric_limits<float32>::max();
+
+// Result of testing whether a volume is contained by another
+namespace Containment
+{
+	enum Type { Outside, Intersecting, Inside };
+}
+
+// Axis-aligned bounding box
+class AABB
+{
+public:
+	Vector3 min;
+	Vector3 max;
+
+	AABB() {}
+	AABB(const Vector3& min, const Vector3& max) : min(min), max(max) {}
+
+	static AABB FromCenterHalfExtents(const Vector3& center, const Vector3& halfExtents) { return AABB(center - halfExtents, center + halfExtents); }
+
+	// Empty box is inverted so that including any point makes it valid
+	static const AABB& Empty() { static AABB aabb(Vector3(kInfiniteDistance, kInfiniteDistance, kInfiniteDistance), Vector3(-kInfiniteDistance, -kInfiniteDistance, -kInfiniteDistance)); return aabb; }
+
+	void SetEmpty() { *this = Empty(); }
+	bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+	void Include(const Vector3& v);
+	void Include(const AABB& aabb);
+
+	Vector3 GetCenter() const { return (min + max) * 0.5f; }
+	Vector3 GetHalfExtents() const { return (max - min) * 0.5f; }
+	Vector3 GetSize() const { return max - min; }
+
+	bool Contains(const Vector3& v) const;
+	bool Contains(const AABB& aabb) const;
+	Vector3 ClosestPoint(const Vector3& v) const;
+};
+
+// Bounding sphere
+class Sphere
+{
+public:
+	Vector3 center;
+	float32 radius;
+
+	Sphere() {}
+	Sphere(const Vector3& center, float32 radius) : center(center), radius(radius) {}
+
+	// Returns sphere that encloses the box (not necessarily the smallest enclosing sphere of the contents)
+	static Sphere FromAABB(const AABB& aabb) { return Sphere(aabb.GetCenter(), aabb.GetHalfExtents().Length()); }
+
+	bool Contains(const Vector3& v) const { return (v - center).LengthSquared() <= radius * radius; }
+};
+
+// Oriented bounding box. Axes must be orthonormal.
+class OBB
+{
+public:
+	Vector3 center;
+	Vector3 axisX, axisY, axisZ;
+	Vector3 halfExtents;
+
+	OBB() {}
+	OBB(const Vector3& center, const Vector3& axisX, const Vector3& axisY, const Vector3& axisZ, const Vector3& halfExtents)
+		: center(center), axisX(axisX), axisY(axisY), axisZ(axisZ), halfExtents(halfExtents) {}
+
+	static OBB FromAABB(const AABB& aabb) { return OBB(aabb.GetCenter(), Vector3::UnitX(), Vector3::UnitY(), Vector3::UnitZ(), aabb.GetHalfExtents()); }
+
+	const Vector3& GetAxis(int i) const { return (&axisX)[i]; }
+
+	bool Contains(const Vector3& v) const;
+
+	// Returns the smallest AABB that contains this box
+	AABB GetAABB() const;
+};
+
+// Plane defined by normal.Dot(p) + d = 0. The normal points to the positive (front) side.
+class Plane
+{
+public:
+	Vector3 normal;
+	float32 d;
+
+	Plane() {}
+	Plane(const Vector3& normal, float32 d) : normal(normal), d(d) {}
+
+	static Plane FromPointNormal(const Vector3& point, const Vector3& normal) { return Plane(normal, -normal.Dot(point)); }
+
+	// Normal points towards the side from which the points appear in clockwise order (left-handed)
+	static Plane FromPoints(const Vector3& p1, const Vector3& p2, const Vector3& p3) { return FromPointNormal(p1, ::Normalize((p2 - p1).Cross(p3 - p1))); }
+
+	// Scales the plane equation so that the normal is unit length
+	void Normalize();
+
+	// Positive in front of the plane, negative behind. Only a distance if normal is unit length.
+	float32 SignedDistance(const Vector3& v) const { return normal.Dot(v) + d; }
+};
+
+// Ray starting at origin and extending in direction dir. Intersection results are returned as
+// a parameter t along the ray (point = origin + dir * t), so dir need not be unit length.
+class Ray
+{
+public:
+	Vector3 origin;
+	Vector3 dir;
+
+	Ray() {}
+	Ray(const Vector3& origin, const Vector3& dir) : origin(origin), dir(dir) {}
+
+	static Ray FromPoints(const Vector3& from, const Vector3& to) { return Ray(from, to - from); }
+
+	Vector3 GetPoint(float32 t) const { return origin + dir * t; }
+};
+
+// Convex view volume made of 6 planes with normals pointing inwards
+class Frustum
+{
+public:
+	enum PlaneIndex { Left, Right, Bottom, Top, Near, Far, NumPlanes };
+
+	Plane planes[NumPlanes];
+
+	// Sets from a view volume in camera space (camera looks down Z+, Y+ up, X+ right) where
+	// left/right/bottom/top are the extents of the near plane (see ProjectionInfo), then
+	// transforms it to world space.
+	void SetFromViewVolume(float32 left, float32 right, float32 bottom, float32 top, float32 nearDist, float32 farDist, bool isPerspective, const Matrix43& cameraToWorld = Matrix43::Identity());
+
+	void SetPerspective(float32 vertFovRadians, float32 aspectRatio, float32 nearDist, float32 farDist, const Matrix43& cameraToWorld = Matrix43::Identity());
+
+	bool Contains(const Vector3& v) const;
+
+	// Conservative tests: may return true/Intersecting for volumes that are outside but close to
+	// a frustum corner, which is fine for culling.
+	bool Intersects(const AABB& aabb) const;
+	bool Intersects(const Sphere& sphere) const;
+	Containment::Type Test(const AABB& aabb) const;
+};
+
+// Intersection tests
+
+bool Intersects(const AABB& a, const AABB& b);
+bool Intersects(const Sphere& a, const Sphere& b);
+bool Intersects(const AABB& aabb, const Sphere& sphere);
+bool Intersects(const OBB& a, const OBB& b);
+
+// Ray tests return the parameter of the first intersection in tHit, which is 0 if the ray
+// starts inside the volume. Only intersections with t in [0, tMax] are reported.
+bool Intersects(const Ray& ray, const AABB& aabb, float32& tHit, float32 tMax = kInfiniteDistance);
+bool Intersects(const Ray& ray, const Sphere& sphere, float32& tHit, float32 tMax = kInfiniteDistance);
+bool Intersects(const Ray& ray, const Plane& plane, float32& tHit, float32 tMax = kInfiniteDistance);
+bool Intersects(const Ray& ray, const OBB& obb, float32& tHit, float32 tMax = kInfiniteDistance);
+
+// Transformation by Matrix43 (any affine transform)
+
+// Returns the AABB that encloses the transformed box
+AABB operator*(const AABB& aabb, const Matrix43& m);
+
+// Radius is scaled by the largest axis scale
+Sphere operator*(const Sphere& sphere, const Matrix43& m);
+
+// Matrix must not contain shear
+OBB operator*(const OBB& obb, const Matrix43& m);
+
+Plane operator*(const Plane& plane, const Matrix43& m);
+Ray operator*(const Ray& ray, const Matrix43& m);
+Frustum operator*(const Frustum& frustum, const Matrix43& m);
+
+inline void AABB::Include(const Vector3& v)
+{
+	min.x = MathEx::Min(min.x, v.x);
+	min.y = MathEx::Min(min.y, v.y);
+	min.z = MathEx::Min(min.z, v.z);
+	max.x = MathEx::Max(max.x, v.x);
+	max.y = MathEx::Max(max.y, v.y);
+	max.z = MathEx::Max(max.z, v.z);
+}
+
+inline void AABB::Include(const AABB& aabb)
+{
+	Include(aabb.min);
+	Include(aabb.max);
+}
+
+inline bool AABB::Contains(const Vector3& v) const
+{
+	return v.x >= min.x && v.x <= max.x
+		&& v.y >= min.y && v.y <= max.y
+		&& v.z >= min.z && v.z <= max.z;
+}
+
+inline bool AABB::Contains(const AABB& aabb) const
+{
+	return Contains(aabb.min) && Contains(aabb.max);
+}
+
+inline Vector3 AABB::ClosestPoint(const Vector3& v) const
+{
+	return Vector3(MathEx::Clamp(v.x, min.x, max.x), MathEx::Clamp(v.y, min.y, max.y), MathEx::Clamp(v.z, min.z, max.z));
+}
+
+inline bool Intersects(const AABB& a, const AABB& b)
+{
+	return a.min.x <= b.max.x && a.max.x >= b.min.x
+		&& a.min.y <= b.max.y && a.max.y >= b.min.y
+		&& a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+inline bool Intersects(const Sphere& a, const Sphere& b)
+{
+	const float32 radiusSum = a.radius + b.radius;
+	return (b.center - a.center).LengthSquared() <= radiusSum * radiusSum;
+}
+
+inline bool Intersects(const AABB& aabb, const Sphere& sphere)
+{
+	return sphere.Contains(aabb.ClosestPoint(sphere.center));
+}
+
+#endif // _GS_GEOMETRY_H_
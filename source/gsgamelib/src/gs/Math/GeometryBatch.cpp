@@ -0,0 +1,150 @@
+#include "GeometryBatch.h"
+#include "SIMD.h"
+
+#if GS_SIMD_SSE
+
+namespace
+{
+	// Returns mask of lanes (4 bits) in [offset, offset + 4) that are outside the frustum
+	int FrustumOutsideAABBx4(const Frustum& frustum, const AABBx8& boxes, size_t offset)
+	{
+		const __m128 cx = _mm_loadu_ps(boxes.centerX + offset);
+		const __m128 cy = _mm_loadu_ps(boxes.centerY + offset);
+		const __m128 cz = _mm_loadu_ps(boxes.centerZ + offset);
+		const __m128 hx = _mm_loadu_ps(boxes.halfExtentsX + offset);
+		const __m128 hy = _mm_loadu_ps(boxes.halfExtentsY + offset);
+		const __m128 hz = _mm_loadu_ps(boxes.halfExtentsZ + offset);
+		const __m128 signMask = _mm_set1_ps(-0.f);
+
+		__m128 outside = _mm_setzero_ps();
+		for (const auto& plane : frustum.planes)
+		{
+			const __m128 nx = _mm_set1_ps(plane.normal.x);
+			const __m128 ny = _mm_set1_ps(plane.normal.y);
+			const __m128 nz = _mm_set1_ps(plane.normal.z);
+
+			// Same operation order as Frustum::Test so that results match exactly
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz));
+			distance = _mm_add_ps(distance, _mm_set1_ps(plane.d));
+
+			__m128 radius = _mm_add_ps(_mm_mul_ps(SIMD::Abs(nx), hx), _mm_mul_ps(SIMD::Abs(ny), hy));
+			radius = _mm_add_ps(radius, _mm_mul_ps(SIMD::Abs(nz), hz));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_xor_ps(radius, signMask)));
+		}
+		return _mm_movemask_ps(outside);
+	}
+
+	int SphereIntersectsSpherex4(const Sphere& sphere, const Spherex8& spheres, size_t offset)
+	{
+		const __m128 dx = _mm_sub_ps(_mm_loadu_ps(spheres.centerX + offset), _mm_set1_ps(sphere.center.x));
+		const __m128 dy = _mm_sub_ps(_mm_loadu_ps(spheres.centerY + offset), _mm_set1_ps(sphere.center.y));
+		const __m128 dz = _mm_sub_ps(_mm_loadu_ps(spheres.centerZ + offset), _mm_set1_ps(sphere.center.z));
+		const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		const __m128 radiusSum = _mm_add_ps(_mm_set1_ps(sphere.radius), _mm_loadu_ps(spheres.radius + offset));
+		return _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_mul_ps(radiusSum, radiusSum)));
+	}
+}
+
+uint32 FrustumIntersectsAABBx8(const Frustum& frustum, const AABBx8& boxes)
+{
+	const int outside = FrustumOutsideAABBx4(frustum, boxes, 0) | (FrustumOutsideAABBx4(frustum, boxes, 4) << 4);
+	return ~static_cast<uint32>(outside) & 0xFF;
+}
+
+uint32 SphereIntersectsSpherex8(const Sphere& sphere, const Spherex8& spheres)
+{
+	return static_cast<uint32>(SphereIntersectsSpherex4(sphere, spheres, 0) | (SphereIntersectsSpherex4(sphere, spheres, 4) << 4));
+}
+
+uint32 RayIntersectsAABBx4(const Ray& ray, const AABBx4& boxes, float32 tHits[4], float32 tMax)
+{
+	const float32* boxMins[3] = { boxes.minX, boxes.minY, boxes.minZ };
+	const float32* boxMaxs[3] = { boxes.maxX, boxes.maxY, boxes.maxZ };
+
+	__m128 tNear = _mm_setzero_ps();
+	__m128 tFar = _mm_set1_ps(tMax);
+	__m128 hit = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const __m128 boxMin = _mm_loadu_ps(boxMins[i]);
+		const __m128 boxMax = _mm_loadu_ps(boxMaxs[i]);
+		const __m128 origin = _mm_set1_ps(ray.origin.v[i]);
+
+		// Direction is the same for all lanes, so handle the parallel case with a branch like the
+		// scalar version does (avoids 0 * inf = NaN when the origin lies on a slab)
+		if (MathEx::Abs(ray.dir.v[i]) < kEpsilon)
+		{
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(boxMin, origin), _mm_cmpge_ps(boxMax, origin)));
+		}
+		else
+		{
+			const __m128 invDir = _mm_set1_ps(1.f / ray.dir.v[i]);
+			const __m128 t1 = _mm_mul_ps(_mm_sub_ps(boxMin, origin), invDir);
+			const __m128 t2 = _mm_mul_ps(_mm_sub_ps(boxMax, origin), invDir);
+			tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+			tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+		}
+	}
+
+	hit = _mm_and_ps(hit, _mm_cmple_ps(tNear, tFar));
+	const uint32 mask = static_cast<uint32>(_mm_movemask_ps(hit));
+
+	float32 tNears[4];
+	_mm_storeu_ps(tNears, tNear);
+	for (int i = 0; i < 4; ++i)
+	{
+		if (mask & (1u << i))
+			tHits[i] = tNears[i];
+	}
+	return mask;
+}
+
+#else // !GS_SIMD_SSE
+
+uint32 FrustumIntersectsAABBx8(const Frustum& frustum, const AABBx8& boxes)
+{
+	uint32 mask = 0;
+	for (size_t i = 0; i < 8; ++i)
+	{
+		const Vector3 center(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+		const Vector3 halfExtents(boxes.halfExtentsX[i], boxes.halfExtentsY[i], boxes.halfExtentsZ[i]);
+
+		bool outside = false;
+		for (const auto& plane : frustum.planes)
+		{
+			const float32 radius = MathEx::Abs(plane.normal.x) * halfExtents.x + MathEx::Abs(plane.normal.y) * halfExtents.y + MathEx::Abs(plane.normal.z) * halfExtents.z;
+			outside = outside || plane.SignedDistance(center) < -radius;
+		}
+		if (!outside)
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+uint32 SphereIntersectsSpherex8(const Sphere& sphere, const Spherex8& spheres)
+{
+	uint32 mask = 0;
+	for (size_t i = 0; i < 8; ++i)
+	{
+		const Sphere other(Vector3(spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i]), spheres.radius[i]);
+		if (Intersects(sphere, other))
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+uint32 RayIntersectsAABBx4(const Ray& ray, const AABBx4& boxes, float32 tHits[4], float32 tMax)
+{
+	uint32 mask = 0;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		const AABB aabb(Vector3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]), Vector3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]));
+		if (Intersects(ray, aabb, tHits[i], tMax))
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+#endif // GS_SIMD_SSE
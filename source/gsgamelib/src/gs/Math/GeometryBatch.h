@@ -0,0 +1,91 @@
+#ifndef _GS_GEOMETRY_BATCH_H_
+#define _GS_GEOMETRY_BATCH_H_
+
+// Batched versions of the most common intersection tests in Geometry.h, for culling and
+// broad-phase collision. Primitives are stored in SoA layout so that one test is performed per
+// SIMD lane (see SIMD.h); 8-wide tests are run as two 4-wide halves when only SSE is available.
+// Results are returned as bitmasks (bit i set if element i passes) and match the scalar tests.
+
+#include "gs/Base/Base.h"
+#include "Geometry.h"
+#include <cstddef>
+
+// 8 AABBs stored as center and half extents, which is what frustum tests need
+struct AABBx8
+{
+	float32 centerX[8], centerY[8], centerZ[8];
+	float32 halfExtentsX[8], halfExtentsY[8], halfExtentsZ[8];
+
+	void Set(size_t index, const AABB& aabb);
+
+	// Sets unused elements to an empty box that fails all tests
+	void Clear(size_t index);
+};
+
+struct Spherex8
+{
+	float32 centerX[8], centerY[8], centerZ[8];
+	float32 radius[8];
+
+	void Set(size_t index, const Sphere& sphere);
+};
+
+struct AABBx4
+{
+	float32 minX[4], minY[4], minZ[4];
+	float32 maxX[4], maxY[4], maxZ[4];
+
+	void Set(size_t index, const AABB& aabb);
+};
+
+// Same as frustum.Intersects(aabb) for each box
+uint32 FrustumIntersectsAABBx8(const Frustum& frustum, const AABBx8& boxes);
+
+// Same as Intersects(sphere, spheres[i]) for each sphere
+uint32 SphereIntersectsSpherex8(const Sphere& sphere, const Spherex8& spheres);
+
+// Same as Intersects(ray, boxes[i], tHits[i], tMax) for each box; tHits is only written for hits
+uint32 RayIntersectsAABBx4(const Ray& ray, const AABBx4& boxes, float32 tHits[4], float32 tMax = kInfiniteDistance);
+
+inline void AABBx8::Set(size_t index, const AABB& aabb)
+{
+	assert(index < 8);
+	const Vector3 center = aabb.GetCenter();
+	const Vector3 halfExtents = aabb.GetHalfExtents();
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	halfExtentsX[index] = halfExtents.x;
+	halfExtentsY[index] = halfExtents.y;
+	halfExtentsZ[index] = halfExtents.z;
+}
+
+inline void AABBx8::Clear(size_t index)
+{
+	assert(index < 8);
+	// Negative extents make every plane test fail, wherever the center is
+	centerX[index] = centerY[index] = centerZ[index] = 0.f;
+	halfExtentsX[index] = halfExtentsY[index] = halfExtentsZ[index] = -kInfiniteDistance;
+}
+
+inline void Spherex8::Set(size_t index, const Sphere& sphere)
+{
+	assert(index < 8);
+	centerX[index] = sphere.center.x;
+	centerY[index] = sphere.center.y;
+	centerZ[index] = sphere.center.z;
+	radius[index] = sphere.radius;
+}
+
+inline void AABBx4::Set(size_t index, const AABB& aabb)
+{
+	assert(index < 4);
+	minX[index] = aabb.min.x;
+	minY[index] = aabb.min.y;
+	minZ[index] = aabb.min.z;
+	maxX[index] = aabb.max.x;
+	maxY[index] = aabb.max.y;
+	maxZ[index] = aabb.max.z;
+}
+
+#endif // _GS_GEOMETRY_BATCH_H_
@@ -88,7 +88,7 @@ namespace MathEx
 
 	// Returns absolute value of val
 	template <typename T>
-	inline T Abs(T val) { return ::abs(val); }
+	inline T Abs(T val) { return std::abs(val); }
 
 	// Returns sin and cosine of input angle (in radians)
 	template <typename T>
@@ -168,20 +168,23 @@ namespace MathEx
 
 	namespace Internal
 	{
+		// Implemented in Random.cpp using the calling thread's Random generator
+		float64 ThreadRandFloat01();
+		int32 ThreadRandInt(int32 min, int32 max);
+
 		template <typename T, bool IsFloat>
 		struct RandImpl
 		{
 			static T DoIt(T min, T max)
 			{
-				float32 ret = rand()/(((T)RAND_MAX + 1) / (max-min));
-				return ret + min;
+				return static_cast<T>(ThreadRandFloat01() * (max-min)) + min;
 			}
 		};
 		
 		template <typename T>
 		struct RandImpl<T, false>
 		{
-			static T DoIt(T min, T max) { return rand() % (max-min+1) + min; }
+			static T DoIt(T min, T max) { return static_cast<T>(ThreadRandInt(static_cast<int32>(min), static_cast<int32>(max))); }
 		};
 	}
 
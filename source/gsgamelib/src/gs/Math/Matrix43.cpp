@@ -3,6 +3,7 @@
 #include "gs/Base/string_helpers.h"
 #include "EulerAngles.h"
 #include "Quaternion.h"
+#include "QTS.h"
 
 namespace
 {
@@ -29,9 +30,9 @@ namespace
 
 void Matrix43::SetRotFromScaleVector(const Vector3& scale)
 {
-	axisX.Set(scale.x, 0.f, 0.f);
-	axisY.Set(0.f, scale.y, 0.f);
-	axisZ.Set(0.f, 0.f, scale.z);	
+	AxisX().Set(scale.x, 0.f, 0.f);
+	AxisY().Set(0.f, scale.y, 0.f);
+	AxisZ().Set(0.f, 0.f, scale.z);	
 }
 
 void Matrix43::SetRotFromAxisAngle(const Vector3& axis, float32 angle)
@@ -101,21 +102,30 @@ void Matrix43::SetRotFromQuaternion(const Quaternion& q)
 	m33 = 1.0f - xx*q.x - yy*q.y;
 }
 
+void Matrix43::SetFromQTS(const QTS& qts)
+{
+	SetRotFromQuaternion(qts.rot);
+	AxisX() *= qts.scale;
+	AxisY() *= qts.scale;
+	AxisZ() *= qts.scale;
+	Translation() = qts.trans;
+}
+
 void Matrix43::SetRotFromLookAtDir(const Vector3& lookAt, const Vector3& up)
 {
 	assert(MathEx::Abs(lookAt.Dot(up)) < 1.f - kEpsilon && "Input vectors cannot be parallel");
 	assert(lookAt.IsUnit() && up.IsUnit() && "Input vectors must be unit length");
 
-	axisX = Normalize(up.Cross(lookAt));
-	axisY = lookAt.Cross(axisX);
-	axisZ = lookAt;
+	AxisX() = Normalize(up.Cross(lookAt));
+	AxisY() = lookAt.Cross(AxisX());
+	AxisZ() = lookAt;
 }
 
 void Matrix43::SetRotFromMatrix(const Matrix43& m)
 {
-	axisX = m.axisX;
-	axisY = m.axisY;
-	axisZ = m.axisZ;
+	AxisX() = m.AxisX();
+	AxisY() = m.AxisY();
+	AxisZ() = m.AxisZ();
 }
 
 void Matrix43::SetInverseFrom(const Matrix43& m)
@@ -144,9 +154,9 @@ void Matrix43::SetInverseFrom(const Matrix43& m)
 
 void Matrix43::SetInverseFromSRT(const Matrix43& m)
 {
-	const float32 invScaleSquaredX = 1.f / (m.axisX.LengthSquared());
-	const float32 invScaleSquaredY = 1.f / (m.axisY.LengthSquared());
-	const float32 invScaleSquaredZ = 1.f / (m.axisZ.LengthSquared());
+	const float32 invScaleSquaredX = 1.f / (m.AxisX().LengthSquared());
+	const float32 invScaleSquaredY = 1.f / (m.AxisY().LengthSquared());
+	const float32 invScaleSquaredZ = 1.f / (m.AxisZ().LengthSquared());
 
     // Transpose upper 3x3 and divide by scale
 	m11 = m.m11 * invScaleSquaredX;
@@ -169,7 +179,7 @@ void Matrix43::SetInverseFromUniformSRT(const Matrix43& m)
 {
 	assert(m.HasUniformScale());
 
-	const float32 invScaleSquared = 1.f / (m.axisX.LengthSquared());
+	const float32 invScaleSquared = 1.f / (m.AxisX().LengthSquared());
 
     // Transpose upper 3x3 and divide by scale
 	m11 = m.m11 * invScaleSquared;
@@ -212,7 +222,7 @@ void Matrix43::SetInverseFromRT(const Matrix43& m)
 void Matrix43::SetInverseFromR(const Matrix43& m)
 {
 	assert(MathEx::AlmostEquals(m.GetUniformScale(), 1.f) && "Matrix must not contain scale");
-	assert(m.trans.IsZero());
+	assert(m.Translation().IsZero());
 
     // Transpose upper 3x3
 	m11 = m.m11;
@@ -225,7 +235,7 @@ void Matrix43::SetInverseFromR(const Matrix43& m)
 	m32 = m.m23;
 	m33 = m.m33;
 
-	trans.SetZero();
+	Translation().SetZero();
 }
 
 Matrix43 Matrix43::Mul(const Matrix43& rhs) const
@@ -6,6 +6,7 @@
 
 class EulerAngles;
 class Quaternion;
+class QTS;
 
 // Matrix43 represents a 4x3 matrix that can contain any 3D affine
 // transformation. It can be treated like a 4x4 where the last column
@@ -27,20 +28,21 @@ public:
 			float32 m41, m42, m43; // Translation row
 		};
 
-		// Useful representation for accessing basis and translation vectors as Vector3s
-		struct
-		{
-			Vector3 axisX;
-			Vector3 axisY;
-			Vector3 axisZ;
-			Vector3 trans;
-		};
+		// Basis and translation vectors as Vector3s, accessed with AxisX(), AxisY(), AxisZ() and
+		// Translation(). (An anonymous struct of Vector3s would be non-standard, as Vector3 has
+		// constructors.)
+		Vector3 rows[4];
 	};
 
 	Matrix43() {}
 
 	Matrix43(const Vector3& axisX, const Vector3& axisY, const Vector3& axisZ, const Vector3& trans)
-		: axisX(axisX), axisY(axisY), axisZ(axisZ), trans(trans) {}
+	{
+		rows[0] = axisX;
+		rows[1] = axisY;
+		rows[2] = axisZ;
+		rows[3] = trans;
+	}
 
 	static const Matrix43& Identity()
 	{
@@ -56,6 +58,7 @@ public:
 	void SetFromAxisAngle(const Vector3& axis, float32 angle, const Vector3& translation = Vector3::Zero());
 	void SetFromEulerAngles(const EulerAngles& eulerAngles, const Vector3& translation = Vector3::Zero());
 	void SetFromQuaternion(const Quaternion& q, const Vector3& translation = Vector3::Zero());
+	void SetFromQTS(const QTS& qts);
 	void SetFromLookAtDir(const Vector3& lookAt, const Vector3& up = Vector3::UnitY(), const Vector3& translation = Vector3::Zero());
 	void SetFromLookAtPos(const Vector3& from, const Vector3& to, const Vector3& up = Vector3::UnitY());
 
@@ -67,10 +70,15 @@ public:
 	void SetRotFromLookAtDir(const Vector3& lookAt, const Vector3& up = Vector3::UnitY());
 	void SetRotFromMatrix(const Matrix43& m);
 
-	const Vector3& AxisX() const { return axisX; }
-	const Vector3& AxisY() const { return axisY; }
-	const Vector3& AxisZ() const { return axisZ; }
-	const Vector3& Translation() const { return trans; }
+	const Vector3& AxisX() const { return rows[0]; }
+	const Vector3& AxisY() const { return rows[1]; }
+	const Vector3& AxisZ() const { return rows[2]; }
+	const Vector3& Translation() const { return rows[3]; }
+
+	Vector3& AxisX() { return rows[0]; }
+	Vector3& AxisY() { return rows[1]; }
+	Vector3& AxisZ() { return rows[2]; }
+	Vector3& Translation() { return rows[3]; }
 
 	// Inverts this matrix. These are ordered from most computationally expensive to least
 	void Invert(); // For any arbitrary affine transform
@@ -86,7 +94,7 @@ public:
 	void SetInverseFromRT(const Matrix43& m);
 	void SetInverseFromR(const Matrix43& m);
 
-	bool AlmostEquals(const Matrix43& rhs, float32 epsilon = kEpsilon);
+	bool AlmostEquals(const Matrix43& rhs, float32 epsilon = kEpsilon) const;
 
 	float32 Determinant() const;
 
@@ -115,50 +123,50 @@ private:
 
 static_assert(sizeof(Matrix43) == sizeof(float32) * 4 * 3, "Invalid size");
 
-inline bool Matrix43::AlmostEquals(const Matrix43& rhs, float32 epsilon)
+inline bool Matrix43::AlmostEquals(const Matrix43& rhs, float32 epsilon) const
 {
-	return axisX.AlmostEquals(rhs.axisX, epsilon)
-		&& axisY.AlmostEquals(rhs.axisY, epsilon)
-		&& axisZ.AlmostEquals(rhs.axisZ, epsilon)
-		&& trans.AlmostEquals(rhs.trans, epsilon);
+	return AxisX().AlmostEquals(rhs.AxisX(), epsilon)
+		&& AxisY().AlmostEquals(rhs.AxisY(), epsilon)
+		&& AxisZ().AlmostEquals(rhs.AxisZ(), epsilon)
+		&& Translation().AlmostEquals(rhs.Translation(), epsilon);
 }
 
 inline void Matrix43::SetFromTranslation(const Vector3& t)
 {
-	axisX = Vector3::UnitX();
-	axisY = Vector3::UnitY();
-	axisZ = Vector3::UnitZ();
-	trans = t;
+	AxisX() = Vector3::UnitX();
+	AxisY() = Vector3::UnitY();
+	AxisZ() = Vector3::UnitZ();
+	Translation() = t;
 }
 
 inline void Matrix43::SetFromScaleVector(const Vector3& scale, const Vector3& translation)
 {
 	SetRotFromScaleVector(scale);
-	trans = translation;
+	Translation() = translation;
 }
 
 inline void Matrix43::SetFromAxisAngle(const Vector3& axis, float32 angle, const Vector3& translation)
 {
 	SetRotFromAxisAngle(axis, angle);
-	trans = translation;
+	Translation() = translation;
 }
 
 inline void Matrix43::SetFromEulerAngles(const EulerAngles& eulerAngles, const Vector3& translation)
 {
 	SetRotFromEulerAngles(eulerAngles);
-	trans = translation;
+	Translation() = translation;
 }
 
 inline void Matrix43::SetFromQuaternion(const Quaternion& q, const Vector3& translation)
 {
 	SetRotFromQuaternion(q);
-	trans = translation;
+	Translation() = translation;
 }
 
 inline void Matrix43::SetFromLookAtDir(const Vector3& lookAt, const Vector3& up, const Vector3& translation)
 {
 	SetRotFromLookAtDir(lookAt, up);
-	trans = translation;
+	Translation() = translation;
 }
 
 inline void Matrix43::SetFromLookAtPos(const Vector3& from, const Vector3& to, const Vector3& up)
@@ -194,35 +202,40 @@ inline void Matrix43::InvertR()
 inline bool Matrix43::IsOrthogonal() const
 {
 	return HasUniformScale()
-		&& MathEx::AlmostEquals(axisX.Dot(axisY), 0.f)
-		&& MathEx::AlmostEquals(axisY.Dot(axisZ), 0.f);
+		&& MathEx::AlmostEquals(AxisX().Dot(AxisY()), 0.f)
+		&& MathEx::AlmostEquals(AxisY().Dot(AxisZ()), 0.f);
 }
 
 inline void Matrix43::Orthogonalize()
 {
 	// Make axes orthogonal
-	axisY = axisZ.Cross(axisX);
-	axisZ = axisX.Cross(axisY);
+	AxisY() = AxisZ().Cross(AxisX());
+	AxisZ() = AxisX().Cross(AxisY());
 	// Makes axes unit length
-	axisX = Normalize(axisX);
-	axisY = Normalize(axisY);
-	axisZ = Normalize(axisZ);
+	AxisX() = Normalize(AxisX());
+	AxisY() = Normalize(AxisY());
+	AxisZ() = Normalize(AxisZ());
 }
 
 inline bool Matrix43::HasUniformScale() const
 {
-	return MathEx::AlmostEquals(axisX.Length(), axisY.Length()) && MathEx::AlmostEquals(axisY.Length(), axisZ.Length());
+	// Float precision decreases with magnitude, so tolerance must be relative to the scale
+	const float32 lengthX = AxisX().Length();
+	const float32 lengthY = AxisY().Length();
+	const float32 lengthZ = AxisZ().Length();
+	const float32 epsilon = kEpsilon * MathEx::Max(1.f, lengthX);
+	return MathEx::AlmostEquals(lengthX, lengthY, epsilon) && MathEx::AlmostEquals(lengthY, lengthZ, epsilon);
 }
 
 inline Vector3 Matrix43::GetScale() const
 {
-	return Vector3(axisX.Length(), axisY.Length(), axisZ.Length());
+	return Vector3(AxisX().Length(), AxisY().Length(), AxisZ().Length());
 }
 
 inline float32 Matrix43::GetUniformScale() const
 {
 	assert(HasUniformScale() && "Matrix does not contain uniform scale");
-	return axisX.Length();
+	return AxisX().Length();
 }
 
 inline float32 Matrix43::Determinant() const
@@ -261,7 +274,7 @@ inline Matrix43& operator*=(Matrix43& lhs, const Matrix43& rhs)
 
 inline bool operator==(const Matrix43& lhs, const Matrix43& rhs)
 {
-	return lhs.axisX == rhs.axisX && lhs.axisY == rhs.axisY && lhs.axisZ == rhs.axisZ && lhs.trans == rhs.trans;
+	return lhs.AxisX() == rhs.AxisX() && lhs.AxisY() == rhs.AxisY() && lhs.AxisZ() == rhs.AxisZ() && lhs.Translation() == rhs.Translation();
 }
 
 inline bool operator!=(const Matrix43& lhs, const Matrix43& rhs)
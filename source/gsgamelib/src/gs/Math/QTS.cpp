@@ -0,0 +1,35 @@
+#include "QTS.h"
+#include "Matrix43.h"
+#include "gs/Base/string_helpers.h"
+
+void QTS::SetFromMatrix(const Matrix43& m)
+{
+	assert(m.HasUniformScale() && "Matrix must have uniform scale to convert to QTS");
+
+	scale = m.GetUniformScale();
+	assert(scale > 0.f);
+
+	// Remove scale from basis vectors so we can extract the rotation
+	const float32 invScale = 1.f / scale;
+	Matrix43 mRot(m.AxisX() * invScale, m.AxisY() * invScale, m.AxisZ() * invScale, Vector3::Zero());
+	rot.SetFromMatrix(mRot);
+	rot.Normalize();
+
+	trans = m.Translation();
+}
+
+std::string QTS::ToString() const
+{
+	return str_format("Q[%f, %f, %f, %f] T", MathEx::AdjustZero(rot.x), MathEx::AdjustZero(rot.y), MathEx::AdjustZero(rot.z), MathEx::AdjustZero(rot.w))
+		+ trans.ToString()
+		+ str_format(" S[%f]", scale);
+}
+
+QTS Interpolate(const QTS& qts1, const QTS& qts2, float32 t)
+{
+	return QTS(
+		Slerp(qts1.rot, qts2.rot, t),
+		MathEx::Lerp(qts1.trans, qts2.trans, t),
+		MathEx::Lerp(qts1.scale, qts2.scale, t)
+		);
+}
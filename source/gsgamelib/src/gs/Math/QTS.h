@@ -0,0 +1,128 @@
+#ifndef _GS_QTS_H_
+#define _GS_QTS_H_
+
+#include "gs/Base/Base.h"
+#include "MathEx.h"
+#include "Vector3.h"
+#include "Quaternion.h"
+#include "Matrix43.h"
+
+// QTS represents an affine transform made up of a rotation (Quaternion), a translation
+// and a uniform scale. It is more compact than a Matrix43 (32 bytes vs 48 bytes), cheaper
+// to concatenate, invert and interpolate, and since the rotation is stored as a unit
+// quaternion, it doesn't accumulate skew that must be removed via Matrix43::Orthogonalize.
+// Transforms are applied in the order scale, rotation, then translation. Like the rest of
+// the math lib, concatenation order is left-to-right (lhs is applied first).
+
+class QTS
+{
+public:
+	Quaternion rot;
+	Vector3 trans;
+	float32 scale;
+
+	QTS() {}
+	QTS(const Quaternion& rot, const Vector3& trans, float32 scale = 1.f) : rot(rot), trans(trans), scale(scale) {}
+
+	static const QTS& Identity() { static QTS qts(Quaternion::Identity(), Vector3::Zero(), 1.f); return qts; }
+
+	void Set(const Quaternion& rot, const Vector3& trans, float32 scale = 1.f) { this->rot = rot; this->trans = trans; this->scale = scale; }
+	void SetIdentity() { *this = Identity(); }
+
+	// Matrix must not contain shear or non-uniform scale
+	void SetFromMatrix(const Matrix43& m);
+
+	// Inverts this transform
+	void Invert();
+	void SetInverseFrom(const QTS& qts);
+
+	bool AlmostEquals(const QTS& rhs, float32 epsilon = kEpsilon) const;
+
+	std::string ToString() const;
+
+private:
+	friend Vector3 operator*(const struct DirectionVector& dir, const QTS& qts);
+	friend Vector3 operator*(const struct PositionVector& pos, const QTS& qts);
+	Vector3 TransformedPos(const Vector3& v) const;
+	Vector3 TransformedDir(const Vector3& v) const;
+};
+
+static_assert(sizeof(QTS) == sizeof(float32) * 8, "Invalid size");
+
+// Rotates v by unit quaternion q. Equivalent to v * q, but doesn't normalize v and
+// uses the optimized form: v' = v + 2w(u x v) + 2u x (u x v)
+inline Vector3 RotateVector(const Vector3& v, const Quaternion& q)
+{
+	const Vector3 u(q.x, q.y, q.z);
+	const Vector3 t = u.Cross(v) * 2.f;
+	return v + t * q.w + u.Cross(t);
+}
+
+inline bool QTS::AlmostEquals(const QTS& rhs, float32 epsilon) const
+{
+	return rot.AlmostEquals(rhs.rot, epsilon)
+		&& trans.AlmostEquals(rhs.trans, epsilon)
+		&& MathEx::AlmostEquals(scale, rhs.scale, epsilon);
+}
+
+inline void QTS::SetInverseFrom(const QTS& qts)
+{
+	assert(qts.scale != 0.f && "Cannot invert transform with zero scale");
+
+	rot = ::Invert(qts.rot);
+	scale = 1.f / qts.scale;
+	trans = RotateVector(-qts.trans, rot) * scale;
+}
+
+inline void QTS::Invert()
+{
+	SetInverseFrom(QTS(*this));
+}
+
+inline QTS Invert(const QTS& qts)
+{
+	QTS result;
+	result.SetInverseFrom(qts);
+	return result;
+}
+
+inline Vector3 QTS::TransformedPos(const Vector3& v) const
+{
+	return RotateVector(v * scale, rot) + trans;
+}
+
+inline Vector3 QTS::TransformedDir(const Vector3& v) const
+{
+	return RotateVector(v * scale, rot);
+}
+
+inline Vector3 operator*(const DirectionVector& dir, const QTS& qts)
+{
+	return qts.TransformedDir(dir.v);
+}
+
+inline Vector3 operator*(const PositionVector& pos, const QTS& qts)
+{
+	return qts.TransformedPos(pos.v);
+}
+
+// Concatenates transforms: result applies lhs, then rhs
+inline QTS operator*(const QTS& lhs, const QTS& rhs)
+{
+	return QTS(
+		lhs.rot * rhs.rot,
+		RotateVector(lhs.trans * rhs.scale, rhs.rot) + rhs.trans,
+		lhs.scale * rhs.scale
+		);
+}
+
+inline QTS& operator*=(QTS& lhs, const QTS& rhs)
+{
+	lhs = lhs * rhs;
+	return lhs;
+}
+
+// Interpolates between two transforms: translation and scale are lerped, rotation is slerped
+QTS Interpolate(const QTS& qts1, const QTS& qts2, float32 t);
+
+#endif // _GS_QTS_H_
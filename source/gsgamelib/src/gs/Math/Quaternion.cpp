@@ -100,6 +100,17 @@ void Quaternion::SetFromMatrix(const Matrix43& m)
 	}
 }
 
+void Quaternion::Normalize()
+{
+	const float32 length = Length();
+	assert(length > 0.f);
+	const float32 invLength = 1.f / length;
+	x *= invLength;
+	y *= invLength;
+	z *= invLength;
+	w *= invLength;
+}
+
 void Quaternion::ToAxisAngle(Vector3& axis, float32& angle) const
 {
 	angle = 2.f * MathEx::ACos(w);
@@ -127,12 +138,15 @@ Quaternion Slerp(const Quaternion& q1, const Quaternion& _q2, float32 t)
 	if (t >= 1.0f) return q2;
 
 	// Compute "cosine of angle between quaternions" using dot product
-	const float32 cosAngle = DotProduct(q1, q2);
+	float32 cosAngle = DotProduct(q1, q2);
 	assert(cosAngle < 1.1f); // Both quats should be unit length
 
 	// Ensure shortest path
 	if (cosAngle < 0.f)
+	{
 		q2 = -q2;
+		cosAngle = -cosAngle;
+	}
 
 	// Compute interpolation weights
 	float32 w0, w1;
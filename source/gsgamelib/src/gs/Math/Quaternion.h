@@ -34,7 +34,7 @@ public:
 	// quaternion is unit, then conjugate == inverse (inverse = conjugate / quat.length)
 	void Invert();
 
-	bool AlmostEquals(const Quaternion& rhs, float32 epsilon = kEpsilon);
+	bool AlmostEquals(const Quaternion& rhs, float32 epsilon = kEpsilon) const;
 
 	Vector3 AxisX() const;
 	Vector3 AxisY() const;
@@ -94,7 +94,7 @@ inline void Quaternion::Invert()
 	z = -z;
 }
 
-inline bool Quaternion::AlmostEquals(const Quaternion& rhs, float32 epsilon)
+inline bool Quaternion::AlmostEquals(const Quaternion& rhs, float32 epsilon) const
 {
 	return (MathEx::AlmostEquals(x, rhs.x, epsilon) && MathEx::AlmostEquals(y, rhs.y, epsilon) && MathEx::AlmostEquals(z, rhs.z, epsilon) && MathEx::AlmostEquals(w, rhs.w, epsilon))
 		|| (MathEx::AlmostEquals(x, -rhs.x, epsilon) && MathEx::AlmostEquals(y, -rhs.y, epsilon) && MathEx::AlmostEquals(z, -rhs.z, epsilon) && MathEx::AlmostEquals(w, -rhs.w, epsilon));
@@ -0,0 +1,415 @@
+#include "QuaternionBatch.h"
+#include "Quaternion.h"
+#include "Matrix43.h"
+#include "SIMD.h"
+#include <cassert>
+
+namespace
+{
+	float32 DotProduct(const Quaternion& a, const Quaternion& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	}
+
+	// Corrects nlerp's interpolation factor so that the result approximates slerp.
+	// absCosAngle is the absolute value of the dot product between the two quaternions.
+	// See "Approximating slerp" (Arseny Kapoulkine) for the derivation of the coefficients.
+	float32 FastSlerpCorrectT(float32 t, float32 absCosAngle)
+	{
+		const float32 d = absCosAngle;
+		const float32 A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+		const float32 B = 0.848013f + d * (-1.06021f + d * 0.215638f);
+		const float32 k = A * (t - 0.5f) * (t - 0.5f) + B;
+		return t + t * (t - 0.5f) * (t - 1.f) * k;
+	}
+
+	// Computes slerp weights for q1 and q2, given the (non-negative) cosine of the angle between them
+	void ComputeSlerpWeights(float32 cosAngle, float32 t, float32& w0, float32& w1)
+	{
+		if (t <= 0.f)
+		{
+			w0 = 1.f;
+			w1 = 0.f;
+		}
+		else if (t >= 1.f)
+		{
+			w0 = 0.f;
+			w1 = 1.f;
+		}
+		else if (cosAngle > 0.9999f)
+		{
+			// Quats are very close, just lerp to avoid divide by zero
+			w0 = 1.f - t;
+			w1 = t;
+		}
+		else
+		{
+			const float32 sinAngle = MathEx::Sqrt(1.f - cosAngle*cosAngle);
+			const float32 angle = MathEx::ATan2(sinAngle, cosAngle);
+			const float32 invSinAngle = 1.f / sinAngle;
+			w0 = MathEx::Sin((1.f - t) * angle) * invSinAngle;
+			w1 = MathEx::Sin(t * angle) * invSinAngle;
+		}
+	}
+
+	Quaternion NlerpScalar(const Quaternion& q1, const Quaternion& q2, float32 t)
+	{
+		const float32 s = DotProduct(q1, q2) < 0.f ? -1.f : 1.f;
+		Quaternion result(
+			q1.x + (q2.x * s - q1.x) * t,
+			q1.y + (q2.y * s - q1.y) * t,
+			q1.z + (q2.z * s - q1.z) * t,
+			q1.w + (q2.w * s - q1.w) * t
+			);
+		result.Normalize();
+		return result;
+	}
+
+	Quaternion FastSlerpScalar(const Quaternion& q1, const Quaternion& q2, float32 t)
+	{
+		return NlerpScalar(q1, q2, FastSlerpCorrectT(t, MathEx::Abs(DotProduct(q1, q2))));
+	}
+
+	// Sources of interpolation factors: one per element, or the same for all elements
+	struct ArrayT
+	{
+		const float32* pT;
+		float32 Get(size_t i) const { return pT[i]; }
+#if GS_SIMD_SSE
+		__m128 Get4(size_t i) const { return _mm_loadu_ps(pT + i); }
+#endif
+	};
+
+	struct UniformT
+	{
+		float32 t;
+		float32 Get(size_t) const { return t; }
+#if GS_SIMD_SSE
+		__m128 Get4(size_t) const { return _mm_set1_ps(t); }
+#endif
+	};
+
+#if GS_SIMD_SSE
+	// Four quaternions in SoA form
+	struct Quat4
+	{
+		__m128 x, y, z, w;
+	};
+
+	inline Quat4 LoadQuat4(const Quaternion* pQuats)
+	{
+		Quat4 q;
+		q.x = _mm_loadu_ps(&pQuats[0].x);
+		q.y = _mm_loadu_ps(&pQuats[1].x);
+		q.z = _mm_loadu_ps(&pQuats[2].x);
+		q.w = _mm_loadu_ps(&pQuats[3].x);
+		_MM_TRANSPOSE4_PS(q.x, q.y, q.z, q.w);
+		return q;
+	}
+
+	inline void StoreQuat4(Quaternion* pQuats, Quat4 q)
+	{
+		_MM_TRANSPOSE4_PS(q.x, q.y, q.z, q.w);
+		_mm_storeu_ps(&pQuats[0].x, q.x);
+		_mm_storeu_ps(&pQuats[1].x, q.y);
+		_mm_storeu_ps(&pQuats[2].x, q.z);
+		_mm_storeu_ps(&pQuats[3].x, q.w);
+	}
+
+	inline __m128 Dot4(const Quat4& a, const Quat4& b)
+	{
+		return _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)),
+			_mm_add_ps(_mm_mul_ps(a.z, b.z), _mm_mul_ps(a.w, b.w)));
+	}
+
+	inline Quat4 Normalize4(const Quat4& q)
+	{
+		const __m128 invLength = SIMD::RecipSqrt(Dot4(q, q));
+		Quat4 r = { _mm_mul_ps(q.x, invLength), _mm_mul_ps(q.y, invLength), _mm_mul_ps(q.z, invLength), _mm_mul_ps(q.w, invLength) };
+		return r;
+	}
+
+	// Negates q2 in lanes where dot(q1, q2) < 0 so that interpolation takes the shortest path
+	inline Quat4 ShortestPath4(const Quat4& q2, __m128 cosAngle)
+	{
+		const __m128 signMask = _mm_and_ps(cosAngle, _mm_set1_ps(-0.f));
+		Quat4 r = { _mm_xor_ps(q2.x, signMask), _mm_xor_ps(q2.y, signMask), _mm_xor_ps(q2.z, signMask), _mm_xor_ps(q2.w, signMask) };
+		return r;
+	}
+
+	inline Quat4 Lerp4(const Quat4& q1, const Quat4& q2, __m128 t)
+	{
+		Quat4 r = {
+			_mm_add_ps(q1.x, _mm_mul_ps(_mm_sub_ps(q2.x, q1.x), t)),
+			_mm_add_ps(q1.y, _mm_mul_ps(_mm_sub_ps(q2.y, q1.y), t)),
+			_mm_add_ps(q1.z, _mm_mul_ps(_mm_sub_ps(q2.z, q1.z), t)),
+			_mm_add_ps(q1.w, _mm_mul_ps(_mm_sub_ps(q2.w, q1.w), t))
+		};
+		return r;
+	}
+
+	inline __m128 FastSlerpCorrectT4(__m128 t, __m128 d)
+	{
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 A = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, _mm_sub_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(1.43519f)))))));
+		const __m128 B = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)))));
+		const __m128 tMinusHalf = _mm_sub_ps(t, half);
+		const __m128 k = _mm_add_ps(_mm_mul_ps(A, _mm_mul_ps(tMinusHalf, tMinusHalf)), B);
+		return _mm_add_ps(t, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, tMinusHalf), _mm_sub_ps(t, _mm_set1_ps(1.f))), k));
+	}
+#endif // GS_SIMD_SSE
+
+	template <typename TSource>
+	void NlerpArrayImpl(const Quaternion* pQ1, const Quaternion* pQ2, const TSource& tSource, Quaternion* pOut, size_t count)
+	{
+		size_t i = 0;
+#if GS_SIMD_SSE
+		for ( ; i + 4 <= count; i += 4)
+		{
+			const Quat4 q1 = LoadQuat4(pQ1 + i);
+			Quat4 q2 = LoadQuat4(pQ2 + i);
+			q2 = ShortestPath4(q2, Dot4(q1, q2));
+			StoreQuat4(pOut + i, Normalize4(Lerp4(q1, q2, tSource.Get4(i))));
+		}
+#endif
+		for ( ; i < count; ++i)
+		{
+			pOut[i] = NlerpScalar(pQ1[i], pQ2[i], tSource.Get(i));
+		}
+	}
+
+	template <typename TSource>
+	void FastSlerpArrayImpl(const Quaternion* pQ1, const Quaternion* pQ2, const TSource& tSource, Quaternion* pOut, size_t count)
+	{
+		size_t i = 0;
+#if GS_SIMD_SSE
+		for ( ; i + 4 <= count; i += 4)
+		{
+			const Quat4 q1 = LoadQuat4(pQ1 + i);
+			Quat4 q2 = LoadQuat4(pQ2 + i);
+			const __m128 cosAngle = Dot4(q1, q2);
+			q2 = ShortestPath4(q2, cosAngle);
+			const __m128 t = FastSlerpCorrectT4(tSource.Get4(i), SIMD::Abs(cosAngle));
+			StoreQuat4(pOut + i, Normalize4(Lerp4(q1, q2, t)));
+		}
+#endif
+		for ( ; i < count; ++i)
+		{
+			pOut[i] = FastSlerpScalar(pQ1[i], pQ2[i], tSource.Get(i));
+		}
+	}
+
+	template <typename TSource>
+	void SlerpArrayImpl(const Quaternion* pQ1, const Quaternion* pQ2, const TSource& tSource, Quaternion* pOut, size_t count)
+	{
+		size_t i = 0;
+#if GS_SIMD_SSE
+		for ( ; i + 4 <= count; i += 4)
+		{
+			const Quat4 q1 = LoadQuat4(pQ1 + i);
+			Quat4 q2 = LoadQuat4(pQ2 + i);
+			const __m128 cosAngle = Dot4(q1, q2);
+			q2 = ShortestPath4(q2, cosAngle);
+
+			// The trig functions are evaluated per lane; the loads, blend and stores are vectorized
+			float32 absCosAngles[4];
+			float32 w0s[4];
+			float32 w1s[4];
+			_mm_storeu_ps(absCosAngles, SIMD::Abs(cosAngle));
+			for (size_t lane = 0; lane < 4; ++lane)
+			{
+				ComputeSlerpWeights(absCosAngles[lane], tSource.Get(i + lane), w0s[lane], w1s[lane]);
+			}
+			const __m128 w0 = _mm_loadu_ps(w0s);
+			const __m128 w1 = _mm_loadu_ps(w1s);
+
+			Quat4 r = {
+				_mm_add_ps(_mm_mul_ps(q1.x, w0), _mm_mul_ps(q2.x, w1)),
+				_mm_add_ps(_mm_mul_ps(q1.y, w0), _mm_mul_ps(q2.y, w1)),
+				_mm_add_ps(_mm_mul_ps(q1.z, w0), _mm_mul_ps(q2.z, w1)),
+				_mm_add_ps(_mm_mul_ps(q1.w, w0), _mm_mul_ps(q2.w, w1))
+			};
+			StoreQuat4(pOut + i, r);
+		}
+#endif
+		for ( ; i < count; ++i)
+		{
+			pOut[i] = Slerp(pQ1[i], pQ2[i], tSource.Get(i));
+		}
+	}
+} // anonymous namespace
+
+void NormalizeArray(Quaternion* pQuats, size_t count)
+{
+	size_t i = 0;
+#if GS_SIMD_SSE
+	for ( ; i + 4 <= count; i += 4)
+	{
+		StoreQuat4(pQuats + i, Normalize4(LoadQuat4(pQuats + i)));
+	}
+#endif
+	for ( ; i < count; ++i)
+	{
+		pQuats[i].Normalize();
+	}
+}
+
+void NlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, const float32* pT, Quaternion* pOut, size_t count)
+{
+	ArrayT tSource = { pT };
+	NlerpArrayImpl(pQ1, pQ2, tSource, pOut, count);
+}
+
+void NlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, float32 t, Quaternion* pOut, size_t count)
+{
+	UniformT tSource = { t };
+	NlerpArrayImpl(pQ1, pQ2, tSource, pOut, count);
+}
+
+void FastSlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, const float32* pT, Quaternion* pOut, size_t count)
+{
+	ArrayT tSource = { pT };
+	FastSlerpArrayImpl(pQ1, pQ2, tSource, pOut, count);
+}
+
+void FastSlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, float32 t, Quaternion* pOut, size_t count)
+{
+	UniformT tSource = { t };
+	FastSlerpArrayImpl(pQ1, pQ2, tSource, pOut, count);
+}
+
+void SlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, const float32* pT, Quaternion* pOut, size_t count)
+{
+	ArrayT tSource = { pT };
+	SlerpArrayImpl(pQ1, pQ2, tSource, pOut, count);
+}
+
+void SlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, float32 t, Quaternion* pOut, size_t count)
+{
+	UniformT tSource = { t };
+	SlerpArrayImpl(pQ1, pQ2, tSource, pOut, count);
+}
+
+void QuaternionsToMatrices(const Quaternion* pQuats, const Vector3* pTranslations, Matrix43* pOut, size_t count)
+{
+	size_t i = 0;
+#if GS_SIMD_SSE
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 two = _mm_set1_ps(2.f);
+
+	for ( ; i + 4 <= count; i += 4)
+	{
+		const Quat4 q = LoadQuat4(pQuats + i);
+		const __m128 xx = _mm_mul_ps(two, q.x);
+		const __m128 yy = _mm_mul_ps(two, q.y);
+		const __m128 zz = _mm_mul_ps(two, q.z);
+		const __m128 ww = _mm_mul_ps(two, q.w);
+
+		// Same as Matrix43::SetRotFromQuaternion, 4 at a time
+		__m128 m11 = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(yy, q.y)), _mm_mul_ps(zz, q.z));
+		__m128 m12 = _mm_add_ps(_mm_mul_ps(xx, q.y), _mm_mul_ps(ww, q.z));
+		__m128 m13 = _mm_sub_ps(_mm_mul_ps(xx, q.z), _mm_mul_ps(ww, q.y));
+
+		__m128 m21 = _mm_sub_ps(_mm_mul_ps(xx, q.y), _mm_mul_ps(ww, q.z));
+		__m128 m22 = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(xx, q.x)), _mm_mul_ps(zz, q.z));
+		__m128 m23 = _mm_add_ps(_mm_mul_ps(yy, q.z), _mm_mul_ps(ww, q.x));
+
+		__m128 m31 = _mm_add_ps(_mm_mul_ps(xx, q.z), _mm_mul_ps(ww, q.y));
+		__m128 m32 = _mm_sub_ps(_mm_mul_ps(yy, q.z), _mm_mul_ps(ww, q.x));
+		__m128 m33 = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(xx, q.x)), _mm_mul_ps(yy, q.y));
+
+		__m128 m41, m42, m43;
+		if (pTranslations)
+		{
+			const Vector3* pT = pTranslations + i;
+			m41 = _mm_setr_ps(pT[0].x, pT[1].x, pT[2].x, pT[3].x);
+			m42 = _mm_setr_ps(pT[0].y, pT[1].y, pT[2].y, pT[3].y);
+			m43 = _mm_setr_ps(pT[0].z, pT[1].z, pT[2].z, pT[3].z);
+		}
+		else
+		{
+			m41 = m42 = m43 = _mm_setzero_ps();
+		}
+
+		// Transpose from SoA back to 4 matrices of 12 contiguous floats each
+		_MM_TRANSPOSE4_PS(m11, m12, m13, m21);
+		_MM_TRANSPOSE4_PS(m22, m23, m31, m32);
+		_MM_TRANSPOSE4_PS(m33, m41, m42, m43);
+
+		_mm_storeu_ps(&pOut[i + 0].m[0][0], m11); _mm_storeu_ps(&pOut[i + 0].m[0][0] + 4, m22); _mm_storeu_ps(&pOut[i + 0].m[0][0] + 8, m33);
+		_mm_storeu_ps(&pOut[i + 1].m[0][0], m12); _mm_storeu_ps(&pOut[i + 1].m[0][0] + 4, m23); _mm_storeu_ps(&pOut[i + 1].m[0][0] + 8, m41);
+		_mm_storeu_ps(&pOut[i + 2].m[0][0], m13); _mm_storeu_ps(&pOut[i + 2].m[0][0] + 4, m31); _mm_storeu_ps(&pOut[i + 2].m[0][0] + 8, m42);
+		_mm_storeu_ps(&pOut[i + 3].m[0][0], m21); _mm_storeu_ps(&pOut[i + 3].m[0][0] + 4, m32); _mm_storeu_ps(&pOut[i + 3].m[0][0] + 8, m43);
+	}
+#endif
+	for ( ; i < count; ++i)
+	{
+		pOut[i].SetFromQuaternion(pQuats[i], pTranslations ? pTranslations[i] : Vector3::Zero());
+	}
+}
+
+void MatricesToQuaternions(const Matrix43* pMatrices, Quaternion* pOut, size_t count)
+{
+	size_t i = 0;
+#if GS_SIMD_SSE
+	const __m128 one = _mm_set1_ps(1.f);
+
+	for ( ; i + 4 <= count; i += 4)
+	{
+		// Load upper 3x3 of 4 matrices in SoA form (translation is ignored)
+		__m128 m11 = _mm_loadu_ps(&pMatrices[i + 0].m[0][0]);
+		__m128 m12 = _mm_loadu_ps(&pMatrices[i + 1].m[0][0]);
+		__m128 m13 = _mm_loadu_ps(&pMatrices[i + 2].m[0][0]);
+		__m128 m21 = _mm_loadu_ps(&pMatrices[i + 3].m[0][0]);
+		_MM_TRANSPOSE4_PS(m11, m12, m13, m21);
+
+		__m128 m22 = _mm_loadu_ps(&pMatrices[i + 0].m[0][0] + 4);
+		__m128 m23 = _mm_loadu_ps(&pMatrices[i + 1].m[0][0] + 4);
+		__m128 m31 = _mm_loadu_ps(&pMatrices[i + 2].m[0][0] + 4);
+		__m128 m32 = _mm_loadu_ps(&pMatrices[i + 3].m[0][0] + 4);
+		_MM_TRANSPOSE4_PS(m22, m23, m31, m32);
+
+		const __m128 m33 = _mm_setr_ps(pMatrices[i + 0].m33, pMatrices[i + 1].m33, pMatrices[i + 2].m33, pMatrices[i + 3].m33);
+
+		// Same as Quaternion::SetFromMatrix, but instead of branching on the biggest component,
+		// we compute it in every lane and select the results.
+		const __m128 fourWSquaredMinus1 = _mm_add_ps(_mm_add_ps(m11, m22), m33);
+		const __m128 fourXSquaredMinus1 = _mm_sub_ps(_mm_sub_ps(m11, m22), m33);
+		const __m128 fourYSquaredMinus1 = _mm_sub_ps(_mm_sub_ps(m22, m11), m33);
+		const __m128 fourZSquaredMinus1 = _mm_sub_ps(_mm_sub_ps(m33, m11), m22);
+
+		__m128 fourBiggestSquaredMinus1 = fourWSquaredMinus1;
+		const __m128 isX = _mm_cmpgt_ps(fourXSquaredMinus1, fourBiggestSquaredMinus1);
+		fourBiggestSquaredMinus1 = SIMD::Select(isX, fourXSquaredMinus1, fourBiggestSquaredMinus1);
+		const __m128 isY = _mm_cmpgt_ps(fourYSquaredMinus1, fourBiggestSquaredMinus1);
+		fourBiggestSquaredMinus1 = SIMD::Select(isY, fourYSquaredMinus1, fourBiggestSquaredMinus1);
+		const __m128 isZ = _mm_cmpgt_ps(fourZSquaredMinus1, fourBiggestSquaredMinus1);
+		fourBiggestSquaredMinus1 = SIMD::Select(isZ, fourZSquaredMinus1, fourBiggestSquaredMinus1);
+
+		const __m128 biggestVal = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(fourBiggestSquaredMinus1, one)), _mm_set1_ps(0.5f));
+		const __m128 mult = _mm_div_ps(_mm_set1_ps(0.25f), biggestVal);
+
+		const __m128 d23 = _mm_mul_ps(_mm_sub_ps(m23, m32), mult);
+		const __m128 d31 = _mm_mul_ps(_mm_sub_ps(m31, m13), mult);
+		const __m128 d12 = _mm_mul_ps(_mm_sub_ps(m12, m21), mult);
+		const __m128 s12 = _mm_mul_ps(_mm_add_ps(m12, m21), mult);
+		const __m128 s31 = _mm_mul_ps(_mm_add_ps(m31, m13), mult);
+		const __m128 s23 = _mm_mul_ps(_mm_add_ps(m23, m32), mult);
+
+		// Later comparisons take precedence, as in the scalar version
+		using SIMD::Select;
+		Quat4 q;
+		q.w = Select(isZ, d12, Select(isY, d31, Select(isX, d23, biggestVal)));
+		q.x = Select(isZ, s31, Select(isY, s12, Select(isX, biggestVal, d23)));
+		q.y = Select(isZ, s23, Select(isY, biggestVal, Select(isX, s12, d31)));
+		q.z = Select(isZ, biggestVal, Select(isY, s23, Select(isX, s31, d12)));
+
+		StoreQuat4(pOut + i, q);
+	}
+#endif
+	for ( ; i < count; ++i)
+	{
+		pOut[i].SetFromMatrix(pMatrices[i]);
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef _GS_QUATERNION_BATCH_H_
+#define _GS_QUATERNION_BATCH_H_
+
+// Batched versions of Quaternion operations, for when many quaternions must be processed at
+// once (i.e. animation sampling, interpolating network state of many ships). These process
+// 4 quaternions per iteration using SIMD when available (see SIMD.h), with a scalar path for
+// the remainder. Output arrays may alias input arrays.
+
+#include "gs/Base/Base.h"
+#include <cstddef>
+
+class Quaternion;
+class Matrix43;
+class Vector3;
+
+// Normalizes count quaternions in place
+void NormalizeArray(Quaternion* pQuats, size_t count);
+
+// Normalized linear interpolation along the shortest path: cheap, but angular velocity is not
+// constant across t (error grows with the angle between the quaternions).
+void NlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, const float32* pT, Quaternion* pOut, size_t count);
+void NlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, float32 t, Quaternion* pOut, size_t count);
+
+// Nlerp with the interpolation factor corrected by a polynomial fit so that results are very
+// close to Slerp (max error ~1e-3 radians) at nearly the cost of Nlerp. Use this instead of
+// SlerpArray unless exact constant angular velocity is required.
+void FastSlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, const float32* pT, Quaternion* pOut, size_t count);
+void FastSlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, float32 t, Quaternion* pOut, size_t count);
+
+// Spherical linear interpolation along the shortest path (same results as Slerp)
+void SlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, const float32* pT, Quaternion* pOut, size_t count);
+void SlerpArray(const Quaternion* pQ1, const Quaternion* pQ2, float32 t, Quaternion* pOut, size_t count);
+
+// Equivalent to calling Matrix43::SetFromQuaternion on each element. If pTranslations is
+// nullptr, translations are set to zero.
+void QuaternionsToMatrices(const Quaternion* pQuats, const Vector3* pTranslations, Matrix43* pOut, size_t count);
+
+// Equivalent to calling Quaternion::SetFromMatrix on each element. Input matrices must have
+// orthonormal rotation parts.
+void MatricesToQuaternions(const Matrix43* pMatrices, Quaternion* pOut, size_t count);
+
+#endif // _GS_QUATERNION_BATCH_H_
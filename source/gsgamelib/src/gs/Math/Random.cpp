@@ -0,0 +1,284 @@
+#include "Random.h"
+#include "SIMD.h"
+#include <atomic>
+
+namespace
+{
+	const uint64 kPcgMultiplier = 6364136223846793005ULL;
+
+	std::atomic<uint64> g_nextThreadStream(0);
+
+	struct ThreadRandomInstance
+	{
+		ThreadRandomInstance() : rng(Random::kDefaultSeed, g_nextThreadStream++) {}
+		Random rng;
+	};
+
+	ThreadRandomInstance& GetThreadRandomInstance()
+	{
+		static thread_local ThreadRandomInstance instance;
+		return instance;
+	}
+}
+
+void Random::Seed(uint64 seed, uint64 stream)
+{
+	// Same initialization as the reference pcg32_srandom_r so sequences match other implementations
+	m_state = 0;
+	m_inc = (stream << 1u) | 1u;
+	NextUInt32();
+	m_state += seed;
+	NextUInt32();
+}
+
+Random Random::Split(uint64 stream)
+{
+	const uint64 high = NextUInt32();
+	const uint64 low = NextUInt32();
+	return Random((high << 32) | low, stream);
+}
+
+void Random::Advance(uint64 delta)
+{
+	// Computes the affine transform of delta steps by repeated squaring (Brown, "Random Number
+	// Generation with Arbitrary Stride")
+	uint64 curMult = kPcgMultiplier;
+	uint64 curPlus = m_inc;
+	uint64 accMult = 1u;
+	uint64 accPlus = 0u;
+	while (delta > 0)
+	{
+		if (delta & 1)
+		{
+			accMult *= curMult;
+			accPlus = accPlus * curMult + curPlus;
+		}
+		curPlus = (curMult + 1) * curPlus;
+		curMult *= curMult;
+		delta >>= 1;
+	}
+	m_state = accMult * m_state + accPlus;
+}
+
+Vector3 Random::UnitVector()
+{
+	// Marsaglia's method: avoids trig functions, whose results may differ between platforms
+	float32 u, v, s;
+	do
+	{
+		u = Float(-1.f, 1.f);
+		v = Float(-1.f, 1.f);
+		s = u*u + v*v;
+	} while (s >= 1.f || s == 0.f);
+
+	const float32 k = 2.f * MathEx::Sqrt(1.f - s);
+	return Vector3(u * k, v * k, 1.f - 2.f * s);
+}
+
+Vector3 Random::InUnitSphere()
+{
+	Vector3 v;
+	do
+	{
+		v.x = Float(-1.f, 1.f);
+		v.y = Float(-1.f, 1.f);
+		v.z = Float(-1.f, 1.f);
+	} while (v.LengthSquared() >= 1.f);
+	return v;
+}
+
+Random& ThreadRandom()
+{
+	return GetThreadRandomInstance().rng;
+}
+
+void SeedThreadRandom(uint64 seed, uint64 stream)
+{
+	GetThreadRandomInstance().rng.Seed(seed, stream);
+}
+
+namespace MathEx
+{
+	namespace Internal
+	{
+		float64 ThreadRandFloat01()
+		{
+			return ThreadRandom().Float64_01();
+		}
+
+		int32 ThreadRandInt(int32 min, int32 max)
+		{
+			return ThreadRandom().Int(min, max);
+		}
+	}
+}
+
+// Bulk fill functions use 4 interleaved xoshiro128** generators (http://prng.di.unimi.it),
+// which only need 32-bit shifts, adds and xors so all 4 lanes run in one SSE register.
+// The scalar path runs the same 4 lanes one after the other so results are identical.
+
+namespace
+{
+	const size_t kNumLanes = 4;
+
+	struct Xoshiro4State
+	{
+		uint32 s[4][kNumLanes]; // s[word][lane]
+	};
+
+	void SeedXoshiro4(Random& rng, Xoshiro4State& state)
+	{
+		for (size_t lane = 0; lane < kNumLanes; ++lane)
+		{
+			for (size_t word = 0; word < 4; ++word)
+				state.s[word][lane] = rng.NextUInt32();
+
+			// All-zero is the only invalid state
+			if ((state.s[0][lane] | state.s[1][lane] | state.s[2][lane] | state.s[3][lane]) == 0)
+				state.s[0][lane] = 1;
+		}
+	}
+
+	inline uint32 RotL(uint32 x, int k)
+	{
+		return (x << k) | (x >> (32 - k));
+	}
+
+	inline void NextXoshiro4Scalar(Xoshiro4State& state, uint32 (&result)[kNumLanes])
+	{
+		for (size_t lane = 0; lane < kNumLanes; ++lane)
+		{
+			uint32& s0 = state.s[0][lane];
+			uint32& s1 = state.s[1][lane];
+			uint32& s2 = state.s[2][lane];
+			uint32& s3 = state.s[3][lane];
+
+			result[lane] = RotL(s1 * 5, 7) * 9;
+
+			const uint32 t = s1 << 9;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = RotL(s3, 11);
+		}
+	}
+
+	template <typename Output>
+	void GenerateScalar(Random& rng, size_t count, Output output)
+	{
+		Xoshiro4State state;
+		SeedXoshiro4(rng, state);
+
+		uint32 result[kNumLanes];
+		for (size_t i = 0; i < count; i += kNumLanes)
+		{
+			NextXoshiro4Scalar(state, result);
+			const size_t numValues = MathEx::Min(kNumLanes, count - i);
+			for (size_t lane = 0; lane < numValues; ++lane)
+				output(i + lane, result[lane]);
+		}
+	}
+
+	inline float32 UInt32ToFloat01(uint32 value)
+	{
+		return static_cast<float32>(value >> 8) * (1.f / 16777216.f);
+	}
+
+#if GS_SIMD_SSE
+	inline __m128i RotL4(__m128i x, int k)
+	{
+		return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+	}
+
+	struct Xoshiro4Simd
+	{
+		__m128i s0, s1, s2, s3;
+
+		explicit Xoshiro4Simd(const Xoshiro4State& state)
+		{
+			s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.s[0]));
+			s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.s[1]));
+			s2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.s[2]));
+			s3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.s[3]));
+		}
+
+		__m128i Next()
+		{
+			// x * 5 == (x << 2) + x, x * 9 == (x << 3) + x (SSE2 has no 32-bit multiply low)
+			const __m128i s1x5 = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);
+			const __m128i r = RotL4(s1x5, 7);
+			const __m128i result = _mm_add_epi32(_mm_slli_epi32(r, 3), r);
+
+			const __m128i t = _mm_slli_epi32(s1, 9);
+			s2 = _mm_xor_si128(s2, s0);
+			s3 = _mm_xor_si128(s3, s1);
+			s1 = _mm_xor_si128(s1, s2);
+			s0 = _mm_xor_si128(s0, s3);
+			s2 = _mm_xor_si128(s2, t);
+			s3 = RotL4(s3, 11);
+			return result;
+		}
+	};
+
+	inline __m128 UInt32ToFloat01(__m128i value)
+	{
+		return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(value, 8)), _mm_set1_ps(1.f / 16777216.f));
+	}
+#endif // GS_SIMD_SSE
+}
+
+void RandomFillUInt32(Random& rng, uint32* pOut, size_t count)
+{
+	assert(pOut || count == 0);
+
+#if GS_SIMD_SSE
+	Xoshiro4State state;
+	SeedXoshiro4(rng, state);
+	Xoshiro4Simd simd(state);
+
+	size_t i = 0;
+	for (; i + kNumLanes <= count; i += kNumLanes)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i), simd.Next());
+
+	if (i < count)
+	{
+		uint32 result[kNumLanes];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(result), simd.Next());
+		for (size_t lane = 0; i < count; ++i, ++lane)
+			pOut[i] = result[lane];
+	}
+#else
+	GenerateScalar(rng, count, [pOut] (size_t index, uint32 value) { pOut[index] = value; });
+#endif
+}
+
+void RandomFillFloat(Random& rng, float32* pOut, size_t count, float32 min, float32 max)
+{
+	assert(pOut || count == 0);
+	const float32 range = max - min;
+
+#if GS_SIMD_SSE
+	Xoshiro4State state;
+	SeedXoshiro4(rng, state);
+	Xoshiro4Simd simd(state);
+
+	const __m128 min4 = _mm_set1_ps(min);
+	const __m128 range4 = _mm_set1_ps(range);
+
+	size_t i = 0;
+	for (; i + kNumLanes <= count; i += kNumLanes)
+		_mm_storeu_ps(pOut + i, _mm_add_ps(min4, _mm_mul_ps(range4, UInt32ToFloat01(simd.Next()))));
+
+	if (i < count)
+	{
+		float32 result[kNumLanes];
+		_mm_storeu_ps(result, _mm_add_ps(min4, _mm_mul_ps(range4, UInt32ToFloat01(simd.Next()))));
+		for (size_t lane = 0; i < count; ++i, ++lane)
+			pOut[i] = result[lane];
+	}
+#else
+	GenerateScalar(rng, count, [pOut, min, range] (size_t index, uint32 value) { pOut[index] = min + range * UInt32ToFloat01(value); });
+#endif
+}
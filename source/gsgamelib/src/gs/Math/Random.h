@@ -0,0 +1,143 @@
+#ifndef _GS_RANDOM_H_
+#define _GS_RANDOM_H_
+
+// Random is a small, fast, deterministic pseudo-random number generator (PCG32, see
+// http://www.pcg-random.org). Unlike rand(), a given seed and stream produce the exact same
+// sequence on every platform and compiler, which is required for replays and for procedural
+// content that must match between machines. MathEx::Rand uses ThreadRandom().
+//
+// A Random object is not thread-safe; give each thread or world its own instance. Instances
+// seeded with the same seed but different stream ids produce independent sequences, which is
+// the preferred way to derive per-thread or per-system generators from a single world seed.
+// ThreadRandom() returns a lazily created generator owned by the calling thread.
+
+#include "gs/Base/Base.h"
+#include "MathEx.h"
+#include "Vector3.h"
+#include <cstddef>
+
+class Random
+{
+public:
+	static const uint64 kDefaultSeed = 0x853c49e6748fea9bULL;
+
+	Random() { Seed(kDefaultSeed); }
+	explicit Random(uint64 seed, uint64 stream = 0) { Seed(seed, stream); }
+
+	void Seed(uint64 seed, uint64 stream = 0);
+
+	// Returns a generator on a stream derived from this one's, seeded from this generator's
+	// output (advances this generator). Useful to hand out independent generators to jobs.
+	Random Split(uint64 stream);
+
+	// Moves the sequence forward (or backward for large values, modulo 2^64) by delta steps in
+	// O(log delta), i.e. to quickly jump to the n'th sample of a procedural sequence.
+	void Advance(uint64 delta);
+
+	// Uniform 32-bit value
+	uint32 NextUInt32();
+
+	// Unbiased value in [0, bound)
+	uint32 NextUInt32(uint32 bound);
+
+	// Unbiased value in [min, max]
+	int32 Int(int32 min, int32 max);
+
+	// Uniform float in [0, 1)
+	float32 Float01() { return static_cast<float32>(NextUInt32() >> 8) * (1.f / 16777216.f); }
+
+	// Uniform float in [min, max)
+	float32 Float(float32 min, float32 max) { return min + (max - min) * Float01(); }
+
+	// Uniform double in [0, 1) using 53 bits of randomness
+	float64 Float64_01();
+
+	bool Bool() { return (NextUInt32() >> 31) != 0; }
+
+	// Vector with each component uniform in [min, max)
+	Vector3 Vector(const Vector3& min, const Vector3& max);
+
+	// Uniformly distributed direction (point on the unit sphere)
+	Vector3 UnitVector();
+
+	// Uniformly distributed point inside the unit sphere
+	Vector3 InUnitSphere();
+
+	bool operator==(const Random& rhs) const { return m_state == rhs.m_state && m_inc == rhs.m_inc; }
+	bool operator!=(const Random& rhs) const { return !(*this == rhs); }
+
+private:
+	uint64 m_state;
+	uint64 m_inc; // Stream selector, always odd
+};
+
+inline uint32 Random::NextUInt32()
+{
+	const uint64 oldState = m_state;
+	m_state = oldState * 6364136223846793005ULL + m_inc;
+	const uint32 xorShifted = static_cast<uint32>(((oldState >> 18u) ^ oldState) >> 27u);
+	const uint32 rot = static_cast<uint32>(oldState >> 59u);
+	return (xorShifted >> rot) | (xorShifted << ((0u - rot) & 31));
+}
+
+inline uint32 Random::NextUInt32(uint32 bound)
+{
+	assert(bound > 0);
+
+	// Lemire's multiply-shift with rejection of the biased low range
+	uint64 m = static_cast<uint64>(NextUInt32()) * bound;
+	uint32 low = static_cast<uint32>(m);
+	if (low < bound)
+	{
+		const uint32 threshold = (0u - bound) % bound;
+		while (low < threshold)
+		{
+			m = static_cast<uint64>(NextUInt32()) * bound;
+			low = static_cast<uint32>(m);
+		}
+	}
+	return static_cast<uint32>(m >> 32);
+}
+
+inline int32 Random::Int(int32 min, int32 max)
+{
+	assert(min <= max);
+	const uint32 range = static_cast<uint32>(max) - static_cast<uint32>(min);
+	if (range == 0xFFFFFFFFu)
+		return static_cast<int32>(NextUInt32());
+	return static_cast<int32>(static_cast<uint32>(min) + NextUInt32(range + 1));
+}
+
+inline float64 Random::Float64_01()
+{
+	const uint64 high = NextUInt32();
+	const uint64 low = NextUInt32();
+	const uint64 bits = (high << 21) ^ (low >> 11);
+	return static_cast<float64>(bits) * (1.0 / 9007199254740992.0);
+}
+
+inline Vector3 Random::Vector(const Vector3& min, const Vector3& max)
+{
+	// Evaluate in a fixed order (argument evaluation order is unspecified)
+	const float32 x = Float(min.x, max.x);
+	const float32 y = Float(min.y, max.y);
+	const float32 z = Float(min.z, max.z);
+	return Vector3(x, y, z);
+}
+
+// Returns the calling thread's generator. Each thread's generator is created on first use with
+// kDefaultSeed and a stream id assigned in order of first use, so only the main thread's (the
+// first user) sequence is reproducible unless threads call SeedThreadRandom explicitly.
+Random& ThreadRandom();
+
+// Reseeds the calling thread's generator, i.e. with a world seed and the worker index as stream
+void SeedThreadRandom(uint64 seed, uint64 stream = 0);
+
+// Bulk generation for procedural content. Generates 4 values per step using SIMD when available
+// (see SIMD.h). Seeds from and advances rng, and outputs are bit-identical with or without SIMD
+// for a given rng state. Much faster than calling Random per value for large counts, but note
+// that the values differ from those that repeated calls to rng would have returned.
+void RandomFillUInt32(Random& rng, uint32* pOut, size_t count);
+void RandomFillFloat(Random& rng, float32* pOut, size_t count, float32 min = 0.f, float32 max = 1.f);
+
+#endif // _GS_RANDOM_H_
@@ -0,0 +1,61 @@
+#ifndef _GS_SIMD_H_
+#define _GS_SIMD_H_
+
+// Selects the SIMD instruction set used by batched math functions. SSE2 is assumed on
+// all x86/x64 targets we build for; other platforms fall back to scalar code paths.
+// Define GS_SIMD_DISABLE to force the scalar paths (useful to validate SIMD results).
+
+#include "gs/Base/Base.h"
+
+#if !defined(GS_SIMD_DISABLE) && (defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__))
+	#define GS_SIMD_SSE 1
+	#include <emmintrin.h>
+#else
+	#define GS_SIMD_SSE 0
+#endif
+
+// Number of floats processed per SIMD operation
+#if GS_SIMD_SSE
+const size_t kSimdWidth = 4;
+#else
+const size_t kSimdWidth = 1;
+#endif
+
+#if GS_SIMD_SSE
+namespace SIMD
+{
+	// Returns 1/sqrt(v) using the fast estimate refined with one Newton-Raphson iteration
+	inline __m128 RecipSqrt(__m128 v)
+	{
+		const __m128 y = _mm_rsqrt_ps(v);
+		const __m128 yy = _mm_mul_ps(y, y);
+		return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), y), _mm_sub_ps(_mm_set1_ps(3.f), _mm_mul_ps(v, yy)));
+	}
+
+	// Returns a ? b : c per lane, where a is a comparison mask
+	inline __m128 Select(__m128 mask, __m128 b, __m128 c)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, c));
+	}
+
+	inline __m128 Abs(__m128 v)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+	}
+
+	inline __m128 Min(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+	inline __m128 Max(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+
+	// Horizontal sum of the four lanes
+	inline float32 HorizontalAdd(__m128 v)
+	{
+		__m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(v, shuf);
+		shuf = _mm_movehl_ps(shuf, sums);
+		sums = _mm_add_ss(sums, shuf);
+		return _mm_cvtss_f32(sums);
+	}
+}
+#endif // GS_SIMD_SSE
+
+#endif // _GS_SIMD_H_
@@ -34,7 +34,7 @@ public:
 	float32 LengthSquared() const { return x*x + y*y + z*z; }
 	bool IsZero() const;
 	bool IsUnit() const;
-	bool AlmostEquals(const Vector3& rhs, float32 epsilon = kEpsilon);
+	bool AlmostEquals(const Vector3& rhs, float32 epsilon = kEpsilon) const;
 
 	float32 Dot(const Vector3& rhs) const { return (x * rhs.x + y * rhs.y + z * rhs.z); }
 	Vector3 Cross(const Vector3& rhs) const { return Vector3(y*rhs.z - z*rhs.y, z*rhs.x - x*rhs.z, x*rhs.y - y*rhs.x); }
@@ -104,7 +104,7 @@ inline bool Vector3::IsUnit() const
 	return MathEx::AlmostEquals(LengthSquared(), 1.0f);
 }
 
-inline bool Vector3::AlmostEquals(const Vector3& rhs, float32 epsilon)
+inline bool Vector3::AlmostEquals(const Vector3& rhs, float32 epsilon) const
 {
 	return MathEx::AlmostEquals(x, rhs.x, epsilon)
 		&& MathEx::AlmostEquals(y, rhs.y, epsilon)
@@ -9,8 +9,8 @@
 #endif
 
 // Include OpenGL-specific headers
-#include <gl/gl.h>
-#include <gl/glu.h>
+#include <GL/gl.h>
+#include <GL/glu.h>
 
 #ifdef WIN32
 // Link with libs
@@ -1,21 +1,89 @@
 #include "GLUtil.h"
 #include "gs/Image/ImageFuncs.h"
+#include <algorithm>
+
+namespace GLHelperInternal {
+
+void StateCache::Invalidate()
+{
+	std::fill(std::begin(capabilities), std::end(capabilities), Unknown);
+	boundTexture = Unknown;
+	blendFunc = Unknown;
+	matrixMode = Unknown;
+	bMaterialKnown = false;
+}
+
+StateCache& GetStateCache()
+{
+	// GL is only used from the thread that owns the context, so there's no need to synchronize
+	static StateCache stateCache = [] ()
+	{
+		StateCache result;
+		result.Invalidate();
+		result.numCallsMade = 0;
+		result.numCallsElided = 0;
+		return result;
+	}();
+	return stateCache;
+}
+
+} // namespace GLHelperInternal
 
 namespace GLUtil {
 
+StateCacheStats ResetStateCacheStats()
+{
+	GLHelperInternal::StateCache& stateCache = GLHelperInternal::GetStateCache();
+	StateCacheStats stats = { stateCache.numCallsMade, stateCache.numCallsElided };
+	stateCache.numCallsMade = 0;
+	stateCache.numCallsElided = 0;
+	return stats;
+}
+
 void MatrixMode(MatrixMode::Type mode, bool bLoadIdentity)
 {
-	switch (mode)
+	GLHelperInternal::StateCache& stateCache = GLHelperInternal::GetStateCache();
+	if (stateCache.Update(stateCache.matrixMode, mode))
 	{
-		case MatrixMode::ModelView:		glMatrixMode(GL_MODELVIEW); break;
-		case MatrixMode::Projection:	glMatrixMode(GL_PROJECTION); break;
-		default: assert(false && "Unexpected matrix mode");
+		switch (mode)
+		{
+			case MatrixMode::ModelView:		glMatrixMode(GL_MODELVIEW); break;
+			case MatrixMode::Projection:	glMatrixMode(GL_PROJECTION); break;
+			default: assert(false && "Unexpected matrix mode");
+		}
 	}
 
 	if (bLoadIdentity)
 		LoadIdentity();
 }
 
+void SetMaterial(const float32 ambient[4], const float32 diffuse[4], const float32 specular[4], const float32 emissive[4], float32 shininess)
+{
+	GLfloat material[GLHelperInternal::StateCache::NumMaterialValues];
+	std::copy(ambient, ambient + 4, material);
+	std::copy(diffuse, diffuse + 4, material + 4);
+	std::copy(specular, specular + 4, material + 8);
+	std::copy(emissive, emissive + 4, material + 12);
+	material[16] = shininess;
+
+	GLHelperInternal::StateCache& stateCache = GLHelperInternal::GetStateCache();
+	if (stateCache.bMaterialKnown && std::equal(std::begin(material), std::end(material), stateCache.material))
+	{
+		++stateCache.numCallsElided;
+		return;
+	}
+	std::copy(std::begin(material), std::end(material), stateCache.material);
+	stateCache.bMaterialKnown = true;
+	++stateCache.numCallsMade;
+
+	glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
+	glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
+	glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
+	glMaterialfv(GL_FRONT, GL_EMISSION, emissive);
+	glMaterialf(GL_FRONT, GL_SHININESS, shininess);
+	ASSERT_NO_GL_ERROR();
+}
+
 TextureId LoadTexture(const ImageData& imgData, Size2d<int>& texSize)
 {
 	// Make our own copy of the data because we need to manipulate it
@@ -57,16 +125,35 @@ TextureId LoadTexture(const ImageData& imgData, Size2d<int>& texSize)
 	<< "\tWasted Bytes: " << iWastedBytes << "(" << ((float32)iWastedBytes*100.0f/(float32)iTotalBytes) << "%)" << endl;
 #endif
 
-	// Finally, generate texture id and load data into it	
+	// Finally, generate texture id and load data into it
+	TextureId texId = CreateTexture(imageInfoCopy, pDataCopy.get());
+
+	// Set output texture image size and return texture id
+	texSize = imageInfoCopy.imageSize;
+	return texId;
+}
+
+TextureId LoadTexture(const ImageData& imgData)
+{
+	Size2d<int> dummy;
+	return LoadTexture(imgData, dummy);
+}
+
+TextureId CreateTexture(const ImageInfo& imageInfo, const uint8* pData)
+{
+	assert(ImageFuncs::IsPowerOf2(imageInfo.imageSize) && "Texture size must be a power of 2");
+	assert((imageInfo.iChannels == 3 || imageInfo.iChannels == 4) && "Texture must be RGB or RGBA");
+
 	GLuint uiTexId;
 	glGenTextures(1, &uiTexId);
 	TextureId texId = uiTexId;
 
 	glBindTexture(GL_TEXTURE_2D, texId);
+	GLHelperInternal::GetStateCache().boundTexture = texId;
 
-	glTexImage2D(GL_TEXTURE_2D, 0, imageInfoCopy.iChannels, imageInfoCopy.imageSize.w,
-		imageInfoCopy.imageSize.h, 0, (imageInfoCopy.iChannels==3? GL_RGB:GL_RGBA), 
-		GL_UNSIGNED_BYTE, pDataCopy.get());
+	glTexImage2D(GL_TEXTURE_2D, 0, imageInfo.iChannels, imageInfo.imageSize.w,
+		imageInfo.imageSize.h, 0, (imageInfo.iChannels==3? GL_RGB:GL_RGBA), 
+		GL_UNSIGNED_BYTE, pData);
 
 	// If we assert here, then something went wrong while loading
 	// the texture into texture memory
@@ -77,15 +164,7 @@ TextureId LoadTexture(const ImageData& imgData, Size2d<int>& texSize)
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-	// Set output texture image size and return texture id
-	texSize = imageInfoCopy.imageSize;
 	return texId;
 }
 
-TextureId LoadTexture(const ImageData& imgData)
-{
-	Size2d<int> dummy;
-	return LoadTexture(imgData, dummy);
-}
-
 } // namespace GLUtil {
\ No newline at end of file
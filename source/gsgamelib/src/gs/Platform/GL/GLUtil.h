@@ -36,6 +36,68 @@
 
 #define SET_GL_PARAM(flag, bEnable) (bEnable? glEnable(flag) : glDisable(flag)); ASSERT_NO_GL_ERROR()
 
+namespace GLHelperInternal
+{
+	// Shadow of the GL state set through GLUtil, used to skip calls that wouldn't change it. State
+	// that isn't known yet (at startup, or after InvalidateStateCache) is always set.
+	struct StateCache
+	{
+		enum { Unknown = -1 - 0x7fffffff };
+		enum { NumMaterialValues = 4 * 4 + 1 }; // Ambient, diffuse, specular, emissive and shininess
+
+		enum Capability
+		{
+			Texture2D,
+			Blend,
+			Lighting,
+			CullFace,
+			DepthTest,
+
+			NumCapabilities
+		};
+
+		void Invalidate();
+
+		// Returns true if value isn't the cached one, in which case the caller must make the GL
+		// call, and caches it
+		bool Update(int& cachedValue, int value)
+		{
+			if (cachedValue == value)
+			{
+				++numCallsElided;
+				return false;
+			}
+			cachedValue = value;
+			++numCallsMade;
+			return true;
+		}
+
+		bool UpdateCapability(Capability capability, bool bEnable) { return Update(capabilities[capability], bEnable? 1 : 0); }
+
+		int capabilities[NumCapabilities];
+		int boundTexture;
+		int blendFunc;
+		int matrixMode;
+		bool bMaterialKnown;
+		GLfloat material[NumMaterialValues];
+
+		uint32 numCallsMade;
+		uint32 numCallsElided;
+	};
+
+	StateCache& GetStateCache();
+
+	inline bool IsEnabled(StateCache::Capability capability, GLenum flag)
+	{
+		int& cachedValue = GetStateCache().capabilities[capability];
+		if (cachedValue == StateCache::Unknown)
+			cachedValue = glIsEnabled(flag) == GL_TRUE? 1 : 0;
+		return cachedValue == 1;
+	}
+}
+
+#define SET_CACHED_GL_PARAM(capability, flag, bEnable) if (GLHelperInternal::GetStateCache().UpdateCapability(GLHelperInternal::StateCache::capability, bEnable)) { SET_GL_PARAM(flag, bEnable); }
+
 
 namespace MatrixMode
 {
@@ -181,6 +243,27 @@ const TextureId INVALID_TEXTURE_ID = -1;
 
 namespace GLUtil
 {
+	///////////////////////////////
+	// State cache functions
+	///////////////////////////////
+
+	// The enabled capabilities, bound texture, blend function, matrix mode and material set through
+	// GLUtil are cached, and setting them to their current value doesn't call into GL. Code that
+	// changes them directly (or through glPopAttrib) must invalidate the cache afterwards.
+	inline void InvalidateStateCache()
+	{
+		GLHelperInternal::GetStateCache().Invalidate();
+	}
+
+	struct StateCacheStats
+	{
+		uint32 numCallsMade;	// State changes that went through to GL
+		uint32 numCallsElided;	// State changes skipped because the state was already set
+	};
+
+	// Returns the counts since the last call
+	StateCacheStats ResetStateCacheStats();
+
 	///////////////////////////////
 	// General functions
 	///////////////////////////////
@@ -216,7 +299,7 @@ namespace GLUtil
 	// Sets depth (Z) testing, specifying the depth test function and the buffer clearing value (range [0,1])
 	inline void SetDepthTesting(bool bEnable, DepthFunc::Type depthFunc = DepthFunc::LessOrEqual, float32 clearVal = 1.0f)
 	{
-		SET_GL_PARAM(GL_DEPTH_TEST, bEnable);
+		SET_CACHED_GL_PARAM(DepthTest, GL_DEPTH_TEST, bEnable);
 		if (bEnable)
 		{			
 			switch (depthFunc)
@@ -251,7 +334,7 @@ namespace GLUtil
 		ASSERT_NO_GL_ERROR();
 		
 		// Enable/disable culling and make sure to set it to back-face if enabled
-		SET_GL_PARAM(GL_CULL_FACE, cullBackFace==CullBackFace::True);
+		SET_CACHED_GL_PARAM(CullFace, GL_CULL_FACE, cullBackFace==CullBackFace::True);
 
 		if (cullBackFace == CullBackFace::True)
 		{
@@ -264,7 +347,7 @@ namespace GLUtil
 	// General matrix functions
 	///////////////////////////////
 
-	// Call to change current matrix
+	// Call to change current matrix (and load identity into it)
 	void MatrixMode(MatrixMode::Type mode, bool bLoadIdentity = true);	
 
 	// Call to load identity matrix in current matrix
@@ -397,12 +480,12 @@ namespace GLUtil
 	// Enables/disables texturing
 	inline void SetTexturing(bool bEnable)
 	{
-		SET_GL_PARAM(GL_TEXTURE_2D, bEnable);
+		SET_CACHED_GL_PARAM(Texture2D, GL_TEXTURE_2D, bEnable);
 	}
 
 	inline bool GetTexturing()
 	{
-		return glIsEnabled(GL_TEXTURE_2D) == GL_TRUE;
+		return GLHelperInternal::IsEnabled(GLHelperInternal::StateCache::Texture2D, GL_TEXTURE_2D);
 	}
 
 	// Creates a 2d texture, returning unique texture id and the texture's size in
@@ -412,17 +495,28 @@ namespace GLUtil
 	TextureId LoadTexture(const ImageData& imgData, Size2d<int>& texSize);
 	TextureId LoadTexture(const ImageData& imgData);
 
+	// Creates a 2d texture directly from RGB or RGBA pixel rows (without copying them first).
+	// The image size must be a power of two.
+	TextureId CreateTexture(const ImageInfo& imageInfo, const uint8* pData);
+
 	// Unloads the texture data for the input texture id
 	inline void FreeTexture(TextureId& rTexId)
 	{
 		unsigned int tex = rTexId;
 		glDeleteTextures(1, &tex);
+
+		// Deleting the bound texture binds the default one
+		int& boundTexture = GLHelperInternal::GetStateCache().boundTexture;
+		if (boundTexture == rTexId)
+			boundTexture = 0;
 	}
 
 	// Select/unselects the input texture
 	inline void SelectTexture(const TextureId& rTexId)
 	{
-		glBindTexture(GL_TEXTURE_2D, rTexId);
+		GLHelperInternal::StateCache& stateCache = GLHelperInternal::GetStateCache();
+		if (stateCache.Update(stateCache.boundTexture, rTexId))
+			glBindTexture(GL_TEXTURE_2D, rTexId);
 	}
 
 	// These functions are only valid for currently selected texture...
@@ -543,7 +637,7 @@ namespace GLUtil
 	// Enable/disable blending
 	inline void SetBlending(bool bEnable)
 	{
-		SET_GL_PARAM(GL_BLEND, bEnable);
+		SET_CACHED_GL_PARAM(Blend, GL_BLEND, bEnable);
 	}
 
 	// Sets blending function
@@ -558,8 +652,12 @@ namespace GLUtil
 		// If this assert is triggered, it likely means we need to update the mapping array just above		
 		static_assert(ARRAY_SIZE(blendFuncMapping) == BlendFunc::NumTypes, "Mismatched array size");
 
-		glBlendFunc(blendFuncMapping[func].srcFunc, blendFuncMapping[func].dstFunc);
-		ASSERT_NO_GL_ERROR();
+		GLHelperInternal::StateCache& stateCache = GLHelperInternal::GetStateCache();
+		if (stateCache.Update(stateCache.blendFunc, func))
+		{
+			glBlendFunc(blendFuncMapping[func].srcFunc, blendFuncMapping[func].dstFunc);
+			ASSERT_NO_GL_ERROR();
+		}
 	}
 
 	//////////////////////////////////////
@@ -568,11 +666,20 @@ namespace GLUtil
 
 	inline void SetLighting(bool bEnable)
 	{
-		SET_GL_PARAM(GL_LIGHTING, bEnable);
+		SET_CACHED_GL_PARAM(Lighting, GL_LIGHTING, bEnable);
 	}
 
+	inline bool GetLighting()
+	{
+		return GLHelperInternal::IsEnabled(GLHelperInternal::StateCache::Lighting, GL_LIGHTING);
+	}
+
+	// Sets the front face material, with RGBA colors
+	void SetMaterial(const float32 ambient[4], const float32 diffuse[4], const float32 specular[4], const float32 emissive[4], float32 shininess);
+
 } // namespace GLUtil
 
+#undef SET_CACHED_GL_PARAM
 #undef SET_GL_PARAM
 
 #endif // __GL_UTIL__
\ No newline at end of file
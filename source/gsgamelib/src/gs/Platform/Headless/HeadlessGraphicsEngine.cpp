@@ -0,0 +1,139 @@
+#include "HeadlessGraphicsEngine.h"
+#include "SoftwareGL.h"
+#include "gs/Platform/GL/GLHeaders.h"
+#include "gs/Rendering/SoftwareRasterizer.h"
+#include "gs/Image/ImageFuncs.h"
+#include "gs/System/System.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	void SaveScreenshot(const SoftwareRasterizer& rasterizer, const std::string& fileName)
+	{
+		ImageInfo imageInfo;
+		imageInfo.iChannels = 3;
+		imageInfo.imageSize.Set(rasterizer.GetWidth(), rasterizer.GetHeight());
+
+		// Both the color buffer and TGA files store rows from the bottom up
+		std::vector<UBYTE> data(imageInfo.GetDataSize());
+		UBYTE* pDst = data.data();
+		for (int y = 0; y < rasterizer.GetHeight(); ++y)
+		{
+			const uint32* pSrc = rasterizer.GetColorBuffer() + y * rasterizer.GetColorPitch();
+			for (int x = 0; x < rasterizer.GetWidth(); ++x, pDst += 3)
+			{
+				pDst[0] = static_cast<UBYTE>(pSrc[x]);
+				pDst[1] = static_cast<UBYTE>(pSrc[x] >> 8);
+				pDst[2] = static_cast<UBYTE>(pSrc[x] >> 16);
+			}
+		}
+		ImageFuncs::SaveTGA(fileName, data.data(), imageInfo);
+	}
+}
+
+HeadlessGraphicsEngine::HeadlessGraphicsEngine()
+	: m_frameIndex(0)
+	, m_maxFrames(0)
+	, m_bInputScriptQuit(false)
+	, m_lastTitlePrintTime(0.0)
+{
+}
+
+void HeadlessGraphicsEngine::Initialize(const char* title, int width, int height, int /*bpp*/, ScreenMode::Type /*screenMode*/, VertSync::Type /*vertSync*/)
+{
+	m_title = title;
+	m_frameIndex = 0;
+
+	if (const char* maxFrames = getenv("GS_HEADLESS_FRAMES"))
+		m_maxFrames = static_cast<uint32>(strtoul(maxFrames, nullptr, 10));
+
+	const char* renderer = getenv("GS_HEADLESS_RENDERER");
+	if (renderer && strcmp(renderer, "software") == 0)
+		SoftwareGL::EnableRasterizer(width, height);
+	else if (renderer && strcmp(renderer, "null") != 0)
+		throw std::invalid_argument(std::string("Unknown GS_HEADLESS_RENDERER (expected null or software): ") + renderer);
+
+	if (const char* screenshotFileName = getenv("GS_HEADLESS_SCREENSHOT"))
+		m_screenshotFileName = screenshotFileName;
+
+	// Apply the script's events for the first frame
+	if (const char* inputScriptFileName = getenv("GS_HEADLESS_INPUT"))
+	{
+		m_inputScript.Load(inputScriptFileName);
+		m_bInputScriptQuit = !m_inputScript.Update(m_frameIndex);
+	}
+
+	printf("%s: running headless at %dx%d with the %s renderer", title, width, height, SoftwareGL::GetRasterizer()? "software" : "null");
+	if (m_maxFrames > 0)
+		printf(" for %u frames", m_maxFrames);
+	printf("\n");
+
+	if (m_windowResizedCallback)
+		m_windowResizedCallback(*this, static_cast<float32>(width), static_cast<float32>(height));
+	else
+		SetActiveViewport(Viewport(0.f, 0.f, static_cast<float32>(width), static_cast<float32>(height)));
+}
+
+void HeadlessGraphicsEngine::Shutdown()
+{
+	printf("%s\n", m_title.c_str());
+	printf("Ran %u frames\n", m_frameIndex);
+
+	if (SoftwareRasterizer* pRasterizer = SoftwareGL::GetRasterizer())
+	{
+		const SoftwareRasterizer::Stats stats = pRasterizer->ResetStats();
+		const uint32 numFrames = m_frameIndex > 0? m_frameIndex : 1;
+		printf("Software renderer: %.2f ms shading per frame, %u triangles per frame (%.2f tiles per triangle)\n",
+			stats.shadeSeconds * 1000.0 / numFrames,
+			stats.numTriangles / numFrames,
+			stats.numTriangles > 0? static_cast<float64>(stats.numTileTriangles) / stats.numTriangles : 0.0);
+
+		if (!m_screenshotFileName.empty())
+		{
+			SaveScreenshot(*pRasterizer, m_screenshotFileName);
+			printf("Saved last frame to %s\n", m_screenshotFileName.c_str());
+		}
+	}
+}
+
+void HeadlessGraphicsEngine::Update(bool& bQuit)
+{
+	// Where a window would swap buffers
+	SoftwareGL::Present();
+
+	// The frame just ended, so input for the next one is applied before the game reads it
+	++m_frameIndex;
+	if (!m_bInputScriptQuit)
+		m_bInputScriptQuit = !m_inputScript.Update(m_frameIndex);
+
+	if (m_bInputScriptQuit || (m_maxFrames > 0 && m_frameIndex >= m_maxFrames))
+		bQuit = true;
+}
+
+void HeadlessGraphicsEngine::SetTitle(const char* title)
+{
+	m_title = title;
+
+	const float64 time = System::GetElapsedSeconds();
+	if (time - m_lastTitlePrintTime >= 1.0)
+	{
+		printf("%s\n", title);
+		fflush(stdout);
+		m_lastTitlePrintTime = time;
+	}
+}
+
+bool HeadlessGraphicsEngine::HasFocus() const
+{
+	// There's no window to lose focus, so never auto-pause
+	return true;
+}
+
+void HeadlessGraphicsEngine::DoSetActiveViewport(const Viewport& viewport)
+{
+	glViewport((GLint)viewport.X(), (GLint)viewport.Y(), (GLsizei)viewport.Width(), (GLsizei)viewport.Height());
+}
@@ -0,0 +1,47 @@
+#ifndef _HEADLESS_GRAPHICS_ENGINE_H_
+#define _HEADLESS_GRAPHICS_ENGINE_H_
+
+#include "gs/Rendering/GraphicsEngine.h"
+#include "InputScript.h"
+#include <string>
+
+// Graphics engine for machines without a display or GPU, such as servers and CI. It opens no
+// window, and GL calls go to SoftwareGL, so the game loop runs unchanged. By default nothing is
+// drawn; the software renderer draws frames on the CPU instead. It's configured by environment
+// variables:
+//
+//   GS_HEADLESS_FRAMES: number of frames to run before quitting (runs until quit by default)
+//   GS_HEADLESS_INPUT: input script that drives the keyboard (see InputScript)
+//   GS_HEADLESS_RENDERER: "null" (the default) to draw nothing, or "software"
+//   GS_HEADLESS_SCREENSHOT: TGA file to save the last frame to on shutdown (software renderer only)
+//
+// The window title, which games use to show stats, is printed once a second instead.
+class HeadlessGraphicsEngine : public GraphicsEngine
+{
+private:
+	friend class GraphicsEngine;
+	HeadlessGraphicsEngine();
+
+public:
+	virtual void Initialize(const char* title, int width, int height, int bpp, ScreenMode::Type screenMode, VertSync::Type vertSync) override;
+	virtual void Shutdown() override;
+	virtual void Update(bool& bQuit) override;
+	virtual void SetTitle(const char* title) override;
+	virtual bool HasFocus() const override;
+
+	uint32 GetFrameIndex() const { return m_frameIndex; }
+
+protected:
+	virtual void DoSetActiveViewport(const Viewport& viewport) override;
+
+private:
+	uint32 m_frameIndex;
+	uint32 m_maxFrames; // 0 for no limit
+	InputScript m_inputScript;
+	bool m_bInputScriptQuit;
+	std::string m_title;
+	float64 m_lastTitlePrintTime;
+	std::string m_screenshotFileName;
+};
+
+#endif // _HEADLESS_GRAPHICS_ENGINE_H_
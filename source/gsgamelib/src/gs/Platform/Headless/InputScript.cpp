@@ -0,0 +1,136 @@
+#include "InputScript.h"
+#include "gs/Base/string_helpers.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+	struct KeyName
+	{
+		const char* name;
+		VKEY vkey;
+	};
+
+	const KeyName g_keyNames[] =
+	{
+		{ "Back",			VK_BACK },
+		{ "Tab",			VK_TAB },
+		{ "Return",			VK_RETURN },
+		{ "Shift",			VK_SHIFT },
+		{ "Control",		VK_CONTROL },
+		{ "Alt",			VK_MENU },
+		{ "Pause",			VK_PAUSE },
+		{ "Escape",			VK_ESCAPE },
+		{ "Space",			VK_SPACE },
+		{ "PageUp",			VK_PRIOR },
+		{ "PageDown",		VK_NEXT },
+		{ "End",			VK_END },
+		{ "Home",			VK_HOME },
+		{ "Left",			VK_LEFT },
+		{ "Up",				VK_UP },
+		{ "Right",			VK_RIGHT },
+		{ "Down",			VK_DOWN },
+		{ "Insert",			VK_INSERT },
+		{ "Delete",			VK_DELETE },
+		{ "F1",				VK_F1 },
+		{ "F2",				VK_F2 },
+		{ "F3",				VK_F3 },
+		{ "F4",				VK_F4 },
+		{ "F5",				VK_F5 },
+		{ "F6",				VK_F6 },
+		{ "F7",				VK_F7 },
+		{ "F8",				VK_F8 },
+		{ "F9",				VK_F9 },
+		{ "F10",			VK_F10 },
+		{ "F11",			VK_F11 },
+		{ "F12",			VK_F12 },
+		{ "Plus",			VK_OEM_PLUS },
+		{ "Comma",			VK_OEM_COMMA },
+		{ "Minus",			VK_OEM_MINUS },
+		{ "Period",			VK_OEM_PERIOD },
+		{ "LeftBracket",	VK_OEM_4 },
+		{ "RightBracket",	VK_OEM_6 },
+	};
+
+	bool ParseKey(const std::string& key, VKEY& vkey)
+	{
+		// Letters and digits are their upper case ascii value
+		if (key.size() == 1 && isalnum(static_cast<unsigned char>(key[0])))
+		{
+			vkey = static_cast<VKEY>(toupper(static_cast<unsigned char>(key[0])));
+			return true;
+		}
+
+		for (const KeyName& keyName : g_keyNames)
+		{
+			if (str_compare_no_case(key, keyName.name) == 0)
+			{
+				vkey = keyName.vkey;
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+void InputScript::Load(const char* fileName)
+{
+	std::ifstream file(fileName);
+	if (!file)
+		throw std::runtime_error(str_format("Failed to open input script: %s", fileName));
+
+	m_events.clear();
+	m_nextEvent = 0;
+
+	std::string line;
+	for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+	{
+		str_trim(line, " \t\r");
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream lineStream(line);
+		Event event;
+		std::string action, key;
+		lineStream >> event.frameIndex >> action;
+
+		bool bValid = !lineStream.fail();
+		if (bValid && action == "quit")
+		{
+			event.type = Event::Quit;
+			event.vkey = 0;
+		}
+		else if (bValid && (action == "down" || action == "up"))
+		{
+			event.type = action == "down"? Event::KeyDown : Event::KeyUp;
+			bValid = static_cast<bool>(lineStream >> key) && ParseKey(key, event.vkey);
+		}
+		else
+		{
+			bValid = false;
+		}
+
+		if (!bValid)
+			throw std::runtime_error(str_format("%s(%d): expected '<frame> down <key>', '<frame> up <key>' or '<frame> quit'", fileName, lineNumber));
+
+		m_events.push_back(event);
+	}
+
+	std::stable_sort(m_events.begin(), m_events.end(), [] (const Event& lhs, const Event& rhs) { return lhs.frameIndex < rhs.frameIndex; });
+}
+
+bool InputScript::Update(uint32 frameIndex)
+{
+	for ( ; m_nextEvent < m_events.size() && m_events[m_nextEvent].frameIndex <= frameIndex; ++m_nextEvent)
+	{
+		const Event& event = m_events[m_nextEvent];
+		if (event.type == Event::Quit)
+			return false;
+
+		System::SetVKeyDown(event.vkey, event.type == Event::KeyDown);
+	}
+	return true;
+}
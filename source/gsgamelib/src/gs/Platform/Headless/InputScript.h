@@ -0,0 +1,42 @@
+#ifndef _INPUT_SCRIPT_H_
+#define _INPUT_SCRIPT_H_
+
+#include "gs/System/System.h"
+#include <vector>
+
+// Key presses and releases read from a text file, to drive the game without a keyboard. Each line
+// is one of:
+//
+//   <frame> down <key>
+//   <frame> up <key>
+//   <frame> quit
+//
+// where frames count from 0, and key is a letter, a digit, or a key name from InputScript.cpp
+// (e.g. Control, F4, Left, PageUp). Empty lines and lines starting with # are ignored.
+class InputScript
+{
+public:
+	InputScript() : m_nextEvent(0) {}
+
+	// Throws std::runtime_error if the file can't be read or a line can't be parsed
+	void Load(const char* fileName);
+
+	// Applies the events of frames up to frameIndex to the System's key state. Returns false once
+	// the script has quit.
+	bool Update(uint32 frameIndex);
+
+private:
+	struct Event
+	{
+		enum Type { KeyDown, KeyUp, Quit };
+
+		uint32 frameIndex;
+		Type type;
+		VKEY vkey;
+	};
+
+	std::vector<Event> m_events; // Sorted by frame
+	size_t m_nextEvent;
+};
+
+#endif // _INPUT_SCRIPT_H_
@@ -0,0 +1,1208 @@
+#include "SoftwareGL.h"
+#include "gs/Platform/GL/GLHeaders.h"
+#include "gs/Rendering/SoftwareRasterizer.h"
+#include "gs/Math/MathEx.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace
+{
+	const int kMaxLights = 8;
+
+	// Column major, like GL
+	struct Matrix44
+	{
+		GLfloat m[16];
+
+		static Matrix44 Identity()
+		{
+			Matrix44 result;
+			for (int i = 0; i < 16; ++i)
+				result.m[i] = (i % 5 == 0)? 1.f : 0.f;
+			return result;
+		}
+
+		Matrix44 operator*(const Matrix44& rhs) const
+		{
+			Matrix44 result;
+			for (int col = 0; col < 4; ++col)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					GLfloat sum = 0.f;
+					for (int i = 0; i < 4; ++i)
+						sum += m[i * 4 + row] * rhs.m[col * 4 + i];
+					result.m[col * 4 + row] = sum;
+				}
+			}
+			return result;
+		}
+
+		void Transform(const GLfloat in[4], GLfloat out[4]) const
+		{
+			for (int row = 0; row < 4; ++row)
+				out[row] = m[row] * in[0] + m[4 + row] * in[1] + m[8 + row] * in[2] + m[12 + row] * in[3];
+		}
+
+		// Returns the inverse transpose of the upper 3x3, which transforms normals, as a column
+		// major 3x3
+		void GetNormalMatrix(GLfloat out[9]) const
+		{
+			// Cofactors of the upper 3x3 are the inverse transpose scaled by the determinant, which
+			// doesn't matter since normals are normalized after
+			const GLfloat a = m[0], b = m[4], c = m[8];
+			const GLfloat d = m[1], e = m[5], f = m[9];
+			const GLfloat g = m[2], h = m[6], i = m[10];
+			out[0] = e * i - f * h;	out[3] = f * g - d * i;	out[6] = d * h - e * g;
+			out[1] = c * h - b * i;	out[4] = a * i - c * g;	out[7] = b * g - a * h;
+			out[2] = b * f - c * e;	out[5] = c * d - a * f;	out[8] = a * e - b * d;
+
+			const GLfloat determinant = a * out[0] + b * out[3] + c * out[6];
+			if (determinant < 0.f)
+			{
+				for (int j = 0; j < 9; ++j)
+					out[j] = -out[j];
+			}
+		}
+	};
+
+	struct Light
+	{
+		GLfloat ambient[4];
+		GLfloat diffuse[4];
+		GLfloat specular[4];
+		GLfloat position[4]; // In eye space
+	};
+
+	struct Material
+	{
+		GLfloat ambient[4];
+		GLfloat diffuse[4];
+		GLfloat specular[4];
+		GLfloat emission[4];
+		GLfloat shininess;
+	};
+
+	struct TextureObject
+	{
+		TextureObject() : width(0), height(0), bLinearFilter(true), bClampS(false), bClampT(false) {}
+
+		GLsizei width, height; // Tracked even when the texels aren't
+		SoftwareRasterizer::TexturePtr pTexture;
+		bool bLinearFilter;
+		bool bClampS, bClampT;
+	};
+
+	struct ArrayPointer
+	{
+		ArrayPointer() : bEnabled(false), size(4), type(GL_FLOAT), stride(0), pointer(nullptr) {}
+
+		// Reads element i's size components into pComponents, or returns false if the array is
+		// disabled. Unsigned byte components are normalized to [0, 1].
+		bool Read(size_t i, GLfloat* pComponents) const
+		{
+			if (!bEnabled)
+				return false;
+
+			const GLsizei componentSize = type == GL_UNSIGNED_BYTE? sizeof(GLubyte) : sizeof(GLfloat);
+			const GLsizei elementStride = stride != 0? stride : size * componentSize;
+			const uint8* pElement = static_cast<const uint8*>(pointer) + i * elementStride;
+			if (type == GL_UNSIGNED_BYTE)
+			{
+				for (GLint c = 0; c < size; ++c)
+					pComponents[c] = pElement[c] * (1.f / 255.f);
+			}
+			else
+			{
+				memcpy(pComponents, pElement, size * sizeof(GLfloat));
+			}
+			return true;
+		}
+
+		bool bEnabled;
+		GLint size;
+		GLenum type;
+		GLsizei stride;
+		const GLvoid* pointer;
+	};
+
+	struct ClientArrays
+	{
+		ArrayPointer vertex, normal, color, texCoord;
+	};
+
+	struct ImmediateVertex
+	{
+		GLfloat position[4];
+		GLfloat normal[3];
+		GLfloat color[4];
+		GLfloat texCoord[2];
+	};
+
+	// Vertex after transform and lighting, in clip space
+	struct ClipVertex
+	{
+		GLfloat position[4];
+		GLfloat color[4];
+		GLfloat texCoord[2];
+	};
+
+	ClipVertex Lerp(const ClipVertex& v0, const ClipVertex& v1, GLfloat t)
+	{
+		ClipVertex result;
+		for (int i = 0; i < 4; ++i)
+		{
+			result.position[i] = v0.position[i] + (v1.position[i] - v0.position[i]) * t;
+			result.color[i] = v0.color[i] + (v1.color[i] - v0.color[i]) * t;
+		}
+		for (int i = 0; i < 2; ++i)
+			result.texCoord[i] = v0.texCoord[i] + (v1.texCoord[i] - v0.texCoord[i]) * t;
+		return result;
+	}
+
+	// Signed distance to each clip plane (-w <= x, y, z <= w), positive inside
+	GLfloat ClipDistance(const ClipVertex& v, int plane)
+	{
+		const GLfloat coord = v.position[plane / 2];
+		const GLfloat w = v.position[3];
+		return (plane & 1)? w - coord : w + coord;
+	}
+
+	uint32 OutCode(const ClipVertex& v)
+	{
+		uint32 outCode = 0;
+		for (int plane = 0; plane < 6; ++plane)
+		{
+			if (ClipDistance(v, plane) < 0.f)
+				outCode |= 1 << plane;
+		}
+		return outCode;
+	}
+
+	void SetColor(GLfloat color[4], GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+	{
+		color[0] = r; color[1] = g; color[2] = b; color[3] = a;
+	}
+
+	struct State
+	{
+		State();
+
+		// Null unless draws are rendered; the state below is tracked either way
+		std::unique_ptr<SoftwareRasterizer> pRasterizer;
+
+		std::set<GLenum> enabledCaps;
+		GLenum matrixMode;
+		std::vector<Matrix44> modelViewStack;
+		std::vector<Matrix44> projectionStack;
+		GLint viewport[4];
+
+		GLfloat currentColor[4];
+		GLfloat currentNormal[3];
+		GLfloat currentTexCoord[2];
+		GLfloat clearColor[4];
+		GLfloat clearDepth;
+
+		GLenum frontFace;
+		GLenum cullFace;
+		GLenum polygonMode;
+		GLenum shadeModel;
+		GLenum blendSrc, blendDst;
+		bool bDepthMask;
+		GLfloat pointSize;
+		GLfloat lineWidth;
+
+		Light lights[kMaxLights];
+		GLfloat lightModelAmbient[4];
+		Material material;
+
+		std::map<GLuint, TextureObject> textures;
+		GLuint nextTextureName;
+		GLuint boundTexture;
+
+		ClientArrays arrays;
+		std::vector<ClientArrays> clientAttribStack;
+
+		GLenum beginMode;
+		std::vector<ImmediateVertex> immediateVertices;
+
+		// Per draw scratch buffers
+		std::vector<ClipVertex> clipVertices;
+		std::vector<uint32> indices;
+
+		bool IsEnabled(GLenum cap) const { return enabledCaps.count(cap) != 0; }
+		std::vector<Matrix44>& CurrentStack() { return matrixMode == GL_PROJECTION? projectionStack : modelViewStack; }
+		Matrix44& CurrentMatrix() { return CurrentStack().back(); }
+	};
+
+	State::State()
+		: matrixMode(GL_MODELVIEW)
+		, clearDepth(1.f)
+		, frontFace(GL_CCW)
+		, cullFace(GL_BACK)
+		, polygonMode(GL_FILL)
+		, shadeModel(GL_SMOOTH)
+		, blendSrc(GL_ONE)
+		, blendDst(GL_ZERO)
+		, bDepthMask(true)
+		, pointSize(1.f)
+		, lineWidth(1.f)
+		, nextTextureName(1)
+		, boundTexture(0)
+		, beginMode(GL_POINTS)
+	{
+		modelViewStack.push_back(Matrix44::Identity());
+		projectionStack.push_back(Matrix44::Identity());
+		std::fill(std::begin(viewport), std::end(viewport), 0);
+
+		SetColor(currentColor, 1.f, 1.f, 1.f, 1.f);
+		currentNormal[0] = 0.f; currentNormal[1] = 0.f; currentNormal[2] = 1.f;
+		currentTexCoord[0] = 0.f; currentTexCoord[1] = 0.f;
+		SetColor(clearColor, 0.f, 0.f, 0.f, 0.f);
+
+		// GL defaults: only light 0 has diffuse and specular colors
+		for (int i = 0; i < kMaxLights; ++i)
+		{
+			Light& light = lights[i];
+			const GLfloat color = i == 0? 1.f : 0.f;
+			SetColor(light.ambient, 0.f, 0.f, 0.f, 1.f);
+			SetColor(light.diffuse, color, color, color, 1.f);
+			SetColor(light.specular, color, color, color, 1.f);
+			SetColor(light.position, 0.f, 0.f, 1.f, 0.f);
+		}
+		SetColor(lightModelAmbient, 0.2f, 0.2f, 0.2f, 1.f);
+
+		SetColor(material.ambient, 0.2f, 0.2f, 0.2f, 1.f);
+		SetColor(material.diffuse, 0.8f, 0.8f, 0.8f, 1.f);
+		SetColor(material.specular, 0.f, 0.f, 0.f, 1.f);
+		SetColor(material.emission, 0.f, 0.f, 0.f, 1.f);
+		material.shininess = 0.f;
+	}
+
+	// GL is only used from the thread that owns the context, so there's no need to synchronize
+	State g_state;
+
+	BlendFactor::Type ToBlendFactor(GLenum factor)
+	{
+		switch (factor)
+		{
+			case GL_ZERO:					return BlendFactor::Zero;
+			case GL_ONE:					return BlendFactor::One;
+			case GL_SRC_ALPHA:				return BlendFactor::SrcAlpha;
+			case GL_ONE_MINUS_SRC_ALPHA:	return BlendFactor::OneMinusSrcAlpha;
+		}
+		assert(false && "Unsupported blend factor");
+		return BlendFactor::One;
+	}
+
+	void Normalize(GLfloat v[3])
+	{
+		const GLfloat lengthSquared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+		if (lengthSquared > 0.f)
+		{
+			const GLfloat invLength = 1.f / std::sqrt(lengthSquared);
+			v[0] *= invLength; v[1] *= invLength; v[2] *= invLength;
+		}
+	}
+
+	GLfloat Dot(const GLfloat a[3], const GLfloat b[3])
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// Transforms and lights the vertices of one draw
+	class VertexProcessor
+	{
+	public:
+		VertexProcessor()
+		{
+			const State& state = g_state;
+			const Matrix44& modelView = state.modelViewStack.back();
+			m_modelView = modelView;
+			m_modelViewProjection = state.projectionStack.back() * modelView;
+
+			m_bLighting = state.IsEnabled(GL_LIGHTING);
+			if (!m_bLighting)
+				return;
+
+			modelView.GetNormalMatrix(m_normalMatrix);
+			for (int i = 0; i < kMaxLights; ++i)
+			{
+				if (state.IsEnabled(GL_LIGHT0 + i))
+					m_lights.push_back(&state.lights[i]);
+			}
+			m_bColorMaterial = state.IsEnabled(GL_COLOR_MATERIAL);
+		}
+
+		ClipVertex Process(const GLfloat position[4], const GLfloat normal[3], const GLfloat color[4], const GLfloat texCoord[2]) const
+		{
+			ClipVertex result;
+			m_modelViewProjection.Transform(position, result.position);
+			result.texCoord[0] = texCoord[0];
+			result.texCoord[1] = texCoord[1];
+
+			if (m_bLighting)
+				ComputeLighting(position, normal, color, result.color);
+			else
+				std::copy(color, color + 4, result.color);
+			return result;
+		}
+
+	private:
+		void ComputeLighting(const GLfloat position[4], const GLfloat normal[3], const GLfloat color[4], GLfloat result[4]) const
+		{
+			const Material& material = g_state.material;
+
+			// With color material, the vertex color replaces the ambient and diffuse material colors
+			const GLfloat* ambient = m_bColorMaterial? color : material.ambient;
+			const GLfloat* diffuse = m_bColorMaterial? color : material.diffuse;
+
+			GLfloat eyeNormal[3];
+			for (int row = 0; row < 3; ++row)
+				eyeNormal[row] = m_normalMatrix[row] * normal[0] + m_normalMatrix[3 + row] * normal[1] + m_normalMatrix[6 + row] * normal[2];
+			Normalize(eyeNormal);
+
+			GLfloat eyePosition[4];
+			bool bEyePositionKnown = false;
+
+			for (int i = 0; i < 3; ++i)
+				result[i] = material.emission[i] + ambient[i] * g_state.lightModelAmbient[i];
+
+			for (const Light* pLight : m_lights)
+			{
+				// Directional lights have w = 0; there's no attenuation, like GL's defaults
+				GLfloat toLight[3] = { pLight->position[0], pLight->position[1], pLight->position[2] };
+				if (pLight->position[3] != 0.f)
+				{
+					if (!bEyePositionKnown)
+					{
+						m_modelView.Transform(position, eyePosition);
+						bEyePositionKnown = true;
+					}
+					for (int j = 0; j < 3; ++j)
+						toLight[j] = pLight->position[j] / pLight->position[3] - eyePosition[j];
+				}
+				Normalize(toLight);
+
+				const GLfloat diffuseAmount = MathEx::Max(Dot(eyeNormal, toLight), 0.f);
+				GLfloat specularAmount = 0.f;
+				if (diffuseAmount > 0.f)
+				{
+					// The viewer is infinitely far along +z, like GL's default
+					GLfloat halfVector[3] = { toLight[0], toLight[1], toLight[2] + 1.f };
+					Normalize(halfVector);
+					specularAmount = std::pow(MathEx::Max(Dot(eyeNormal, halfVector), 0.f), material.shininess);
+				}
+
+				for (int j = 0; j < 3; ++j)
+				{
+					result[j] += ambient[j] * pLight->ambient[j]
+						+ diffuseAmount * diffuse[j] * pLight->diffuse[j]
+						+ specularAmount * material.specular[j] * pLight->specular[j];
+				}
+			}
+
+			for (int i = 0; i < 3; ++i)
+				result[i] = MathEx::Clamp(result[i], 0.f, 1.f);
+			result[3] = MathEx::Clamp(diffuse[3], 0.f, 1.f);
+		}
+
+		Matrix44 m_modelView;
+		Matrix44 m_modelViewProjection;
+		bool m_bLighting;
+		bool m_bColorMaterial;
+		GLfloat m_normalMatrix[9];
+		std::vector<const Light*> m_lights;
+	};
+
+	SoftwareRasterizer::Vertex ToWindow(const ClipVertex& v)
+	{
+		const GLint* viewport = g_state.viewport;
+		const GLfloat invW = 1.f / v.position[3];
+
+		SoftwareRasterizer::Vertex result;
+		result.x = viewport[0] + (v.position[0] * invW + 1.f) * 0.5f * viewport[2];
+		result.y = viewport[1] + (v.position[1] * invW + 1.f) * 0.5f * viewport[3];
+		result.z = (v.position[2] * invW + 1.f) * 0.5f;
+		result.invW = invW;
+		result.r = v.color[0];
+		result.g = v.color[1];
+		result.b = v.color[2];
+		result.a = v.color[3];
+		result.u = v.texCoord[0];
+		result.v = v.texCoord[1];
+		return result;
+	}
+
+	// Sets the rasterizer state for the draw about to be made
+	void ApplyDrawState()
+	{
+		const State& state = g_state;
+		SoftwareRasterizer::DrawState drawState;
+
+		if (state.IsEnabled(GL_TEXTURE_2D))
+		{
+			const auto iter = state.textures.find(state.boundTexture);
+			if (iter != state.textures.end() && iter->second.pTexture)
+			{
+				const TextureObject& texture = iter->second;
+				drawState.pTexture = texture.pTexture;
+				drawState.bLinearFilter = texture.bLinearFilter;
+				drawState.bClampS = texture.bClampS;
+				drawState.bClampT = texture.bClampT;
+			}
+		}
+
+		// Only GL_LEQUAL is supported, which is what GLUtil::SetDepthTesting sets
+		drawState.bDepthTest = state.IsEnabled(GL_DEPTH_TEST);
+		drawState.bDepthWrite = state.bDepthMask && drawState.bDepthTest;
+		drawState.bBlend = state.IsEnabled(GL_BLEND);
+		drawState.srcFactor = ToBlendFactor(state.blendSrc);
+		drawState.dstFactor = ToBlendFactor(state.blendDst);
+
+		state.pRasterizer->SetDrawState(drawState);
+	}
+
+	void DrawLine(const ClipVertex& v0In, const ClipVertex& v1In)
+	{
+		// Clip the segment to each plane
+		GLfloat tMin = 0.f, tMax = 1.f;
+		for (int plane = 0; plane < 6; ++plane)
+		{
+			const GLfloat d0 = ClipDistance(v0In, plane);
+			const GLfloat d1 = ClipDistance(v1In, plane);
+			if (d0 < 0.f && d1 < 0.f)
+				return;
+			if (d0 < 0.f)
+				tMin = MathEx::Max(tMin, d0 / (d0 - d1));
+			else if (d1 < 0.f)
+				tMax = MathEx::Min(tMax, d0 / (d0 - d1));
+		}
+		if (tMin > tMax)
+			return;
+
+		const SoftwareRasterizer::Vertex v0 = ToWindow(tMin > 0.f? Lerp(v0In, v1In, tMin) : v0In);
+		const SoftwareRasterizer::Vertex v1 = ToWindow(tMax < 1.f? Lerp(v0In, v1In, tMax) : v1In);
+
+		// Draw as a quad as wide as the line
+		const GLfloat dx = v1.x - v0.x;
+		const GLfloat dy = v1.y - v0.y;
+		const GLfloat length = std::sqrt(dx * dx + dy * dy);
+		if (!(length > 0.f))
+			return;
+		const GLfloat halfWidth = MathEx::Max(g_state.lineWidth, 1.f) * 0.5f;
+		const GLfloat offsetX = -dy / length * halfWidth;
+		const GLfloat offsetY = dx / length * halfWidth;
+
+		SoftwareRasterizer::Vertex corners[4] = { v0, v1, v1, v0 };
+		corners[0].x += offsetX; corners[0].y += offsetY;
+		corners[1].x += offsetX; corners[1].y += offsetY;
+		corners[2].x -= offsetX; corners[2].y -= offsetY;
+		corners[3].x -= offsetX; corners[3].y -= offsetY;
+
+		// Keep the quad in the framebuffer, which the rasterizer expects
+		const SoftwareRasterizer& rasterizer = *g_state.pRasterizer;
+		for (auto& corner : corners)
+		{
+			corner.x = MathEx::Clamp(corner.x, 0.f, static_cast<GLfloat>(rasterizer.GetWidth()));
+			corner.y = MathEx::Clamp(corner.y, 0.f, static_cast<GLfloat>(rasterizer.GetHeight()));
+		}
+
+		g_state.pRasterizer->DrawTriangle(corners[0], corners[1], corners[2]);
+		g_state.pRasterizer->DrawTriangle(corners[0], corners[2], corners[3]);
+	}
+
+	void DrawPoint(const ClipVertex& v)
+	{
+		if (OutCode(v) != 0)
+			return;
+
+		const SoftwareRasterizer::Vertex center = ToWindow(v);
+		const SoftwareRasterizer& rasterizer = *g_state.pRasterizer;
+		const GLfloat halfSize = MathEx::Max(g_state.pointSize, 1.f) * 0.5f;
+		const GLfloat minX = MathEx::Max(center.x - halfSize, 0.f), maxX = MathEx::Min(center.x + halfSize, static_cast<GLfloat>(rasterizer.GetWidth()));
+		const GLfloat minY = MathEx::Max(center.y - halfSize, 0.f), maxY = MathEx::Min(center.y + halfSize, static_cast<GLfloat>(rasterizer.GetHeight()));
+
+		SoftwareRasterizer::Vertex corners[4] = { center, center, center, center };
+		corners[0].x = minX; corners[0].y = minY;
+		corners[1].x = maxX; corners[1].y = minY;
+		corners[2].x = maxX; corners[2].y = maxY;
+		corners[3].x = minX; corners[3].y = maxY;
+
+		g_state.pRasterizer->DrawTriangle(corners[0], corners[1], corners[2]);
+		g_state.pRasterizer->DrawTriangle(corners[0], corners[2], corners[3]);
+	}
+
+	// Draws triangle v0, v1, v2; with flat shading, the whole triangle has flatColorVertex's color
+	void DrawTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const ClipVertex& flatColorVertex)
+	{
+		const State& state = g_state;
+
+		// Clip against each plane in turn (Sutherland-Hodgman); each plane adds at most one vertex
+		ClipVertex polygons[2][9];
+		int numVertices = 3;
+		polygons[0][0] = v0;
+		polygons[0][1] = v1;
+		polygons[0][2] = v2;
+
+		if (state.shadeModel == GL_FLAT)
+		{
+			for (int i = 0; i < 3; ++i)
+				std::copy(flatColorVertex.color, flatColorVertex.color + 4, polygons[0][i].color);
+		}
+
+		const uint32 outCode0 = OutCode(v0), outCode1 = OutCode(v1), outCode2 = OutCode(v2);
+		if (outCode0 & outCode1 & outCode2)
+			return;
+
+		int current = 0;
+		if (outCode0 | outCode1 | outCode2)
+		{
+			for (int plane = 0; plane < 6 && numVertices >= 3; ++plane)
+			{
+				const ClipVertex* pIn = polygons[current];
+				ClipVertex* pOut = polygons[1 - current];
+				int numOut = 0;
+				for (int i = 0; i < numVertices; ++i)
+				{
+					const ClipVertex& a = pIn[i];
+					const ClipVertex& b = pIn[(i + 1) % numVertices];
+					const GLfloat da = ClipDistance(a, plane);
+					const GLfloat db = ClipDistance(b, plane);
+					if (da >= 0.f)
+						pOut[numOut++] = a;
+					if ((da >= 0.f) != (db >= 0.f))
+						pOut[numOut++] = Lerp(a, b, da / (da - db));
+				}
+				numVertices = numOut;
+				current = 1 - current;
+			}
+			if (numVertices < 3)
+				return;
+		}
+
+		SoftwareRasterizer::Vertex windowVertices[9];
+		GLfloat area2 = 0.f;
+		for (int i = 0; i < numVertices; ++i)
+			windowVertices[i] = ToWindow(polygons[current][i]);
+		for (int i = 0; i < numVertices; ++i)
+		{
+			const SoftwareRasterizer::Vertex& a = windowVertices[i];
+			const SoftwareRasterizer::Vertex& b = windowVertices[(i + 1) % numVertices];
+			area2 += a.x * b.y - b.x * a.y;
+		}
+
+		if (state.IsEnabled(GL_CULL_FACE))
+		{
+			const bool bFrontFacing = (area2 > 0.f) == (state.frontFace == GL_CCW);
+			if (state.cullFace == GL_FRONT_AND_BACK || (state.cullFace == GL_BACK) != bFrontFacing)
+				return;
+		}
+
+		if (state.polygonMode == GL_LINE)
+		{
+			DrawLine(v0, v1);
+			DrawLine(v1, v2);
+			DrawLine(v2, v0);
+			return;
+		}
+
+		for (int i = 1; i + 1 < numVertices; ++i)
+			state.pRasterizer->DrawTriangle(windowVertices[0], windowVertices[i], windowVertices[i + 1]);
+	}
+
+	// Assembles and draws primitives from vertices, in the order given by indices (or in order if
+	// indices is null)
+	void DrawPrimitives(GLenum mode, const std::vector<ClipVertex>& vertices, const uint32* indices, size_t count)
+	{
+		ApplyDrawState();
+
+		auto vertex = [&] (size_t i) -> const ClipVertex& { return vertices[indices? indices[i] : i]; };
+
+		switch (mode)
+		{
+			case GL_POINTS:
+				for (size_t i = 0; i < count; ++i)
+					DrawPoint(vertex(i));
+				break;
+
+			case GL_LINES:
+				for (size_t i = 0; i + 1 < count; i += 2)
+					DrawLine(vertex(i), vertex(i + 1));
+				break;
+
+			case GL_LINE_STRIP:
+			case GL_LINE_LOOP:
+				for (size_t i = 0; i + 1 < count; ++i)
+					DrawLine(vertex(i), vertex(i + 1));
+				if (mode == GL_LINE_LOOP && count > 2)
+					DrawLine(vertex(count - 1), vertex(0));
+				break;
+
+			case GL_TRIANGLES:
+				for (size_t i = 0; i + 2 < count; i += 3)
+					DrawTriangle(vertex(i), vertex(i + 1), vertex(i + 2), vertex(i + 2));
+				break;
+
+			case GL_TRIANGLE_STRIP:
+				for (size_t i = 0; i + 2 < count; ++i)
+				{
+					// Every other triangle is flipped to keep the winding consistent
+					if (i & 1)
+						DrawTriangle(vertex(i + 1), vertex(i), vertex(i + 2), vertex(i + 2));
+					else
+						DrawTriangle(vertex(i), vertex(i + 1), vertex(i + 2), vertex(i + 2));
+				}
+				break;
+
+			case GL_TRIANGLE_FAN:
+				for (size_t i = 1; i + 1 < count; ++i)
+					DrawTriangle(vertex(0), vertex(i), vertex(i + 1), vertex(i + 1));
+				break;
+
+			case GL_QUADS:
+				for (size_t i = 0; i + 3 < count; i += 4)
+				{
+					DrawTriangle(vertex(i), vertex(i + 1), vertex(i + 2), vertex(i + 3));
+					DrawTriangle(vertex(i), vertex(i + 2), vertex(i + 3), vertex(i + 3));
+				}
+				break;
+
+			case GL_QUAD_STRIP:
+				for (size_t i = 0; i + 3 < count; i += 2)
+				{
+					DrawTriangle(vertex(i), vertex(i + 1), vertex(i + 3), vertex(i + 3));
+					DrawTriangle(vertex(i), vertex(i + 3), vertex(i + 2), vertex(i + 3));
+				}
+				break;
+
+			case GL_POLYGON:
+				for (size_t i = 1; i + 1 < count; ++i)
+					DrawTriangle(vertex(0), vertex(i), vertex(i + 1), vertex(0));
+				break;
+
+			default:
+				assert(false && "Unsupported primitive type");
+		}
+	}
+
+	void AddImmediateVertex(GLfloat x, GLfloat y, GLfloat z)
+	{
+		State& state = g_state;
+		if (!state.pRasterizer)
+			return;
+
+		ImmediateVertex vertex;
+		vertex.position[0] = x; vertex.position[1] = y; vertex.position[2] = z; vertex.position[3] = 1.f;
+		std::copy(std::begin(state.currentNormal), std::end(state.currentNormal), vertex.normal);
+		std::copy(std::begin(state.currentColor), std::end(state.currentColor), vertex.color);
+		std::copy(std::begin(state.currentTexCoord), std::end(state.currentTexCoord), vertex.texCoord);
+		state.immediateVertices.push_back(vertex);
+	}
+
+	uint32 PackColor(const GLfloat color[4])
+	{
+		uint32 result = 0;
+		for (int i = 0; i < 4; ++i)
+			result |= static_cast<uint32>(MathEx::Clamp(color[i], 0.f, 1.f) * 255.f + 0.5f) << (i * 8);
+		return result;
+	}
+
+	int g_dummyQuadric;
+}
+
+namespace SoftwareGL
+{
+	void EnableRasterizer(int width, int height)
+	{
+		g_state.pRasterizer.reset(new SoftwareRasterizer());
+		g_state.pRasterizer->Resize(width, height);
+	}
+
+	SoftwareRasterizer* GetRasterizer()
+	{
+		return g_state.pRasterizer.get();
+	}
+
+	void Present()
+	{
+		if (g_state.pRasterizer)
+			g_state.pRasterizer->Flush();
+	}
+}
+
+// GL entry points; they get their C linkage from the declarations in the GL headers
+
+void GLAPIENTRY glEnable(GLenum cap) { g_state.enabledCaps.insert(cap); }
+void GLAPIENTRY glDisable(GLenum cap) { g_state.enabledCaps.erase(cap); }
+GLboolean GLAPIENTRY glIsEnabled(GLenum cap) { return g_state.IsEnabled(cap)? GL_TRUE : GL_FALSE; }
+GLenum GLAPIENTRY glGetError() { return GL_NO_ERROR; }
+void GLAPIENTRY glFinish() { SoftwareGL::Present(); }
+const GLubyte* GLAPIENTRY glGetString(GLenum) { return reinterpret_cast<const GLubyte*>(""); }
+
+void GLAPIENTRY glGetFloatv(GLenum pname, GLfloat* params)
+{
+	const State& state = g_state;
+	switch (pname)
+	{
+		case GL_CURRENT_COLOR:			std::copy(std::begin(state.currentColor), std::end(state.currentColor), params); break;
+		case GL_COLOR_CLEAR_VALUE:		std::copy(std::begin(state.clearColor), std::end(state.clearColor), params); break;
+		case GL_LINE_WIDTH:				params[0] = state.lineWidth; break;
+		case GL_POINT_SIZE:				params[0] = state.pointSize; break;
+		case GL_MODELVIEW_MATRIX:		std::copy(state.modelViewStack.back().m, state.modelViewStack.back().m + 16, params); break;
+		case GL_PROJECTION_MATRIX:		std::copy(state.projectionStack.back().m, state.projectionStack.back().m + 16, params); break;
+		default:						params[0] = 0.f;
+	}
+}
+
+void GLAPIENTRY glGetIntegerv(GLenum pname, GLint* params)
+{
+	const State& state = g_state;
+	switch (pname)
+	{
+		case GL_SHADE_MODEL:			params[0] = state.shadeModel; break;
+		case GL_MATRIX_MODE:			params[0] = state.matrixMode; break;
+		case GL_VIEWPORT:				std::copy(std::begin(state.viewport), std::end(state.viewport), params); break;
+		case GL_TEXTURE_BINDING_2D:		params[0] = state.boundTexture; break;
+		case GL_POLYGON_MODE:			params[0] = params[1] = state.polygonMode; break;
+		default:						params[0] = 0;
+	}
+}
+
+void GLAPIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	g_state.viewport[0] = x;
+	g_state.viewport[1] = y;
+	g_state.viewport[2] = width;
+	g_state.viewport[3] = height;
+}
+
+void GLAPIENTRY glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) { SetColor(g_state.clearColor, red, green, blue, alpha); }
+void GLAPIENTRY glClearDepth(GLclampd depth) { g_state.clearDepth = static_cast<GLfloat>(depth); }
+
+void GLAPIENTRY glClear(GLbitfield mask)
+{
+	if (g_state.pRasterizer)
+		g_state.pRasterizer->Clear((mask & GL_COLOR_BUFFER_BIT) != 0, PackColor(g_state.clearColor), (mask & GL_DEPTH_BUFFER_BIT) != 0, g_state.clearDepth);
+}
+
+void GLAPIENTRY glCullFace(GLenum mode) { g_state.cullFace = mode; }
+void GLAPIENTRY glFrontFace(GLenum mode) { g_state.frontFace = mode; }
+void GLAPIENTRY glDepthFunc(GLenum func) { assert(func == GL_LEQUAL && "Only GL_LEQUAL is supported"); (void)func; }
+void GLAPIENTRY glDepthMask(GLboolean flag) { g_state.bDepthMask = flag == GL_TRUE; }
+void GLAPIENTRY glPolygonMode(GLenum, GLenum mode) { g_state.polygonMode = mode; }
+void GLAPIENTRY glShadeModel(GLenum mode) { g_state.shadeModel = mode; }
+void GLAPIENTRY glPointSize(GLfloat size) { g_state.pointSize = size; }
+void GLAPIENTRY glLineWidth(GLfloat width) { g_state.lineWidth = width; }
+
+void GLAPIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	g_state.blendSrc = sfactor;
+	g_state.blendDst = dfactor;
+}
+
+void GLAPIENTRY glLightfv(GLenum lightName, GLenum pname, const GLfloat* params)
+{
+	assert(lightName >= GL_LIGHT0 && lightName < GL_LIGHT0 + kMaxLights);
+	Light& light = g_state.lights[lightName - GL_LIGHT0];
+	switch (pname)
+	{
+		case GL_AMBIENT:	std::copy(params, params + 4, light.ambient); break;
+		case GL_DIFFUSE:	std::copy(params, params + 4, light.diffuse); break;
+		case GL_SPECULAR:	std::copy(params, params + 4, light.specular); break;
+
+		// Lights are stored in eye space, transformed by the model view matrix when they're set
+		case GL_POSITION:	g_state.modelViewStack.back().Transform(params, light.position); break;
+	}
+}
+
+void GLAPIENTRY glGetLightfv(GLenum lightName, GLenum pname, GLfloat* params)
+{
+	assert(lightName >= GL_LIGHT0 && lightName < GL_LIGHT0 + kMaxLights);
+	const Light& light = g_state.lights[lightName - GL_LIGHT0];
+	switch (pname)
+	{
+		case GL_AMBIENT:	std::copy(light.ambient, light.ambient + 4, params); break;
+		case GL_DIFFUSE:	std::copy(light.diffuse, light.diffuse + 4, params); break;
+		case GL_SPECULAR:	std::copy(light.specular, light.specular + 4, params); break;
+		case GL_POSITION:	std::copy(light.position, light.position + 4, params); break;
+	}
+}
+
+void GLAPIENTRY glMaterialfv(GLenum, GLenum pname, const GLfloat* params)
+{
+	Material& material = g_state.material;
+	switch (pname)
+	{
+		case GL_AMBIENT:				std::copy(params, params + 4, material.ambient); break;
+		case GL_DIFFUSE:				std::copy(params, params + 4, material.diffuse); break;
+		case GL_AMBIENT_AND_DIFFUSE:	std::copy(params, params + 4, material.ambient); std::copy(params, params + 4, material.diffuse); break;
+		case GL_SPECULAR:				std::copy(params, params + 4, material.specular); break;
+		case GL_EMISSION:				std::copy(params, params + 4, material.emission); break;
+		case GL_SHININESS:				material.shininess = params[0]; break;
+	}
+}
+
+void GLAPIENTRY glMaterialf(GLenum, GLenum pname, GLfloat param)
+{
+	// Shininess is the only single value material parameter
+	if (pname == GL_SHININESS)
+		g_state.material.shininess = param;
+}
+
+void GLAPIENTRY glMatrixMode(GLenum mode) { g_state.matrixMode = mode; }
+void GLAPIENTRY glLoadIdentity() { g_state.CurrentMatrix() = Matrix44::Identity(); }
+void GLAPIENTRY glLoadMatrixf(const GLfloat* m) { std::copy(m, m + 16, g_state.CurrentMatrix().m); }
+
+void GLAPIENTRY glMultMatrixf(const GLfloat* m)
+{
+	Matrix44 rhs;
+	std::copy(m, m + 16, rhs.m);
+	g_state.CurrentMatrix() = g_state.CurrentMatrix() * rhs;
+}
+
+void GLAPIENTRY glPushMatrix()
+{
+	std::vector<Matrix44>& stack = g_state.CurrentStack();
+	stack.push_back(stack.back());
+}
+
+void GLAPIENTRY glPopMatrix()
+{
+	std::vector<Matrix44>& stack = g_state.CurrentStack();
+	assert(stack.size() > 1 && "Matrix stack underflow");
+	stack.pop_back();
+}
+
+void GLAPIENTRY glFrustum(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar)
+{
+	Matrix44 m = Matrix44::Identity();
+	m.m[0] = static_cast<GLfloat>(2.0 * zNear / (right - left));
+	m.m[5] = static_cast<GLfloat>(2.0 * zNear / (top - bottom));
+	m.m[8] = static_cast<GLfloat>((right + left) / (right - left));
+	m.m[9] = static_cast<GLfloat>((top + bottom) / (top - bottom));
+	m.m[10] = static_cast<GLfloat>(-(zFar + zNear) / (zFar - zNear));
+	m.m[11] = -1.f;
+	m.m[14] = static_cast<GLfloat>(-2.0 * zFar * zNear / (zFar - zNear));
+	m.m[15] = 0.f;
+	glMultMatrixf(m.m);
+}
+
+void GLAPIENTRY glOrtho(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar)
+{
+	Matrix44 m = Matrix44::Identity();
+	m.m[0] = static_cast<GLfloat>(2.0 / (right - left));
+	m.m[5] = static_cast<GLfloat>(2.0 / (top - bottom));
+	m.m[10] = static_cast<GLfloat>(-2.0 / (zFar - zNear));
+	m.m[12] = static_cast<GLfloat>(-(right + left) / (right - left));
+	m.m[13] = static_cast<GLfloat>(-(top + bottom) / (top - bottom));
+	m.m[14] = static_cast<GLfloat>(-(zFar + zNear) / (zFar - zNear));
+	glMultMatrixf(m.m);
+}
+
+void GLAPIENTRY glTranslatef(GLfloat x, GLfloat y, GLfloat z)
+{
+	Matrix44 m = Matrix44::Identity();
+	m.m[12] = x; m.m[13] = y; m.m[14] = z;
+	glMultMatrixf(m.m);
+}
+
+void GLAPIENTRY glScalef(GLfloat x, GLfloat y, GLfloat z)
+{
+	Matrix44 m = Matrix44::Identity();
+	m.m[0] = x; m.m[5] = y; m.m[10] = z;
+	glMultMatrixf(m.m);
+}
+
+void GLAPIENTRY glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
+{
+	GLfloat axis[3] = { x, y, z };
+	Normalize(axis);
+	const GLfloat radians = MathEx::DegToRad(angle);
+	const GLfloat c = std::cos(radians), s = std::sin(radians), t = 1.f - c;
+	x = axis[0]; y = axis[1]; z = axis[2];
+
+	Matrix44 m = Matrix44::Identity();
+	m.m[0] = t * x * x + c;		m.m[4] = t * x * y - s * z;	m.m[8] = t * x * z + s * y;
+	m.m[1] = t * x * y + s * z;	m.m[5] = t * y * y + c;		m.m[9] = t * y * z - s * x;
+	m.m[2] = t * x * z - s * y;	m.m[6] = t * y * z + s * x;	m.m[10] = t * z * z + c;
+	glMultMatrixf(m.m);
+}
+
+void GLAPIENTRY gluPerspective(GLdouble fovy, GLdouble aspect, GLdouble zNear, GLdouble zFar)
+{
+	const GLdouble top = std::tan(MathEx::DegToRad(fovy) * 0.5) * zNear;
+	glFrustum(-top * aspect, top * aspect, -top, top, zNear, zFar);
+}
+
+void GLAPIENTRY glGenTextures(GLsizei n, GLuint* textures)
+{
+	for (GLsizei i = 0; i < n; ++i)
+	{
+		textures[i] = g_state.nextTextureName++;
+		g_state.textures[textures[i]] = TextureObject();
+	}
+}
+
+void GLAPIENTRY glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+	// Triangles still waiting to be shaded keep their own references to the texels
+	for (GLsizei i = 0; i < n; ++i)
+	{
+		g_state.textures.erase(textures[i]);
+		if (g_state.boundTexture == textures[i])
+			g_state.boundTexture = 0;
+	}
+}
+
+void GLAPIENTRY glBindTexture(GLenum, GLuint texture) { g_state.boundTexture = texture; }
+
+void GLAPIENTRY glTexImage2D(GLenum, GLint level, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const GLvoid* pixels)
+{
+	// Only the base level is sampled
+	if (level != 0)
+		return;
+
+	// Other formats are ignored, like a failed upload
+	if (type != GL_UNSIGNED_BYTE || (format != GL_RGB && format != GL_RGBA))
+	{
+		assert(false && "Unsupported texture format");
+		return;
+	}
+
+	TextureObject& textureObject = g_state.textures[g_state.boundTexture];
+	textureObject.width = width;
+	textureObject.height = height;
+	if (!g_state.pRasterizer)
+		return;
+
+	assert((width & (width - 1)) == 0 && (height & (height - 1)) == 0 && "Texture size must be a power of 2");
+
+	auto pTexture = std::make_shared<SoftwareRasterizer::Texture>();
+	pTexture->width = width;
+	pTexture->height = height;
+	pTexture->texels.resize(width * height);
+
+	const int numChannels = format == GL_RGBA? 4 : 3;
+	const uint8* pSrc = static_cast<const uint8*>(pixels);
+	for (uint32& texel : pTexture->texels)
+	{
+		const uint32 alpha = numChannels == 4? pSrc[3] : 0xFF;
+		texel = pSrc[0] | (pSrc[1] << 8) | (pSrc[2] << 16) | (alpha << 24);
+		pSrc += numChannels;
+	}
+
+	// Replaces rather than modifies the texels, which triangles waiting to be shaded may be using
+	textureObject.pTexture = pTexture;
+}
+
+void GLAPIENTRY glGetTexLevelParameteriv(GLenum, GLint level, GLenum pname, GLint* params)
+{
+	const TextureObject& texture = g_state.textures[g_state.boundTexture];
+	switch (pname)
+	{
+		case GL_TEXTURE_WIDTH:	params[0] = level == 0? texture.width : 0; break;
+		case GL_TEXTURE_HEIGHT:	params[0] = level == 0? texture.height : 0; break;
+		default:				params[0] = 0;
+	}
+}
+
+void GLAPIENTRY glGetTexImage(GLenum, GLint level, GLenum format, GLenum type, GLvoid* pixels)
+{
+	assert(level == 0 && format == GL_RGBA && type == GL_UNSIGNED_BYTE && "Unsupported texture format");
+	(void)level; (void)format; (void)type;
+
+	// Texels are only kept when the rasterizer is enabled, and read back white otherwise
+	const TextureObject& texture = g_state.textures[g_state.boundTexture];
+	const size_t numTexels = texture.width * texture.height;
+	if (texture.pTexture)
+		memcpy(pixels, texture.pTexture->texels.data(), numTexels * sizeof(uint32));
+	else
+		memset(pixels, 0xFF, numTexels * sizeof(uint32));
+}
+
+void GLAPIENTRY glTexParameteri(GLenum, GLenum pname, GLint param)
+{
+	TextureObject& texture = g_state.textures[g_state.boundTexture];
+	switch (pname)
+	{
+		case GL_TEXTURE_MAG_FILTER:	texture.bLinearFilter = param == GL_LINEAR; break;
+		case GL_TEXTURE_WRAP_S:		texture.bClampS = param != GL_REPEAT; break;
+		case GL_TEXTURE_WRAP_T:		texture.bClampT = param != GL_REPEAT; break;
+	}
+}
+
+void GLAPIENTRY glBegin(GLenum mode)
+{
+	g_state.beginMode = mode;
+	g_state.immediateVertices.clear();
+}
+
+void GLAPIENTRY glEnd()
+{
+	State& state = g_state;
+	if (!state.pRasterizer || state.immediateVertices.empty())
+		return;
+
+	const VertexProcessor vertexProcessor;
+	state.clipVertices.clear();
+	for (const ImmediateVertex& vertex : state.immediateVertices)
+		state.clipVertices.push_back(vertexProcessor.Process(vertex.position, vertex.normal, vertex.color, vertex.texCoord));
+
+	DrawPrimitives(state.beginMode, state.clipVertices, nullptr, state.clipVertices.size());
+}
+
+void GLAPIENTRY glVertex2f(GLfloat x, GLfloat y) { AddImmediateVertex(x, y, 0.f); }
+void GLAPIENTRY glVertex3f(GLfloat x, GLfloat y, GLfloat z) { AddImmediateVertex(x, y, z); }
+void GLAPIENTRY glVertex3fv(const GLfloat* v) { AddImmediateVertex(v[0], v[1], v[2]); }
+void GLAPIENTRY glNormal3f(GLfloat x, GLfloat y, GLfloat z) { g_state.currentNormal[0] = x; g_state.currentNormal[1] = y; g_state.currentNormal[2] = z; }
+void GLAPIENTRY glTexCoord2f(GLfloat s, GLfloat t) { g_state.currentTexCoord[0] = s; g_state.currentTexCoord[1] = t; }
+void GLAPIENTRY glColor3f(GLfloat red, GLfloat green, GLfloat blue) { SetColor(g_state.currentColor, red, green, blue, 1.f); }
+void GLAPIENTRY glColor3ub(GLubyte red, GLubyte green, GLubyte blue) { SetColor(g_state.currentColor, red / 255.f, green / 255.f, blue / 255.f, 1.f); }
+void GLAPIENTRY glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) { SetColor(g_state.currentColor, red, green, blue, alpha); }
+void GLAPIENTRY glColor4fv(const GLfloat* v) { SetColor(g_state.currentColor, v[0], v[1], v[2], v[3]); }
+
+void GLAPIENTRY glPushClientAttrib(GLbitfield) { g_state.clientAttribStack.push_back(g_state.arrays); }
+
+void GLAPIENTRY glPopClientAttrib()
+{
+	assert(!g_state.clientAttribStack.empty() && "Client attribute stack underflow");
+	g_state.arrays = g_state.clientAttribStack.back();
+	g_state.clientAttribStack.pop_back();
+}
+
+namespace
+{
+	ArrayPointer* GetArray(GLenum array)
+	{
+		ClientArrays& arrays = g_state.arrays;
+		switch (array)
+		{
+			case GL_VERTEX_ARRAY:			return &arrays.vertex;
+			case GL_NORMAL_ARRAY:			return &arrays.normal;
+			case GL_COLOR_ARRAY:			return &arrays.color;
+			case GL_TEXTURE_COORD_ARRAY:	return &arrays.texCoord;
+		}
+		assert(false && "Unsupported client array");
+		return nullptr;
+	}
+
+	void SetArrayPointer(ArrayPointer& array, GLint size, GLenum type, GLsizei stride, const GLvoid* pointer)
+	{
+		assert((type == GL_FLOAT || (type == GL_UNSIGNED_BYTE && &array == &g_state.arrays.color)) && "Only float arrays and unsigned byte colors are supported");
+		assert(size >= 1 && size <= 4);
+		array.size = size;
+		array.type = type;
+		array.stride = stride;
+		array.pointer = pointer;
+	}
+}
+
+void GLAPIENTRY glEnableClientState(GLenum array) { GetArray(array)->bEnabled = true; }
+void GLAPIENTRY glDisableClientState(GLenum array) { GetArray(array)->bEnabled = false; }
+void GLAPIENTRY glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) { SetArrayPointer(g_state.arrays.vertex, size, type, stride, pointer); }
+void GLAPIENTRY glNormalPointer(GLenum type, GLsizei stride, const GLvoid* pointer) { SetArrayPointer(g_state.arrays.normal, 3, type, stride, pointer); }
+void GLAPIENTRY glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) { SetArrayPointer(g_state.arrays.color, size, type, stride, pointer); }
+void GLAPIENTRY glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) { SetArrayPointer(g_state.arrays.texCoord, size, type, stride, pointer); }
+
+namespace
+{
+	// Transforms the vertices in [first, first + count) of the enabled arrays into clipVertices
+	void ProcessArrayVertices(uint32 first, uint32 count)
+	{
+		State& state = g_state;
+		assert(state.arrays.vertex.bEnabled && "Drawing requires a vertex array");
+
+		const ClientArrays& arrays = state.arrays;
+		const VertexProcessor vertexProcessor;
+		state.clipVertices.resize(count);
+		for (uint32 i = first; i < first + count; ++i)
+		{
+			GLfloat position[4] = { 0.f, 0.f, 0.f, 1.f };
+			arrays.vertex.Read(i, position);
+
+			GLfloat color[4] = { 0.f, 0.f, 0.f, 1.f };
+			if (!arrays.color.Read(i, color))
+				std::copy(std::begin(state.currentColor), std::end(state.currentColor), color);
+
+			GLfloat normal[3];
+			if (!arrays.normal.Read(i, normal))
+				std::copy(std::begin(state.currentNormal), std::end(state.currentNormal), normal);
+
+			GLfloat texCoord[4];
+			if (!arrays.texCoord.Read(i, texCoord))
+				std::copy(std::begin(state.currentTexCoord), std::end(state.currentTexCoord), texCoord);
+
+			state.clipVertices[i - first] = vertexProcessor.Process(position, normal, color, texCoord);
+		}
+	}
+}
+
+void GLAPIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	State& state = g_state;
+	if (!state.pRasterizer || count <= 0)
+		return;
+
+	ProcessArrayVertices(static_cast<uint32>(first), static_cast<uint32>(count));
+	DrawPrimitives(mode, state.clipVertices, nullptr, state.clipVertices.size());
+}
+
+void GLAPIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+	State& state = g_state;
+	if (!state.pRasterizer || count <= 0)
+		return;
+
+	// Read the indices, and transform each vertex they reference once
+	state.indices.resize(count);
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		switch (type)
+		{
+			case GL_UNSIGNED_BYTE:	state.indices[i] = static_cast<const GLubyte*>(indices)[i]; break;
+			case GL_UNSIGNED_SHORT:	state.indices[i] = static_cast<const GLushort*>(indices)[i]; break;
+			case GL_UNSIGNED_INT:	state.indices[i] = static_cast<const GLuint*>(indices)[i]; break;
+			default: assert(false && "Unsupported index type"); return;
+		}
+	}
+	const auto minMax = std::minmax_element(state.indices.begin(), state.indices.end());
+	const uint32 minIndex = *minMax.first;
+	const uint32 maxIndex = *minMax.second;
+	ProcessArrayVertices(minIndex, maxIndex - minIndex + 1);
+
+	for (uint32& index : state.indices)
+		index -= minIndex;
+
+	DrawPrimitives(mode, state.clipVertices, state.indices.data(), state.indices.size());
+}
+
+GLUquadric* GLAPIENTRY gluNewQuadric() { return reinterpret_cast<GLUquadric*>(&g_dummyQuadric); }
+void GLAPIENTRY gluDeleteQuadric(GLUquadric*) {}
+
+void GLAPIENTRY gluSphere(GLUquadric*, GLdouble radius, GLint slices, GLint stacks)
+{
+	// A quad strip per stack, from the bottom (-z) to the top (+z) like GLU
+	for (GLint stack = 0; stack < stacks; ++stack)
+	{
+		glBegin(GL_QUAD_STRIP);
+		for (GLint slice = 0; slice <= slices; ++slice)
+		{
+			const GLfloat theta = 2.f * kPi * slice / slices;
+			for (GLint i = 1; i >= 0; --i)
+			{
+				const GLfloat phi = kPi * (stack + i) / stacks - kPi;
+				const GLfloat normal[3] = { std::cos(theta) * std::sin(phi), std::sin(theta) * std::sin(phi), std::cos(phi) };
+				glNormal3f(normal[0], normal[1], normal[2]);
+				glVertex3f(normal[0] * static_cast<GLfloat>(radius), normal[1] * static_cast<GLfloat>(radius), normal[2] * static_cast<GLfloat>(radius));
+			}
+		}
+		glEnd();
+	}
+}
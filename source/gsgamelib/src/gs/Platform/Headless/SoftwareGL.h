@@ -0,0 +1,24 @@
+#ifndef _SOFTWARE_GL_H_
+#define _SOFTWARE_GL_H_
+
+// GL for headless builds, implemented in SoftwareGL.cpp. It covers the subset of fixed function
+// GL that GLUtil and the game use: matrix stacks, vertex arrays and immediate mode, one
+// directional or point light per GL light, textures, blending and depth testing. State is always
+// tracked, but draws are ignored unless the rasterizer is enabled, in which case they're
+// transformed, lit and clipped here, and rendered on the CPU by SoftwareRasterizer.
+
+class SoftwareRasterizer;
+
+namespace SoftwareGL
+{
+	// Renders draws into a width x height framebuffer from now on
+	void EnableRasterizer(int width, int height);
+
+	// Returns the rasterizer, or nullptr if draws are ignored
+	SoftwareRasterizer* GetRasterizer();
+
+	// Finishes rendering the frame, where a window would swap buffers
+	void Present();
+}
+
+#endif // _SOFTWARE_GL_H_
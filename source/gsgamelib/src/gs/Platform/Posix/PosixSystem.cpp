@@ -0,0 +1,73 @@
+#include "PosixSystem.h"
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+
+namespace
+{
+	std::array<bool, 256> g_keysDown = {};
+
+	bool ReadIsDebuggerAttached()
+	{
+		// A process being debugged is traced by the debugger, whose pid is reported in its status
+		FILE* pFile = fopen("/proc/self/status", "r");
+		if (!pFile)
+			return false;
+
+		bool bAttached = false;
+		char line[256];
+		while (fgets(line, sizeof(line), pFile))
+		{
+			const char tracerPidField[] = "TracerPid:";
+			if (strncmp(line, tracerPidField, sizeof(tracerPidField) - 1) == 0)
+			{
+				bAttached = atoi(line + sizeof(tracerPidField) - 1) != 0;
+				break;
+			}
+		}
+		fclose(pFile);
+		return bAttached;
+	}
+}
+
+void PosixSystem::Sleep(int ms)
+{
+	timespec duration;
+	duration.tv_sec = ms / 1000;
+	duration.tv_nsec = (ms % 1000) * 1000000L;
+
+	// Resume sleeping for the remaining time if interrupted by a signal
+	while (nanosleep(&duration, &duration) == -1 && errno == EINTR)
+	{
+	}
+}
+
+float64 PosixSystem::GetElapsedTicks()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return static_cast<float64>(time.tv_sec) * GetTicksPerSecond() + static_cast<float64>(time.tv_nsec);
+}
+
+bool PosixSystem::IsVKeyDown(VKEY vkey)
+{
+	return vkey < g_keysDown.size() && g_keysDown[vkey];
+}
+
+void PosixSystem::SetVKeyDown(VKEY vkey, bool bDown)
+{
+	assert(vkey < g_keysDown.size());
+	g_keysDown[vkey] = bDown;
+}
+
+bool PosixSystem::IsDebuggerAttached()
+{
+	// Called every frame, so the status file is only read once. A debugger attached later isn't
+	// noticed.
+	static const bool bAttached = ReadIsDebuggerAttached();
+	return bAttached;
+}
@@ -0,0 +1,85 @@
+#ifndef _POSIX_SYSTEM_H_
+#define _POSIX_SYSTEM_H_
+
+#include "gs/Base/Base.h"
+
+// Each platform must define virtual key codes for each keyboard key.
+// (keys with ascii values use the ascii value as their VKEY value)
+typedef unsigned int VKEY;
+
+// Same values as Win32's, so that key codes mean the same thing on every platform
+const VKEY VK_BACK = 0x08;
+const VKEY VK_TAB = 0x09;
+const VKEY VK_RETURN = 0x0D;
+const VKEY VK_SHIFT = 0x10;
+const VKEY VK_CONTROL = 0x11;
+const VKEY VK_MENU = 0x12; // Alt
+const VKEY VK_PAUSE = 0x13;
+const VKEY VK_ESCAPE = 0x1B;
+const VKEY VK_SPACE = 0x20;
+const VKEY VK_PRIOR = 0x21; // Page up
+const VKEY VK_NEXT = 0x22; // Page down
+const VKEY VK_END = 0x23;
+const VKEY VK_HOME = 0x24;
+const VKEY VK_LEFT = 0x25;
+const VKEY VK_UP = 0x26;
+const VKEY VK_RIGHT = 0x27;
+const VKEY VK_DOWN = 0x28;
+const VKEY VK_INSERT = 0x2D;
+const VKEY VK_DELETE = 0x2E;
+const VKEY VK_NUMPAD0 = 0x60; // Through VK_NUMPAD9
+const VKEY VK_NUMPAD9 = 0x69;
+const VKEY VK_F1 = 0x70; // Through VK_F12
+const VKEY VK_F2 = 0x71;
+const VKEY VK_F3 = 0x72;
+const VKEY VK_F4 = 0x73;
+const VKEY VK_F5 = 0x74;
+const VKEY VK_F6 = 0x75;
+const VKEY VK_F7 = 0x76;
+const VKEY VK_F8 = 0x77;
+const VKEY VK_F9 = 0x78;
+const VKEY VK_F10 = 0x79;
+const VKEY VK_F11 = 0x7A;
+const VKEY VK_F12 = 0x7B;
+const VKEY VK_OEM_PLUS = 0xBB; // +=
+const VKEY VK_OEM_COMMA = 0xBC; // ,<
+const VKEY VK_OEM_MINUS = 0xBD; // -_
+const VKEY VK_OEM_PERIOD = 0xBE; // .>
+const VKEY VK_OEM_4 = 0xDB; // [{
+const VKEY VK_OEM_6 = 0xDD; // ]}
+
+// System for POSIX platforms without a window system. There's no keyboard to poll, so key state
+// is set by an input source instead (see InputScript), and the mouse is never visible.
+class PosixSystem
+{
+public:
+	static void Sleep(int ms);
+
+	static float64 GetElapsedTicks();
+
+	static float64 GetTicksPerSecond()
+	{
+		return 1000000000.0; // Ticks are nanoseconds
+	}
+
+	static float64 GetElapsedSeconds()
+	{
+		return GetElapsedTicks() / GetTicksPerSecond();
+	}
+
+	static bool IsVKeyDown(VKEY vkey);
+
+	// Sets the state returned by IsVKeyDown
+	static void SetVKeyDown(VKEY vkey, bool bDown);
+
+	static void SetMouseVisible(bool /*bShow*/) {}
+
+	static bool IsMouseVisible()
+	{
+		return false;
+	}
+
+	static bool IsDebuggerAttached();
+};
+
+#endif // _POSIX_SYSTEM_H_
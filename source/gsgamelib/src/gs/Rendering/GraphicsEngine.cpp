@@ -17,6 +17,20 @@ GraphicsEngine& GraphicsEngine::Instance()
 	return *pInstance;
 }
 
+#elif defined(__unix__) || defined(__APPLE__)
+
+#include "gs/Platform/Headless/HeadlessGraphicsEngine.h"
+
+GraphicsEngine& GraphicsEngine::Instance()
+{
+	static HeadlessGraphicsEngine* pInstance = nullptr;
+	if (!pInstance)
+	{
+		pInstance = new HeadlessGraphicsEngine();
+	}
+	return *pInstance;
+}
+
 #else
 
 #error GraphicsEngine class not defined for current platform
@@ -0,0 +1,559 @@
+#include "SoftwareRasterizer.h"
+#include "gs/Math/MathEx.h"
+#include "gs/Math/SIMD.h"
+#include "gs/System/JobSystem.h"
+#include "gs/System/System.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	const uint32 kFullyCovered = 0x80000000u;
+
+	// Interpolated values: depth, 1/w, and the attributes divided by w
+	enum
+	{
+		PlaneZ,
+		PlaneInvW,
+		PlaneR,
+		PlaneG,
+		PlaneB,
+		PlaneA,
+		PlaneU,
+		PlaneV,
+
+		NumPlanes
+	};
+
+	// Value at pixel (x, y) is a * x + b * y + c
+	struct Plane
+	{
+		float32 a, b, c;
+
+		float32 Evaluate(float32 x, float32 y) const { return a * x + b * y + c; }
+	};
+
+	inline uint32 Texel(const SoftwareRasterizer::Texture& texture, int x, int y)
+	{
+		return texture.texels[y * texture.width + x];
+	}
+
+	inline int WrapOrClamp(int i, int size, bool bClamp)
+	{
+		return bClamp? MathEx::Clamp(i, 0, size - 1) : i & (size - 1);
+	}
+
+	// Returns the texel color at (u, v) as floats in [0,1]
+	void SampleTexture(const SoftwareRasterizer::DrawState& state, float32 u, float32 v, float32 color[4])
+	{
+		const SoftwareRasterizer::Texture& texture = *state.pTexture;
+
+		// Bring coordinates into [0,1] first so that large ones don't overflow when converted to ints
+		u = state.bClampS? MathEx::Clamp(u, 0.f, 1.f) : u - MathEx::Floor(u);
+		v = state.bClampT? MathEx::Clamp(v, 0.f, 1.f) : v - MathEx::Floor(v);
+
+		const float32 kInv255 = 1.f / 255.f;
+
+		if (!state.bLinearFilter)
+		{
+			const int x = WrapOrClamp(static_cast<int>(u * texture.width), texture.width, state.bClampS);
+			const int y = WrapOrClamp(static_cast<int>(v * texture.height), texture.height, state.bClampT);
+			const uint32 texel = Texel(texture, x, y);
+			for (int i = 0; i < 4; ++i)
+				color[i] = static_cast<float32>((texel >> (i * 8)) & 0xFF) * kInv255;
+			return;
+		}
+
+		const float32 fx = u * texture.width - 0.5f;
+		const float32 fy = v * texture.height - 0.5f;
+		const float32 floorX = MathEx::Floor(fx);
+		const float32 floorY = MathEx::Floor(fy);
+		const float32 tx = fx - floorX;
+		const float32 ty = fy - floorY;
+		const int x0 = static_cast<int>(floorX);
+		const int y0 = static_cast<int>(floorY);
+		const int x1 = WrapOrClamp(x0 + 1, texture.width, state.bClampS);
+		const int y1 = WrapOrClamp(y0 + 1, texture.height, state.bClampT);
+		const int x0w = WrapOrClamp(x0, texture.width, state.bClampS);
+		const int y0w = WrapOrClamp(y0, texture.height, state.bClampT);
+
+		const uint32 t00 = Texel(texture, x0w, y0w);
+		const uint32 t10 = Texel(texture, x1, y0w);
+		const uint32 t01 = Texel(texture, x0w, y1);
+		const uint32 t11 = Texel(texture, x1, y1);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			const int shift = i * 8;
+			const float32 c00 = static_cast<float32>((t00 >> shift) & 0xFF);
+			const float32 c10 = static_cast<float32>((t10 >> shift) & 0xFF);
+			const float32 c01 = static_cast<float32>((t01 >> shift) & 0xFF);
+			const float32 c11 = static_cast<float32>((t11 >> shift) & 0xFF);
+			const float32 bottom = c00 + (c10 - c00) * tx;
+			const float32 top = c01 + (c11 - c01) * tx;
+			color[i] = (bottom + (top - bottom) * ty) * kInv255;
+		}
+	}
+
+	inline float32 BlendFactorValue(BlendFactor::Type factor, float32 srcAlpha)
+	{
+		switch (factor)
+		{
+			case BlendFactor::Zero:				return 0.f;
+			case BlendFactor::One:				return 1.f;
+			case BlendFactor::SrcAlpha:			return srcAlpha;
+			case BlendFactor::OneMinusSrcAlpha:	return 1.f - srcAlpha;
+		}
+		assert(false && "Unexpected blend factor");
+		return 1.f;
+	}
+}
+
+struct SoftwareRasterizer::Triangle
+{
+	Plane edges[3]; // Positive inside
+	bool bOwnsEdge[3]; // Whether pixels centered exactly on the edge belong to this triangle
+	Plane planes[NumPlanes];
+	int minX, minY, maxX, maxY; // Pixels whose centers may be inside, clamped to the framebuffer
+	uint32 stateIndex;
+};
+
+#if GS_SIMD_SSE
+
+namespace
+{
+	inline __m128 EvaluatePlane(const Plane& plane, __m128 x, float32 y)
+	{
+		return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.a), x), _mm_set1_ps(plane.b * y + plane.c));
+	}
+
+	inline __m128 BlendFactorValue(BlendFactor::Type factor, __m128 srcAlpha)
+	{
+		switch (factor)
+		{
+			case BlendFactor::Zero:				return _mm_setzero_ps();
+			case BlendFactor::One:				return _mm_set1_ps(1.f);
+			case BlendFactor::SrcAlpha:			return srcAlpha;
+			case BlendFactor::OneMinusSrcAlpha:	return _mm_sub_ps(_mm_set1_ps(1.f), srcAlpha);
+		}
+		assert(false && "Unexpected blend factor");
+		return _mm_set1_ps(1.f);
+	}
+
+	inline __m128 UnpackChannel(__m128i colors, int shift)
+	{
+		return _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(colors, shift), _mm_set1_epi32(0xFF))), _mm_set1_ps(1.f / 255.f));
+	}
+
+	inline __m128i PackChannel(__m128 channel, int shift)
+	{
+		const __m128 clamped = _mm_min_ps(_mm_max_ps(channel, _mm_setzero_ps()), _mm_set1_ps(1.f));
+		const __m128i value = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+		return _mm_slli_epi32(value, shift);
+	}
+}
+
+// Shades the part of the triangle within [minX, maxX] x [minY, maxY], 4 pixels at a time. minX must
+// be a multiple of 4.
+void SoftwareRasterizer::ShadeTriangle(const Triangle& tri, const DrawState& state, bool bFullyCovered,
+	int minX, int maxX, int minY, int maxY, uint32* pColorBuffer, float32* pDepthBuffer, int pitch)
+{
+	const __m128 laneCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 allLanes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	__m128 ownsEdge[3];
+	for (int i = 0; i < 3; ++i)
+		ownsEdge[i] = tri.bOwnsEdge[i]? allLanes : zero;
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		const float32 centerY = static_cast<float32>(y) + 0.5f;
+		uint32* pColorRow = pColorBuffer + y * pitch;
+		float32* pDepthRow = pDepthBuffer + y * pitch;
+
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float32>(x)), laneCenters);
+
+			__m128 mask = allLanes;
+			if (!bFullyCovered)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					const __m128 e = EvaluatePlane(tri.edges[i], centerX, centerY);
+					mask = _mm_and_ps(mask, _mm_or_ps(_mm_cmpgt_ps(e, zero), _mm_and_ps(_mm_cmpeq_ps(e, zero), ownsEdge[i])));
+				}
+				if (_mm_movemask_ps(mask) == 0)
+					continue;
+			}
+
+			const __m128 z = EvaluatePlane(tri.planes[PlaneZ], centerX, centerY);
+			const __m128 depth = _mm_loadu_ps(pDepthRow + x);
+			if (state.bDepthTest)
+			{
+				mask = _mm_and_ps(mask, _mm_cmple_ps(z, depth));
+				if (_mm_movemask_ps(mask) == 0)
+					continue;
+			}
+
+			// Perspective correct attributes
+			const __m128 w = _mm_div_ps(one, EvaluatePlane(tri.planes[PlaneInvW], centerX, centerY));
+			__m128 r = _mm_mul_ps(EvaluatePlane(tri.planes[PlaneR], centerX, centerY), w);
+			__m128 g = _mm_mul_ps(EvaluatePlane(tri.planes[PlaneG], centerX, centerY), w);
+			__m128 b = _mm_mul_ps(EvaluatePlane(tri.planes[PlaneB], centerX, centerY), w);
+			__m128 a = _mm_mul_ps(EvaluatePlane(tri.planes[PlaneA], centerX, centerY), w);
+
+			if (state.pTexture)
+			{
+				// There's no gather in SSE, so textures are sampled one lane at a time
+				float32 u[4], v[4], texels[4][4];
+				_mm_storeu_ps(u, _mm_mul_ps(EvaluatePlane(tri.planes[PlaneU], centerX, centerY), w));
+				_mm_storeu_ps(v, _mm_mul_ps(EvaluatePlane(tri.planes[PlaneV], centerX, centerY), w));
+				for (int lane = 0; lane < 4; ++lane)
+					SampleTexture(state, u[lane], v[lane], texels[lane]);
+
+				r = _mm_mul_ps(r, _mm_setr_ps(texels[0][0], texels[1][0], texels[2][0], texels[3][0]));
+				g = _mm_mul_ps(g, _mm_setr_ps(texels[0][1], texels[1][1], texels[2][1], texels[3][1]));
+				b = _mm_mul_ps(b, _mm_setr_ps(texels[0][2], texels[1][2], texels[2][2], texels[3][2]));
+				a = _mm_mul_ps(a, _mm_setr_ps(texels[0][3], texels[1][3], texels[2][3], texels[3][3]));
+			}
+
+			const __m128i dstColors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pColorRow + x));
+			if (state.bBlend)
+			{
+				const __m128 srcFactor = BlendFactorValue(state.srcFactor, a);
+				const __m128 dstFactor = BlendFactorValue(state.dstFactor, a);
+				r = _mm_add_ps(_mm_mul_ps(r, srcFactor), _mm_mul_ps(UnpackChannel(dstColors, 0), dstFactor));
+				g = _mm_add_ps(_mm_mul_ps(g, srcFactor), _mm_mul_ps(UnpackChannel(dstColors, 8), dstFactor));
+				b = _mm_add_ps(_mm_mul_ps(b, srcFactor), _mm_mul_ps(UnpackChannel(dstColors, 16), dstFactor));
+				a = _mm_add_ps(_mm_mul_ps(a, srcFactor), _mm_mul_ps(UnpackChannel(dstColors, 24), dstFactor));
+			}
+
+			const __m128i srcColors = _mm_or_si128(_mm_or_si128(PackChannel(r, 0), PackChannel(g, 8)), _mm_or_si128(PackChannel(b, 16), PackChannel(a, 24)));
+			const __m128i maskInt = _mm_castps_si128(mask);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pColorRow + x), _mm_or_si128(_mm_and_si128(maskInt, srcColors), _mm_andnot_si128(maskInt, dstColors)));
+
+			if (state.bDepthWrite)
+				_mm_storeu_ps(pDepthRow + x, SIMD::Select(mask, z, depth));
+		}
+	}
+}
+
+#else // !GS_SIMD_SSE
+
+namespace
+{
+	inline uint32 PackChannel(float32 channel, int shift)
+	{
+		return static_cast<uint32>(MathEx::Clamp(channel, 0.f, 1.f) * 255.f + 0.5f) << shift;
+	}
+}
+
+void SoftwareRasterizer::ShadeTriangle(const Triangle& tri, const DrawState& state, bool bFullyCovered,
+	int minX, int maxX, int minY, int maxY, uint32* pColorBuffer, float32* pDepthBuffer, int pitch)
+{
+	for (int y = minY; y <= maxY; ++y)
+	{
+		const float32 centerY = static_cast<float32>(y) + 0.5f;
+		uint32* pColorRow = pColorBuffer + y * pitch;
+		float32* pDepthRow = pDepthBuffer + y * pitch;
+
+		for (int x = minX; x <= maxX; ++x)
+		{
+			const float32 centerX = static_cast<float32>(x) + 0.5f;
+
+			if (!bFullyCovered)
+			{
+				bool bInside = true;
+				for (int i = 0; i < 3 && bInside; ++i)
+				{
+					const float32 e = tri.edges[i].Evaluate(centerX, centerY);
+					bInside = e > 0.f || (e == 0.f && tri.bOwnsEdge[i]);
+				}
+				if (!bInside)
+					continue;
+			}
+
+			const float32 z = tri.planes[PlaneZ].Evaluate(centerX, centerY);
+			if (state.bDepthTest && z > pDepthRow[x])
+				continue;
+
+			const float32 w = 1.f / tri.planes[PlaneInvW].Evaluate(centerX, centerY);
+			float32 color[4];
+			for (int i = 0; i < 4; ++i)
+				color[i] = tri.planes[PlaneR + i].Evaluate(centerX, centerY) * w;
+
+			if (state.pTexture)
+			{
+				float32 texel[4];
+				SampleTexture(state, tri.planes[PlaneU].Evaluate(centerX, centerY) * w, tri.planes[PlaneV].Evaluate(centerX, centerY) * w, texel);
+				for (int i = 0; i < 4; ++i)
+					color[i] *= texel[i];
+			}
+
+			if (state.bBlend)
+			{
+				const float32 srcFactor = BlendFactorValue(state.srcFactor, color[3]);
+				const float32 dstFactor = BlendFactorValue(state.dstFactor, color[3]);
+				for (int i = 0; i < 4; ++i)
+					color[i] = color[i] * srcFactor + static_cast<float32>((pColorRow[x] >> (i * 8)) & 0xFF) / 255.f * dstFactor;
+			}
+
+			pColorRow[x] = PackChannel(color[0], 0) | PackChannel(color[1], 8) | PackChannel(color[2], 16) | PackChannel(color[3], 24);
+			if (state.bDepthWrite)
+				pDepthRow[x] = z;
+		}
+	}
+}
+
+#endif // GS_SIMD_SSE
+
+SoftwareRasterizer::DrawState::DrawState()
+	: bLinearFilter(false)
+	, bClampS(false)
+	, bClampT(false)
+	, bDepthTest(false)
+	, bDepthWrite(true)
+	, bBlend(false)
+	, srcFactor(BlendFactor::One)
+	, dstFactor(BlendFactor::Zero)
+{
+}
+
+bool SoftwareRasterizer::DrawState::operator==(const DrawState& rhs) const
+{
+	return pTexture == rhs.pTexture
+		&& bLinearFilter == rhs.bLinearFilter
+		&& bClampS == rhs.bClampS
+		&& bClampT == rhs.bClampT
+		&& bDepthTest == rhs.bDepthTest
+		&& bDepthWrite == rhs.bDepthWrite
+		&& bBlend == rhs.bBlend
+		&& srcFactor == rhs.srcFactor
+		&& dstFactor == rhs.dstFactor;
+}
+
+SoftwareRasterizer::SoftwareRasterizer()
+	: m_width(0)
+	, m_height(0)
+	, m_numTilesX(0)
+	, m_numTilesY(0)
+{
+	m_drawStates.push_back(DrawState());
+	m_pendingClear.bColor = false;
+	m_pendingClear.bDepth = false;
+	ResetStats();
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+void SoftwareRasterizer::Resize(int width, int height)
+{
+	assert(width > 0 && height > 0);
+	m_triangles.clear();
+
+	m_width = width;
+	m_height = height;
+	m_numTilesX = (width + kTileSize - 1) / kTileSize;
+	m_numTilesY = (height + kTileSize - 1) / kTileSize;
+
+	// Buffers cover whole tiles so that tiles never need bounds checks
+	const size_t numPixels = static_cast<size_t>(m_numTilesX * kTileSize) * (m_numTilesY * kTileSize);
+	m_colorBuffer.assign(numPixels, 0);
+	m_depthBuffer.assign(numPixels, 1.f);
+	m_tileBins.assign(m_numTilesX * m_numTilesY, std::vector<uint32>());
+}
+
+void SoftwareRasterizer::SetDrawState(const DrawState& drawState)
+{
+	if (!(m_drawStates.back() == drawState))
+		m_drawStates.push_back(drawState);
+}
+
+void SoftwareRasterizer::DrawTriangle(const Vertex& v0, const Vertex& v1In, const Vertex& v2In)
+{
+	// Make the winding counter-clockwise, so that the inside of every edge is positive
+	float32 area2 = (v1In.x - v0.x) * (v2In.y - v0.y) - (v2In.x - v0.x) * (v1In.y - v0.y);
+	const bool bSwap = area2 < 0.f;
+	const Vertex& v1 = bSwap? v2In : v1In;
+	const Vertex& v2 = bSwap? v1In : v2In;
+	area2 = MathEx::Abs(area2);
+
+	// Also rejects NaNs
+	if (!(area2 > 0.f))
+		return;
+
+	Triangle tri;
+	tri.minX = MathEx::Max(static_cast<int>(std::ceil(MathEx::Min(v0.x, MathEx::Min(v1.x, v2.x)) - 0.5f)), 0);
+	tri.minY = MathEx::Max(static_cast<int>(std::ceil(MathEx::Min(v0.y, MathEx::Min(v1.y, v2.y)) - 0.5f)), 0);
+	tri.maxX = MathEx::Min(static_cast<int>(MathEx::Floor(MathEx::Max(v0.x, MathEx::Max(v1.x, v2.x)) - 0.5f)), m_width - 1);
+	tri.maxY = MathEx::Min(static_cast<int>(MathEx::Floor(MathEx::Max(v0.y, MathEx::Max(v1.y, v2.y)) - 0.5f)), m_height - 1);
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+		return;
+
+	const Vertex* vertices[3] = { &v0, &v1, &v2 };
+	for (int i = 0; i < 3; ++i)
+	{
+		const Vertex& from = *vertices[i];
+		const Vertex& to = *vertices[(i + 1) % 3];
+		Plane& edge = tri.edges[i];
+		edge.a = from.y - to.y;
+		edge.b = to.x - from.x;
+		edge.c = -(edge.a * from.x + edge.b * from.y);
+
+		// Triangles that share an edge see it with opposite signs, so exactly one of them owns it
+		tri.bOwnsEdge[i] = edge.a > 0.f || (edge.a == 0.f && edge.b > 0.f);
+	}
+
+	// Fit a plane to each interpolated value
+	const float32 invArea2 = 1.f / area2;
+	const float32 dx1 = v1.x - v0.x, dy1 = v1.y - v0.y;
+	const float32 dx2 = v2.x - v0.x, dy2 = v2.y - v0.y;
+	for (int i = 0; i < NumPlanes; ++i)
+	{
+		float32 values[3];
+		for (int j = 0; j < 3; ++j)
+		{
+			const Vertex& vertex = *vertices[j];
+			switch (i)
+			{
+				case PlaneZ:	values[j] = vertex.z; break;
+				case PlaneInvW:	values[j] = vertex.invW; break;
+				case PlaneR:	values[j] = vertex.r * vertex.invW; break;
+				case PlaneG:	values[j] = vertex.g * vertex.invW; break;
+				case PlaneB:	values[j] = vertex.b * vertex.invW; break;
+				case PlaneA:	values[j] = vertex.a * vertex.invW; break;
+				case PlaneU:	values[j] = vertex.u * vertex.invW; break;
+				case PlaneV:	values[j] = vertex.v * vertex.invW; break;
+			}
+		}
+
+		Plane& plane = tri.planes[i];
+		const float32 d1 = values[1] - values[0];
+		const float32 d2 = values[2] - values[0];
+		plane.a = (d1 * dy2 - d2 * dy1) * invArea2;
+		plane.b = (d2 * dx1 - d1 * dx2) * invArea2;
+		plane.c = values[0] - plane.a * v0.x - plane.b * v0.y;
+	}
+
+	tri.stateIndex = static_cast<uint32>(m_drawStates.size() - 1);
+	const uint32 triIndex = static_cast<uint32>(m_triangles.size());
+	m_triangles.push_back(tri);
+	++m_stats.numTriangles;
+
+	// Bin into the tiles overlapped by the bounds, skipping those entirely outside an edge
+	for (int tileY = tri.minY / kTileSize; tileY <= tri.maxY / kTileSize; ++tileY)
+	{
+		for (int tileX = tri.minX / kTileSize; tileX <= tri.maxX / kTileSize; ++tileX)
+		{
+			const float32 minCenterX = static_cast<float32>(tileX * kTileSize) + 0.5f;
+			const float32 minCenterY = static_cast<float32>(tileY * kTileSize) + 0.5f;
+			const float32 maxCenterX = minCenterX + (kTileSize - 1);
+			const float32 maxCenterY = minCenterY + (kTileSize - 1);
+
+			bool bOutside = false;
+			bool bFullyCovered = true;
+			for (const Plane& edge : tri.edges)
+			{
+				// Evaluate at the corners where the edge is largest and smallest
+				const float32 maxValue = edge.Evaluate(edge.a > 0.f? maxCenterX : minCenterX, edge.b > 0.f? maxCenterY : minCenterY);
+				const float32 minValue = edge.Evaluate(edge.a > 0.f? minCenterX : maxCenterX, edge.b > 0.f? minCenterY : maxCenterY);
+				bOutside = bOutside || maxValue < 0.f;
+				bFullyCovered = bFullyCovered && minValue > 0.f;
+			}
+
+			if (!bOutside)
+			{
+				m_tileBins[tileY * m_numTilesX + tileX].push_back(triIndex | (bFullyCovered? kFullyCovered : 0));
+				++m_stats.numTileTriangles;
+			}
+		}
+	}
+}
+
+void SoftwareRasterizer::Clear(bool bColor, uint32 color, bool bDepth, float32 depth)
+{
+	// Triangles drawn before the clear must be shaded first. Clears are applied by the tiles as
+	// they are shaded, so they're parallel too.
+	if (!m_triangles.empty())
+		Flush();
+
+	if (bColor)
+	{
+		m_pendingClear.bColor = true;
+		m_pendingClear.color = color;
+	}
+	if (bDepth)
+	{
+		m_pendingClear.bDepth = true;
+		m_pendingClear.depth = depth;
+	}
+}
+
+void SoftwareRasterizer::Flush()
+{
+	if (m_triangles.empty() && !m_pendingClear.bColor && !m_pendingClear.bDepth)
+		return;
+
+	const float64 startTime = System::GetElapsedSeconds();
+	JobSystem::Instance().ParallelFor(m_tileBins.size(), [this] (size_t tileIndex) { ShadeTile(static_cast<int>(tileIndex)); });
+	m_stats.shadeSeconds += System::GetElapsedSeconds() - startTime;
+
+	m_triangles.clear();
+	for (auto& tileBin : m_tileBins)
+		tileBin.clear();
+
+	// Keep the current state for the next triangles
+	m_drawStates.erase(m_drawStates.begin(), m_drawStates.end() - 1);
+
+	m_pendingClear.bColor = false;
+	m_pendingClear.bDepth = false;
+}
+
+void SoftwareRasterizer::ShadeTile(int tileIndex)
+{
+	const int pitch = GetColorPitch();
+	const int tileMinX = (tileIndex % m_numTilesX) * kTileSize;
+	const int tileMinY = (tileIndex / m_numTilesX) * kTileSize;
+	const int tileMaxX = tileMinX + kTileSize - 1;
+	const int tileMaxY = tileMinY + kTileSize - 1;
+
+	if (m_pendingClear.bColor || m_pendingClear.bDepth)
+	{
+		for (int y = tileMinY; y <= tileMaxY; ++y)
+		{
+			const size_t rowStart = static_cast<size_t>(y) * pitch + tileMinX;
+			if (m_pendingClear.bColor)
+				std::fill_n(m_colorBuffer.begin() + rowStart, kTileSize, m_pendingClear.color);
+			if (m_pendingClear.bDepth)
+				std::fill_n(m_depthBuffer.begin() + rowStart, kTileSize, m_pendingClear.depth);
+		}
+	}
+
+	for (const uint32 binEntry : m_tileBins[tileIndex])
+	{
+		const Triangle& tri = m_triangles[binEntry & ~kFullyCovered];
+		const DrawState& state = m_drawStates[tri.stateIndex];
+
+		// Start on a SIMD boundary (tiles start on one too)
+		const int minX = MathEx::Max(tri.minX, tileMinX) & ~static_cast<int>(kSimdWidth - 1);
+		const int maxX = MathEx::Min(tri.maxX, tileMaxX);
+		const int minY = MathEx::Max(tri.minY, tileMinY);
+		const int maxY = MathEx::Min(tri.maxY, tileMaxY);
+
+		ShadeTriangle(tri, state, (binEntry & kFullyCovered) != 0, minX, maxX, minY, maxY, m_colorBuffer.data(), m_depthBuffer.data(), pitch);
+	}
+}
+
+SoftwareRasterizer::Stats SoftwareRasterizer::ResetStats()
+{
+	const Stats stats = m_stats;
+	m_stats.numTriangles = 0;
+	m_stats.numTileTriangles = 0;
+	m_stats.shadeSeconds = 0.0;
+	return stats;
+}
@@ -0,0 +1,129 @@
+#ifndef _SOFTWARE_RASTERIZER_H_
+#define _SOFTWARE_RASTERIZER_H_
+
+#include "gs/Base/Base.h"
+#include <memory>
+#include <vector>
+
+namespace BlendFactor
+{
+	enum Type
+	{
+		Zero,
+		One,
+		SrcAlpha,
+		OneMinusSrcAlpha
+	};
+}
+
+// Renders depth tested, textured, Gouraud shaded triangles on the CPU. Triangles are set up and
+// binned into screen tiles as they are drawn, and the tiles are shaded in parallel on the
+// JobSystem when the rasterizer is flushed, 4 pixels per SIMD op (see SIMD.h). Each tile draws its
+// triangles in submission order, so blending and depth ties resolve like they would on a GPU.
+//
+// Colors are RGBA8 (r in the lowest byte), and rows go from the bottom of the screen to the top,
+// like in GL. Triangles must already be clipped to the framebuffer and the near plane; lines and
+// points are drawn as triangles by the caller.
+class SoftwareRasterizer
+{
+public:
+	static const int kTileSize = 64; // In pixels, a multiple of the SIMD width
+
+	// RGBA8 texels, with power of 2 dimensions
+	struct Texture
+	{
+		int width;
+		int height;
+		std::vector<uint32> texels;
+	};
+	typedef std::shared_ptr<const Texture> TexturePtr;
+
+	// State used by the triangles drawn after it's set
+	struct DrawState
+	{
+		DrawState();
+		bool operator==(const DrawState& rhs) const;
+
+		TexturePtr pTexture; // Modulates the vertex color if set
+		bool bLinearFilter;
+		bool bClampS, bClampT; // Wrap otherwise
+		bool bDepthTest; // Passes if less or equal
+		bool bDepthWrite;
+		bool bBlend;
+		BlendFactor::Type srcFactor, dstFactor;
+	};
+
+	// Vertex in window coordinates: x and y in pixels, and z in [0,1]. Attributes are interpolated
+	// with perspective correction using invW (1/w of the clip space position).
+	struct Vertex
+	{
+		float32 x, y, z, invW;
+		float32 r, g, b, a;
+		float32 u, v;
+	};
+
+	struct Stats
+	{
+		uint32 numTriangles;		// Triangles drawn
+		uint32 numTileTriangles;	// Triangles shaded by each tile, summed over all tiles
+		float64 shadeSeconds;		// Time spent shading tiles
+	};
+
+	SoftwareRasterizer();
+	~SoftwareRasterizer();
+
+	// Resizes the framebuffer, whose contents are undefined until the next clear
+	void Resize(int width, int height);
+
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+	void SetDrawState(const DrawState& drawState);
+
+	// Draws a triangle with either winding; back-face culling is up to the caller
+	void DrawTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
+	// Clears the color buffer to color (RGBA8) and/or the depth buffer to depth
+	void Clear(bool bColor, uint32 color, bool bDepth, float32 depth);
+
+	// Shades the triangles drawn since the last flush
+	void Flush();
+
+	// Returns the color buffer, which is up to date after a flush. Rows are GetColorPitch()
+	// pixels apart.
+	const uint32* GetColorBuffer() const { return m_colorBuffer.data(); }
+	int GetColorPitch() const { return m_numTilesX * kTileSize; }
+
+	// Returns the counts since the last call
+	Stats ResetStats();
+
+private:
+	struct Triangle;
+	struct PendingClear
+	{
+		bool bColor;
+		bool bDepth;
+		uint32 color;
+		float32 depth;
+	};
+
+	void ShadeTile(int tileIndex);
+	static void ShadeTriangle(const Triangle& tri, const DrawState& state, bool bFullyCovered,
+		int minX, int maxX, int minY, int maxY, uint32* pColorBuffer, float32* pDepthBuffer, int pitch);
+
+	int m_width;
+	int m_height;
+	int m_numTilesX;
+	int m_numTilesY;
+	std::vector<uint32> m_colorBuffer;
+	std::vector<float32> m_depthBuffer;
+
+	std::vector<DrawState> m_drawStates; // Of the triangles since the last flush; the last one is current
+	std::vector<Triangle> m_triangles;
+	std::vector<std::vector<uint32>> m_tileBins; // Triangle indices, with kFullyCovered set for triangles that cover the whole tile
+	PendingClear m_pendingClear;
+
+	Stats m_stats;
+};
+
+#endif // _SOFTWARE_RASTERIZER_H_
@@ -0,0 +1,458 @@
+#include "VertexFormat.h"
+#include "gs/Math/SIMD.h"
+#include <cstring>
+#include <cmath>
+#include <cassert>
+
+namespace
+{
+	uint32 FloatBits(float32 f)
+	{
+		uint32 bits;
+		memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+
+	float32 BitsToFloat(uint32 bits)
+	{
+		float32 f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	uint32 GetFormatSize(VertexAttributeFormat::Type format)
+	{
+		switch (format)
+		{
+			case VertexAttributeFormat::None:			return 0;
+			case VertexAttributeFormat::Float2:			return 8;
+			case VertexAttributeFormat::Float3:			return 12;
+			case VertexAttributeFormat::Half2:			return 4;
+			case VertexAttributeFormat::UNorm16x3:		return 6;
+			case VertexAttributeFormat::OctSNorm16x2:	return 4;
+			case VertexAttributeFormat::UNorm8x4:		return 4;
+			default: assert(false && "Unknown vertex attribute format"); return 0;
+		}
+	}
+
+	// Whether format can encode attribute, i.e. decodes to the attribute's number of floats
+	bool CanEncode(VertexAttribute::Type attribute, VertexAttributeFormat::Type format)
+	{
+		switch (attribute)
+		{
+			case VertexAttribute::Position:	return format == VertexAttributeFormat::Float3 || format == VertexAttributeFormat::UNorm16x3;
+			case VertexAttribute::Normal:	return format == VertexAttributeFormat::None || format == VertexAttributeFormat::Float3 || format == VertexAttributeFormat::OctSNorm16x2;
+			case VertexAttribute::Color:	return format == VertexAttributeFormat::None || format == VertexAttributeFormat::UNorm8x4;
+			case VertexAttribute::TexCoord:	return format == VertexAttributeFormat::None || format == VertexAttributeFormat::Float2 || format == VertexAttributeFormat::Half2;
+			default: return false;
+		}
+	}
+
+	int32 Round(float32 f)
+	{
+		return static_cast<int32>(f >= 0.f ? f + 0.5f : f - 0.5f);
+	}
+
+	const float32* StridedAt(const float32* p, size_t stride, size_t index)
+	{
+		return reinterpret_cast<const float32*>(reinterpret_cast<const uint8*>(p) + stride * index);
+	}
+
+	float32* StridedAt(float32* p, size_t stride, size_t index)
+	{
+		return reinterpret_cast<float32*>(reinterpret_cast<uint8*>(p) + stride * index);
+	}
+
+	void PackAttribute(VertexAttributeFormat::Type format, const VertexLayout& layout, const float32* pSrc, size_t srcStride, uint8* pDst, size_t count)
+	{
+		switch (format)
+		{
+			case VertexAttributeFormat::Float2:
+			case VertexAttributeFormat::Float3:
+			{
+				const size_t size = GetFormatSize(format);
+				for (size_t i = 0; i < count; ++i)
+					memcpy(pDst + i * layout.stride, StridedAt(pSrc, srcStride, i), size);
+				break;
+			}
+
+			case VertexAttributeFormat::Half2:
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					const float32* pFloats = StridedAt(pSrc, srcStride, i);
+					const uint16 packed[2] = { VertexPacking::FloatToHalf(pFloats[0]), VertexPacking::FloatToHalf(pFloats[1]) };
+					memcpy(pDst + i * layout.stride, packed, sizeof(packed));
+				}
+				break;
+			}
+
+			case VertexAttributeFormat::UNorm16x3:
+			{
+				const Vector3& offset = layout.positionOffset;
+				const Vector3& scale = layout.positionScale;
+				const Vector3 invScale(scale.x > 0.f ? 1.f / scale.x : 0.f, scale.y > 0.f ? 1.f / scale.y : 0.f, scale.z > 0.f ? 1.f / scale.z : 0.f);
+				for (size_t i = 0; i < count; ++i)
+				{
+					const float32* pFloats = StridedAt(pSrc, srcStride, i);
+					uint16 packed[3];
+					for (int c = 0; c < 3; ++c)
+						packed[c] = static_cast<uint16>(MathEx::Clamp(Round((pFloats[c] - offset.v[c]) * invScale.v[c]), 0, 0xFFFF));
+					memcpy(pDst + i * layout.stride, packed, sizeof(packed));
+				}
+				break;
+			}
+
+			case VertexAttributeFormat::OctSNorm16x2:
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					const float32* pFloats = StridedAt(pSrc, srcStride, i);
+					int16 packed[2];
+					VertexPacking::OctEncode(Vector3(pFloats[0], pFloats[1], pFloats[2]), packed);
+					memcpy(pDst + i * layout.stride, packed, sizeof(packed));
+				}
+				break;
+			}
+
+			case VertexAttributeFormat::UNorm8x4:
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					const float32* pFloats = StridedAt(pSrc, srcStride, i);
+					uint8* pPacked = pDst + i * layout.stride;
+					for (int c = 0; c < 4; ++c)
+						pPacked[c] = static_cast<uint8>(Round(MathEx::Clamp(pFloats[c], 0.f, 1.f) * 255.f));
+				}
+				break;
+			}
+
+			default:
+				assert(false && "Unknown vertex attribute format");
+		}
+	}
+
+	void UnpackAttribute(VertexAttributeFormat::Type format, const VertexLayout& layout, const uint8* pSrc, float32* pDst, size_t dstStride, size_t count)
+	{
+		switch (format)
+		{
+			case VertexAttributeFormat::Float2:
+			case VertexAttributeFormat::Float3:
+			{
+				const size_t size = GetFormatSize(format);
+				for (size_t i = 0; i < count; ++i)
+					memcpy(StridedAt(pDst, dstStride, i), pSrc + i * layout.stride, size);
+				break;
+			}
+
+			case VertexAttributeFormat::Half2:
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					uint16 packed[2];
+					memcpy(packed, pSrc + i * layout.stride, sizeof(packed));
+					float32* pFloats = StridedAt(pDst, dstStride, i);
+					pFloats[0] = VertexPacking::HalfToFloat(packed[0]);
+					pFloats[1] = VertexPacking::HalfToFloat(packed[1]);
+				}
+				break;
+			}
+
+			case VertexAttributeFormat::UNorm16x3:
+			{
+				const Vector3& offset = layout.positionOffset;
+				const Vector3& scale = layout.positionScale;
+				for (size_t i = 0; i < count; ++i)
+				{
+					uint16 packed[3];
+					memcpy(packed, pSrc + i * layout.stride, sizeof(packed));
+					float32* pFloats = StridedAt(pDst, dstStride, i);
+					pFloats[0] = offset.x + packed[0] * scale.x;
+					pFloats[1] = offset.y + packed[1] * scale.y;
+					pFloats[2] = offset.z + packed[2] * scale.z;
+				}
+				break;
+			}
+
+			case VertexAttributeFormat::OctSNorm16x2:
+			{
+				size_t i = 0;
+#if GS_SIMD_SSE
+				// Same math as OctDecode, 4 normals at a time
+				const __m128 kInv32767 = _mm_set1_ps(1.f / 32767.f);
+				const __m128 kOne = _mm_set1_ps(1.f);
+				const __m128 kMinusOne = _mm_set1_ps(-1.f);
+				const __m128 kSignMask = _mm_set1_ps(-0.f);
+				for (; i + 4 <= count; i += 4)
+				{
+					int16 packed[4][2];
+					for (size_t lane = 0; lane < 4; ++lane)
+						memcpy(packed[lane], pSrc + (i + lane) * layout.stride, sizeof(packed[lane]));
+
+					__m128 x = _mm_setr_ps(packed[0][0], packed[1][0], packed[2][0], packed[3][0]);
+					__m128 y = _mm_setr_ps(packed[0][1], packed[1][1], packed[2][1], packed[3][1]);
+					x = _mm_max_ps(_mm_mul_ps(x, kInv32767), kMinusOne);
+					y = _mm_max_ps(_mm_mul_ps(y, kInv32767), kMinusOne);
+					__m128 z = _mm_sub_ps(_mm_sub_ps(kOne, SIMD::Abs(x)), SIMD::Abs(y));
+
+					const __m128 t = _mm_max_ps(_mm_xor_ps(z, kSignMask), _mm_setzero_ps());
+					x = _mm_sub_ps(x, _mm_or_ps(t, _mm_and_ps(x, kSignMask)));
+					y = _mm_sub_ps(y, _mm_or_ps(t, _mm_and_ps(y, kSignMask)));
+
+					const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+					const __m128 invLength = SIMD::RecipSqrt(lengthSquared);
+
+					float32 normalX[4], normalY[4], normalZ[4];
+					_mm_storeu_ps(normalX, _mm_mul_ps(x, invLength));
+					_mm_storeu_ps(normalY, _mm_mul_ps(y, invLength));
+					_mm_storeu_ps(normalZ, _mm_mul_ps(z, invLength));
+					for (size_t lane = 0; lane < 4; ++lane)
+					{
+						float32* pFloats = StridedAt(pDst, dstStride, i + lane);
+						pFloats[0] = normalX[lane];
+						pFloats[1] = normalY[lane];
+						pFloats[2] = normalZ[lane];
+					}
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					int16 packed[2];
+					memcpy(packed, pSrc + i * layout.stride, sizeof(packed));
+					const Vector3 normal = VertexPacking::OctDecode(packed);
+					float32* pFloats = StridedAt(pDst, dstStride, i);
+					pFloats[0] = normal.x;
+					pFloats[1] = normal.y;
+					pFloats[2] = normal.z;
+				}
+				break;
+			}
+
+			case VertexAttributeFormat::UNorm8x4:
+			{
+#if GS_SIMD_SSE
+				const __m128 kInv255 = _mm_set1_ps(1.f / 255.f);
+				const __m128i kZero = _mm_setzero_si128();
+				for (size_t i = 0; i < count; ++i)
+				{
+					int32 packed;
+					memcpy(&packed, pSrc + i * layout.stride, sizeof(packed));
+					const __m128i bytes = _mm_cvtsi32_si128(packed);
+					const __m128i ints = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, kZero), kZero);
+					_mm_storeu_ps(StridedAt(pDst, dstStride, i), _mm_mul_ps(_mm_cvtepi32_ps(ints), kInv255));
+				}
+#else
+				const float32 kInv255 = 1.f / 255.f;
+				for (size_t i = 0; i < count; ++i)
+				{
+					const uint8* pPacked = pSrc + i * layout.stride;
+					float32* pFloats = StridedAt(pDst, dstStride, i);
+					for (int c = 0; c < 4; ++c)
+						pFloats[c] = pPacked[c] * kInv255;
+				}
+#endif
+				break;
+			}
+
+			default:
+				assert(false && "Unknown vertex attribute format");
+		}
+	}
+
+	const float32* GetStream(const ConstVertexStreams& streams, VertexAttribute::Type attribute)
+	{
+		const float32* pStreams[] = { streams.position, streams.normal, streams.color, streams.texCoord };
+		static_assert(ARRAY_SIZE(pStreams) == VertexAttribute::NumTypes, "Mismatched array size");
+		return pStreams[attribute];
+	}
+
+	float32* GetStream(const VertexStreams& streams, VertexAttribute::Type attribute)
+	{
+		float32* pStreams[] = { streams.position, streams.normal, streams.color, streams.texCoord };
+		static_assert(ARRAY_SIZE(pStreams) == VertexAttribute::NumTypes, "Mismatched array size");
+		return pStreams[attribute];
+	}
+}
+
+VertexLayout VertexLayout::Create(uint32 flags, const AABB& bounds)
+{
+	VertexLayout layout;
+
+	const bool quantizePosition = (flags & VertexLayoutFlags::QuantizePosition) != 0;
+	layout.formats[VertexAttribute::Position] = quantizePosition ? VertexAttributeFormat::UNorm16x3 : VertexAttributeFormat::Float3;
+	layout.formats[VertexAttribute::Normal] = (flags & VertexLayoutFlags::Normal) ? VertexAttributeFormat::OctSNorm16x2 : VertexAttributeFormat::None;
+	layout.formats[VertexAttribute::Color] = (flags & VertexLayoutFlags::Color) ? VertexAttributeFormat::UNorm8x4 : VertexAttributeFormat::None;
+	layout.formats[VertexAttribute::TexCoord] = (flags & VertexLayoutFlags::TexCoord) ? VertexAttributeFormat::Half2 : VertexAttributeFormat::None;
+
+	layout.stride = 0;
+	for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+	{
+		layout.offsets[i] = layout.stride;
+		layout.stride += GetFormatSize(layout.formats[i]);
+	}
+
+	if (quantizePosition)
+	{
+		assert(!bounds.IsEmpty() && "Bounds required to quantize positions");
+		layout.positionOffset = bounds.min;
+		layout.positionScale = bounds.GetSize() * (1.f / 0xFFFF);
+	}
+	else
+	{
+		layout.positionOffset = Vector3::Zero();
+		layout.positionScale = Vector3(1.f, 1.f, 1.f);
+	}
+
+	return layout;
+}
+
+bool VertexLayout::operator==(const VertexLayout& rhs) const
+{
+	for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+	{
+		if (formats[i] != rhs.formats[i] || offsets[i] != rhs.offsets[i])
+			return false;
+	}
+	return stride == rhs.stride && positionOffset == rhs.positionOffset && positionScale == rhs.positionScale;
+}
+
+bool VertexLayout::IsValid() const
+{
+	for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+	{
+		if (!CanEncode(static_cast<VertexAttribute::Type>(i), formats[i]))
+			return false;
+		if (formats[i] != VertexAttributeFormat::None && (offsets[i] > stride || GetFormatSize(formats[i]) > stride - offsets[i]))
+			return false;
+	}
+	return true;
+}
+
+void PackVertices(const VertexLayout& layout, const ConstVertexStreams& src, size_t count, void* dst)
+{
+	uint8* pDst = static_cast<uint8*>(dst);
+
+	// Attribute at a time, so that the format switch is out of the inner loop
+	for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+	{
+		const auto attribute = static_cast<VertexAttribute::Type>(i);
+		const VertexAttributeFormat::Type format = layout.formats[attribute];
+		if (format == VertexAttributeFormat::None)
+			continue;
+
+		if (const float32* pSrc = GetStream(src, attribute))
+		{
+			PackAttribute(format, layout, pSrc, src.stride, pDst + layout.offsets[attribute], count);
+		}
+		else
+		{
+			const uint32 size = GetFormatSize(format);
+			for (size_t v = 0; v < count; ++v)
+				memset(pDst + v * layout.stride + layout.offsets[attribute], 0, size);
+		}
+	}
+}
+
+void UnpackVertices(const VertexLayout& layout, const void* src, size_t count, const VertexStreams& dst)
+{
+	const uint8* pSrc = static_cast<const uint8*>(src);
+
+	for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+	{
+		const auto attribute = static_cast<VertexAttribute::Type>(i);
+		const VertexAttributeFormat::Type format = layout.formats[attribute];
+		float32* pDst = GetStream(dst, attribute);
+		if (format == VertexAttributeFormat::None || !pDst)
+			continue;
+
+		UnpackAttribute(format, layout, pSrc + layout.offsets[attribute], pDst, dst.stride, count);
+	}
+}
+
+namespace VertexPacking
+{
+	uint16 FloatToHalf(float32 f)
+	{
+		uint32 bits = FloatBits(f);
+		const uint32 sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		uint32 half;
+		if (bits >= 0x47800000u) // >= 65536, inf or NaN
+		{
+			half = bits > 0x7F800000u ? 0x7E00u : 0x7C00u;
+		}
+		else if (bits < 0x38800000u) // Below smallest normal half, let the FPU round the denormal
+		{
+			const float32 denormMagic = BitsToFloat(((127u - 15u) + (23u - 10u) + 1u) << 23);
+			half = FloatBits(BitsToFloat(bits) + denormMagic) - FloatBits(denormMagic);
+		}
+		else
+		{
+			const uint32 mantissaOdd = (bits >> 13) & 1;
+			bits -= (127u - 15u) << 23; // Rebias exponent
+			bits += 0xFFFu; // Round
+			bits += mantissaOdd;
+			half = bits >> 13;
+		}
+
+		return static_cast<uint16>(half | (sign >> 16));
+	}
+
+	float32 HalfToFloat(uint16 h)
+	{
+		const uint32 shiftedExponent = 0x7C00u << 13;
+
+		uint32 bits = (h & 0x7FFFu) << 13;
+		const uint32 exponent = bits & shiftedExponent;
+		bits += (127u - 15u) << 23;
+
+		if (exponent == shiftedExponent) // Inf or NaN
+		{
+			bits += (128u - 16u) << 23;
+		}
+		else if (exponent == 0) // Zero or denormal, renormalize
+		{
+			bits += 1u << 23;
+			bits = FloatBits(BitsToFloat(bits) - BitsToFloat(113u << 23));
+		}
+
+		return BitsToFloat(bits | ((h & 0x8000u) << 16));
+	}
+
+	void OctEncode(const Vector3& normal, int16 encoded[2])
+	{
+		const float32 invL1Norm = 1.f / (MathEx::Abs(normal.x) + MathEx::Abs(normal.y) + MathEx::Abs(normal.z));
+		float32 x = normal.x * invL1Norm;
+		float32 y = normal.y * invL1Norm;
+
+		// Fold the lower hemisphere over the diagonals
+		if (normal.z < 0.f)
+		{
+			const float32 foldedX = (1.f - MathEx::Abs(y)) * (x >= 0.f ? 1.f : -1.f);
+			const float32 foldedY = (1.f - MathEx::Abs(x)) * (y >= 0.f ? 1.f : -1.f);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		encoded[0] = static_cast<int16>(Round(MathEx::Clamp(x, -1.f, 1.f) * 32767.f));
+		encoded[1] = static_cast<int16>(Round(MathEx::Clamp(y, -1.f, 1.f) * 32767.f));
+	}
+
+	Vector3 OctDecode(const int16 encoded[2])
+	{
+		const float32 kInv32767 = 1.f / 32767.f;
+		Vector3 v;
+		v.x = MathEx::Max(encoded[0] * kInv32767, -1.f);
+		v.y = MathEx::Max(encoded[1] * kInv32767, -1.f);
+		v.z = 1.f - MathEx::Abs(v.x) - MathEx::Abs(v.y);
+
+		// Unfold the lower hemisphere. Written without branches since signs are unpredictable:
+		// t = max(-z, 0) and the offset takes the sign of each component.
+		const float32 t = (MathEx::Abs(v.z) - v.z) * 0.5f;
+		v.x -= std::copysign(t, v.x);
+		v.y -= std::copysign(t, v.y);
+
+		return v * (1.f / v.Length());
+	}
+}
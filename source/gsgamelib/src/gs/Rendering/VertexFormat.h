@@ -0,0 +1,117 @@
+#ifndef _GS_VERTEX_FORMAT_H_
+#define _GS_VERTEX_FORMAT_H_
+
+// Compact vertex storage. A VertexLayout describes which attributes a packed vertex contains and
+// how each one is encoded; PackVertices/UnpackVertices convert between packed vertices and full
+// precision float attributes. With all attributes and quantized positions, a vertex takes 18 bytes:
+//
+//   position  UNorm16x3    6 bytes, relative to the bounds passed to VertexLayout::Create
+//   normal    OctSNorm16x2 4 bytes, octahedral encoding of a unit vector
+//   color     UNorm8x4     4 bytes, RGBA
+//   texCoord  Half2        4 bytes
+
+#include "gs/Base/Base.h"
+#include "gs/Math/Vector3.h"
+#include "gs/Math/Geometry.h"
+#include <cstddef>
+
+namespace VertexAttribute
+{
+	enum Type
+	{
+		Position,
+		Normal,
+		Color,
+		TexCoord,
+
+		NumTypes
+	};
+}
+
+namespace VertexAttributeFormat
+{
+	enum Type
+	{
+		None,			// Attribute not stored
+		Float2,
+		Float3,
+		Half2,
+		UNorm16x3,		// Dequantized with VertexLayout::positionOffset/positionScale
+		OctSNorm16x2,
+		UNorm8x4,
+	};
+}
+
+namespace VertexLayoutFlags
+{
+	enum Type
+	{
+		Normal				= 0x01,
+		Color				= 0x02,
+		TexCoord			= 0x04,
+		QuantizePosition	= 0x08,
+
+		All = Normal | Color | TexCoord | QuantizePosition
+	};
+}
+
+struct VertexLayout
+{
+	VertexAttributeFormat::Type formats[VertexAttribute::NumTypes];
+	uint32 offsets[VertexAttribute::NumTypes];
+	uint32 stride;
+
+	// Quantized positions are decoded as positionOffset + quantized * positionScale
+	Vector3 positionOffset;
+	Vector3 positionScale;
+
+	// Returns a layout with a position and the attributes in flags (combination of VertexLayoutFlags).
+	// Bounds must contain every position if positions are quantized.
+	static VertexLayout Create(uint32 flags, const AABB& bounds = AABB::Empty());
+
+	bool Has(VertexAttribute::Type attribute) const { return formats[attribute] != VertexAttributeFormat::None; }
+
+	// Returns true if every attribute has a format that can encode it, a position is stored, and
+	// every attribute fits within stride. For layouts read from files.
+	bool IsValid() const;
+
+	bool operator==(const VertexLayout& rhs) const;
+	bool operator!=(const VertexLayout& rhs) const { return !(*this == rhs); }
+};
+
+// Strided pointers to full precision attributes (3 floats for position and normal, 4 for color,
+// 2 for texCoord), typically pointing into an array of vertex structs. Null attributes are skipped.
+template <typename Float>
+struct VertexStreamsT
+{
+	VertexStreamsT() : position(nullptr), normal(nullptr), color(nullptr), texCoord(nullptr), stride(0) {}
+
+	Float* position;
+	Float* normal;
+	Float* color;
+	Float* texCoord;
+	size_t stride; // In bytes, shared by all attributes
+};
+
+typedef VertexStreamsT<float32> VertexStreams;
+typedef VertexStreamsT<const float32> ConstVertexStreams;
+
+// Encodes count vertices into dst, which must hold count * layout.stride bytes. Attributes that are
+// in the layout but missing from src are stored as zero.
+void PackVertices(const VertexLayout& layout, const ConstVertexStreams& src, size_t count, void* dst);
+
+// Decodes count vertices from src. Attributes that are not in the layout are left untouched in dst.
+void UnpackVertices(const VertexLayout& layout, const void* src, size_t count, const VertexStreams& dst);
+
+namespace VertexPacking
+{
+	// IEEE half precision, round to nearest even. Overflow saturates to infinity.
+	uint16 FloatToHalf(float32 f);
+	float32 HalfToFloat(uint16 h);
+
+	// Octahedral normal encoding: maps the unit sphere onto a square, with good precision everywhere
+	void OctEncode(const Vector3& normal, int16 encoded[2]);
+	Vector3 OctDecode(const int16 encoded[2]);
+}
+
+#endif // _GS_VERTEX_FORMAT_H_
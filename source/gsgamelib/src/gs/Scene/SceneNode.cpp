@@ -6,6 +6,7 @@ static SceneGraph g_sceneGraph;
 SceneNode::SceneNode(const private_constructor_tag&)
 	: m_bComputeL2P(false)
 	, m_bComputeL2W(false)
+	, m_bLocalIsQTS(false)
 	, m_localToParent(Matrix43::Identity())
 	, m_localToWorld(Matrix43::Identity())
 {
@@ -77,6 +78,14 @@ void SceneNode::DoDetachChild(const SceneNodeSharedPtr& psNode)
 
 Matrix43& SceneNode::ModifyLocalToParent()
 {
+	// Matrix becomes the authoritative local transform again
+	if (m_bLocalIsQTS)
+	{
+		const QTS qts = m_localToParentQTS;
+		m_localToParent.SetFromQTS(qts);
+		m_bLocalIsQTS = false;
+	}
+
 	// m_localToParent will be modified, so our L2W matrix and
 	// those of our children must be invalidated
 	RecurseSetComputeL2W();
@@ -91,6 +100,9 @@ Matrix43& SceneNode::ModifyLocalToWorld()
 	// and recompute it on demand.
 	SetComputeL2P();
 
+	// Local transform will be recomputed from L2W as a matrix
+	m_bLocalIsQTS = false;
+
 	// However, our children's L2W matrices are now invalid, so recurse and mark them
 	// as such
 	for (std::size_t i=0; i<GetNumChildren(); ++i)
@@ -101,7 +113,32 @@ Matrix43& SceneNode::ModifyLocalToWorld()
 	return m_localToWorld;
 }
 
-const Matrix43& SceneNode::GetLocalToParent() const
+QTS& SceneNode::ModifyLocalToParentQTS()
+{
+	if (!m_bLocalIsQTS)
+	{
+		// Read before switching, as the QTS shares its storage with the matrix
+		const QTS qts = GetLocalToParentQTS();
+		m_localToParentQTS = qts;
+		m_bLocalIsQTS = true;
+	}
+
+	RecurseSetComputeL2W();
+
+	return m_localToParentQTS;
+}
+
+QTS SceneNode::GetLocalToParentQTS() const
+{
+	if (m_bLocalIsQTS)
+		return m_localToParentQTS;
+
+	QTS qts;
+	qts.SetFromMatrix(GetLocalToParent());
+	return qts;
+}
+
+Matrix43 SceneNode::GetLocalToParent() const
 {
 	if (m_bComputeL2P)
 	{
@@ -128,6 +165,18 @@ const Matrix43& SceneNode::GetLocalToParent() const
 		m_bComputeL2P = false;
 	}
 
+	return GetStoredLocalToParent();
+}
+
+Matrix43 SceneNode::GetStoredLocalToParent() const
+{
+	if (m_bLocalIsQTS)
+	{
+		Matrix43 localToParent;
+		localToParent.SetFromQTS(m_localToParentQTS);
+		return localToParent;
+	}
+
 	return m_localToParent;
 }
 
@@ -141,7 +190,7 @@ const Matrix43& SceneNode::GetLocalToWorld() const
 			const Matrix43& parL2W = pParent->GetLocalToWorld();
 
 			// L2W = L2P * par.L2W
-			m_localToWorld = m_localToParent * parL2W;
+			m_localToWorld = GetStoredLocalToParent() * parL2W;
 		}
 		else
 		{
@@ -159,9 +208,12 @@ void SceneNode::PostAttachChild_UpdateTransform(const SceneNodeSharedPtr& psNode
 	// Node has a new parent, so set its world matrix to match its
 	// previous local matrix. This updates the local matrix to reflect
 	// the difference between the node and its new parent, effecively
-	// not moving it from where it was.
+	// not moving it from where it was. The local matrix is read first, as
+	// ModifyLocalToWorld brings a dirty world matrix up to date using the
+	// new parent.
+	const Matrix43 nodeL2P = psNode->GetLocalToParent();
 	Matrix43& nodeL2W = psNode->ModifyLocalToWorld();
-	nodeL2W = psNode->GetLocalToParent();
+	nodeL2W = nodeL2P;
 }
 
 void SceneNode::PreDetachChild_UpdateTransform(const SceneNodeSharedPtr& psNode)
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cassert>
 #include "gs/Math/Matrix43.h"
+#include "gs/Math/QTS.h"
 #include "SceneNodeComponent.h"
 
 // ps : shared pointer
@@ -157,9 +158,17 @@ public:
 	Matrix43& ModifyLocalToParent();
 	Matrix43& ModifyLocalToWorld();
 
-	const Matrix43& GetLocalToParent() const;
+	// Returned by value, as the local transform may be stored as a QTS
+	Matrix43 GetLocalToParent() const;
 	const Matrix43& GetLocalToWorld() const;
 
+	// Stores the local transform as a QTS instead of a matrix, until ModifyLocalToParent() or
+	// ModifyLocalToWorld() is called. Rotation and uniform scale are preserved exactly, so
+	// repeated modification doesn't accumulate skew.
+	QTS& ModifyLocalToParentQTS();
+	QTS GetLocalToParentQTS() const;
+	bool IsLocalToParentQTS() const { return m_bLocalIsQTS; }
+
 private:
 	void PostAttachChild_UpdateTransform(const SceneNodeSharedPtr& psNode);
 	void PreDetachChild_UpdateTransform(const SceneNodeSharedPtr& psNode);
@@ -170,11 +179,21 @@ private:
 	void SetComputeL2P();
 	void SetComputeL2W();
 
+	// Local transform as it's stored, without recomputing it from L2W
+	Matrix43 GetStoredLocalToParent() const;
+
 	// L2W and L2P matrices are cached version that are
 	// recomputed when necessary
 	mutable bool m_bComputeL2P;
 	mutable bool m_bComputeL2W;
-	mutable Matrix43 m_localToParent;
+
+	// The local transform is either a matrix or a QTS, never both
+	bool m_bLocalIsQTS;
+	union
+	{
+		mutable Matrix43 m_localToParent;
+		QTS m_localToParentQTS;
+	};
 	mutable Matrix43 m_localToWorld;
 #pragma endregion Transform
 
@@ -304,6 +323,16 @@ public:
 		}
 	}
 
+	// Renders only the components that can (bParallel) or can't render in parallel
+	void Render(bool bParallel)
+	{
+		for (auto pComponent : m_components)
+		{
+			if (pComponent->IsEnabled() && pComponent->CanRenderInParallel() == bParallel)
+				pComponent->Render();
+		}
+	}
+
 private:
 	template <typename ComponentT>
 	void TryGetComponentsInto(std::vector<ComponentT*>& result)
@@ -25,8 +25,14 @@ public:
 	bool IsEnabled() const { return m_enabled; }
 
 	virtual void Update(float32 deltaTime) {}
+	// Called on the update thread, which may not own the GL context, so components draw by
+	// submitting to a render queue rather than making GL calls
 	virtual void Render() {}
 
+	// Return true if Render is thread safe, so that it can be called from a job, in parallel with
+	// other components
+	virtual bool CanRenderInParallel() const { return false; }
+
 protected:
 	virtual void OnPostAddComponent(SceneNode& owner) {}
 	virtual void OnPreRemoveComponent(SceneNode& owner) {}
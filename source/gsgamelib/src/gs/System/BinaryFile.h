@@ -0,0 +1,58 @@
+#ifndef _BINARY_FILE_H_
+#define _BINARY_FILE_H_
+
+#include "gs/Base/Base.h"
+#include <vector>
+#include <cassert>
+
+// Helpers for binary file formats that are written into memory with offsets to their sections,
+// and read back in place (see MappedFile)
+namespace BinaryFile
+{
+	// alignment must be a power of 2
+	inline uint32 AlignUp(uint32 value, uint32 alignment)
+	{
+		assert((alignment & (alignment - 1)) == 0);
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Returns true if [offset, offset + size) lies within a file of fileSize bytes
+	inline bool InFile(uint64 offset, uint64 size, uint64 fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+
+	// Appends data to a growing buffer, returning the offsets it was written at so that records
+	// written earlier can be patched to point to it
+	class Writer
+	{
+	public:
+		uint32 GetSize() const { return static_cast<uint32>(m_buffer.size()); }
+		const uint8* GetData() const { return m_buffer.data(); }
+
+		uint32 Write(const void* pData, size_t size)
+		{
+			const uint32 offset = GetSize();
+			m_buffer.insert(m_buffer.end(), static_cast<const uint8*>(pData), static_cast<const uint8*>(pData) + size);
+			return offset;
+		}
+
+		// Pads with zeros up to the next multiple of alignment
+		void Align(uint32 alignment)
+		{
+			m_buffer.resize(AlignUp(GetSize(), alignment), 0);
+		}
+
+		template <typename T>
+		T& At(uint32 offset)
+		{
+			assert(offset + sizeof(T) <= m_buffer.size());
+			return *reinterpret_cast<T*>(&m_buffer[offset]);
+		}
+
+	private:
+		std::vector<uint8> m_buffer;
+	};
+}
+
+#endif // _BINARY_FILE_H_
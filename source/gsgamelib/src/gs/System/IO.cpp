@@ -0,0 +1,99 @@
+#include "IO.h"
+#include <cstdio>
+
+#ifdef WIN32
+#include "gs/Platform/Win32/Win32Headers.h"
+#else
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
+int64 IO::File::GetSize(const std::string& path)
+{
+#ifdef WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!::GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes) || (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		return -1;
+	return (static_cast<int64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+#else
+	struct stat fileStat;
+	if (::stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+		return -1;
+	return static_cast<int64>(fileStat.st_size);
+#endif
+}
+
+bool IO::File::ReadAllBytes(const std::string& path, std::vector<uint8>& bytes)
+{
+	FILE* pFile = fopen(path.c_str(), "rb");
+	if (!pFile)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	const long size = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	bytes.resize(size > 0? static_cast<size_t>(size) : 0);
+	const bool bRead = size >= 0 && fread(bytes.data(), 1, bytes.size(), pFile) == bytes.size();
+	fclose(pFile);
+	return bRead;
+}
+
+std::vector<std::string> IO::Directory::GetFiles(const std::string& path, bool bRecursive)
+{
+	std::vector<std::string> files;
+	std::vector<std::string> subDirectories;
+
+#ifdef WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE hFind = ::FindFirstFileA(Path::Combine(path, "*").c_str(), &findData);
+	if (hFind != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			const std::string name = findData.cFileName;
+			if (name == "." || name == "..")
+				continue;
+
+			if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				subDirectories.push_back(Path::Combine(path, name));
+			else
+				files.push_back(Path::Combine(path, name));
+		}
+		while (::FindNextFileA(hFind, &findData));
+		::FindClose(hFind);
+	}
+#else
+	if (DIR* pDir = ::opendir(path.c_str()))
+	{
+		while (dirent* pEntry = ::readdir(pDir))
+		{
+			const std::string name = pEntry->d_name;
+			if (name == "." || name == "..")
+				continue;
+
+			struct stat fileStat;
+			const std::string entryPath = path + Path::AltDirectorySeparatorChar + name;
+			if (::stat(entryPath.c_str(), &fileStat) != 0)
+				continue;
+
+			if (S_ISDIR(fileStat.st_mode))
+				subDirectories.push_back(entryPath);
+			else
+				files.push_back(entryPath);
+		}
+		::closedir(pDir);
+	}
+#endif
+
+	if (bRecursive)
+	{
+		for (const auto& subDirectory : subDirectories)
+		{
+			std::vector<std::string> subFiles = GetFiles(subDirectory, true);
+			files.insert(files.end(), subFiles.begin(), subFiles.end());
+		}
+	}
+
+	return files;
+}
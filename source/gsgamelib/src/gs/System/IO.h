@@ -3,7 +3,9 @@
 
 // Input/Output utilities inspired largely by .NET's System.IO
 
+#include "gs/Base/Base.h"
 #include <string>
+#include <vector>
 
 namespace IO
 {
@@ -11,7 +13,11 @@ namespace IO
 	{
 		typedef std::string string;
 
+#ifdef WIN32
 		const char DirectorySeparatorChar = '\\';
+#else
+		const char DirectorySeparatorChar = '/';
+#endif
 		const char AltDirectorySeparatorChar = '/';
 		const char DirectorySeparatorChars[] = {DirectorySeparatorChar, AltDirectorySeparatorChar, 0};
 
@@ -24,6 +30,24 @@ namespace IO
 		string ChangeExtension(const string& path, const string& extension);
 
 	} // namespace Path
+
+	namespace File
+	{
+		// Returns -1 if the file doesn't exist
+		int64 GetSize(const std::string& path);
+
+		// Returns false if the file can't be opened or read
+		bool ReadAllBytes(const std::string& path, std::vector<uint8>& bytes);
+
+	} // namespace File
+
+	namespace Directory
+	{
+		// Returns the paths of the files in a directory (combined with path), and those in its
+		// subdirectories if bRecursive is true
+		std::vector<std::string> GetFiles(const std::string& path, bool bRecursive = false);
+
+	} // namespace Directory
 } // namespace IO
 
 
@@ -70,7 +94,7 @@ namespace IO
 			return path1 + DirectorySeparatorChar + path2;
 		}
 
-		string ChangeExtension(const string& path, const string& extension)
+		inline string ChangeExtension(const string& path, const string& extension)
 		{
 			const string& d = GetDirectoryName(path);
 			const string& f = GetFileNameWithoutExtension(path);
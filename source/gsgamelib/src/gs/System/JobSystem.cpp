@@ -0,0 +1,172 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <atomic>
+#include <exception>
+#include <cassert>
+
+struct JobSystem::Batch
+{
+	Batch(size_t count, const Job& job)
+		: m_job(job), m_count(count), m_nextIndex(0), m_numRemaining(count)
+	{
+	}
+
+	const Job m_job;
+	const size_t m_count;
+	std::atomic<size_t> m_nextIndex;
+	std::atomic<size_t> m_numRemaining;
+
+	std::mutex m_mutex;
+	std::condition_variable m_completed;
+	std::exception_ptr m_pException;
+};
+
+JobSystem::JobSystem()
+	: m_isInitialized(false)
+	, m_isShuttingDown(false)
+{
+}
+
+void JobSystem::Initialize(uint32 numWorkers)
+{
+	Shutdown();
+
+	if (numWorkers == kDefaultNumWorkers)
+	{
+		const uint32 numHardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = numHardwareThreads > 1? numHardwareThreads - 1 : 0;
+	}
+
+#ifdef GS_PROFILER
+	// Created here rather than by the first worker to name itself, as Instance isn't thread safe
+	Profiler::Instance();
+#endif
+
+	m_isShuttingDown = false;
+	m_isInitialized = true;
+	for (uint32 i = 0; i < numWorkers; ++i)
+		m_workers.emplace_back(&JobSystem::WorkerMain, this, i);
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShuttingDown = true;
+	}
+	m_batchAdded.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+
+	m_workers.clear();
+	m_isInitialized = false;
+}
+
+void JobSystem::ParallelFor(size_t count, const Job& job)
+{
+	if (count == 0)
+		return;
+
+	if (!m_isInitialized)
+		Initialize();
+
+	auto pBatch = std::make_shared<Batch>(count, job);
+
+	if (count > 1 && !m_workers.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_batches.push_back(pBatch);
+		}
+		m_batchAdded.notify_all();
+	}
+
+	// Work on our own batch rather than just waiting for it
+	RunJobs(*pBatch);
+
+	{
+		std::unique_lock<std::mutex> lock(pBatch->m_mutex);
+		pBatch->m_completed.wait(lock, [&] { return pBatch->m_numRemaining == 0; });
+	}
+
+	if (pBatch->m_pException)
+		std::rethrow_exception(pBatch->m_pException);
+}
+
+void JobSystem::RunAsync(const AsyncJob& job)
+{
+	if (!m_isInitialized)
+		Initialize();
+
+	auto pBatch = std::make_shared<Batch>(1, [job] (size_t) { job(); });
+
+	if (m_workers.empty())
+	{
+		RunJobs(*pBatch);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_batches.push_back(pBatch);
+	}
+	m_batchAdded.notify_one();
+}
+
+void JobSystem::WorkerMain(uint32 workerIndex)
+{
+	PROFILE_THREAD_NAME("Worker " + std::to_string(workerIndex));
+
+	for (;;)
+	{
+		std::shared_ptr<Batch> pBatch;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_batchAdded.wait(lock, [&] { return m_isShuttingDown || !m_batches.empty(); });
+			if (m_batches.empty())
+				return; // Shutting down
+
+			pBatch = m_batches.front();
+
+			// Every index of the batch will have been claimed by the threads running it once we're
+			// done, so no other worker needs to find it
+			if (pBatch->m_nextIndex >= pBatch->m_count)
+			{
+				m_batches.pop_front();
+				continue;
+			}
+		}
+
+		RunJobs(*pBatch);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_batches.empty() && m_batches.front() == pBatch)
+			m_batches.pop_front();
+	}
+}
+
+void JobSystem::RunJobs(Batch& batch)
+{
+	size_t numCompleted = 0;
+	for (size_t index = batch.m_nextIndex++; index < batch.m_count; index = batch.m_nextIndex++)
+	{
+		try
+		{
+			batch.m_job(index);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(batch.m_mutex);
+			if (!batch.m_pException)
+				batch.m_pException = std::current_exception();
+		}
+		++numCompleted;
+	}
+
+	if (numCompleted > 0 && (batch.m_numRemaining -= numCompleted) == 0)
+	{
+		std::lock_guard<std::mutex> lock(batch.m_mutex);
+		batch.m_completed.notify_all();
+	}
+}
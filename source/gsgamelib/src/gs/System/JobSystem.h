@@ -0,0 +1,63 @@
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+#include "gs/Base/Base.h"
+#include "gs/Base/Singleton.h"
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Pool of worker threads that run data parallel jobs. The calling thread works on its own jobs too,
+// so ParallelFor makes progress even with no workers, and nested calls from a job don't deadlock.
+class JobSystem : public Singleton<JobSystem>
+{
+private:
+	friend class Singleton<JobSystem>;
+	JobSystem();
+
+public:
+	~JobSystem() { Shutdown(); }
+
+	static const uint32 kDefaultNumWorkers = ~0u; // One per hardware thread, not counting the caller
+
+	// Starts numWorkers worker threads (0 is valid: jobs then all run on the calling thread).
+	// Called with the default on first use if not called explicitly. Initialize and Shutdown must
+	// not be called while jobs are running.
+	void Initialize(uint32 numWorkers = kDefaultNumWorkers);
+
+	// Waits for the workers to finish their current jobs and joins them
+	void Shutdown();
+
+	uint32 GetNumWorkers() const { return static_cast<uint32>(m_workers.size()); }
+
+	// Invokes job(i) for every i in [0, count), spread across the workers and the calling thread,
+	// and returns once all have completed. If any job throws, the first exception is rethrown
+	// here after the others have completed.
+	typedef std::function<void (size_t index)> Job;
+	void ParallelFor(size_t count, const Job& job);
+
+	// Queues job to run on a worker and returns without waiting for it. Exceptions thrown by the
+	// job are dropped, so it should handle its own errors. With no workers, the job runs before
+	// this returns. Shutdown waits for queued jobs to complete.
+	typedef std::function<void ()> AsyncJob;
+	void RunAsync(const AsyncJob& job);
+
+private:
+	struct Batch;
+
+	void WorkerMain(uint32 workerIndex);
+	static void RunJobs(Batch& batch);
+
+	std::vector<std::thread> m_workers;
+	std::deque<std::shared_ptr<Batch>> m_batches; // Batches with jobs that haven't been started
+	std::mutex m_mutex;
+	std::condition_variable m_batchAdded;
+	bool m_isInitialized;
+	bool m_isShuttingDown;
+};
+
+#endif // _JOB_SYSTEM_H_
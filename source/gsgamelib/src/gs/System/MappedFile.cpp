@@ -0,0 +1,97 @@
+#include "MappedFile.h"
+
+#ifdef WIN32
+#include "gs/Platform/Win32/Win32Headers.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: m_pData(nullptr)
+	, m_size(0)
+#ifdef WIN32
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(nullptr)
+#else
+	, m_fd(-1)
+#endif
+{
+}
+
+#ifdef WIN32
+
+std::shared_ptr<MappedFile> MappedFile::Open(const char* pFileName)
+{
+	std::shared_ptr<MappedFile> pFile(new MappedFile);
+
+	pFile->m_hFile = ::CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (pFile->m_hFile == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(pFile->m_hFile, &size))
+		return nullptr;
+
+	pFile->m_size = static_cast<size_t>(size.QuadPart);
+	if (pFile->m_size == 0) // Can't map an empty file, but it's still a valid (empty) view
+		return pFile;
+
+	pFile->m_hMapping = ::CreateFileMappingA(pFile->m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!pFile->m_hMapping)
+		return nullptr;
+
+	pFile->m_pData = static_cast<const uint8*>(::MapViewOfFile(pFile->m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!pFile->m_pData)
+		return nullptr;
+
+	return pFile;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData)
+		::UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		::CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		::CloseHandle(m_hFile);
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::Open(const char* pFileName)
+{
+	std::shared_ptr<MappedFile> pFile(new MappedFile);
+
+	pFile->m_fd = ::open(pFileName, O_RDONLY);
+	if (pFile->m_fd < 0)
+		return nullptr;
+
+	struct stat fileStat;
+	if (::fstat(pFile->m_fd, &fileStat) != 0)
+		return nullptr;
+
+	pFile->m_size = static_cast<size_t>(fileStat.st_size);
+	if (pFile->m_size == 0)
+		return pFile;
+
+	void* pData = ::mmap(nullptr, pFile->m_size, PROT_READ, MAP_PRIVATE, pFile->m_fd, 0);
+	if (pData == MAP_FAILED)
+		return nullptr;
+
+	pFile->m_pData = static_cast<const uint8*>(pData);
+	return pFile;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData)
+		::munmap(const_cast<uint8*>(m_pData), m_size);
+	if (m_fd >= 0)
+		::close(m_fd);
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include "gs/Base/Base.h"
+#include <memory>
+#include <cassert>
+
+// Read-only memory mapped view of an entire file. Pages are brought in by the OS on first access,
+// so opening is cheap regardless of file size, and the data can be referenced in place for as long
+// as the MappedFile is alive (share ownership with the returned shared_ptr to extend its lifetime).
+class MappedFile
+{
+public:
+	// Returns nullptr if the file doesn't exist or can't be mapped
+	static std::shared_ptr<MappedFile> Open(const char* pFileName);
+
+	~MappedFile();
+
+	const uint8* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+
+	// Returns a pointer into the mapped data that keeps this file mapped while it is referenced
+	template <typename T>
+	static std::shared_ptr<const T> GetSharedData(const std::shared_ptr<MappedFile>& pFile, size_t offset)
+	{
+		assert(offset <= pFile->GetSize());
+		return std::shared_ptr<const T>(pFile, reinterpret_cast<const T*>(pFile->GetData() + offset));
+	}
+
+private:
+	MappedFile();
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const uint8* m_pData;
+	size_t m_size;
+
+#ifdef WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#else
+	int m_fd;
+#endif
+};
+
+#endif // _MAPPED_FILE_H_
@@ -0,0 +1,319 @@
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <cassert>
+
+namespace
+{
+	// Per thread, so 1 MB each
+	const uint32 kThreadBufferCapacity = 64 * 1024;
+
+	uint64 GetTicks()
+	{
+		return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	float64 TicksToSeconds(uint64 ticks)
+	{
+		return ticks * 1e-9;
+	}
+
+	// Appends s as a JSON string
+	void AppendJsonString(std::string& json, const char* s)
+	{
+		json += '"';
+		for (; *s; ++s)
+		{
+			if (*s == '"' || *s == '\\')
+				json += '\\';
+			json += *s;
+		}
+		json += '"';
+	}
+}
+
+thread_local Profiler::ThreadBuffer* Profiler::ms_pThreadBuffer = nullptr;
+
+// Ring buffer of the scopes that one thread began and ended. The thread writes events and the
+// thread that calls EndFrame reads them, each moving its own index forward, so neither locks.
+struct Profiler::ThreadBuffer
+{
+	// A scope beginning, or ending for a null name
+	struct Event
+	{
+		const char* name;
+		uint64 ticks;
+	};
+
+	struct OpenScope
+	{
+		const char* name;
+		uint64 beginTicks;
+		uint32 nodeIndex;
+	};
+
+	ThreadBuffer() : events(kThreadBufferCapacity), writeIndex(0), readIndex(0), numOpenScopes(0), numDroppedScopes(0) {}
+
+	std::vector<Event> events;
+	std::atomic<uint64> writeIndex; // Only written by the thread
+	std::atomic<uint64> readIndex; // Only written by the reader
+	uint32 numOpenScopes; // Recorded scopes that haven't ended, as seen by the thread
+	std::atomic<uint32> numDroppedScopes;
+
+	// Reader state
+	std::string name;
+	std::vector<OpenScope> openScopes; // Scopes that began but haven't ended, as read back so far
+};
+
+struct Profiler::TraceEvent
+{
+	const char* name;
+	uint32 threadIndex;
+	uint64 beginTicks;
+	uint64 endTicks;
+};
+
+Profiler::Profiler()
+	: m_lastFrameTicks(0)
+	, m_bTracing(false)
+	, m_traceStartTicks(0)
+{
+	m_frame.seconds = 0.0;
+	m_lastFrame.seconds = 0.0;
+}
+
+Profiler::~Profiler()
+{
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+	if (!ms_pThreadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_threadBuffers.emplace_back(new ThreadBuffer());
+		ms_pThreadBuffer = m_threadBuffers.back().get();
+		ms_pThreadBuffer->name = "Thread " + std::to_string(m_threadBuffers.size() - 1);
+	}
+	return *ms_pThreadBuffer;
+}
+
+bool Profiler::BeginScope(const char* name)
+{
+	assert(name);
+	ThreadBuffer& threadBuffer = GetThreadBuffer();
+	const uint64 writeIndex = threadBuffer.writeIndex.load(std::memory_order_relaxed);
+	const uint64 readIndex = threadBuffer.readIndex.load(std::memory_order_acquire);
+
+	// Leave room for this scope's end, and the ends of the scopes it's nested in
+	if (kThreadBufferCapacity - (writeIndex - readIndex) < threadBuffer.numOpenScopes + 2)
+	{
+		threadBuffer.numDroppedScopes.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	ThreadBuffer::Event& event = threadBuffer.events[writeIndex % kThreadBufferCapacity];
+	event.name = name;
+	event.ticks = GetTicks();
+	threadBuffer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+	++threadBuffer.numOpenScopes;
+	return true;
+}
+
+void Profiler::EndScope()
+{
+	const uint64 ticks = GetTicks();
+	ThreadBuffer& threadBuffer = GetThreadBuffer();
+	assert(threadBuffer.numOpenScopes > 0);
+	const uint64 writeIndex = threadBuffer.writeIndex.load(std::memory_order_relaxed);
+
+	ThreadBuffer::Event& event = threadBuffer.events[writeIndex % kThreadBufferCapacity];
+	event.name = nullptr;
+	event.ticks = ticks;
+	threadBuffer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+	--threadBuffer.numOpenScopes;
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer& threadBuffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	threadBuffer.name = name;
+}
+
+uint32 Profiler::FindOrAddNode(int32 parentIndex, uint32 threadIndex, const char* name)
+{
+	std::vector<Node>& nodes = m_frame.nodes;
+	for (uint32 i = parentIndex + 1; i < nodes.size(); ++i)
+	{
+		const Node& node = nodes[i];
+		if (node.parentIndex == parentIndex && node.threadIndex == threadIndex && node.name == name)
+			return i;
+	}
+
+	Node node;
+	node.name = name;
+	node.parentIndex = parentIndex;
+	node.threadIndex = threadIndex;
+	node.depth = parentIndex < 0? 0 : nodes[parentIndex].depth + 1;
+	node.numCalls = 0;
+	node.totalSeconds = 0.0;
+	nodes.push_back(node);
+	return static_cast<uint32>(nodes.size() - 1);
+}
+
+void Profiler::ReadThreadBuffer(ThreadBuffer& threadBuffer, uint32 threadIndex)
+{
+	const uint64 writeIndex = threadBuffer.writeIndex.load(std::memory_order_acquire);
+	uint64 readIndex = threadBuffer.readIndex.load(std::memory_order_relaxed);
+
+	for (; readIndex < writeIndex; ++readIndex)
+	{
+		const ThreadBuffer::Event& event = threadBuffer.events[readIndex % kThreadBufferCapacity];
+		std::vector<ThreadBuffer::OpenScope>& openScopes = threadBuffer.openScopes;
+
+		if (event.name)
+		{
+			const int32 parentIndex = openScopes.empty()? -1 : static_cast<int32>(openScopes.back().nodeIndex);
+			const ThreadBuffer::OpenScope openScope = { event.name, event.ticks, FindOrAddNode(parentIndex, threadIndex, event.name) };
+			openScopes.push_back(openScope);
+			continue;
+		}
+
+		assert(!openScopes.empty() && "Scope ended that didn't begin");
+		const ThreadBuffer::OpenScope& openScope = openScopes.back();
+		Node& node = m_frame.nodes[openScope.nodeIndex];
+		++node.numCalls;
+		node.totalSeconds += TicksToSeconds(event.ticks - openScope.beginTicks);
+
+		if (m_bTracing && openScope.beginTicks >= m_traceStartTicks)
+		{
+			const TraceEvent traceEvent = { openScope.name, threadIndex, openScope.beginTicks, event.ticks };
+			m_traceEvents.push_back(traceEvent);
+		}
+
+		openScopes.pop_back();
+	}
+
+	threadBuffer.readIndex.store(readIndex, std::memory_order_release);
+}
+
+void Profiler::EndFrame()
+{
+	const uint64 ticks = GetTicks();
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (uint32 i = 0; i < m_threadBuffers.size(); ++i)
+		ReadThreadBuffer(*m_threadBuffers[i], i);
+
+	m_frame.seconds = m_lastFrameTicks == 0? 0.0 : TicksToSeconds(ticks - m_lastFrameTicks);
+	m_lastFrameTicks = ticks;
+	std::swap(m_lastFrame, m_frame);
+	m_frame.nodes.clear();
+
+	// Scopes still running carry over to the next frame
+	for (uint32 i = 0; i < m_threadBuffers.size(); ++i)
+	{
+		int32 parentIndex = -1;
+		for (ThreadBuffer::OpenScope& openScope : m_threadBuffers[i]->openScopes)
+		{
+			openScope.nodeIndex = FindOrAddNode(parentIndex, i, openScope.name);
+			parentIndex = static_cast<int32>(openScope.nodeIndex);
+		}
+	}
+}
+
+void Profiler::PrintNode(int32 nodeIndex) const
+{
+	const Node& node = m_lastFrame.nodes[nodeIndex];
+	const int indent = 2 * (node.depth + 1);
+	printf("%*s%-*s %8.3f ms %6u calls\n", indent, "", 40 - indent, node.name, node.totalSeconds * 1000.0, node.numCalls);
+
+	for (uint32 i = nodeIndex + 1; i < m_lastFrame.nodes.size(); ++i)
+	{
+		if (m_lastFrame.nodes[i].parentIndex == nodeIndex)
+			PrintNode(static_cast<int32>(i));
+	}
+}
+
+void Profiler::PrintLastFrame() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	printf("Profile of last frame (%.3f ms):\n", m_lastFrame.seconds * 1000.0);
+	for (uint32 threadIndex = 0; threadIndex < m_threadBuffers.size(); ++threadIndex)
+	{
+		const ThreadBuffer& threadBuffer = *m_threadBuffers[threadIndex];
+		const uint32 numDroppedScopes = threadBuffer.numDroppedScopes.load(std::memory_order_relaxed);
+
+		bool bPrintedName = false;
+		for (uint32 i = 0; i < m_lastFrame.nodes.size(); ++i)
+		{
+			const Node& node = m_lastFrame.nodes[i];
+			if (node.threadIndex != threadIndex || node.parentIndex != -1)
+				continue;
+
+			if (!bPrintedName)
+			{
+				if (numDroppedScopes > 0)
+					printf("%s (%u scopes dropped)\n", threadBuffer.name.c_str(), numDroppedScopes);
+				else
+					printf("%s\n", threadBuffer.name.c_str());
+				bPrintedName = true;
+			}
+			PrintNode(static_cast<int32>(i));
+		}
+	}
+}
+
+void Profiler::StartTrace()
+{
+	m_traceEvents.clear();
+	m_traceStartTicks = GetTicks();
+	m_bTracing = true;
+}
+
+void Profiler::StopTrace(const char* fileName)
+{
+	assert(m_bTracing);
+	m_bTracing = false;
+
+	// Formatted here rather than with str_format, which isn't thread safe
+	char buffer[256];
+	std::string json = "{\"traceEvents\":[\n";
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (uint32 i = 0; i < m_threadBuffers.size(); ++i)
+		{
+			snprintf(buffer, sizeof(buffer), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", i);
+			json += buffer;
+			AppendJsonString(json, m_threadBuffers[i]->name.c_str());
+			json += "}},\n";
+		}
+	}
+
+	// Complete events, with times in microseconds since the trace started
+	for (const TraceEvent& traceEvent : m_traceEvents)
+	{
+		json += "{\"name\":";
+		AppendJsonString(json, traceEvent.name);
+		snprintf(buffer, sizeof(buffer), ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", traceEvent.threadIndex,
+			(traceEvent.beginTicks - m_traceStartTicks) / 1000.0, (traceEvent.endTicks - traceEvent.beginTicks) / 1000.0);
+		json += buffer;
+	}
+	if (json.compare(json.size() - 2, 2, ",\n") == 0)
+		json.erase(json.size() - 2, 1); // Trailing comma
+	json += "],\"displayTimeUnit\":\"ms\"}\n";
+	m_traceEvents.clear();
+
+	FILE* pFile = fopen(fileName, "wb");
+	if (!pFile)
+		throw std::runtime_error(std::string("Profiler::StopTrace: failed to open ") + fileName + " for writing");
+
+	fwrite(json.data(), 1, json.size(), pFile);
+	const bool bFailed = ferror(pFile) != 0;
+	fclose(pFile);
+	if (bFailed)
+		throw std::runtime_error(std::string("Profiler::StopTrace: failed to write ") + fileName);
+}
@@ -0,0 +1,131 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include "gs/Base/Base.h"
+#include "gs/Base/Singleton.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Hierarchical CPU profiler. Code is instrumented with PROFILE_SCOPE("name"), which times the
+// enclosing scope on whichever thread runs it; scopes nested at run time are nested in the profile.
+// Each thread records begin and end timestamps into its own ring buffer without locking, and
+// EndFrame, called once per frame, reads them back into the frame's hierarchy of scopes and, while
+// tracing, into a trace that's saved in the Chrome trace event format (open it in about:tracing or
+// ui.perfetto.dev).
+//
+// Instrumentation is compiled in when GS_PROFILER is defined (see gsgamelib's CMakeLists.txt).
+// Without it, the macros expand to nothing and the profiler records nothing.
+//
+// The instance must be created on the main thread before other threads profile (naming the main
+// thread with PROFILE_THREAD_NAME does this).
+class Profiler : public Singleton<Profiler>
+{
+private:
+	friend class Singleton<Profiler>;
+	Profiler();
+
+public:
+	~Profiler();
+
+	// A scope as it ran on one thread during a frame: all the times it ran with the same parent
+	// scope are added together
+	struct Node
+	{
+		const char* name;
+		int32 parentIndex; // -1 for the thread's top level scopes
+		uint32 threadIndex;
+		uint32 depth;
+		uint32 numCalls; // Times the scope ended during the frame
+		float64 totalSeconds;
+	};
+
+	struct Frame
+	{
+		std::vector<Node> nodes; // Parents come before their children
+		float64 seconds; // Since the previous EndFrame
+	};
+
+	// name must be a string literal (or otherwise outlive the profiler), as only the pointer is
+	// recorded. Returns false if the thread's buffer is full, in which case the scope is dropped
+	// and EndScope must not be called for it.
+	bool BeginScope(const char* name);
+	void EndScope();
+
+	// Names the calling thread in reports and traces
+	void SetThreadName(const std::string& name);
+
+	// Reads back what threads recorded since the last call, and makes it the last frame. Scopes
+	// still running are counted in the frame they end in. Must always be called from the same
+	// thread.
+	void EndFrame();
+
+	const Frame& GetLastFrame() const { return m_lastFrame; }
+
+	// Prints the last frame's scopes, by thread
+	void PrintLastFrame() const;
+
+	// While tracing, every scope that ends is kept until StopTrace writes them all to fileName.
+	// Throws std::runtime_error if the file can't be written. Call from the thread that calls
+	// EndFrame.
+	void StartTrace();
+	void StopTrace(const char* fileName);
+	bool IsTracing() const { return m_bTracing; }
+
+private:
+	struct ThreadBuffer;
+	struct TraceEvent;
+
+	ThreadBuffer& GetThreadBuffer();
+	uint32 FindOrAddNode(int32 parentIndex, uint32 threadIndex, const char* name);
+	void ReadThreadBuffer(ThreadBuffer& threadBuffer, uint32 threadIndex);
+	void PrintNode(int32 nodeIndex) const;
+
+	std::vector<std::unique_ptr<ThreadBuffer>> m_threadBuffers; // One per thread that has profiled, kept until exit
+	mutable std::mutex m_mutex; // Guards m_threadBuffers and the thread names
+
+	Frame m_frame; // Being read back
+	Frame m_lastFrame;
+	uint64 m_lastFrameTicks;
+
+	bool m_bTracing;
+	uint64 m_traceStartTicks;
+	std::vector<TraceEvent> m_traceEvents;
+
+	static thread_local ThreadBuffer* ms_pThreadBuffer;
+};
+
+// Times the enclosing scope
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) : m_bRecorded(Profiler::Instance().BeginScope(name)) {}
+	~ProfileScope() { if (m_bRecorded) Profiler::Instance().EndScope(); }
+
+private:
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+
+	const bool m_bRecorded;
+};
+
+#ifdef GS_PROFILER
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Profiler::Instance().SetThreadName(name)
+
+#else
+
+// The name isn't evaluated, but still counts as used, so that variables only used to build it don't
+// cause warnings
+#define PROFILE_SCOPE(name) ((void)sizeof(name))
+#define PROFILE_THREAD_NAME(name) ((void)sizeof(name))
+
+#endif // GS_PROFILER
+
+#endif // _PROFILER_H_
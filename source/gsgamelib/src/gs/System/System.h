@@ -7,6 +7,11 @@
 #include "gs/Platform/Win32/Win32System.h"
 typedef Win32System System;
 
+#elif defined(__unix__) || defined(__APPLE__)
+
+#include "gs/Platform/Posix/PosixSystem.h"
+typedef PosixSystem System;
+
 #else
 
 #error No System class defined for current platform
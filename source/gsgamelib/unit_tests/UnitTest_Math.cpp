@@ -1,8 +1,15 @@
+#include "gs/Base/UnitTest.h"
 #include "gs/Math/Matrix43.h"
 #include "gs/Math/Quaternion.h"
 #include "gs/Math/Vector3.h"
 #include "gs/Math/EulerAngles.h"
-#include <cassert>
+#include "gs/Math/QTS.h"
+#include "gs/Math/QuaternionBatch.h"
+#include "gs/Math/Random.h"
+#include "gs/Math/Geometry.h"
+#include "gs/Math/GeometryBatch.h"
+#include "gs/Rendering/VertexFormat.h"
+#include "gs/Scene/SceneNode.h"
 
 static Vector3 RandNormalizedVector3()
 {
@@ -29,71 +36,71 @@ extern void UnitTest_Math()
 	{
 		// Identity
 		m1.SetFromAxisAngle(vUp, 0.f);
-		assert(m1.AlmostEquals(Matrix43::Identity()));
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
 
 		m1.SetFromAxisAngle(vForward, 0.f);
-		assert(m1.AlmostEquals(Matrix43::Identity()));
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
 
 		m1.SetFromAxisAngle(vRight, 0.f);
-		assert(m1.AlmostEquals(Matrix43::Identity()));
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
 
 		// Yaw
 		m1.SetFromAxisAngle(vUp, Angle::FromDeg(90.0f));
 		v1 = DirectionVector(vForward) * m1;
-		assert(v1.AlmostEquals(vRight));
+		CHECK(v1.AlmostEquals(vRight));
 
 		m1.SetFromAxisAngle(vUp, Angle::FromDeg(-90.0f));
 		v1 = DirectionVector(vForward) * m1;
-		assert(v1.AlmostEquals(-vRight));
+		CHECK(v1.AlmostEquals(-vRight));
 
 		m1.SetFromAxisAngle(vUp, Angle::FromDeg(180.0f));
 		v1 = DirectionVector(vForward) * m1;
-		assert(v1.AlmostEquals(-vForward));
+		CHECK(v1.AlmostEquals(-vForward));
 
 		// Roll
 		m1.SetFromAxisAngle(vForward, Angle::FromDeg(90.f));
 		v1 = DirectionVector(vRight) * m1;
-		assert(v1.AlmostEquals(vUp));
+		CHECK(v1.AlmostEquals(vUp));
 
 		m1.SetFromAxisAngle(vForward, Angle::FromDeg(90.f));
 		v1 = DirectionVector(vUp) * m1;
-		assert(v1.AlmostEquals(-vRight));
+		CHECK(v1.AlmostEquals(-vRight));
 
 		// Pitch
 		m1.SetFromAxisAngle(vRight, Angle::FromDeg(90.f));
 		v1 = DirectionVector(vForward) * m1;
-		assert(v1.AlmostEquals(-vUp));
+		CHECK(v1.AlmostEquals(-vUp));
 
 		m1.SetFromAxisAngle(vRight, Angle::FromDeg(180));
 		v1 = DirectionVector(vUp) * m1;
-		assert(v1.AlmostEquals(-vUp));
+		CHECK(v1.AlmostEquals(-vUp));
 	}
 
 	// Matrix43::SetFromEulerAngles
 	{
 		// Identity
 		m1.SetFromEulerAngles(EulerAngles::Identity());
-		assert(m1.AlmostEquals(Matrix43::Identity()));
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
 
 		m1.SetFromEulerAngles(EulerAngles(Angle::FromDeg(360.f), Angle::FromDeg(360.f * 2.f), Angle::FromDeg(-360.0f*5)));
-		assert(m1.AlmostEquals(Matrix43::Identity()));
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
 
 		for (uint32 i = 0; i < 100; ++i)
 		{
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m1.SetFromAxisAngle(vUp, a1);
 			m2.SetFromEulerAngles(EulerAngles(a1, 0.f, 0.f));
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m1.SetFromAxisAngle(vRight, a1);
 			m2.SetFromEulerAngles(EulerAngles(0.f, a1, 0.f));
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m1.SetFromAxisAngle(vForward, a1);
 			m2.SetFromEulerAngles(EulerAngles(0.f, 0.f, a1));
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 		}
 	}
 
@@ -101,10 +108,10 @@ extern void UnitTest_Math()
 	// Quaternion::SetFromAxis, SetFromEulerAngles, and SetFromMatrix
 	{
 		m1.SetFromQuaternion(Quaternion::Identity());
-		assert(m1.AlmostEquals(Matrix43::Identity()));
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
 
 		m1.SetFromQuaternion(-Quaternion::Identity());
-		assert(m1.AlmostEquals(Matrix43::Identity()));
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
 
 		for (uint32 i = 0; i < 100; ++i)
 		{
@@ -112,34 +119,34 @@ extern void UnitTest_Math()
 			m1.SetFromAxisAngle(vUp, a1);
 			q2.SetFromAxisAngle(vUp, a1);
 			m2.SetFromQuaternion(q2);
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 			q2.SetFromEulerAngles(EulerAngles(a1, 0.f, 0.f));
 			m2.SetFromQuaternion(q2);
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 			q1.SetFromMatrix(m2);
-			assert(q1.AlmostEquals(q2));
+			CHECK(q1.AlmostEquals(q2));
 
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m1.SetFromAxisAngle(vRight, a1);
 			q2.SetFromAxisAngle(vRight, a1);
 			m2.SetFromQuaternion(q2);
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 			q2.SetFromEulerAngles(EulerAngles(0.f, a1, 0.f));
 			m2.SetFromQuaternion(q2);
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 			q1.SetFromMatrix(m2);
-			assert(q1.AlmostEquals(q2));
+			CHECK(q1.AlmostEquals(q2));
 
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m1.SetFromAxisAngle(vForward, a1);
 			q2.SetFromAxisAngle(vForward, a1);
 			m2.SetFromQuaternion(q2);
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 			q2.SetFromEulerAngles(EulerAngles(0.f, 0.f, a1));
 			m2.SetFromQuaternion(q2);
-			assert(m1.AlmostEquals(m2));
+			CHECK(m1.AlmostEquals(m2));
 			q1.SetFromMatrix(m2);
-			assert(q1.AlmostEquals(q2));
+			CHECK(q1.AlmostEquals(q2));
 		}
 	}
 
@@ -150,7 +157,7 @@ extern void UnitTest_Math()
 		m1.SetFromTranslation(Vector3(1.f, 2.f, 3.f));
 		m2.SetFromAxisAngle(vUp, kPiOver2);
 		m3 = m2 * m1;
-		assert(m3.trans.AlmostEquals(m1.trans));
+		CHECK(m3.Translation().AlmostEquals(m1.Translation()));
 
 		for (uint32 i = 0; i < 100; ++i)
 		{
@@ -160,16 +167,16 @@ extern void UnitTest_Math()
 			v1 = RandNormalizedVector3();
 
 			m1.SetFromAxisAngle(vAxis, a1);
-			m1.trans = v1;
+			m1.Translation() = v1;
 			m2.SetFromAxisAngle(vAxis, -a1);
-			m2.trans = DirectionVector(-v1) * m2; // Reverse translation in rotated
+			m2.Translation() = DirectionVector(-v1) * m2; // Reverse translation in rotated
 			m3 = m1 * m2;
-			assert(m3.AlmostEquals(Matrix43::Identity()));
+			CHECK(m3.AlmostEquals(Matrix43::Identity()));
 			
 			q1.SetFromAxisAngle(vAxis, a1);
 			q2.SetFromAxisAngle(vAxis, -a1);
 			q3 = q1 * q2;
-			assert(q3.AlmostEquals(Quaternion::Identity()));
+			CHECK(q3.AlmostEquals(Quaternion::Identity()));
 
 			// M(Angle) * M(Angle) = M(Angle + Angle)
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
@@ -180,13 +187,13 @@ extern void UnitTest_Math()
 			m2.SetFromAxisAngle(vAxis, a2);
 			m3 = m1 * m2;
 			m4.SetFromAxisAngle(vAxis, a1 + a2);
-			assert(m3.AlmostEquals(m4));
+			CHECK(m3.AlmostEquals(m4));
 
 			q1.SetFromAxisAngle(vAxis, a1);
 			q2.SetFromAxisAngle(vAxis, a2);
 			q3 = q1 * q2;
 			q4.SetFromAxisAngle(vAxis, a1 + a2);
-			assert(q3.AlmostEquals(q4));
+			CHECK(q3.AlmostEquals(q4));
 		}
 	}
 
@@ -201,29 +208,29 @@ extern void UnitTest_Math()
 			m1.SetFromAxisAngle(vAxis, a1);
 			m2.SetInverseFromR(m1);
 			m3 = m1 * m2;
-			assert(m3.AlmostEquals(Matrix43::Identity()));
+			CHECK(m3.AlmostEquals(Matrix43::Identity()));
 
 			// Quat
 			q1.SetFromMatrix(m1);
 			q2 = Invert(q1);
 			q3 = q1 * q2;
-			assert(q3.AlmostEquals(Quaternion::Identity()));
+			CHECK(q3.AlmostEquals(Quaternion::Identity()));
 
 			// M1*M2*M3*M3-1*M2-1*M1-1 == Identity
 			vAxis = RandNormalizedVector3();
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m1.SetFromAxisAngle(vAxis, a1);
-			m1.trans = RandNormalizedVector3();
+			m1.Translation() = RandNormalizedVector3();
 		
 			vAxis = RandNormalizedVector3();
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m2.SetFromAxisAngle(vAxis, a1);
-			m2.trans = RandNormalizedVector3();
+			m2.Translation() = RandNormalizedVector3();
 		
 			vAxis = RandNormalizedVector3();
 			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
 			m3.SetFromAxisAngle(vAxis, a1);
-			m3.trans = RandNormalizedVector3();
+			m3.Translation() = RandNormalizedVector3();
 		
 			mInv1.SetInverseFromRT(m1);
 			mInv2.SetInverseFromRT(m2);
@@ -231,7 +238,7 @@ extern void UnitTest_Math()
 
 			m4 = m1 * m2 * m3;
 			m5 = m4 * mInv3 * mInv2 * mInv1;
-			assert(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
+			CHECK(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
 
 			// Quat
 			q1.SetFromMatrix(m1);
@@ -242,7 +249,7 @@ extern void UnitTest_Math()
 			qInv3 = Invert(q3);
 			q4 = q1 * q2 * q3;
 			q5 = q4 * qInv3 * qInv2 * qInv1;
-			assert(q5.AlmostEquals(Quaternion::Identity()));
+			CHECK(q5.AlmostEquals(Quaternion::Identity()));
 		}
 
 		// Test variants of Matrix43 inverse
@@ -267,62 +274,62 @@ extern void UnitTest_Math()
 			mInv3.SetInverseFromR(m3);
 			m4 = m1 * m2 * m3;
 			m5 = m4 * mInv3 * mInv2 * mInv1;
-			assert(m5.AlmostEquals(Matrix43::Identity()));
+			CHECK(m5.AlmostEquals(Matrix43::Identity()));
 
 			// InvertRT
-			m1.trans = RandNormalizedVector3();
-			m2.trans = RandNormalizedVector3();
-			m3.trans = RandNormalizedVector3();
+			m1.Translation() = RandNormalizedVector3();
+			m2.Translation() = RandNormalizedVector3();
+			m3.Translation() = RandNormalizedVector3();
 			mInv1.SetInverseFromRT(m1);
 			mInv2.SetInverseFromRT(m2);
 			mInv3.SetInverseFromRT(m3);
 			m4 = m1 * m2 * m3;
 			m5 = m4 * mInv3 * mInv2 * mInv1;
 			m5.Orthogonalize();
-			assert(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
+			CHECK(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
 
 			// InvertUniformSRT
 			float32 s1 = MathEx::Rand(1.f, maxScale);
-			m1.axisX *= s1;
-			m1.axisY *= s1;
-			m1.axisZ *= s1;
+			m1.AxisX() *= s1;
+			m1.AxisY() *= s1;
+			m1.AxisZ() *= s1;
 			float32 s2 = MathEx::Rand(1.f, maxScale);
-			m2.axisX *= s2;
-			m2.axisY *= s2;
-			m2.axisZ *= s2;
+			m2.AxisX() *= s2;
+			m2.AxisY() *= s2;
+			m2.AxisZ() *= s2;
 			float32 s3 = MathEx::Rand(1.f, maxScale);
-			m3.axisX *= s3;
-			m3.axisY *= s3;
-			m3.axisZ *= s3;
+			m3.AxisX() *= s3;
+			m3.AxisY() *= s3;
+			m3.AxisZ() *= s3;
 			mInv1.SetInverseFromUniformSRT(m1);
 			mInv2.SetInverseFromUniformSRT(m2);
 			mInv3.SetInverseFromUniformSRT(m3);
 			m4 = m1 * m2 * m3;
 			m5 = m4 * mInv3 * mInv2 * mInv1;
-			assert(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
+			CHECK(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
 
 			// InvertSRT
-			m1.axisX *= MathEx::Rand(1.f, maxScale);
-			m1.axisY *= MathEx::Rand(1.f, maxScale);
-			m1.axisZ *= MathEx::Rand(1.f, maxScale);
-			m2.axisX *= MathEx::Rand(1.f, maxScale);
-			m2.axisY *= MathEx::Rand(1.f, maxScale);
-			m2.axisZ *= MathEx::Rand(1.f, maxScale);
-			m3.axisX *= MathEx::Rand(1.f, maxScale);
-			m3.axisY *= MathEx::Rand(1.f, maxScale);
-			m3.axisZ *= MathEx::Rand(1.f, maxScale);
+			m1.AxisX() *= MathEx::Rand(1.f, maxScale);
+			m1.AxisY() *= MathEx::Rand(1.f, maxScale);
+			m1.AxisZ() *= MathEx::Rand(1.f, maxScale);
+			m2.AxisX() *= MathEx::Rand(1.f, maxScale);
+			m2.AxisY() *= MathEx::Rand(1.f, maxScale);
+			m2.AxisZ() *= MathEx::Rand(1.f, maxScale);
+			m3.AxisX() *= MathEx::Rand(1.f, maxScale);
+			m3.AxisY() *= MathEx::Rand(1.f, maxScale);
+			m3.AxisZ() *= MathEx::Rand(1.f, maxScale);
 			mInv1.SetInverseFromSRT(m1);
 			mInv2.SetInverseFromSRT(m2);
 			mInv3.SetInverseFromSRT(m3);
 			m4 = m1 * m2 * m3;
 			m5 = m4 * mInv3 * mInv2 * mInv1;
-			assert(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
+			CHECK(m5.AlmostEquals(Matrix43::Identity(), 1e-4f));
 
 			// Invert
 			Matrix43 mShear = Matrix43::Identity();
-			mShear.axisX.y = MathEx::Rand(1.f, maxScale);
-			mShear.axisY.z = MathEx::Rand(1.f, maxScale);
-			mShear.axisZ.x = MathEx::Rand(1.f, maxScale);
+			mShear.AxisX().y = MathEx::Rand(1.f, maxScale);
+			mShear.AxisY().z = MathEx::Rand(1.f, maxScale);
+			mShear.AxisZ().x = MathEx::Rand(1.f, maxScale);
 			m1 = m1 * mShear;
 			m2 = m2 * mShear;
 			m3 = m3 * mShear;
@@ -331,7 +338,7 @@ extern void UnitTest_Math()
 			mInv3.SetInverseFrom(m3);
 			m4 = m1 * m2 * m3;
 			m5 = m4 * mInv3 * mInv2 * mInv1;
-			assert(m5.AlmostEquals(Matrix43::Identity(), 1e-3f));
+			CHECK(m5.AlmostEquals(Matrix43::Identity(), 1e-3f));
 		}
 	}
 
@@ -342,27 +349,410 @@ extern void UnitTest_Math()
 		q2.SetFromAxisAngle(vUp, Angle::FromDeg(90.f));
 		
 		q3 = Slerp(q1, q2, 0.f);
-		assert(q3.AlmostEquals(q1));
+		CHECK(q3.AlmostEquals(q1));
 
 		q3 = Slerp(q1, q2, 1.f);
-		assert(q3.AlmostEquals(q2));
+		CHECK(q3.AlmostEquals(q2));
 
 		q3 = Slerp(q1, q2, 0.5f);
 		q3.ToAxisAngle(vAxis, a1);
-		assert(vAxis.AlmostEquals(vUp));
-		assert(MathEx::AlmostEquals(a1.ToDeg(), 45.f, 1e-4f));
+		CHECK(vAxis.AlmostEquals(vUp));
+		CHECK(MathEx::AlmostEquals(a1.ToDeg(), 45.f, 1e-4f));
 
 		q2.SetFromAxisAngle(vUp, Angle::FromDeg(-90.f));
 		q3 = Slerp(q1, q2, 0.5f);
 		q3.ToAxisAngle(vAxis, a1);
-		assert(vAxis.AlmostEquals(vUp) && MathEx::AlmostEquals(a1.ToDeg(), -45.f, 1e-4f)
-			|| vAxis.AlmostEquals(-vUp) && MathEx::AlmostEquals(a1.ToDeg(), 45.f, 1e-4f));
+		CHECK((vAxis.AlmostEquals(vUp) && MathEx::AlmostEquals(a1.ToDeg(), -45.f, 1e-4f))
+			|| (vAxis.AlmostEquals(-vUp) && MathEx::AlmostEquals(a1.ToDeg(), 45.f, 1e-4f)));
+	}
+
+	// QTS
+	// QTS::SetFromMatrix, Matrix43::SetFromQTS, operator*, Invert, Interpolate
+	{
+		QTS qts1, qts2, qts3;
+
+		m1.SetFromQTS(QTS::Identity());
+		CHECK(m1.AlmostEquals(Matrix43::Identity()));
+
+		for (uint32 i = 0; i < 100; ++i)
+		{
+			vAxis = RandNormalizedVector3();
+			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
+			q1.SetFromAxisAngle(vAxis, a1);
+			qts1.Set(q1, RandNormalizedVector3() * 10.f, MathEx::Rand(1.f, maxScale));
+
+			vAxis = RandNormalizedVector3();
+			a1 = Angle::FromDeg( MathEx::Rand(0.f, 360.f) );
+			q2.SetFromAxisAngle(vAxis, a1);
+			qts2.Set(q2, RandNormalizedVector3() * 10.f, MathEx::Rand(1.f, maxScale));
+
+			// Round-trip through Matrix43
+			m1.SetFromQTS(qts1);
+			qts3.SetFromMatrix(m1);
+			CHECK(qts3.AlmostEquals(qts1, 1e-4f));
+
+			// Transforming vectors matches Matrix43
+			v1 = RandNormalizedVector3();
+			CHECK( (PositionVector(v1) * qts1).AlmostEquals(PositionVector(v1) * m1, 1e-4f) );
+			CHECK( (DirectionVector(v1) * qts1).AlmostEquals(DirectionVector(v1) * m1, 1e-4f) );
+
+			// Concatenation matches Matrix43
+			m2.SetFromQTS(qts2);
+			m3.SetFromQTS(qts1 * qts2);
+			m4 = m1 * m2;
+			CHECK(m3.AlmostEquals(m4, 1e-3f));
+
+			// QTS * QTS-1 == Identity
+			qts3 = qts1 * Invert(qts1);
+			CHECK(qts3.AlmostEquals(QTS::Identity(), 1e-4f));
+
+			// Interpolation end points
+			CHECK(Interpolate(qts1, qts2, 0.f).AlmostEquals(qts1));
+			CHECK(Interpolate(qts1, qts2, 1.f).AlmostEquals(qts2));
+		}
+
+		// SceneNode local QTS edits aren't lost when the node is attached (which keeps its world transform)
+		{
+			auto psParent = SceneNode::Create("UnitTest_Parent");
+			auto psChild = SceneNode::Create("UnitTest_Child");
+			psParent->ModifyLocalToParentQTS() = qts2;
+			psChild->GetLocalToWorld();
+
+			psChild->ModifyLocalToParentQTS() = qts1;
+			psParent->AttachChild(psChild);
+			m1.SetFromQTS(qts1);
+			CHECK(psChild->GetLocalToWorld().AlmostEquals(m1, 1e-3f));
+
+			// Again, with the node edited while attached, then detached
+			psChild->ModifyLocalToParentQTS() = qts2;
+			m1 = m2 * psParent->GetLocalToWorld();
+			psChild->DetachFromParent();
+			CHECK(psChild->GetLocalToWorld().AlmostEquals(m1, 1e-3f));
+
+			SceneNode::Destroy(psChild);
+			SceneNode::Destroy(psParent);
+		}
+	}
+
+	// Batched quaternion operations
+	// NormalizeArray, NlerpArray, FastSlerpArray, SlerpArray, QuaternionsToMatrices, MatricesToQuaternions
+	{
+		const size_t count = 35; // Not a multiple of SIMD width so scalar remainder is tested too
+		Quaternion qa[count], qb[count], qr[count];
+		float32 t[count];
+		Matrix43 ma[count];
+		Vector3 va[count];
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			qa[i].SetFromAxisAngle(RandNormalizedVector3(), Angle::FromDeg( MathEx::Rand(0.f, 360.f) ));
+			qb[i].SetFromAxisAngle(RandNormalizedVector3(), Angle::FromDeg( MathEx::Rand(0.f, 360.f) ));
+			t[i] = MathEx::Rand(0.f, 1.f);
+			va[i] = RandNormalizedVector3();
+		}
+
+		SlerpArray(qa, qb, t, qr, count);
+		for (size_t i = 0; i < count; ++i)
+			CHECK(qr[i].AlmostEquals(Slerp(qa[i], qb[i], t[i]), 1e-5f));
+
+		SlerpArray(qa, qb, 0.f, qr, count);
+		for (size_t i = 0; i < count; ++i)
+			CHECK(qr[i].AlmostEquals(qa[i]));
+
+		FastSlerpArray(qa, qb, t, qr, count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Quaternion qs = Slerp(qa[i], qb[i], t[i]);
+			CHECK(qr[i].AlmostEquals(qs, 2e-3f));
+		}
+
+		NlerpArray(qa, qb, 1.f, qr, count);
+		for (size_t i = 0; i < count; ++i)
+			CHECK(qr[i].AlmostEquals(qb[i], 1e-5f));
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			qr[i].Set(qa[i].x * 3.f, qa[i].y * 3.f, qa[i].z * 3.f, qa[i].w * 3.f);
+		}
+		NormalizeArray(qr, count);
+		for (size_t i = 0; i < count; ++i)
+			CHECK(qr[i].AlmostEquals(qa[i], 1e-5f));
+
+		QuaternionsToMatrices(qa, va, ma, count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			m1.SetFromQuaternion(qa[i], va[i]);
+			CHECK(ma[i].AlmostEquals(m1));
+		}
+
+		MatricesToQuaternions(ma, qr, count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			q1.SetFromMatrix(ma[i]);
+			CHECK(qr[i].AlmostEquals(q1) && qr[i].AlmostEquals(qa[i], 1e-5f));
+		}
+	}
+
+	// Random
+	{
+		// Matches reference PCG32 implementation (pcg32-demo, seed 42, stream 54)
+		Random r1(42u, 54u);
+		const uint32 expected[] = { 0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e };
+		for (size_t i = 0; i < ARRAY_SIZE(expected); ++i)
+			CHECK(r1.NextUInt32() == expected[i]);
+
+		// Same seed and stream reproduce the same sequence, different streams don't
+		Random r2(1234u, 1u), r3(1234u, 1u), r4(1234u, 2u);
+		bool allSame = true;
+		for (size_t i = 0; i < 100; ++i)
+		{
+			const uint32 value = r2.NextUInt32();
+			CHECK(value == r3.NextUInt32());
+			allSame = allSame && (value == r4.NextUInt32());
+		}
+		CHECK(!allSame);
+
+		// Advance skips ahead
+		r3 = Random(1234u, 1u);
+		r3.Advance(100);
+		CHECK(r2 == r3);
+
+		for (size_t i = 0; i < 1000; ++i)
+		{
+			const int32 n = r1.Int(-3, 3);
+			CHECK(n >= -3 && n <= 3);
+
+			const float32 f = r1.Float(-2.f, 5.f);
+			CHECK(f >= -2.f && f < 5.f);
+
+			CHECK(r1.UnitVector().IsUnit());
+			CHECK(r1.InUnitSphere().LengthSquared() < 1.f);
+		}
+
+		// Bulk fill is deterministic for a given seed (count not a multiple of SIMD width)
+		const size_t count = 103;
+		uint32 ua[count], ub[count];
+		float32 fa[count];
+		r2 = r3 = Random(99u);
+		RandomFillUInt32(r2, ua, count);
+		RandomFillUInt32(r3, ub, count);
+		CHECK(r2 == r3);
+		for (size_t i = 0; i < count; ++i)
+			CHECK(ua[i] == ub[i]);
+
+		RandomFillFloat(r2, fa, count, 10.f, 20.f);
+		for (size_t i = 0; i < count; ++i)
+			CHECK(fa[i] >= 10.f && fa[i] < 20.f);
+	}
+
+	// Geometry
+	{
+		AABB box = AABB::Empty();
+		CHECK(box.IsEmpty());
+		box.Include(Vector3(1.f, 2.f, 3.f));
+		box.Include(Vector3(-1.f, 0.f, 5.f));
+		CHECK(!box.IsEmpty());
+		CHECK(box.min.AlmostEquals(Vector3(-1.f, 0.f, 3.f)) && box.max.AlmostEquals(Vector3(1.f, 2.f, 5.f)));
+		CHECK(box.Contains(Vector3(0.f, 1.f, 4.f)) && !box.Contains(Vector3(0.f, 3.f, 4.f)));
+
+		// Transformed AABB encloses all transformed corners
+		m1.SetFromAxisAngle(RandNormalizedVector3(), Angle::FromDeg( MathEx::Rand(0.f, 360.f) ));
+		m1.AxisX() *= 2.f;
+		m1.Translation() = Vector3(10.f, -20.f, 30.f);
+		const AABB boxWorld = box * m1;
+		for (int i = 0; i < 8; ++i)
+		{
+			const Vector3 corner((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z);
+			v1 = PositionVector(corner) * m1;
+			CHECK(AABB(boxWorld.min - Vector3(1e-4f, 1e-4f, 1e-4f), boxWorld.max + Vector3(1e-4f, 1e-4f, 1e-4f)).Contains(v1));
+		}
+
+		// Transformed OBB contains the same transformed points, and transformed plane keeps them on the same side
+		const OBB obbWorld = OBB::FromAABB(box) * m1;
+		const Plane plane = Plane::FromPointNormal(Vector3(0.f, 1.f, 0.f), Vector3::UnitY());
+		const Plane planeWorld = plane * m1;
+		for (int i = 0; i < 10; ++i)
+		{
+			v1 = box.GetCenter() + Vector3(MathEx::Rand(-0.99f, 0.99f), MathEx::Rand(-0.99f, 0.99f), MathEx::Rand(-0.99f, 0.99f));
+			v2 = PositionVector(v1) * m1;
+			CHECK(obbWorld.Contains(v2));
+			CHECK((plane.SignedDistance(v1) > 0.f) == (planeWorld.SignedDistance(v2) > 0.f));
+		}
+
+		// Spheres
+		CHECK(Intersects(Sphere(Vector3::Zero(), 1.f), Sphere(Vector3(1.9f, 0.f, 0.f), 1.f)));
+		CHECK(!Intersects(Sphere(Vector3::Zero(), 1.f), Sphere(Vector3(2.1f, 0.f, 0.f), 1.f)));
+		CHECK(Intersects(box, Sphere(Vector3(2.f, 1.f, 4.f), 1.1f)));
+		CHECK(!Intersects(box, Sphere(Vector3(2.f, 3.f, 4.f), 1.1f)));
+
+		// OBBs: boxes rotated 45 degrees around Y touch when their corners meet
+		m2.SetFromAxisAngle(vUp, Angle::FromDeg(45.f));
+		const OBB obbUnit = OBB::FromAABB(AABB(-Vector3(1.f, 1.f, 1.f), Vector3(1.f, 1.f, 1.f)));
+		OBB obbRotated = obbUnit * m2;
+		obbRotated.center.x = 1.f + MathEx::Sqrt(2.f) - 0.01f;
+		CHECK(Intersects(obbUnit, obbRotated));
+		obbRotated.center.x = 1.f + MathEx::Sqrt(2.f) + 0.01f;
+		CHECK(!Intersects(obbUnit, obbRotated));
+
+		// Rays
+		float32 tHit;
+		CHECK(Intersects(Ray(Vector3(0.f, 1.f, 0.f), vForward), box, tHit) && MathEx::AlmostEquals(tHit, 3.f));
+		CHECK(!Intersects(Ray(Vector3(0.f, 1.f, 0.f), vForward), box, tHit, 2.f));
+		CHECK(!Intersects(Ray(Vector3(0.f, 1.f, 0.f), -vForward), box, tHit));
+		CHECK(Intersects(Ray(box.GetCenter(), vUp), box, tHit) && tHit == 0.f);
+		CHECK(Intersects(Ray(Vector3(0.f, 0.f, -5.f), vForward * 2.f), Sphere(Vector3::Zero(), 1.f), tHit) && MathEx::AlmostEquals(tHit, 2.f));
+		CHECK(Intersects(Ray(Vector3(0.f, 5.f, 0.f), -vUp), plane, tHit) && MathEx::AlmostEquals(tHit, 4.f));
+		CHECK(Intersects(Ray(Vector3(-10.f, 0.f, 0.f), vRight), obbRotated, tHit) && MathEx::AlmostEquals(tHit, 10.f + obbRotated.center.x - MathEx::Sqrt(2.f), 1e-4f));
+
+		// Frustum: camera at origin looking down Z+, then moved and turned to look down X+
+		Frustum frustum;
+		frustum.SetPerspective(Angle::FromDeg(90.f), 1.f, 1.f, 100.f);
+		CHECK(frustum.Contains(Vector3(0.f, 0.f, 50.f)) && frustum.Contains(Vector3(49.f, -49.f, 50.f)));
+		CHECK(!frustum.Contains(Vector3(0.f, 0.f, 0.5f)) && !frustum.Contains(Vector3(0.f, 0.f, 101.f)) && !frustum.Contains(Vector3(51.f, 0.f, 50.f)));
+		CHECK(frustum.Test(AABB::FromCenterHalfExtents(Vector3(0.f, 0.f, 50.f), Vector3(1.f, 1.f, 1.f))) == Containment::Inside);
+		CHECK(frustum.Test(AABB::FromCenterHalfExtents(Vector3(0.f, 0.f, 100.f), Vector3(1.f, 1.f, 1.f))) == Containment::Intersecting);
+		CHECK(frustum.Test(AABB::FromCenterHalfExtents(Vector3(0.f, 0.f, -50.f), Vector3(1.f, 1.f, 1.f))) == Containment::Outside);
+		CHECK(frustum.Intersects(Sphere(Vector3(0.f, 0.f, 0.5f), 1.f)) && !frustum.Intersects(Sphere(Vector3(0.f, 0.f, -2.f), 1.f)));
+
+		m2.SetFromAxisAngle(vUp, Angle::FromDeg(90.f), Vector3(0.f, 0.f, 1000.f));
+		frustum.SetPerspective(Angle::FromDeg(90.f), 1.f, 1.f, 100.f, m2);
+		CHECK(frustum.Contains(Vector3(50.f, 0.f, 1000.f)) && !frustum.Contains(Vector3(0.f, 0.f, 1050.f)));
+
+		// Batched tests match scalar tests
+		AABBx8 boxes8;
+		Spherex8 spheres8;
+		AABBx4 boxes4;
+		AABB boxes[8];
+		Sphere spheres[8];
+		const Sphere sphere(Vector3(1000.f, 0.f, 50.f), 20.f);
+		const Ray ray(Vector3(990.f, 0.f, 1000.f), RandNormalizedVector3());
+		for (int iter = 0; iter < 20; ++iter)
+		{
+			for (size_t i = 0; i < 8; ++i)
+			{
+				const Vector3 center(MathEx::Rand(950.f, 1150.f), MathEx::Rand(-100.f, 100.f), MathEx::Rand(950.f, 1050.f));
+				const Vector3 halfExtents(MathEx::Rand(1.f, 20.f), MathEx::Rand(1.f, 20.f), MathEx::Rand(1.f, 20.f));
+				boxes[i] = AABB::FromCenterHalfExtents(center, halfExtents);
+				boxes8.Set(i, boxes[i]);
+				spheres[i] = Sphere(center - Vector3(0.f, 0.f, 950.f), halfExtents.x);
+				spheres8.Set(i, spheres[i]);
+				if (i < 4)
+					boxes4.Set(i, boxes[i]);
+			}
+			boxes8.Clear(7);
+
+			const uint32 frustumMask = FrustumIntersectsAABBx8(frustum, boxes8);
+			const uint32 sphereMask = SphereIntersectsSpherex8(sphere, spheres8);
+			float32 tHits[4];
+			const uint32 rayMask = RayIntersectsAABBx4(ray, boxes4, tHits);
+			for (size_t i = 0; i < 8; ++i)
+			{
+				CHECK(((frustumMask >> i) & 1) == (i < 7 && frustum.Intersects(boxes[i]) ? 1u : 0u));
+				CHECK(((sphereMask >> i) & 1) == (Intersects(sphere, spheres[i]) ? 1u : 0u));
+				if (i < 4)
+				{
+					const bool hit = Intersects(ray, boxes[i], tHit);
+					CHECK(((rayMask >> i) & 1) == (hit ? 1u : 0u));
+					CHECK(!hit || MathEx::AlmostEquals(tHits[i], tHit));
+				}
+			}
+		}
+	}
+
+	// Vertex packing
+	{
+		using namespace VertexPacking;
+
+		// Half floats: exactly representable values round-trip, others round to nearest
+		const float32 exactHalfs[] = { 0.f, -0.f, 1.f, -2.f, 0.5f, 1024.f, 65504.f, 1.f / 16384.f, 1.f / 16777216.f };
+		for (float32 f : exactHalfs)
+			CHECK(HalfToFloat(FloatToHalf(f)) == f);
+		CHECK(FloatToHalf(1.f) == 0x3C00 && FloatToHalf(-2.f) == 0xC000);
+		CHECK(FloatToHalf(1.f + 1.f / 2048.f) == 0x3C00 && FloatToHalf(1.f + 3.f / 2048.f) == 0x3C02); // Ties round to even
+		CHECK(HalfToFloat(FloatToHalf(70000.f)) == std::numeric_limits<float32>::infinity());
+		for (int i = 0; i < 100; ++i)
+		{
+			const float32 f = MathEx::Rand(-100.f, 100.f);
+			CHECK(MathEx::Abs(HalfToFloat(FloatToHalf(f)) - f) <= MathEx::Abs(f) * (1.f / 2048.f));
+		}
+
+		// Octahedral normals
+		int16 encoded[2];
+		const Vector3 axes[] = { vRight, -vRight, vUp, -vUp, vForward, -vForward };
+		for (const Vector3& axis : axes)
+		{
+			OctEncode(axis, encoded);
+			CHECK(OctDecode(encoded).AlmostEquals(axis, 1e-4f));
+		}
+		for (int i = 0; i < 100; ++i)
+		{
+			v1 = ThreadRandom().UnitVector();
+			OctEncode(v1, encoded);
+			v2 = OctDecode(encoded);
+			CHECK(v2.IsUnit() && v1.Dot(v2) > 0.99999f);
+		}
+
+		// Layouts only store the attributes asked for
+		const AABB bounds(Vector3(-100.f, 0.f, -10.f), Vector3(100.f, 50.f, 10.f));
+		CHECK(VertexLayout::Create(VertexLayoutFlags::All, bounds).stride == 18);
+		CHECK(VertexLayout::Create(VertexLayoutFlags::Normal | VertexLayoutFlags::QuantizePosition, bounds).stride == 10);
+		CHECK(VertexLayout::Create(0).stride == 12 && !VertexLayout::Create(0).Has(VertexAttribute::Color));
+
+		// Pack/unpack round-trip
+		struct FloatVertex { float32 position[3], normal[3], color[4], texCoord[2]; };
+		const size_t numVertices = 16;
+		FloatVertex vertices[numVertices], unpacked[numVertices];
+		for (auto& vertex : vertices)
+		{
+			v1 = ThreadRandom().Vector(bounds.min, bounds.max);
+			v2 = ThreadRandom().UnitVector();
+			for (int c = 0; c < 3; ++c)
+			{
+				vertex.position[c] = v1.v[c];
+				vertex.normal[c] = v2.v[c];
+			}
+			for (int c = 0; c < 4; ++c)
+				vertex.color[c] = MathEx::Rand(0.f, 1.f);
+			vertex.texCoord[0] = MathEx::Rand(0.f, 1.f);
+			vertex.texCoord[1] = MathEx::Rand(0.f, 1.f);
+		}
+
+		ConstVertexStreams src;
+		src.position = vertices[0].position;
+		src.normal = vertices[0].normal;
+		src.color = vertices[0].color;
+		src.texCoord = vertices[0].texCoord;
+		src.stride = sizeof(FloatVertex);
+
+		VertexStreams dst;
+		dst.position = unpacked[0].position;
+		dst.normal = unpacked[0].normal;
+		dst.color = unpacked[0].color;
+		dst.texCoord = unpacked[0].texCoord;
+		dst.stride = sizeof(FloatVertex);
+
+		const VertexLayout layout = VertexLayout::Create(VertexLayoutFlags::All, bounds);
+		uint8 packed[numVertices * 18];
+		PackVertices(layout, src, numVertices, packed);
+		UnpackVertices(layout, packed, numVertices, dst);
+
+		const Vector3 positionError = bounds.GetSize() * (1.f / 0xFFFF);
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+				CHECK(MathEx::Abs(unpacked[i].position[c] - vertices[i].position[c]) <= positionError.v[c]);
+			CHECK(Vector3(unpacked[i].normal[0], unpacked[i].normal[1], unpacked[i].normal[2]).Dot(Vector3(vertices[i].normal[0], vertices[i].normal[1], vertices[i].normal[2])) > 0.99999f);
+			for (int c = 0; c < 4; ++c)
+				CHECK(MathEx::Abs(unpacked[i].color[c] - vertices[i].color[c]) <= 0.5f / 255.f + 1e-6f);
+			for (int c = 0; c < 2; ++c)
+				CHECK(MathEx::Abs(unpacked[i].texCoord[c] - vertices[i].texCoord[c]) <= 1.f / 2048.f);
+		}
 	}
 
 	// Vector
 	{
 		// Cross-product
 		v1 = Vector3::UnitX().Cross(Vector3::UnitY());
-		assert( v1.AlmostEquals(Vector3::UnitZ()) );
+		CHECK( v1.AlmostEquals(Vector3::UnitZ()) );
 	}
 }
@@ -0,0 +1,333 @@
+#include "FbxLoader.h"
+#include "StaticMesh.h"
+#include "MeshUtil.h"
+#include "MeshFile.h"
+#include "TextureFile.h"
+#include "gs/Image/ImageData.h"
+#include "gs/System/IO.h"
+#include "gs/System/JobSystem.h"
+#include "gs/Base/string_helpers.h"
+#include "gs/Math/MathEx.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// starfox_cook: converts the game's source assets into the cooked formats it loads at runtime.
+// Usage: starfox_cook [--data <dir>] [--out <dir>] [--jobs <count>] [--force]
+//
+// Each output is keyed by a hash of its input file's bytes, the cooker version and the settings
+// that affect the output. Keys are kept in a cache file in the output directory, and assets whose
+// key hasn't changed since they were last cooked are skipped.
+
+namespace
+{
+	// Bump to recook everything when cooking changes in a way that the settings don't capture
+	const uint32 kCookerVersion = 2; // v2: submeshes merged by material
+
+	const char kCacheFileName[] = "cook_cache.txt";
+
+	typedef std::chrono::steady_clock Clock;
+
+	float64 GetSecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<float64>(Clock::now() - start).count();
+	}
+
+	// 64-bit FNV-1a
+	uint64 Hash(const void* pData, size_t size, uint64 hash = 14695981039346656037ull)
+	{
+		const uint8* pBytes = static_cast<const uint8*>(pData);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	namespace AssetType
+	{
+		enum Type { Mesh, Texture, NumTypes };
+	}
+
+	// Everything besides the input bytes that affects the cooked output of each asset type
+	std::string GetSettings(AssetType::Type type)
+	{
+		switch (type)
+		{
+		case AssetType::Mesh:		return str_format("sfmesh v%u, %s", MeshFile::kVersion, MeshUtil::GetSettings().c_str());
+		case AssetType::Texture:	return str_format("sftex v%u", TextureFile::kVersion);
+		default: assert(false); return "";
+		}
+	}
+
+	namespace CookStatus
+	{
+		enum Type { Cooked, Skipped, Failed };
+	}
+
+	struct Asset
+	{
+		Asset() : type(AssetType::NumTypes), key(0), status(CookStatus::Failed), inputSize(0), outputSize(0), seconds(0.0) {}
+
+		AssetType::Type type;
+		std::string inputPath;
+		std::string outputPath;
+		std::string cacheName;	// Input file name relative to the data directory
+		uint64 key;
+		CookStatus::Type status;
+		std::string error;
+		size_t inputSize;
+		size_t outputSize;
+		float64 seconds;
+	};
+
+	typedef std::map<std::string, uint64> Cache;
+
+	Cache ReadCache(const std::string& path)
+	{
+		Cache cache;
+		if (FILE* pFile = fopen(path.c_str(), "r"))
+		{
+			char name[1024];
+			unsigned long long key;
+			while (fscanf(pFile, "%llx %1023[^\n]\n", &key, name) == 2)
+				cache[name] = key;
+			fclose(pFile);
+		}
+		return cache;
+	}
+
+	bool WriteCache(const std::string& path, const Cache& cache)
+	{
+		FILE* pFile = fopen(path.c_str(), "w");
+		if (!pFile)
+			return false;
+
+		for (const auto& entry : cache)
+			fprintf(pFile, "%016llx %s\n", (unsigned long long)entry.second, entry.first.c_str());
+		fclose(pFile);
+		return true;
+	}
+
+	void CookMesh(const Asset& asset, FbxLoader& fbxLoader)
+	{
+		auto pStaticMesh = fbxLoader.LoadStaticMesh(asset.inputPath.c_str());
+		MeshFile::Save(*pStaticMesh, asset.outputPath.c_str());
+	}
+
+	void CookTexture(const Asset& asset)
+	{
+		ImageData imageData = ImageData::Load(asset.inputPath);
+		TextureFile::Save(imageData, asset.outputPath.c_str());
+	}
+
+	void CookAsset(Asset& asset, const Cache& cache, bool bForce, FbxLoader& fbxLoader)
+	{
+		const Clock::time_point start = Clock::now();
+
+		std::vector<uint8> bytes;
+		if (!IO::File::ReadAllBytes(asset.inputPath, bytes))
+		{
+			asset.error = "failed to read input";
+			return;
+		}
+		asset.inputSize = bytes.size();
+
+		const std::string settings = GetSettings(asset.type);
+		asset.key = Hash(bytes.data(), bytes.size());
+		asset.key = Hash(&kCookerVersion, sizeof(kCookerVersion), asset.key);
+		asset.key = Hash(settings.c_str(), settings.size(), asset.key);
+
+		auto iter = cache.find(asset.cacheName);
+		if (!bForce && iter != cache.end() && iter->second == asset.key && IO::File::GetSize(asset.outputPath) >= 0)
+		{
+			asset.status = CookStatus::Skipped;
+		}
+		else
+		{
+			try
+			{
+				switch (asset.type)
+				{
+				case AssetType::Mesh:		CookMesh(asset, fbxLoader); break;
+				case AssetType::Texture:	CookTexture(asset); break;
+				default: assert(false);
+				}
+				asset.status = CookStatus::Cooked;
+			}
+			catch (const std::exception& e)
+			{
+				asset.error = e.what();
+			}
+		}
+
+		asset.outputSize = static_cast<size_t>(MathEx::Max<int64>(IO::File::GetSize(asset.outputPath), 0));
+		asset.seconds = GetSecondsSince(start);
+	}
+
+	void PrintReport(const std::vector<Asset>& assets, float64 totalSeconds, uint32 numThreads)
+	{
+		const char* statusNames[] = { "cooked", "skipped", "FAILED" };
+		uint32 numByStatus[ARRAY_SIZE(statusNames)] = {};
+		uint64 totalInputSize = 0;
+		uint64 totalOutputSize = 0;
+		float64 totalAssetSeconds = 0.0;
+
+		printf("%-40s %-8s %10s %10s %10s\n", "Asset", "Status", "Input KB", "Output KB", "Time ms");
+		for (const auto& asset : assets)
+		{
+			printf("%-40s %-8s %10.1f %10.1f %10.2f", asset.cacheName.c_str(), statusNames[asset.status],
+				asset.inputSize / 1024.0, asset.outputSize / 1024.0, asset.seconds * 1000.0);
+			if (!asset.error.empty())
+				printf("  (%s)", asset.error.c_str());
+			printf("\n");
+
+			++numByStatus[asset.status];
+			totalInputSize += asset.inputSize;
+			totalOutputSize += asset.outputSize;
+			totalAssetSeconds += asset.seconds;
+		}
+
+		printf("\n%u assets: %u cooked, %u skipped, %u failed\n", (uint32)assets.size(),
+			numByStatus[CookStatus::Cooked], numByStatus[CookStatus::Skipped], numByStatus[CookStatus::Failed]);
+		printf("Input %.1f KB, output %.1f KB\n", totalInputSize / 1024.0, totalOutputSize / 1024.0);
+		printf("Wall time %.3f s on %u threads (%.3f s summed over assets)\n", totalSeconds, numThreads, totalAssetSeconds);
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: starfox_cook [options]\n");
+		printf("  --data <dir>   Directory of source assets, searched recursively (default data)\n");
+		printf("  --out <dir>    Directory to write cooked assets to (default: same as --data)\n");
+		printf("  --jobs <count> Number of threads to cook with (default: one per core)\n");
+		printf("  --force        Cook every asset, even if unchanged since the last cook\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string dataDir = "data";
+	std::string outDir;
+	uint32 numJobs = 0;
+	bool bForce = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--data") == 0 && hasValue)
+		{
+			dataDir = argv[++i];
+		}
+		else if (strcmp(argv[i], "--out") == 0 && hasValue)
+		{
+			outDir = argv[++i];
+		}
+		else if (strcmp(argv[i], "--jobs") == 0 && hasValue)
+		{
+			numJobs = static_cast<uint32>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--force") == 0)
+		{
+			bForce = true;
+		}
+		else
+		{
+			PrintUsage();
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	// Without trailing separators, so that the paths of files found under it start with dataDir
+	// and a single separator
+	while (dataDir.size() > 1 && strchr(IO::Path::DirectorySeparatorChars, dataDir.back()))
+		dataDir.pop_back();
+
+	if (outDir.empty())
+		outDir = dataDir;
+
+	const Clock::time_point start = Clock::now();
+
+	// Gather assets. Outputs are flattened into outDir since the game looks assets up by name, so
+	// sources with the same name in different directories can't both be cooked.
+	std::vector<Asset> assets;
+	std::map<std::string, std::string> inputsByOutput;
+	bool bCollision = false;
+	for (const std::string& path : IO::Directory::GetFiles(dataDir, true))
+	{
+		Asset asset;
+		const std::string extension = str_tolower(path.substr(path.find_last_of('.') + 1));
+		if (extension == "fbx")
+			asset.type = AssetType::Mesh;
+		else if (extension == "tga")
+			asset.type = AssetType::Texture;
+		else
+			continue;
+
+		const std::string name = IO::Path::GetFileNameWithoutExtension(path);
+		const char* outputExtension = asset.type == AssetType::Mesh? MeshFile::kExtension : TextureFile::kExtension;
+
+		asset.inputPath = path;
+		asset.outputPath = IO::Path::Combine(outDir, name + "." + outputExtension);
+		asset.cacheName = path.substr(path.find_first_not_of(IO::Path::DirectorySeparatorChars, dataDir.size()));
+
+		// Case insensitive, as file names are on Windows
+		auto result = inputsByOutput.insert(std::make_pair(str_tolower(asset.outputPath), asset.cacheName));
+		if (!result.second)
+		{
+			fprintf(stderr, "%s and %s would both be cooked to %s\n", result.first->second.c_str(), asset.cacheName.c_str(), asset.outputPath.c_str());
+			bCollision = true;
+		}
+
+		assets.push_back(asset);
+	}
+
+	if (bCollision)
+	{
+		fprintf(stderr, "Rename the sources so that their names are unique\n");
+		return 1;
+	}
+
+	const std::string cachePath = IO::Path::Combine(outDir, kCacheFileName);
+	Cache cache = ReadCache(cachePath);
+
+	// Imports on different threads use separate FBX managers from the loader's pool
+	FbxLoader fbxLoader;
+	fbxLoader.Init();
+
+	JobSystem& jobSystem = JobSystem::Instance();
+	jobSystem.Initialize(numJobs > 0? numJobs - 1 : JobSystem::kDefaultNumWorkers);
+	jobSystem.ParallelFor(assets.size(), [&] (size_t i)
+	{
+		CookAsset(assets[i], cache, bForce, fbxLoader);
+	});
+	const uint32 numThreads = jobSystem.GetNumWorkers() + 1;
+	jobSystem.Shutdown();
+
+	// Failed assets are removed from the cache so that they're retried next time
+	bool bAnyFailed = false;
+	for (const auto& asset : assets)
+	{
+		if (asset.status == CookStatus::Failed)
+		{
+			cache.erase(asset.cacheName);
+			bAnyFailed = true;
+		}
+		else
+		{
+			cache[asset.cacheName] = asset.key;
+		}
+	}
+
+	if (!WriteCache(cachePath, cache))
+		fprintf(stderr, "Failed to write %s\n", cachePath.c_str());
+
+	PrintReport(assets, GetSecondsSince(start), numThreads);
+	return bAnyFailed? 1 : 0;
+}
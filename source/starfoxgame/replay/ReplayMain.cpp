@@ -0,0 +1,177 @@
+#include "RenderCapture.h"
+#include "gs/Rendering/GraphicsEngine.h"
+#include "gs/Platform/GL/GLUtil.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// starfox_replay: replays a frame captured from the game (see RenderCapture.h) and reports how long
+// the render backend takes to draw it.
+// Usage: starfox_replay [--frames <count>] [--warmup <count>] <capture file>
+//
+// The capture is loaded and its textures created up front, then each frame clears the screen,
+// applies the captured view state, executes the captured commands and presents, waiting for GL to
+// finish. Only the frames after the warmup ones are timed. On headless builds, the backend is
+// selected with GS_HEADLESS_RENDERER like in the game.
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	float64 GetSecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<float64>(Clock::now() - start).count();
+	}
+
+	// The fixed state that the game sets up at startup
+	void SetupGLState()
+	{
+		glEnable(GL_COLOR_MATERIAL);
+		glEnable(GL_LIGHT0);
+
+		GLUtil::SetBlending(false);
+		GLUtil::SetDepthTesting(true);
+		GLUtil::SetFrontFace(Winding::CounterClockwise, CullBackFace::True);
+		GLUtil::SetShadeModel(ShadeModel::Smooth);
+		GLUtil::SetTexturing(true);
+	}
+
+	// Creates the capture's textures, and makes its commands use them instead of the ids they were
+	// captured with
+	void CreateTextures(RenderCapture::Frame& frame)
+	{
+		std::map<TextureId, TextureId> textureIds;
+		for (const RenderCapture::Texture& texture : frame.textures)
+		{
+			if (texture.width == 0 || texture.height == 0)
+				continue;
+
+			ImageInfo imageInfo;
+			imageInfo.iChannels = 4;
+			imageInfo.imageSize.Set(texture.width, texture.height);
+			textureIds[texture.textureId] = GLUtil::CreateTexture(imageInfo, texture.texels.data());
+		}
+
+		auto GetTextureId = [&] (TextureId capturedTextureId)
+		{
+			const auto iter = textureIds.find(capturedTextureId);
+			return iter != textureIds.end()? iter->second : 0;
+		};
+
+		for (RenderCommand& command : frame.commands.commands)
+		{
+			if (command.type == RenderCommandType::SelectTexture)
+				command.arg = GetTextureId(command.arg);
+		}
+		frame.viewState.boundTexture = GetTextureId(frame.viewState.boundTexture);
+	}
+
+	void PrintReport(const std::vector<float64>& frameSeconds, uint32 numWarmupFrames)
+	{
+		if (frameSeconds.empty())
+		{
+			printf("No frames were timed\n");
+			return;
+		}
+
+		std::vector<float64> sorted = frameSeconds;
+		std::sort(sorted.begin(), sorted.end());
+
+		float64 totalSeconds = 0.0;
+		for (float64 seconds : sorted)
+			totalSeconds += seconds;
+
+		printf("Replayed %u frames (after %u warmup frames): %.3f ms average, %.3f ms min, %.3f ms median, %.3f ms max\n",
+			(uint32)sorted.size(), numWarmupFrames,
+			totalSeconds * 1000.0 / sorted.size(),
+			sorted.front() * 1000.0,
+			sorted[sorted.size() / 2] * 1000.0,
+			sorted.back() * 1000.0);
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: starfox_replay [options] <capture file>\n");
+		printf("  --frames <count> Number of frames to time (default 100)\n");
+		printf("  --warmup <count> Number of frames to replay before timing (default 10)\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string fileName;
+	uint32 numFrames = 100;
+	uint32 numWarmupFrames = 10;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--frames") == 0 && hasValue)
+		{
+			numFrames = static_cast<uint32>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+		{
+			numWarmupFrames = static_cast<uint32>(atoi(argv[++i]));
+		}
+		else if (argv[i][0] != '-' && fileName.empty())
+		{
+			fileName = argv[i];
+		}
+		else
+		{
+			PrintUsage();
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	if (fileName.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::unique_ptr<RenderCapture::Frame> pFrame = RenderCapture::Load(fileName.c_str());
+	if (!pFrame)
+	{
+		fprintf(stderr, "Failed to load capture %s\n", fileName.c_str());
+		return 1;
+	}
+	RenderCapture::Frame& frame = *pFrame;
+
+	const int width = frame.viewState.viewport[2];
+	const int height = frame.viewState.viewport[3];
+	printf("%s: %dx%d, %u commands, %u draws, %u triangles, %u textures\n", fileName.c_str(), width, height,
+		(uint32)frame.commands.commands.size(), (uint32)frame.commands.draws.size(), frame.commands.numTriangles, (uint32)frame.textures.size());
+
+	GraphicsEngine& gfxEngine = GraphicsEngine::Instance();
+	gfxEngine.Initialize("Star Fox Replay", width, height, 32, ScreenMode::Windowed, VertSync::Disable);
+	SetupGLState();
+	CreateTextures(frame);
+
+	std::vector<float64> frameSeconds;
+	bool bQuit = false;
+	for (uint32 i = 0; i < numWarmupFrames + numFrames && !bQuit; ++i)
+	{
+		const Clock::time_point start = Clock::now();
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		frame.viewState.Apply();
+		frame.commands.Execute();
+		gfxEngine.Update(bQuit);
+		glFinish();
+
+		if (i >= numWarmupFrames)
+			frameSeconds.push_back(GetSecondsSince(start));
+	}
+
+	PrintReport(frameSeconds, numWarmupFrames);
+	gfxEngine.Shutdown();
+	return 0;
+}
@@ -11,12 +11,12 @@ void AnchorComponent::Advance(float32 distance)
 
 	// For now, just move along Z axis
 	auto& mLocal = GetSceneNode()->ModifyLocalToParent();
-	mLocal.trans += mLocal.axisZ * distance;
+	mLocal.Translation() += mLocal.AxisZ() * distance;
 
 	//TWEAKABLE float32 speed = 0.005f;
 	//TWEAKABLE float32 amplitude = 100.f;
 	//const float32 lastS = MathEx::Sin(speed * (m_totalDistance - distance));
 	//const float32 currS = MathEx::Sin(speed * m_totalDistance);
 	//const float32 delta = (lastS - currS) * amplitude;
-	//mLocal.trans += mLocal.axisX * delta;
+	//mLocal.Translation() += mLocal.AxisX() * delta;
 }
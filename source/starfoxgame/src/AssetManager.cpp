@@ -0,0 +1,568 @@
+#include "AssetManager.h"
+#include "StaticMesh.h"
+#include "MeshFile.h"
+#include "TextureFile.h"
+#ifdef STARFOX_FBX_IMPORT
+#include "FbxLoader.h"
+#endif
+#include "gs/Image/ImageData.h"
+#include "gs/Image/ImageFuncs.h"
+#include "gs/System/IO.h"
+#include "gs/System/JobSystem.h"
+#include "gs/System/Profiler.h"
+#include "gs/Base/string_helpers.h"
+#include <algorithm>
+#include <limits>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+struct AssetManager::MeshEntry
+{
+	MeshEntry() : m_memorySize(0), m_bPending(true) { m_future = m_promise.get_future().share(); }
+
+	// Once loaded, the mesh is only referenced by m_future, so that its use count tells whether
+	// anything outside the manager uses it
+	const StaticMeshPtr& GetStaticMesh() const { assert(!m_bPending); return m_future.get(); }
+
+	std::string m_name;
+	size_t m_memorySize;
+	bool m_bPending;
+	std::promise<StaticMeshPtr> m_promise;
+	StaticMeshFuture m_future;
+	std::vector<StaticMeshCallback> m_callbacks;
+
+	// Written by the loading job
+	StaticMeshPtr m_pLoadedStaticMesh;
+	std::exception_ptr m_pException;
+};
+
+struct AssetManager::TextureEntry
+{
+	TextureEntry() : m_bPending(true), m_bEvicted(false) {}
+
+	std::string m_name;
+	std::string m_basePath; // Path without extension
+	TexturePtr m_pTexture;
+	bool m_bPending;
+	bool m_bEvicted; // Freed to stay under the texture budget, reloaded once drawn again
+
+	// Written by the loading job: pixels grown to a power of 2, ready to upload
+	ImageInfo m_imageInfo;
+	std::shared_ptr<const uint8> m_pPixels;
+	std::string m_error;
+};
+
+namespace
+{
+	const char kDataDirectory[] = "data";
+
+	// Placeholder texture: a grey and white checkerboard
+	const int kPlaceholderTextureSize = 8;
+
+	// Half the size of the placeholder mesh's box
+	const float32 kPlaceholderMeshExtent = 5.f;
+
+	size_t GetMemorySize(const gfx::StaticMesh& staticMesh)
+	{
+		size_t size = 0;
+		for (const auto& subMesh : staticMesh.m_subMeshes)
+		{
+			size += subMesh.GetVertexDataSize();
+			for (size_t lod = 0; lod < subMesh.GetNumLods(); ++lod)
+				size += subMesh.GetIndexDataSize(lod);
+		}
+		return size;
+	}
+
+	std::shared_ptr<gfx::StaticMesh> CreateBoxMesh(float32 extent)
+	{
+		std::vector<gfx::StaticMesh::Vertex> vertices;
+		std::vector<uint32> indices;
+
+		// Each face has its own vertices so that its normal is flat
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			for (float32 sign = -1.f; sign <= 1.f; sign += 2.f)
+			{
+				Vector3 normal = Vector3::Zero();
+				normal.v[axis] = sign;
+				Vector3 tangent = Vector3::Zero();
+				tangent.v[(axis + 1) % 3] = 1.f;
+				const Vector3 bitangent = normal.Cross(tangent);
+
+				const uint32 firstVertex = static_cast<uint32>(vertices.size());
+				const float32 corners[4][2] = { { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+				for (const auto& corner : corners)
+				{
+					gfx::StaticMesh::Vertex vertex;
+					const Vector3 position = (normal + tangent * corner[0] + bitangent * corner[1]) * extent;
+					vertex.position = Vector4(position.x, position.y, position.z, 1.f);
+					vertex.normal = Vector4(normal.x, normal.y, normal.z, 0.f);
+					vertices.push_back(vertex);
+				}
+
+				const uint32 quad[6] = { 0, 1, 2, 0, 2, 3 };
+				for (uint32 index : quad)
+					indices.push_back(firstVertex + index);
+			}
+		}
+
+		std::shared_ptr<gfx::StaticMesh> pStaticMesh(new gfx::StaticMesh);
+		pStaticMesh->m_subMeshes.resize(1);
+		pStaticMesh->m_subMeshes[0].SetVertices(vertices, VertexLayoutFlags::Normal);
+		pStaticMesh->m_subMeshes[0].SetIndices(indices);
+		pStaticMesh->m_boundingBox = AABB(-Vector3(extent, extent, extent), Vector3(extent, extent, extent));
+		return pStaticMesh;
+	}
+}
+
+AssetManager::AssetManager()
+	: m_numPendingRequests(0)
+	, m_placeholderTextureId(INVALID_TEXTURE_ID)
+	, m_frameIndex(0)
+	, m_textureBudget(std::numeric_limits<size_t>::max())
+	, m_numTextureUnusedFrames(kDefaultNumTextureUnusedFrames)
+	, m_textureMemoryUsage(0)
+	, m_bOverTextureBudget(false)
+	, m_numRunningJobs(0)
+{
+#ifdef STARFOX_FBX_IMPORT
+	// FBX managers are only created once an import needs one
+	m_pFbxLoader = std::make_shared<FbxLoader>();
+#endif
+}
+
+AssetManager::~AssetManager()
+{
+	// Jobs reference the manager, so wait for them. Textures aren't freed: the GL context is
+	// destroyed with them by then.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobCompleted.wait(lock, [&] { return m_numRunningJobs == 0; });
+}
+
+std::string AssetManager::GetMeshKey(const std::string& name)
+{
+	return str_tolower(name);
+}
+
+std::string AssetManager::GetTextureKey(const std::string& fileName)
+{
+	// Materials reference textures by the path they had when the mesh was authored, so only the
+	// name is used to find them in the data directory
+	return str_tolower(IO::Path::GetFileNameWithoutExtension(fileName));
+}
+
+AssetManager::StaticMeshFuture AssetManager::RequestStaticMeshAsync(const std::string& name, const StaticMeshCallback& callback)
+{
+	const std::string key = GetMeshKey(name);
+	auto iter = m_meshes.find(key);
+	if (iter != m_meshes.end())
+	{
+		MeshEntry& entry = *iter->second;
+		if (callback)
+		{
+			if (entry.m_bPending)
+				entry.m_callbacks.push_back(callback);
+			else
+				callback(entry.GetStaticMesh());
+		}
+		return entry.m_future;
+	}
+
+	auto pEntry = std::make_shared<MeshEntry>();
+	pEntry->m_name = name;
+	if (callback)
+		pEntry->m_callbacks.push_back(callback);
+	m_meshes[key] = pEntry;
+
+	++m_numPendingRequests;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_numRunningJobs;
+	}
+
+	JobSystem::Instance().RunAsync([this, pEntry]
+	{
+		PROFILE_SCOPE("AssetManager::LoadStaticMeshJob");
+
+		try
+		{
+			const std::string basePath = IO::Path::Combine(kDataDirectory, pEntry->m_name);
+			const std::string cookedFileName = basePath + "." + MeshFile::kExtension;
+			StaticMeshPtr pStaticMesh = MeshFile::Load(cookedFileName.c_str());
+
+			if (!pStaticMesh)
+			{
+#ifdef STARFOX_FBX_IMPORT
+				pStaticMesh = m_pFbxLoader->LoadStaticMesh((basePath + ".fbx").c_str());
+				MeshFile::Save(*pStaticMesh, cookedFileName.c_str());
+#else
+				throw std::runtime_error(str_format("Missing or out of date cooked mesh: %s (run starfox_cook)", cookedFileName.c_str()).c_str());
+#endif
+			}
+
+			pEntry->m_pLoadedStaticMesh = pStaticMesh;
+		}
+		catch (...)
+		{
+			pEntry->m_pException = std::current_exception();
+		}
+
+		// Notified under the lock, as the manager may be destroyed as soon as it's released
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completedMeshes.push_back(pEntry);
+		--m_numRunningJobs;
+		m_jobCompleted.notify_all();
+	});
+
+	return pEntry->m_future;
+}
+
+AssetManager::StaticMeshPtr AssetManager::LoadStaticMesh(const std::string& name)
+{
+	StaticMeshFuture future = RequestStaticMeshAsync(name);
+	while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		WaitForCompletedJob();
+
+	StaticMeshPtr pStaticMesh = future.get();
+
+	auto IsLoadingTextures = [&]
+	{
+		for (const auto& material : pStaticMesh->m_materials)
+		{
+			auto iter = m_textures.find(GetTextureKey(material.m_filename));
+			if (!material.m_filename.empty() && iter != m_textures.end() && iter->second->m_bPending)
+				return true;
+		}
+		return false;
+	};
+
+	while (IsLoadingTextures())
+		WaitForCompletedJob();
+
+	return pStaticMesh;
+}
+
+AssetManager::TexturePtr AssetManager::RequestTextureAsync(const std::string& fileName)
+{
+	const std::string key = GetTextureKey(fileName);
+	auto iter = m_textures.find(key);
+	if (iter != m_textures.end())
+		return iter->second->m_pTexture;
+
+	if (m_placeholderTextureId == INVALID_TEXTURE_ID)
+	{
+		uint8 pixels[kPlaceholderTextureSize * kPlaceholderTextureSize * 3];
+		for (int y = 0; y < kPlaceholderTextureSize; ++y)
+		{
+			for (int x = 0; x < kPlaceholderTextureSize; ++x)
+				memset(&pixels[(y * kPlaceholderTextureSize + x) * 3], (x + y) % 2 == 0? 0xFF : 0x80, 3);
+		}
+
+		ImageInfo imageInfo;
+		imageInfo.iChannels = 3;
+		imageInfo.imageSize = Size2d<int>(kPlaceholderTextureSize, kPlaceholderTextureSize);
+		m_placeholderTextureId = GLUtil::CreateTexture(imageInfo, pixels);
+	}
+
+	auto pEntry = std::make_shared<TextureEntry>();
+	pEntry->m_name = IO::Path::GetFileNameWithoutExtension(fileName);
+	pEntry->m_basePath = IO::Path::Combine(kDataDirectory, pEntry->m_name);
+	pEntry->m_pTexture = std::make_shared<gfx::Texture>();
+	pEntry->m_pTexture->m_textureId = m_placeholderTextureId;
+	m_textures[key] = pEntry;
+
+	StartTextureJob(pEntry);
+	return pEntry->m_pTexture;
+}
+
+void AssetManager::StartTextureJob(const std::shared_ptr<TextureEntry>& pEntry)
+{
+	assert(pEntry->m_bPending);
+	pEntry->m_error.clear();
+
+	++m_numPendingRequests;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_numRunningJobs;
+	}
+
+	JobSystem::Instance().RunAsync([this, pEntry]
+	{
+		PROFILE_SCOPE("AssetManager::LoadTextureJob");
+
+		try
+		{
+			// Prefer the cooked texture, which is uploaded straight from the mapped file
+			pEntry->m_pPixels = TextureFile::Load((pEntry->m_basePath + "." + TextureFile::kExtension).c_str(), pEntry->m_imageInfo);
+			if (!pEntry->m_pPixels)
+			{
+				ImageData imageData = ImageData::Load(pEntry->m_basePath + ".tga");
+				pEntry->m_imageInfo = imageData.GetImageInfo();
+
+				std::shared_ptr<uint8> pPixels(new uint8[imageData.GetDataSize()], std::default_delete<uint8[]>());
+				imageData.CopyDataTo(pPixels.get());
+
+				if (uint8* pGrownPixels = ImageFuncs::GrowToPowerOf2(pPixels.get(), pEntry->m_imageInfo))
+					pPixels.reset(pGrownPixels, std::default_delete<uint8[]>());
+
+				pEntry->m_pPixels = pPixels;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			pEntry->m_error = e.what();
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completedTextures.push_back(pEntry);
+		--m_numRunningJobs;
+		m_jobCompleted.notify_all();
+	});
+}
+
+TextureId AssetManager::UseTexture(gfx::Texture* pTexture)
+{
+	if (!pTexture)
+		return INVALID_TEXTURE_ID;
+
+	pTexture->m_lastUsedFrame = m_frameIndex;
+	return pTexture->m_textureId;
+}
+
+void AssetManager::SetTextureBudget(size_t budget, uint32 numUnusedFrames)
+{
+	assert(numUnusedFrames > 0 && "Textures drawn in the current frame can't be evicted");
+	m_textureBudget = budget;
+	m_numTextureUnusedFrames = numUnusedFrames;
+	m_bOverTextureBudget = false;
+}
+
+const AssetManager::StaticMeshPtr& AssetManager::GetPlaceholderStaticMesh()
+{
+	if (!m_pPlaceholderStaticMesh)
+		m_pPlaceholderStaticMesh = CreateBoxMesh(kPlaceholderMeshExtent);
+	return m_pPlaceholderStaticMesh;
+}
+
+void AssetManager::Update()
+{
+	PROFILE_SCOPE("AssetManager::Update");
+
+	std::vector<std::shared_ptr<MeshEntry>> completedMeshes;
+	std::vector<std::shared_ptr<TextureEntry>> completedTextures;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		completedMeshes.swap(m_completedMeshes);
+		completedTextures.swap(m_completedTextures);
+	}
+
+	// Textures first, so that meshes completed in the same update don't show placeholders for
+	// textures that are already loaded
+	for (const auto& pEntry : completedTextures)
+		CompleteTexture(*pEntry);
+
+	for (const auto& pEntry : completedMeshes)
+		CompleteMesh(*pEntry);
+
+	UpdateTextureResidency();
+
+	// Textures drawn from now on are used in the next frame
+	++m_frameIndex;
+}
+
+void AssetManager::UpdateTextureResidency()
+{
+	std::vector<TextureEntry*> evictable;
+	for (const auto& entry : m_textures)
+	{
+		TextureEntry& texture = *entry.second;
+		if (texture.m_bPending)
+			continue;
+
+		const uint32 numUnusedFrames = m_frameIndex - texture.m_pTexture->m_lastUsedFrame;
+
+		// Stream evicted textures back in once they're drawn (with the placeholder) again
+		if (texture.m_bEvicted && numUnusedFrames == 0)
+		{
+			texture.m_bEvicted = false;
+			texture.m_bPending = true;
+			StartTextureJob(entry.second);
+		}
+		else if (texture.m_pTexture->m_bLoaded && numUnusedFrames >= m_numTextureUnusedFrames)
+		{
+			evictable.push_back(&texture);
+		}
+	}
+
+	if (m_textureMemoryUsage <= m_textureBudget)
+	{
+		m_bOverTextureBudget = false;
+		return;
+	}
+
+	// Least recently used first
+	std::sort(evictable.begin(), evictable.end(), [] (const TextureEntry* pLhs, const TextureEntry* pRhs)
+	{
+		return pLhs->m_pTexture->m_lastUsedFrame < pRhs->m_pTexture->m_lastUsedFrame;
+	});
+
+	for (size_t i = 0; i < evictable.size() && m_textureMemoryUsage > m_textureBudget; ++i)
+		EvictTexture(*evictable[i]);
+
+	if (m_textureMemoryUsage > m_textureBudget && !m_bOverTextureBudget)
+	{
+		printf("Recently drawn textures exceed the texture budget: %.1f KB / %.1f KB\n", m_textureMemoryUsage / 1024.0, m_textureBudget / 1024.0);
+		m_bOverTextureBudget = true;
+	}
+}
+
+void AssetManager::EvictTexture(TextureEntry& entry)
+{
+	gfx::Texture& texture = *entry.m_pTexture;
+	assert(texture.m_bLoaded && !entry.m_bPending);
+
+	GLUtil::FreeTexture(texture.m_textureId);
+	texture.m_textureId = m_placeholderTextureId;
+	texture.m_bLoaded = false;
+	m_textureMemoryUsage -= texture.m_memorySize;
+	entry.m_bEvicted = true;
+}
+
+void AssetManager::CompleteTexture(TextureEntry& entry)
+{
+	assert(entry.m_bPending);
+	entry.m_bPending = false;
+	--m_numPendingRequests;
+
+	if (!entry.m_pPixels)
+	{
+		printf("Failed to load texture %s: %s\n", entry.m_name.c_str(), entry.m_error.c_str());
+		return;
+	}
+
+	gfx::Texture& texture = *entry.m_pTexture;
+	texture.m_textureId = GLUtil::CreateTexture(entry.m_imageInfo, entry.m_pPixels.get());
+	texture.m_memorySize = entry.m_imageInfo.GetDataSize();
+	texture.m_bLoaded = true;
+	entry.m_pPixels = nullptr;
+
+	// Count the texture as used when it arrives, so that it isn't evicted before it's drawn
+	texture.m_lastUsedFrame = m_frameIndex;
+	m_textureMemoryUsage += texture.m_memorySize;
+}
+
+void AssetManager::CompleteMesh(MeshEntry& entry)
+{
+	assert(entry.m_bPending);
+	entry.m_bPending = false;
+	--m_numPendingRequests;
+
+	std::vector<StaticMeshCallback> callbacks;
+	callbacks.swap(entry.m_callbacks);
+
+	if (entry.m_pException)
+	{
+		entry.m_promise.set_exception(entry.m_pException);
+
+		// Forget the failed request so that the mesh can be requested again
+		m_meshes.erase(GetMeshKey(entry.m_name));
+		for (const auto& callback : callbacks)
+			callback(nullptr);
+		return;
+	}
+
+	StaticMeshPtr pStaticMesh = entry.m_pLoadedStaticMesh;
+	entry.m_pLoadedStaticMesh = nullptr;
+
+	for (auto& material : pStaticMesh->m_materials)
+	{
+		if (!material.m_filename.empty())
+			material.m_pTexture = RequestTextureAsync(material.m_filename);
+	}
+
+	entry.m_memorySize = GetMemorySize(*pStaticMesh);
+	entry.m_promise.set_value(pStaticMesh);
+
+	for (const auto& callback : callbacks)
+		callback(pStaticMesh);
+}
+
+void AssetManager::WaitForCompletedJob()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobCompleted.wait(lock, [&] { return !m_completedMeshes.empty() || !m_completedTextures.empty(); });
+	}
+	Update();
+}
+
+void AssetManager::WaitForPendingRequests()
+{
+	// Completing a mesh can request textures, so keep going until nothing is left
+	while (m_numPendingRequests > 0)
+		WaitForCompletedJob();
+}
+
+void AssetManager::ReleaseUnused()
+{
+	// Meshes first, as releasing them releases their references to textures
+	for (auto iter = m_meshes.begin(); iter != m_meshes.end(); )
+	{
+		const MeshEntry& entry = *iter->second;
+		if (!entry.m_bPending && entry.GetStaticMesh().use_count() == 1)
+			iter = m_meshes.erase(iter);
+		else
+			++iter;
+	}
+
+	for (auto iter = m_textures.begin(); iter != m_textures.end(); )
+	{
+		TextureEntry& entry = *iter->second;
+		if (!entry.m_bPending && entry.m_pTexture.use_count() == 1)
+		{
+			if (entry.m_pTexture->m_bLoaded)
+			{
+				GLUtil::FreeTexture(entry.m_pTexture->m_textureId);
+				m_textureMemoryUsage -= entry.m_pTexture->m_memorySize;
+			}
+			iter = m_textures.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+size_t AssetManager::GetMemoryUsage() const
+{
+	size_t size = 0;
+	for (const auto& entry : m_meshes)
+		size += entry.second->m_memorySize;
+	return size + m_textureMemoryUsage;
+}
+
+void AssetManager::PrintReport() const
+{
+	// The manager's own reference isn't counted
+	printf("%-8s %-32s %6s %10s\n", "Type", "Asset", "Refs", "KB");
+	for (const auto& entry : m_meshes)
+	{
+		const MeshEntry& mesh = *entry.second;
+		printf("%-8s %-32s %6ld %10.1f%s\n", "mesh", mesh.m_name.c_str(), mesh.m_bPending? 0 : mesh.GetStaticMesh().use_count() - 1,
+			mesh.m_memorySize / 1024.0, mesh.m_bPending? " (loading)" : "");
+	}
+	for (const auto& entry : m_textures)
+	{
+		const TextureEntry& texture = *entry.second;
+		printf("%-8s %-32s %6ld %10.1f%s\n", "texture", texture.m_name.c_str(), texture.m_pTexture.use_count() - 1,
+			texture.m_pTexture->m_memorySize / 1024.0, texture.m_bPending? " (loading)" : texture.m_bEvicted? " (evicted)" : texture.m_pTexture->m_bLoaded? "" : " (failed)");
+	}
+	printf("Total %.1f KB (textures %.1f KB", GetMemoryUsage() / 1024.0, m_textureMemoryUsage / 1024.0);
+	if (m_textureBudget != std::numeric_limits<size_t>::max())
+		printf(" of %.1f KB budget", m_textureBudget / 1024.0);
+	printf(")\n");
+}
@@ -0,0 +1,138 @@
+#ifndef _ASSET_MANAGER_H_
+#define _ASSET_MANAGER_H_
+
+#include "gs/Base/Base.h"
+#include "gs/Base/Singleton.h"
+#include "gs/Platform/GL/GLUtil.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+
+namespace gfx
+{
+	struct StaticMesh;
+	struct Texture;
+}
+
+class FbxLoader;
+
+// Loads and caches the game's meshes and textures. Assets are keyed by path: requesting an asset
+// that is loaded or loading returns the same instance, so for example two meshes whose materials
+// reference the same .tga share one GPU texture. Files are read and decoded on the JobSystem, while
+// GPU uploads and callbacks run in Update, so all member functions must be called from the thread
+// that owns the GL context.
+//
+// The manager keeps a reference to every asset it loads; ReleaseUnused frees the ones nothing else
+// references anymore. Textures are also kept under a memory budget: when the loaded textures exceed
+// it, Update evicts the least recently drawn ones from GPU memory, and streams them back in once
+// they're drawn again.
+class AssetManager : public Singleton<AssetManager>
+{
+private:
+	friend class Singleton<AssetManager>;
+	AssetManager();
+
+public:
+	~AssetManager();
+
+	typedef std::shared_ptr<gfx::StaticMesh> StaticMeshPtr;
+	typedef std::shared_ptr<gfx::Texture> TexturePtr;
+	typedef std::shared_future<StaticMeshPtr> StaticMeshFuture;
+	typedef std::function<void (const StaticMeshPtr& pStaticMesh)> StaticMeshCallback;
+
+	// Requests the cooked mesh data/<name>.sfmesh, which is first cooked from data/<name>.fbx if it's
+	// missing or out of date and FBX import is enabled. Once the mesh is loaded, Update makes the
+	// future ready and calls callback (right away if the mesh is already loaded). The mesh's textures
+	// are requested at that point, and use the placeholder until they're loaded. If the mesh fails to
+	// load, the future holds the exception and callback is called with nullptr.
+	StaticMeshFuture RequestStaticMeshAsync(const std::string& name, const StaticMeshCallback& callback = StaticMeshCallback());
+
+	// Blocks until the mesh and its textures are loaded. Throws std::exception if the mesh fails to load.
+	StaticMeshPtr LoadStaticMesh(const std::string& name);
+
+	// Requests the texture of an image file, looked up by name in data/ (the cooked .sftex, then the
+	// .tga). Returns right away with a texture that uses the placeholder's id until it's loaded, and
+	// keeps it if loading fails.
+	TexturePtr RequestTextureAsync(const std::string& fileName);
+
+	// Returns the id to bind to draw with texture (which can be null), and marks it as used this frame
+	// so that it isn't evicted, or is streamed back in if it was
+	TextureId UseTexture(gfx::Texture* pTexture);
+
+	// Textures not drawn in the last numUnusedFrames frames are evicted, least recently drawn first,
+	// while the loaded textures use more than budget bytes. Textures in use are never evicted, so
+	// memory usage can exceed a budget that's too small for a single frame. There's no budget by default.
+	static const uint32 kDefaultNumTextureUnusedFrames = 60;
+	void SetTextureBudget(size_t budget, uint32 numUnusedFrames = kDefaultNumTextureUnusedFrames);
+
+	// Small box to draw in place of meshes that are still loading
+	const StaticMeshPtr& GetPlaceholderStaticMesh();
+
+	// Completes loaded requests: uploads textures, then makes mesh futures ready and calls their
+	// callbacks. Then streams in evicted textures that were drawn, and evicts textures to stay under
+	// the budget. Call once per frame, before rendering.
+	void Update();
+
+	// Blocks until every request made so far has completed
+	void WaitForPendingRequests();
+
+	// Frees loaded assets that are only referenced by the manager
+	void ReleaseUnused();
+
+	// Bytes of vertex, index and texture data used by the loaded assets
+	size_t GetMemoryUsage() const;
+
+	// Bytes of texture data used by the loaded (not evicted) textures
+	size_t GetTextureMemoryUsage() const { return m_textureMemoryUsage; }
+
+	// Prints each loaded asset with its number of references and memory usage
+	void PrintReport() const;
+
+private:
+	struct MeshEntry;
+	struct TextureEntry;
+
+	static std::string GetMeshKey(const std::string& name);
+	static std::string GetTextureKey(const std::string& fileName);
+
+	// Blocks until a job completes, then runs Update
+	void WaitForCompletedJob();
+
+	// Reads and decodes the texture's file on the JobSystem
+	void StartTextureJob(const std::shared_ptr<TextureEntry>& pEntry);
+
+	void CompleteMesh(MeshEntry& entry);
+	void CompleteTexture(TextureEntry& entry);
+
+	void UpdateTextureResidency();
+	void EvictTexture(TextureEntry& entry);
+
+	std::map<std::string, std::shared_ptr<MeshEntry>> m_meshes;
+	std::map<std::string, std::shared_ptr<TextureEntry>> m_textures;
+	uint32 m_numPendingRequests;
+
+	StaticMeshPtr m_pPlaceholderStaticMesh;
+	TextureId m_placeholderTextureId;
+
+	uint32 m_frameIndex;
+	size_t m_textureBudget;
+	uint32 m_numTextureUnusedFrames;
+	size_t m_textureMemoryUsage;
+	bool m_bOverTextureBudget; // Reported once each time the budget can't be met
+
+	std::shared_ptr<FbxLoader> m_pFbxLoader; // Null without FBX import
+
+	// Entries whose jobs have completed, waiting for Update. Jobs also use this mutex.
+	std::mutex m_mutex;
+	std::condition_variable m_jobCompleted;
+	std::vector<std::shared_ptr<MeshEntry>> m_completedMeshes;
+	std::vector<std::shared_ptr<TextureEntry>> m_completedTextures;
+	uint32 m_numRunningJobs;
+};
+
+#endif // _ASSET_MANAGER_H_
@@ -34,9 +34,10 @@ void OrbitTargetCameraComponent::Update(float32 deltaTime)
 	}
 	//m_angles.Canonize();
 
-	auto& mCamera = GetSceneNode()->ModifyLocalToParent();
-	mCamera.SetFromEulerAngles(m_angles);
-	mCamera.trans = pTarget->GetLocalToWorld().trans + DirectionVector(Vector3(0,0,-m_offset)) * mCamera;
+	QTS& camera = GetSceneNode()->ModifyLocalToParentQTS();
+	camera.rot.SetFromEulerAngles(m_angles);
+	camera.scale = 1.f;
+	camera.trans = pTarget->GetLocalToWorld().Translation() + DirectionVector(Vector3(0,0,-m_offset)) * camera;
 }
 
 void FollowShipCameraComponent::UpdateTransform(float32 deltaTime, bool damp)
@@ -48,69 +49,79 @@ void FollowShipCameraComponent::UpdateTransform(float32 deltaTime, bool damp)
 	auto psAnchor = pTarget->GetParent();
 	const Matrix43& mAnchorWorld = psAnchor->GetLocalToWorld();
 	const Matrix43& mShipWorld = pTarget->GetLocalToWorld();		
-	Matrix43& mCamWorld = GetSceneNode()->ModifyLocalToWorld();
+
+	// The camera has no parent, so its local transform is its world transform
+	assert(!GetSceneNode()->GetParent());
+	QTS& camWorld = GetSceneNode()->ModifyLocalToParentQTS();
 
 	// First thing, we want the camera to be a fixed distance behind the ship. We do
 	// this in anchor space since the ship yaws.
 	Matrix43 mInvAnchorWorld; mInvAnchorWorld.SetInverseFromSRT(mAnchorWorld);
-	Vector3 vCamPosInAnchorSpace = PositionVector(mCamWorld.trans) * mInvAnchorWorld;
+	Vector3 vCamPosInAnchorSpace = PositionVector(camWorld.trans) * mInvAnchorWorld;
 	vCamPosInAnchorSpace.z = -m_offset;
-	mCamWorld.trans = PositionVector(vCamPosInAnchorSpace) * mAnchorWorld;
+	const Vector3 vCamPos = PositionVector(vCamPosInAnchorSpace) * mAnchorWorld;
 
 	// Now approach the camera in the xy plane to be behind the ship
 	TWEAKABLE float32 timeToTarget = 0.5f;
-	Vector3 vCamDestPos = mShipWorld.trans - mAnchorWorld.axisZ * m_offset;
-	Vector3 vCamFinalPos = damp? ApproachDamped(mCamWorld.trans, vCamDestPos, deltaTime, 0.99f, timeToTarget, 1.f) : vCamDestPos;
+	Vector3 vCamDestPos = mShipWorld.Translation() - mAnchorWorld.AxisZ() * m_offset;
+	Vector3 vCamFinalPos = damp? ApproachDamped(vCamPos, vCamDestPos, deltaTime, 0.99f, timeToTarget, 1.f) : vCamDestPos;
 
 	//TWEAKABLE float32 approachSpeed = 100.f;
-	//Vector3 vCamFinalPos = damp? ApproachLinear(mCamWorld.trans, vCamDestPos, deltaTime, approachSpeed) : vCamDestPos;
+	//Vector3 vCamFinalPos = damp? ApproachLinear(mCamWorld.Translation(), vCamDestPos, deltaTime, approachSpeed) : vCamDestPos;
 
 
 	//TWEAKABLE float32 maxAllowedDistX = 50.f;
 	//TWEAKABLE float32 maxAllowedDistY = 50.f;
-	//Vector3 vDelta = vCamDestPos - mCamWorld.trans;
+	//Vector3 vDelta = vCamDestPos - mCamWorld.Translation();
 	//assert(vDelta.z == 0.f);
-	//Vector3 vCamFinalPos = mCamWorld.trans;
+	//Vector3 vCamFinalPos = mCamWorld.Translation();
 	//const bool outsideAllowedDistX = MathEx::Abs(vDelta.x) > maxAllowedDistX;
 	//const bool outsideAllowedDistY = MathEx::Abs(vDelta.y) > maxAllowedDistY;
 	//if (outsideAllowedDistX || outsideAllowedDistY)
 	//{
 	//	Vector3 vDeltaNorm = Normalize(vDelta);
 
-	//	vCamDestPos = mCamWorld.trans;
+	//	vCamDestPos = mCamWorld.Translation();
 
 	//	if (outsideAllowedDistX)
 	//	{
-	//		vCamDestPos.x = mCamWorld.trans.x + (vDelta.x - vDeltaNorm.x * maxAllowedDistX);
+	//		vCamDestPos.x = mCamWorld.Translation().x + (vDelta.x - vDeltaNorm.x * maxAllowedDistX);
 	//	}
 
 	//	if (outsideAllowedDistY)
 	//	{
-	//		vCamDestPos.y = mCamWorld.trans.y + (vDelta.y - vDeltaNorm.y * maxAllowedDistX);
+	//		vCamDestPos.y = mCamWorld.Translation().y + (vDelta.y - vDeltaNorm.y * maxAllowedDistX);
 	//	}
 
-	//	vCamFinalPos = damp? ApproachDamped(mCamWorld.trans, vCamDestPos, deltaTime, 0.99f, timeToTarget, 1.f) : vCamDestPos;
+	//	vCamFinalPos = damp? ApproachDamped(mCamWorld.Translation(), vCamDestPos, deltaTime, 0.99f, timeToTarget, 1.f) : vCamDestPos;
 	//}
 
 	////// Approach point that brings the ship into the allowable region
-	//////vCamDestPos = mCamWorld.trans + (vDelta - (Normalize(vDelta) * maxAllowedDistXY));
+	//////vCamDestPos = mCamWorld.Translation() + (vDelta - (Normalize(vDelta) * maxAllowedDistXY));
 
 
 
-	EulerAngles anchorAngles; anchorAngles.SetFromMatrix(mAnchorWorld);
-	EulerAngles shipAngles; shipAngles.SetFromMatrix(mShipWorld);
-	EulerAngles camAngles; camAngles.SetFromMatrix(mCamWorld);
+	// Orient the camera like the anchor, rolled towards a fraction of the ship's roll relative to
+	// the anchor: the twist of the ship's local rotation about its forward (Z) axis
+	QTS anchorWorld; anchorWorld.SetFromMatrix(mAnchorWorld);
+	const Quaternion qShipLocal = pTarget->GetLocalToParentQTS().rot;
+	Quaternion qShipRoll(0.f, 0.f, qShipLocal.z, qShipLocal.w);
+	qShipRoll.Normalize();
 
 	TWEAKABLE float32 camToShipRollRatio = 0.2f;
 	TWEAKABLE float32 timeToTarget3 = 2.f;
-	EulerAngles camFinalAngles = anchorAngles;
-	camFinalAngles.roll = ApproachDamped(camAngles.roll, shipAngles.roll * camToShipRollRatio, deltaTime, 0.99f, timeToTarget3);
+	const Quaternion qCamDestRoll = Slerp(Quaternion::Identity(), qShipRoll, camToShipRollRatio);
+	const Quaternion qCamRoll = camWorld.rot * Invert(anchorWorld.rot);
+	const float32 rollAlpha = damp? 1.f - MathEx::Pow(1.f - 0.99f, deltaTime / timeToTarget3) : 1.f;
 
-	mCamWorld.SetFromEulerAngles(camFinalAngles, vCamFinalPos);
+	camWorld.rot = Slerp(qCamRoll, qCamDestRoll, rollAlpha) * anchorWorld.rot;
+	camWorld.rot.Normalize();
+	camWorld.trans = vCamFinalPos;
+	camWorld.scale = 1.f;
 
 	// Look at the ship
-	//const Vector3 vCamCurrForward = mCamWorld.axisZ;
-	//const Vector3 vCamTargetForward = Normalize(mShipWorld.trans - vCamFinalPos);
+	//const Vector3 vCamCurrForward = mCamWorld.AxisZ();
+	//const Vector3 vCamTargetForward = Normalize(mShipWorld.Translation() - vCamFinalPos);
 	//TWEAKABLE float32 timeToTarget2 = 2.f;
 	//const Vector3 vCamFinalForward = ApproachDirectionDamped(vCamCurrForward, vCamTargetForward, deltaTime, 0.99f, timeToTarget2);//, 0.1f);
 
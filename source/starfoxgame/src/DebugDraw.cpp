@@ -1,3 +1,278 @@
 #include "DebugDraw.h"
+#include "gs/Math/MathEx.h"
+#include "gs/Platform/GL/GLUtil.h"
+#include <algorithm>
+#include <cassert>
 
 DebugDrawManager g_debugDrawManager;
+
+thread_local const DebugDrawManager* DebugDrawManager::ms_pThreadBufferOwner = nullptr;
+thread_local DebugDrawManager::ThreadBuffer* DebugDrawManager::ms_pThreadBuffer = nullptr;
+
+// What one thread added since the last TakeFrame
+struct DebugDrawManager::ThreadBuffer
+{
+	std::vector<Vertex> lineVertices;
+	std::vector<Instance> instances;
+};
+
+namespace
+{
+	const uint32 kNumSphereSegments = 16;
+
+	typedef std::vector<DebugDrawManager::Vertex> VertexList;
+
+	void AddLineVertices(VertexList& vertices, const Vector3& v1, const Vector3& v2, const Color4F& color)
+	{
+		DebugDrawManager::Vertex vertex = { v1, color };
+		vertices.push_back(vertex);
+		vertex.position = v2;
+		vertices.push_back(vertex);
+	}
+
+	// Line lists for each DebugPrimitive, in primitive space. Primitives other than Axes are white,
+	// and drawn without their vertex colors.
+	class PrimitiveGeometry
+	{
+	public:
+		PrimitiveGeometry()
+		{
+			const Color4F white = Color4F::White();
+
+			// Sphere: a circle around each axis
+			VertexList& sphere = m_vertices[DebugPrimitive::Sphere];
+			for (uint32 i = 0; i < kNumSphereSegments; ++i)
+			{
+				const float32 angle1 = k2Pi * i / kNumSphereSegments;
+				const float32 angle2 = k2Pi * (i + 1) / kNumSphereSegments;
+				const float32 c1 = MathEx::Cos(angle1), s1 = MathEx::Sin(angle1);
+				const float32 c2 = MathEx::Cos(angle2), s2 = MathEx::Sin(angle2);
+				AddLineVertices(sphere, Vector3(0.f, c1, s1), Vector3(0.f, c2, s2), white);
+				AddLineVertices(sphere, Vector3(c1, 0.f, s1), Vector3(c2, 0.f, s2), white);
+				AddLineVertices(sphere, Vector3(c1, s1, 0.f), Vector3(c2, s2, 0.f), white);
+			}
+
+			// Box and frustum: the edges of the -1 to 1 cube
+			AddCubeEdges(m_vertices[DebugPrimitive::Box]);
+			AddCubeEdges(m_vertices[DebugPrimitive::Frustum]);
+
+			VertexList& axes = m_vertices[DebugPrimitive::Axes];
+			AddLineVertices(axes, Vector3::Zero(), Vector3::UnitX(), Color4F::Red());
+			AddLineVertices(axes, Vector3::Zero(), Vector3::UnitY(), Color4F::Green());
+			AddLineVertices(axes, Vector3::Zero(), Vector3::UnitZ(), Color4F::Blue());
+		}
+
+		const VertexList& GetVertices(DebugPrimitive::Type primitive) const { return m_vertices[primitive]; }
+
+	private:
+		static void AddCubeEdges(VertexList& vertices)
+		{
+			const Color4F white = Color4F::White();
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				// The four edges parallel to this axis
+				for (int corner = 0; corner < 4; ++corner)
+				{
+					Vector3 v1, v2;
+					v1.v[axis] = -1.f;
+					v2.v[axis] = 1.f;
+					v1.v[(axis + 1) % 3] = v2.v[(axis + 1) % 3] = (corner & 1)? 1.f : -1.f;
+					v1.v[(axis + 2) % 3] = v2.v[(axis + 2) % 3] = (corner & 2)? 1.f : -1.f;
+					AddLineVertices(vertices, v1, v2, white);
+				}
+			}
+		}
+
+		VertexList m_vertices[DebugPrimitive::NumTypes];
+	};
+
+	const PrimitiveGeometry& GetPrimitiveGeometry()
+	{
+		static const PrimitiveGeometry primitiveGeometry;
+		return primitiveGeometry;
+	}
+
+	void SetVertexPointers(const VertexList& vertices)
+	{
+		const GLsizei stride = sizeof(DebugDrawManager::Vertex);
+		glVertexPointer(3, GL_FLOAT, stride, vertices[0].position.v);
+		glColorPointer(4, GL_FLOAT, stride, vertices[0].color.v);
+	}
+
+	// mResult = mA * mB, for column-major GL matrices
+	void MultiplyGLMatrices(const float32 mA[16], const float32 mB[16], float32 mResult[16])
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				float32 sum = 0.f;
+				for (int k = 0; k < 4; ++k)
+					sum += mA[k * 4 + row] * mB[column * 4 + k];
+				mResult[column * 4 + row] = sum;
+			}
+		}
+	}
+
+	// The inverse of the matrix that glFrustum or glOrtho builds from projection, which maps the -1 to
+	// 1 cube of normalized device coordinates back to view space
+	void GetInverseProjectionMatrix(const ProjectionInfo& projection, float32 mResult[16])
+	{
+		const float32 l = projection.left, r = projection.right;
+		const float32 b = projection.bottom, t = projection.top;
+		const float32 n = projection.near, f = projection.far;
+
+		std::fill(mResult, mResult + 16, 0.f);
+		if (projection.isFrustum)
+		{
+			mResult[0] = (r - l) / (2.f * n);
+			mResult[5] = (t - b) / (2.f * n);
+			mResult[11] = -(f - n) / (2.f * f * n);
+			mResult[12] = (r + l) / (2.f * n);
+			mResult[13] = (t + b) / (2.f * n);
+			mResult[14] = -1.f;
+			mResult[15] = (f + n) / (2.f * f * n);
+		}
+		else
+		{
+			mResult[0] = (r - l) * 0.5f;
+			mResult[5] = (t - b) * 0.5f;
+			mResult[10] = -(f - n) * 0.5f;
+			mResult[12] = (r + l) * 0.5f;
+			mResult[13] = (t + b) * 0.5f;
+			mResult[14] = -(f + n) * 0.5f;
+			mResult[15] = 1.f;
+		}
+	}
+}
+
+DebugDrawManager::DebugDrawManager()
+{
+}
+
+DebugDrawManager::~DebugDrawManager()
+{
+}
+
+DebugDrawManager::ThreadBuffer& DebugDrawManager::GetThreadBuffer()
+{
+	if (ms_pThreadBufferOwner != this)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_threadBuffers.emplace_back(new ThreadBuffer());
+		ms_pThreadBuffer = m_threadBuffers.back().get();
+		ms_pThreadBufferOwner = this;
+	}
+	return *ms_pThreadBuffer;
+}
+
+void DebugDrawManager::AddLine(const Vector3& v1, const Vector3& v2, const Color4F& color)
+{
+	AddLineVertices(GetThreadBuffer().lineVertices, v1, v2, color);
+}
+
+void DebugDrawManager::AddPrimitive(DebugPrimitive::Type primitive, const Matrix43& mPrimitiveToWorld, const Color4F& color)
+{
+	float32 mGL[16];
+	GLUtil::Matrix43ToGLMatrix(mPrimitiveToWorld, mGL);
+	AddPrimitive(primitive, mGL, color);
+}
+
+void DebugDrawManager::AddPrimitive(DebugPrimitive::Type primitive, const float32 mPrimitiveToWorld[16], const Color4F& color)
+{
+	assert(primitive >= 0 && primitive < DebugPrimitive::NumTypes);
+	Instance instance;
+	instance.primitive = primitive;
+	std::copy(mPrimitiveToWorld, mPrimitiveToWorld + 16, instance.mPrimitiveToWorld);
+	instance.color = color;
+	GetThreadBuffer().instances.push_back(instance);
+}
+
+void DebugDrawManager::TakeFrame(Frame& frame)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	frame.lineVertices.clear();
+	frame.instances.clear();
+	for (auto& pThreadBuffer : m_threadBuffers)
+	{
+		frame.lineVertices.insert(frame.lineVertices.end(), pThreadBuffer->lineVertices.begin(), pThreadBuffer->lineVertices.end());
+		frame.instances.insert(frame.instances.end(), pThreadBuffer->instances.begin(), pThreadBuffer->instances.end());
+		pThreadBuffer->lineVertices.clear();
+		pThreadBuffer->instances.clear();
+	}
+
+	// So that Render sets up each primitive's arrays once
+	std::stable_sort(frame.instances.begin(), frame.instances.end(), [] (const Instance& lhs, const Instance& rhs)
+	{
+		return lhs.primitive < rhs.primitive;
+	});
+}
+
+void DebugDrawManager::Render(const Frame& frame)
+{
+	if (frame.lineVertices.empty() && frame.instances.empty())
+		return;
+
+	const bool bLighting = GLUtil::GetLighting();
+	const bool bTexturing = GLUtil::GetTexturing();
+	const Color4F color = GLUtil::GetColor();
+	GLUtil::SetLighting(false);
+	GLUtil::SetTexturing(false);
+
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glEnableClientState(GL_VERTEX_ARRAY);
+
+	if (!frame.lineVertices.empty())
+	{
+		glEnableClientState(GL_COLOR_ARRAY);
+		SetVertexPointers(frame.lineVertices);
+		glDrawArrays(GL_LINES, 0, (GLsizei)frame.lineVertices.size());
+	}
+
+	const PrimitiveGeometry& primitiveGeometry = GetPrimitiveGeometry();
+	for (size_t i = 0; i < frame.instances.size(); )
+	{
+		const DebugPrimitive::Type primitive = frame.instances[i].primitive;
+		const VertexList& vertices = primitiveGeometry.GetVertices(primitive);
+		const bool bVertexColors = primitive == DebugPrimitive::Axes;
+
+		SetVertexPointers(vertices);
+		if (bVertexColors)
+			glEnableClientState(GL_COLOR_ARRAY);
+		else
+			glDisableClientState(GL_COLOR_ARRAY);
+
+		for (; i < frame.instances.size() && frame.instances[i].primitive == primitive; ++i)
+		{
+			const Instance& instance = frame.instances[i];
+			if (!bVertexColors)
+				GLUtil::SetColor(instance.color);
+
+			glPushMatrix();
+			glMultMatrixf(instance.mPrimitiveToWorld);
+			glDrawArrays(GL_LINES, 0, (GLsizei)vertices.size());
+			glPopMatrix();
+		}
+	}
+
+	glPopClientAttrib();
+	ASSERT_NO_GL_ERROR();
+
+	GLUtil::SetColor(color);
+	GLUtil::SetTexturing(bTexturing);
+	GLUtil::SetLighting(bLighting);
+}
+
+void DebugDrawFrustum(const ProjectionInfo& projection, const Matrix43& mViewToWorld, const Color4F& color)
+{
+	float32 mViewToWorldGL[16];
+	GLUtil::Matrix43ToGLMatrix(mViewToWorld, mViewToWorldGL);
+
+	float32 mInverseProjection[16];
+	GetInverseProjectionMatrix(projection, mInverseProjection);
+
+	float32 mFrustumToWorld[16];
+	MultiplyGLMatrices(mViewToWorldGL, mInverseProjection, mFrustumToWorld);
+	g_debugDrawManager.AddPrimitive(DebugPrimitive::Frustum, mFrustumToWorld, color);
+}
@@ -3,61 +3,121 @@
 
 #include "gs/Math/Vector3.h"
 #include "gs/Math/Matrix43.h"
+#include "gs/Math/Geometry.h"
 #include "gs/Rendering/Color4.h"
-#include "gs/Platform/GL/GLHeaders.h"
+#include <memory>
+#include <mutex>
 #include <vector>
 
+struct ProjectionInfo;
+
+namespace DebugPrimitive
+{
+	enum Type
+	{
+		Sphere,		// Radius 1, as a circle around each axis
+		Box,		// From -1 to 1 on each axis
+		Axes,		// Length 1, colored red, green and blue (the instance color is ignored)
+		Frustum,	// The -1 to 1 cube, which an inverse projection turns into a view frustum
+
+		NumTypes
+	};
+}
+
+// Collects debug lines and primitives, added from any thread while a frame is updated, and draws
+// them when it's rendered. Each thread appends to its own buffers, so adding doesn't lock. Lines are
+// gathered into one vertex array and drawn with a single draw call. Primitives are instances of
+// line lists that are built once: each instance is drawn from its primitive's cached vertex array,
+// with its own transform.
 class DebugDrawManager
 {
 public:
-	struct Line { Vector3 v1, v2; Color4F color; };
-
-	void AddLine(const Line& line) { m_lines.push_back(line); }
+	struct Vertex
+	{
+		Vector3 position;
+		Color4F color;
+	};
 
-	void Clear()
+	struct Instance
 	{
-		m_lines.clear();
-	}
+		DebugPrimitive::Type primitive;
+		float32 mPrimitiveToWorld[16]; // GL matrix, so that it can be projective (see DebugPrimitive::Frustum)
+		Color4F color;
+	};
 
-	void Render()
+	// What to draw for one frame
+	struct Frame
 	{
-		glPushAttrib(GL_LIGHTING_BIT|GL_TEXTURE_BIT);
-		glDisable(GL_LIGHTING);
-		glDisable(GL_TEXTURE_2D);
-		
-		
-		glBegin(GL_LINES);
-		for (const Line& line : m_lines)
-		{
-			glColor4fv(line.color.v);
-			glVertex3fv(line.v1.v);
-			glVertex3fv(line.v2.v);
-		}
-		glEnd();
-		
-		
-		glPopAttrib();
-
-		Clear();
-	}
+		std::vector<Vertex> lineVertices; // Pairs of line end points
+		std::vector<Instance> instances; // Sorted by primitive
+	};
+
+	DebugDrawManager();
+	~DebugDrawManager();
+
+	// Can be called from any thread
+	void AddLine(const Vector3& v1, const Vector3& v2, const Color4F& color);
+	void AddPrimitive(DebugPrimitive::Type primitive, const Matrix43& mPrimitiveToWorld, const Color4F& color);
+	void AddPrimitive(DebugPrimitive::Type primitive, const float32 mPrimitiveToWorld[16], const Color4F& color);
+
+	// Moves what was added since the last call into frame, reusing its memory. Must not be called
+	// while other threads are adding.
+	void TakeFrame(Frame& frame);
+
+	// Draws frame in the current model view space. Must be called on the thread that owns the GL
+	// context.
+	static void Render(const Frame& frame);
 
 private:
-	std::vector<Line> m_lines;
+	struct ThreadBuffer;
+	ThreadBuffer& GetThreadBuffer();
+
+	std::vector<std::unique_ptr<ThreadBuffer>> m_threadBuffers; // One per thread that has added, kept until exit
+	std::mutex m_mutex; // Guards m_threadBuffers, which only changes when a thread adds for the first time
+
+	static thread_local const DebugDrawManager* ms_pThreadBufferOwner;
+	static thread_local ThreadBuffer* ms_pThreadBuffer;
 };
 
 extern DebugDrawManager g_debugDrawManager;
 
 inline void DebugDrawLine(const Vector3& v1, const Vector3& v2, const Color4F& color = Color4F::White())
 {
-	DebugDrawManager::Line line = {v1, v2, color};
-	g_debugDrawManager.AddLine( line );
+	g_debugDrawManager.AddLine(v1, v2, color);
 }
 
 inline void DebugDrawAxes(const Matrix43& m, float32 scale = 1.f)
 {
-	DebugDrawLine(m.trans, m.trans + m.axisX * scale, Color4F::Red());
-	DebugDrawLine(m.trans, m.trans + m.axisY * scale, Color4F::Green());
-	DebugDrawLine(m.trans, m.trans + m.axisZ * scale, Color4F::Blue());
+	Matrix43 mAxes = m;
+	mAxes.AxisX() *= scale;
+	mAxes.AxisY() *= scale;
+	mAxes.AxisZ() *= scale;
+	g_debugDrawManager.AddPrimitive(DebugPrimitive::Axes, mAxes, Color4F::White());
+}
+
+inline void DebugDrawSphere(const Vector3& center, float32 radius, const Color4F& color = Color4F::White())
+{
+	Matrix43 mSphere = Matrix43::Identity();
+	mSphere.AxisX() *= radius;
+	mSphere.AxisY() *= radius;
+	mSphere.AxisZ() *= radius;
+	mSphere.Translation() = center;
+	g_debugDrawManager.AddPrimitive(DebugPrimitive::Sphere, mSphere, color);
 }
 
+inline void DebugDrawBox(const AABB& aabb, const Color4F& color = Color4F::White())
+{
+	const Vector3 halfExtents = aabb.GetHalfExtents();
+	Matrix43 mBox = Matrix43::Identity();
+	mBox.AxisX() *= halfExtents.x;
+	mBox.AxisY() *= halfExtents.y;
+	mBox.AxisZ() *= halfExtents.z;
+	mBox.Translation() = aabb.GetCenter();
+	g_debugDrawManager.AddPrimitive(DebugPrimitive::Box, mBox, color);
+}
+
+// Draws the volume that projection sees from a camera (in GL convention, looking down -Z) at
+// mViewToWorld
+void DebugDrawFrustum(const ProjectionInfo& projection, const Matrix43& mViewToWorld, const Color4F& color = Color4F::White());
+
 #endif // _DEBUG_DRAW_H_
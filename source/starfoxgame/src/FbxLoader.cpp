@@ -1,10 +1,17 @@
 #include "FbxLoader.h"
 #include "StaticMesh.h"
+#include "MeshUtil.h"
+#include "gs/Math/MathEx.h"
+#include "gs/System/JobSystem.h"
+#include "gs/System/Profiler.h"
+#include "gs/Base/string_helpers.h"
 #include "fbxsdk.h"
 #include <cassert>
+#include <cstdio>
 #include <algorithm>
-#include "gs/Image/ImageData.h"
-#include "gs/System/IO.h"
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 
 namespace
 {
@@ -50,26 +57,37 @@ namespace
 		mFbx.mData[3][3] = 1.f;
 	}
 
-	FbxScene* LoadScene(const char* pFileName, FbxManager* pManager)
+	// Destroys SDK objects when they go out of scope, including when an import throws
+	struct FbxObjectDeleter
 	{
+		void operator()(FbxObject* pObject) const { pObject->Destroy(); }
+	};
+
+	typedef std::unique_ptr<FbxScene, FbxObjectDeleter> FbxScenePtr;
+	typedef std::unique_ptr<FbxImporter, FbxObjectDeleter> FbxImporterPtr;
+
+	FbxScenePtr LoadScene(const char* pFileName, FbxManager* pManager)
+	{
+		PROFILE_SCOPE("FbxLoader::LoadScene");
+
 		assert(pManager);
 
 		// Create an FBX scene. This object holds most objects imported/exported from/to files.
-		FbxScene* pScene = FbxScene::Create(pManager, "My Scene");
+		FbxScenePtr pScene(FbxScene::Create(pManager, "My Scene"));
 		if (!pScene)
-			throw std::exception("FbxScene::Create failed");
+			throw std::runtime_error("FbxScene::Create failed");
+
+		FbxImporterPtr pImporter(FbxImporter::Create(pManager,""));
+		if (!pImporter)
+			throw std::runtime_error("FbxImporter::Create failed");
 
-		FbxImporter* pImporter = FbxImporter::Create(pManager,"");
 		if ( !pImporter->Initialize(pFileName, -1, pManager->GetIOSettings()) )
-			throw std::exception("FbxImporter::Initialize failed");
+			throw std::runtime_error("FbxImporter::Initialize failed");
 
 		assert(pImporter->IsFBX());
 
-		bool bImportedScene = pImporter->Import(pScene);
-		pImporter->Destroy();
-
-		if (!bImportedScene)
-			throw std::exception("FbxImporter::Import failed");
+		if (!pImporter->Import(pScene.get()))
+			throw std::runtime_error("FbxImporter::Import failed");
 
 		return pScene;
 	}
@@ -155,13 +173,6 @@ namespace
 						assert(pFileTexture && "Material: texture must be a file");
 
 						material.m_filename = pFileTexture->GetFileName();
-
-						//@TODO: Should we load textures externally? TextureManager?
-						std::string path = IO::Path::ChangeExtension(IO::Path::GetFileName(material.m_filename), "tga");
-						path = IO::Path::Combine("data", path); //@HACK! At least use directory of input fbx
-
-						ImageData imgData = ImageData::Load(path);
-						material.m_textureId = GLUtil::LoadTexture(imgData);
 					}
 				}
 			}
@@ -176,15 +187,24 @@ namespace
 		Matrix43 mMaxToGame;
 		mMaxToGame.SetIdentity();
 		float32 scale = 1.f;
-		mMaxToGame.axisX = -Vector3::UnitX() * scale;
-		mMaxToGame.axisY = -Vector3::UnitZ() * scale;
-		mMaxToGame.axisZ = Vector3::UnitY() * scale;
+		mMaxToGame.AxisX() = -Vector3::UnitX() * scale;
+		mMaxToGame.AxisY() = -Vector3::UnitZ() * scale;
+		mMaxToGame.AxisZ() = Vector3::UnitY() * scale;
 		FbxAMatrix maxToGameTransform;
 		Matrix43ToFbxMatrix(mMaxToGame, maxToGameTransform);
 		return maxToGameTransform;
 	}
 
-	void LoadStaticMeshFromNode(FbxNode* pNode, gfx::StaticMesh& staticMesh)
+	struct ImportStats
+	{
+		ImportStats() : m_lodErrors(MeshUtil::kMaxLods, 0.f) {}
+
+		MeshUtil::VertexCacheStats m_vertexCacheBefore;
+		MeshUtil::VertexCacheStats m_vertexCacheAfter;
+		std::vector<float32> m_lodErrors; // Largest over all submeshes
+	};
+
+	void LoadStaticMeshFromNode(FbxNode* pNode, gfx::StaticMesh& staticMesh, ImportStats& importStats)
 	{
 		const FbxNodeAttribute* pNodeAttribute = pNode->GetNodeAttribute();
 
@@ -230,7 +250,6 @@ namespace
 		FbxMesh* pMesh = static_cast<FbxMesh*>( pNode->GetNodeAttribute() );
 
 		const int numPolygons = pMesh->GetPolygonCount();
-		FbxVector4* pControlPoints = pMesh->GetControlPoints();
 		int vertexId = 0;
 
 		staticMesh.m_subMeshes.emplace_back();
@@ -239,6 +258,42 @@ namespace
 		// Load material info -- we assume materials mapped to entire sub mesh
 		LoadMaterialsFromMesh(pMesh, staticMesh, currSubMesh);
 
+		// Transform the control points and normals by the node's transform once each, rather than
+		// for every polygon vertex that references them
+		static_assert(sizeof(FbxVector4) == 4 * sizeof(float64), "FbxVector4 must be 4 doubles");
+		Matrix43 mNodeGlobalTransform;
+		FbxMatrixToMatrix43(nodeGlobalTransform, mNodeGlobalTransform);
+
+		std::vector<Vector4> positions(pMesh->GetControlPointsCount());
+		MeshUtil::TransformPositions(reinterpret_cast<const float64*>(pMesh->GetControlPoints()), positions.size(), mNodeGlobalTransform, positions.data());
+
+		// Only the last normal element is used
+		//@TODO: Apparently we should be multiplying by the inverse of the transpose?
+		FbxGeometryElementNormal* pNormalElement = pMesh->GetElementNormalCount() > 0? pMesh->GetElementNormal(pMesh->GetElementNormalCount() - 1) : nullptr;
+		std::vector<Vector4> normals;
+		if (pNormalElement)
+		{
+			assert(pNormalElement->GetMappingMode() == FbxGeometryElement::eByPolygonVertex);
+			assert(pNormalElement->GetReferenceMode() == FbxGeometryElement::eDirect || pNormalElement->GetReferenceMode() == FbxGeometryElement::eIndexToDirect);
+
+			// Transformed straight from the array's storage, which is locked while it's read
+			FbxLayerElementArrayTemplate<FbxVector4>& directNormals = pNormalElement->GetDirectArray();
+			normals.resize(directNormals.GetCount());
+			if (!normals.empty())
+			{
+				FbxVector4* pFbxNormals = directNormals.GetLocked(FbxLayerElementArray::eReadLock);
+				if (!pFbxNormals)
+					throw std::runtime_error(std::string("Failed to lock the normals of node ") + pNode->GetName());
+
+				MeshUtil::TransformDirections(reinterpret_cast<const float64*>(pFbxNormals), normals.size(), mNodeGlobalTransform, normals.data());
+				directNormals.Release(&pFbxNormals);
+			}
+		}
+
+		// FBX stores attributes per polygon vertex, so we first build one vertex per triangle corner,
+		// then weld identical ones and index them.
+		std::vector<gfx::StaticMesh::Vertex> polygonVertices(numPolygons * 3);
+
 		for (int i = 0; i < numPolygons; ++i)
 		{
 			const int polygonSize = pMesh->GetPolygonSize(i);
@@ -248,19 +303,10 @@ namespace
 			{
 				assert(i * 3 + j == vertexId);
 
-				// We keep adding vertices to the current submesh
-				gfx::StaticMesh::Vertex& currVertex = *currSubMesh.m_vertices.emplace(currSubMesh.m_vertices.end());
+				gfx::StaticMesh::Vertex& currVertex = polygonVertices[vertexId];
 				
 				// Position
-				const int controlPointIndex = pMesh->GetPolygonVertex(i, j);
-				FbxVector4 position = pControlPoints[controlPointIndex];
-				position = nodeGlobalTransform.MultT(position);
-
-				currVertex.position.x = (float32)position[0];
-				currVertex.position.y = (float32)position[1];
-				currVertex.position.z = (float32)position[2];
-
-				staticMesh.m_boundingBox.Include(Vector3(currVertex.position.x, currVertex.position.y, currVertex.position.z));
+				currVertex.position = positions[pMesh->GetPolygonVertex(i, j)];
 
 				// Color
 				for (int l = 0; l < pMesh->GetElementVertexColorCount(); ++l)
@@ -316,37 +362,11 @@ namespace
 					currVertex.textureCoords.y = (float32)uv[1];
 				}
 
-				// Normals
-				for(int l = 0; l < pMesh->GetElementNormalCount(); ++l)
+				// Normal
+				if (pNormalElement)
 				{
-					FbxGeometryElementNormal* leNormal = pMesh->GetElementNormal(l);
-					assert(leNormal->GetMappingMode() == FbxGeometryElement::eByPolygonVertex);
-
-					FbxVector4 normal;
-					switch (leNormal->GetReferenceMode())
-					{
-					case FbxGeometryElement::eDirect:
-						normal = leNormal->GetDirectArray().GetAt(vertexId);
-						break;
-					case FbxGeometryElement::eIndexToDirect:
-						{
-							int id = leNormal->GetIndexArray().GetAt(vertexId);
-							normal = leNormal->GetDirectArray().GetAt(id);
-						}
-						break;
-					default:
-						assert(false);
-					}
-
-					//@TODO: Apparently we should be multiplying by the inverse of the transpose?
-					auto nodeGlobalTransformNoT = nodeGlobalTransform;
-					nodeGlobalTransformNoT.SetT(FbxVector4(0,0,0,1));
-					normal = nodeGlobalTransformNoT.MultT(normal);
-					normal.Normalize(); // Ignore scale in transform
-
-					currVertex.normal.x = (float32)normal[0];
-					currVertex.normal.y = (float32)normal[1];
-					currVertex.normal.z = (float32)normal[2];
+					const bool bIndexed = pNormalElement->GetReferenceMode() == FbxGeometryElement::eIndexToDirect;
+					currVertex.normal = normals[bIndexed? pNormalElement->GetIndexArray().GetAt(vertexId) : vertexId];
 				}
 
 				//@TEST: randomize vertex colors
@@ -358,15 +378,45 @@ namespace
 				++vertexId;
 			}
 		}
+
+		// Only store the attributes the mesh has, with positions quantized to the submesh bounds
+		uint32 layoutFlags = VertexLayoutFlags::QuantizePosition;
+		if (pMesh->GetElementNormalCount() > 0)
+			layoutFlags |= VertexLayoutFlags::Normal;
+		if (pMesh->GetElementVertexColorCount() > 0)
+			layoutFlags |= VertexLayoutFlags::Color;
+		if (pMesh->GetElementUVCount() > 0)
+			layoutFlags |= VertexLayoutFlags::TexCoord;
+
+		std::vector<gfx::StaticMesh::Vertex> vertices;
+		std::vector<uint32> indices;
+		MeshUtil::WeldVertices(polygonVertices, vertices, indices);
+		staticMesh.m_boundingBox.Include(MeshUtil::ComputeBoundingBox(vertices));
+
+		importStats.m_vertexCacheBefore += MeshUtil::AnalyzeVertexCache(indices, vertices.size());
+		MeshUtil::OptimizeMesh(vertices, indices);
+		importStats.m_vertexCacheAfter += MeshUtil::AnalyzeVertexCache(indices, vertices.size());
+
+		std::vector<std::vector<uint32>> lodIndices;
+		std::vector<float32> lodErrors;
+		MeshUtil::GenerateLods(vertices, indices, lodIndices, lodErrors);
+
+		currSubMesh.SetVertices(vertices, layoutFlags);
+		currSubMesh.SetIndices(indices);
+		for (size_t lod = 1; lod < MeshUtil::kMaxLods; ++lod)
+		{
+			currSubMesh.SetIndices(lodIndices[lod - 1], lod);
+			importStats.m_lodErrors[lod] = MathEx::Max(importStats.m_lodErrors[lod], lodErrors[lod - 1]);
+		}
 	}
 
-	void RecursiveLoadStaticMesh(FbxNode* pNode, gfx::StaticMesh& staticMesh)
+	void RecursiveLoadStaticMesh(FbxNode* pNode, gfx::StaticMesh& staticMesh, ImportStats& importStats)
 	{
-		LoadStaticMeshFromNode(pNode, staticMesh);
+		LoadStaticMeshFromNode(pNode, staticMesh, importStats);
 
 		for (int i = 0; i < pNode->GetChildCount(); ++i)
 		{
-			RecursiveLoadStaticMesh(pNode->GetChild(i), staticMesh);
+			RecursiveLoadStaticMesh(pNode->GetChild(i), staticMesh, importStats);
 		}
 	}
 
@@ -391,11 +441,71 @@ namespace
 struct FbxLoader::PIMPL
 {
 	PIMPL()
-		: m_pManager(nullptr)
+		: m_numManagers(0)
+	{
+	}
+
+	// Returns a manager that no other thread is using, creating one if they all are
+	FbxManager* AcquireManager()
 	{
+		// Managers are also created under the lock, as the SDK's global state isn't thread safe
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_freeManagers.empty())
+		{
+			FbxManager* pManager = m_freeManagers.back();
+			m_freeManagers.pop_back();
+			return pManager;
+		}
+
+		// The first thing to do is to create the FBX Manager which is the object allocator for almost all the classes in the SDK
+		FbxManager* pManager = FbxManager::Create();
+		if (!pManager)
+			throw std::runtime_error("FbxManager::Create() failed");
+
+		// Create an IOSettings object. This object holds all import/export settings.
+		FbxIOSettings* ios = FbxIOSettings::Create(pManager, IOSROOT);
+		pManager->SetIOSettings(ios);
+
+		++m_numManagers;
+		return pManager;
 	}
 
-	FbxManager* m_pManager;
+	void ReleaseManager(FbxManager* pManager)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_freeManagers.push_back(pManager);
+	}
+
+	void DestroyManagers()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		assert(m_freeManagers.size() == m_numManagers && "Shutting down while imports are running");
+		for (FbxManager* pManager : m_freeManagers)
+			pManager->Destroy();
+		m_freeManagers.clear();
+		m_numManagers = 0;
+	}
+
+	// Holds a manager from the pool for the duration of an import
+	class ScopedManager
+	{
+	public:
+		ScopedManager(PIMPL& pimpl) : m_pimpl(pimpl), m_pManager(pimpl.AcquireManager()) {}
+		~ScopedManager() { m_pimpl.ReleaseManager(m_pManager); }
+
+		FbxManager* Get() const { return m_pManager; }
+
+	private:
+		ScopedManager(const ScopedManager&);
+		ScopedManager& operator=(const ScopedManager&);
+
+		PIMPL& m_pimpl;
+		FbxManager* m_pManager;
+	};
+
+	std::mutex m_mutex;
+	std::vector<FbxManager*> m_freeManagers;
+	size_t m_numManagers;
 };
 
 FbxLoader::FbxLoader()
@@ -405,48 +515,74 @@ FbxLoader::FbxLoader()
 
 void FbxLoader::Init()
 {
-	auto& pManager = m_pPimpl->m_pManager;
-
-	// The first thing to do is to create the FBX Manager which is the object allocator for almost all the classes in the SDK
-	pManager = FbxManager::Create();
-	if (!pManager)
-		throw std::exception("FbxManager::Create() failed");
-
-	// Create an IOSettings object. This object holds all import/export settings.
-	FbxIOSettings* ios = FbxIOSettings::Create(pManager, IOSROOT);
-	pManager->SetIOSettings(ios);
+	// Create the first manager up front, so that SDK failures show up here rather than on first import
+	m_pPimpl->ReleaseManager(m_pPimpl->AcquireManager());
 }
 
 void FbxLoader::Shutdown()
 {
-	if (auto& pManager = m_pPimpl->m_pManager)
-	{
-		pManager->Destroy();
-		pManager = nullptr;
-	}
+	m_pPimpl->DestroyManagers();
 }
 
 std::shared_ptr<gfx::StaticMesh> FbxLoader::LoadStaticMesh(const char* pFileName)
 {
-	FbxScene* pScene = LoadScene(pFileName, m_pPimpl->m_pManager);
+	PROFILE_SCOPE("FbxLoader::LoadStaticMesh");
+
+	// Declared after the manager, so that the scene is destroyed before the manager is released
+	PIMPL::ScopedManager manager(*m_pPimpl);
+	const FbxScenePtr pScene = LoadScene(pFileName, manager.Get());
 
 	// Note: doing this just converts the node global and local transforms, but not the mesh vertices.
 	// As we load the nodes, we transform the vertex positions and normals by the node global transform.
 	//const FbxAxisSystem axisSystem(FbxAxisSystem::eYAxis, FbxAxisSystem::eParityOdd, FbxAxisSystem::eLeftHanded);
 	//const FbxAxisSystem& axisSystem = FbxAxisSystem::DirectX;
 	//const FbxAxisSystem& axisSystem = FbxAxisSystem::OpenGL;
-	//ConvertSceneAxisSystemAndUnits(pScene, axisSystem, FbxSystemUnit::m);
+	//ConvertSceneAxisSystemAndUnits(pScene.get(), axisSystem, FbxSystemUnit::m);
 
 	FbxNode* pRootNode = pScene->GetRootNode();
 	assert(pRootNode);
 
 	std::shared_ptr<gfx::StaticMesh> pStaticMesh(new gfx::StaticMesh);
+	ImportStats importStats;
+
+	{
+		PROFILE_SCOPE("FbxLoader::LoadNodes");
+		for (int i = 0; i < pRootNode->GetChildCount(); ++i)
+		{
+			RecursiveLoadStaticMesh(pRootNode->GetChild(i), *pStaticMesh, importStats);
+		}
+	}
+
+	const size_t numNodeSubMeshes = pStaticMesh->m_subMeshes.size();
+	MeshUtil::MergeSubMeshesByMaterial(*pStaticMesh);
+	MeshUtil::SetupLods(*pStaticMesh, importStats.m_lodErrors);
+
+	// Printed at once so that the reports of concurrent imports don't interleave
+	const MeshUtil::VertexCacheStats& before = importStats.m_vertexCacheBefore;
+	const MeshUtil::VertexCacheStats& after = importStats.m_vertexCacheAfter;
+	std::string report = str_format("%s: %u triangles, %u vertices, %u submeshes merged into %u, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", pFileName,
+		after.numTriangles, after.numVertices, (uint32)numNodeSubMeshes, (uint32)pStaticMesh->m_subMeshes.size(),
+		before.GetACMR(), after.GetACMR(), before.GetATVR(), after.GetATVR());
 
-	for (int i = 0; i < pRootNode->GetChildCount(); ++i)
+	for (size_t lod = 1; lod < pStaticMesh->GetNumLods(); ++lod)
 	{
-		RecursiveLoadStaticMesh(pRootNode->GetChild(i), *pStaticMesh);
+		size_t numIndices = 0;
+		for (const auto& subMesh : pStaticMesh->m_subMeshes)
+			numIndices += subMesh.GetNumIndices(lod);
+		report += str_format("  LOD %u: %u triangles, error %.4f, below %.3f of screen height\n", (uint32)lod, (uint32)(numIndices / 3),
+			importStats.m_lodErrors[lod], pStaticMesh->m_lodScreenSizes[lod]);
 	}
+	printf("%s", report.c_str());
 
-	pScene->Destroy();
 	return pStaticMesh;
 }
+
+std::vector<std::shared_ptr<gfx::StaticMesh>> FbxLoader::LoadStaticMeshes(const std::vector<std::string>& fileNames)
+{
+	std::vector<std::shared_ptr<gfx::StaticMesh>> staticMeshes(fileNames.size());
+	JobSystem::Instance().ParallelFor(fileNames.size(), [&] (size_t i)
+	{
+		staticMeshes[i] = LoadStaticMesh(fileNames[i].c_str());
+	});
+	return staticMeshes;
+}
@@ -3,12 +3,17 @@
 
 #include "gs/Base/Base.h"
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace gfx
 {
 	struct StaticMesh;
 }
 
+// Imports static meshes from FBX files. The FBX SDK isn't thread safe, so each import runs with its
+// own FBX manager, taken from a pool that grows to the number of concurrent imports. LoadStaticMesh
+// can therefore be called from multiple threads at once.
 class FbxLoader
 {
 public:
@@ -16,10 +21,16 @@ public:
 	~FbxLoader() { Shutdown(); }
 
 	void Init();
+
+	// Destroys the pooled FBX managers. Must not be called while imports are running.
 	void Shutdown();
 
 	std::shared_ptr<gfx::StaticMesh> LoadStaticMesh(const char* pFileName);
 
+	// Imports each file in parallel on the JobSystem, and returns once all are loaded, in the
+	// order of fileNames. If any import throws, the first exception is rethrown.
+	std::vector<std::shared_ptr<gfx::StaticMesh>> LoadStaticMeshes(const std::vector<std::string>& fileNames);
+
 private:
 	struct PIMPL;
 	std::shared_ptr<PIMPL> m_pPimpl; // Want to use unique_ptr but MSVC's implementation doesn't work with incomplete types as it should
@@ -0,0 +1,146 @@
+#include "FramePipeline.h"
+#include "gs/System/System.h"
+#include "gs/System/Profiler.h"
+#include <cassert>
+
+namespace
+{
+	const float32 kLatencySmoothing = 0.1f;
+}
+
+FramePipeline::FramePipeline(const UpdateFunc& update, const RenderFunc& render)
+	: m_update(update)
+	, m_render(render)
+	, m_depth(0)
+	, m_packets(1)
+	, m_numFramesUpdated(0)
+	, m_numFramesRendered(0)
+	, m_latency(0.f)
+	, m_pUpdatingPacket(nullptr)
+	, m_bStopping(false)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+	if (m_updateThread.joinable())
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_updateCompleted.wait(lock, [&] { return !m_pUpdatingPacket; });
+		}
+		StopUpdateThread();
+	}
+}
+
+void FramePipeline::SetDepth(uint32 depth)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		assert(!m_pUpdatingPacket && "Depth must be set between WaitForUpdate and StartUpdate");
+	}
+
+	while (m_numFramesRendered < m_numFramesUpdated)
+		RenderNextFrame();
+
+	if (m_updateThread.joinable())
+		StopUpdateThread();
+
+	m_depth = depth;
+	m_packets.resize(depth + 1);
+
+	if (depth > 0)
+		m_updateThread = std::thread(&FramePipeline::UpdateThreadMain, this);
+}
+
+void FramePipeline::WaitForUpdate()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_updateCompleted.wait(lock, [&] { return !m_pUpdatingPacket; });
+
+	if (m_pUpdateException)
+	{
+		std::exception_ptr pException = m_pUpdateException;
+		m_pUpdateException = nullptr;
+		std::rethrow_exception(pException);
+	}
+}
+
+void FramePipeline::StartUpdate()
+{
+	FramePacket& packet = GetPacket(m_numFramesUpdated++);
+	packet.updateStartTime = System::GetElapsedSeconds();
+
+	if (!m_updateThread.joinable())
+	{
+		m_update(packet);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		assert(!m_pUpdatingPacket && "Previous update wasn't waited for");
+		m_pUpdatingPacket = &packet;
+	}
+	m_updateStarted.notify_one();
+}
+
+void FramePipeline::Render()
+{
+	// The frames after the oldest one, including the one being updated, fill the pipeline
+	if (m_numFramesUpdated - m_numFramesRendered > m_depth)
+		RenderNextFrame();
+}
+
+void FramePipeline::RenderNextFrame()
+{
+	assert(m_numFramesRendered < m_numFramesUpdated);
+	FramePacket& packet = GetPacket(m_numFramesRendered);
+	m_render(packet);
+	++m_numFramesRendered;
+
+	const float32 latency = static_cast<float32>(System::GetElapsedSeconds() - packet.updateStartTime);
+	m_latency = m_latency == 0.f? latency : m_latency + kLatencySmoothing * (latency - m_latency);
+}
+
+void FramePipeline::StopUpdateThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_updateStarted.notify_one();
+	m_updateThread.join();
+	m_bStopping = false;
+}
+
+void FramePipeline::UpdateThreadMain()
+{
+	PROFILE_THREAD_NAME("Update");
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_updateStarted.wait(lock, [&] { return m_pUpdatingPacket || m_bStopping; });
+		if (!m_pUpdatingPacket)
+			return;
+
+		FramePacket& packet = *m_pUpdatingPacket;
+		std::exception_ptr pException;
+
+		lock.unlock();
+		try
+		{
+			m_update(packet);
+		}
+		catch (...)
+		{
+			pException = std::current_exception();
+		}
+		lock.lock();
+
+		m_pUpdateException = pException;
+		m_pUpdatingPacket = nullptr;
+		m_updateCompleted.notify_all();
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+
+#include "gs/Base/Base.h"
+#include "RenderQueue.h"
+#include "DebugDraw.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Everything needed to render a frame, filled in by its update
+struct FramePacket
+{
+	FramePacket() : updateStartTime(0.0) {}
+
+	float32 mWorldToView[16]; // GL model view matrix for world space
+	RenderQueue::Frame renderQueueFrame;
+	DebugDrawManager::Frame debugFrame;
+	float64 updateStartTime; // System::GetElapsedSeconds() when the update started, after input was read
+};
+
+// Overlaps updating a frame with rendering the previous ones. The thread that creates the pipeline,
+// which owns the window and the GL context, renders, while frames are updated on an update thread
+// that fills in one FramePacket per frame.
+//
+// The depth is the number of frames that are updated ahead of the one being rendered: with a depth
+// of 1, frame N + 1 is updated while frame N is rendered. Deeper pipelines absorb frames that take
+// uneven times to update or render, and each frame of depth adds a frame of latency between reading
+// input and showing its result. A depth of 0 updates and renders each frame in sequence on the
+// calling thread, without an update thread.
+//
+// Each frame, the calling thread:
+//   1. WaitForUpdate: waits for the update thread to finish the frame it's updating. Until
+//      StartUpdate, the update thread is idle, so input and any other state that updates read can
+//      be changed safely.
+//   2. StartUpdate: starts updating the next frame.
+//   3. Render: renders the oldest updated frame, once depth frames are updated ahead of it.
+class FramePipeline
+{
+public:
+	typedef std::function<void (FramePacket& packet)> UpdateFunc;
+	typedef std::function<void (FramePacket& packet)> RenderFunc;
+
+	// Starts with a depth of 0
+	FramePipeline(const UpdateFunc& update, const RenderFunc& render);
+
+	// Waits for the frame being updated. Frames that were updated but not rendered are dropped.
+	~FramePipeline();
+
+	// Renders the frames that were updated but not rendered, then changes the depth. Call between
+	// WaitForUpdate and StartUpdate.
+	void SetDepth(uint32 depth);
+	uint32 GetDepth() const { return m_depth; }
+
+	// Rethrows the exception if the update threw one
+	void WaitForUpdate();
+
+	void StartUpdate();
+	void Render();
+
+	// Seconds from the start of a frame's update to the end of its rendering, averaged over recent
+	// frames
+	float32 GetLatency() const { return m_latency; }
+
+private:
+	FramePacket& GetPacket(uint64 frameIndex) { return m_packets[frameIndex % m_packets.size()]; }
+
+	void RenderNextFrame();
+	void StopUpdateThread();
+	void UpdateThreadMain();
+
+	const UpdateFunc m_update;
+	const RenderFunc m_render;
+
+	uint32 m_depth;
+	std::vector<FramePacket> m_packets; // depth + 1, indexed by frame
+	uint64 m_numFramesUpdated; // Including the one being updated
+	uint64 m_numFramesRendered;
+	float32 m_latency;
+
+	std::thread m_updateThread; // Only when depth > 0
+	std::mutex m_mutex;
+	std::condition_variable m_updateStarted;
+	std::condition_variable m_updateCompleted;
+	FramePacket* m_pUpdatingPacket; // Null while the update thread is idle
+	std::exception_ptr m_pUpdateException;
+	bool m_bStopping;
+};
+
+#endif // _FRAME_PIPELINE_H_
@@ -1,5 +1,7 @@
 #include "GroundComponent.h"
+#include "RenderQueue.h"
 #include "gs/Platform/GL/GLUtil.h"
+#include <array>
 
 void GroundComponent::Render()
 {
@@ -10,26 +12,13 @@ void GroundComponent::Render()
 	TWEAKABLE float32 planeStartZ = 1000.f;
 	TWEAKABLE float32 planeEndZ = 9000.f;
 
-	const Vector3& v1 = PositionVector(Vector3(-halfPlaneSizeX, 0.f, -planeStartZ)) * mWorld;
-	const Vector3& v2 = PositionVector(Vector3(halfPlaneSizeX, 0.f, -planeStartZ)) * mWorld;
-	const Vector3& v3 = PositionVector(Vector3(halfPlaneSizeX, 0.f, planeEndZ)) * mWorld;
-	const Vector3& v4 = PositionVector(Vector3(-halfPlaneSizeX, 0.f, planeEndZ)) * mWorld;
-
-	glPushAttrib(GL_LIGHTING_BIT|GL_TEXTURE_BIT);
-	glDisable(GL_LIGHTING);
-	glDisable(GL_TEXTURE_2D);
-		
-	glBegin(GL_QUADS);
-	{
-		glColor3ub(25, 89, 58);
-		glVertex3fv(v1.v);
-		glVertex3fv(v2.v);
-
-		glColor3ub(132, 178, 181);
-		glVertex3fv(v3.v);
-		glVertex3fv(v4.v);
-	}
-	glEnd();
+	const std::array<Vector3, 4> corners =
+	{{
+		PositionVector(Vector3(-halfPlaneSizeX, 0.f, -planeStartZ)) * mWorld,
+		PositionVector(Vector3(halfPlaneSizeX, 0.f, -planeStartZ)) * mWorld,
+		PositionVector(Vector3(halfPlaneSizeX, 0.f, planeEndZ)) * mWorld,
+		PositionVector(Vector3(-halfPlaneSizeX, 0.f, planeEndZ)) * mWorld
+	}};
 
 	// Draw visible white dots
 	TWEAKABLE float32 halfDistX = 80.f;
@@ -38,30 +27,56 @@ void GroundComponent::Render()
 
 	const Vector3 vOffsetX(halfDistX, 0.f, 0.f);
 
-	Vector3 vDotCenter = mWorld.trans;
+	Vector3 vDotCenter = mWorld.Translation();
 	vDotCenter.x = 0.f;
 	vDotCenter.y += 0.1f;
 	vDotCenter.z = MathEx::Floor(vDotCenter.z / distZ) * distZ;
-		
-	glPointSize(5.0f);
-	glBegin(GL_POINTS);
-	glColor4f(1.f, 1.f, 1.f, 1.f);
+
+	std::vector<Vector3> dots;
+	dots.reserve(static_cast<size_t>(numDots) * 8);
 	for (uint32 i = 0; i < numDots; ++i)
 	{
-		glVertex3fv((vDotCenter - vOffsetX).v);
-		glVertex3fv((vDotCenter - vOffsetX * 3.f).v);
-		glVertex3fv((vDotCenter - vOffsetX * 5.f).v);
-		glVertex3fv((vDotCenter - vOffsetX * 7.f).v);
+		dots.push_back(vDotCenter - vOffsetX);
+		dots.push_back(vDotCenter - vOffsetX * 3.f);
+		dots.push_back(vDotCenter - vOffsetX * 5.f);
+		dots.push_back(vDotCenter - vOffsetX * 7.f);
 
-		glVertex3fv((vDotCenter + vOffsetX).v);
-		glVertex3fv((vDotCenter + vOffsetX * 3.f).v);
-		glVertex3fv((vDotCenter + vOffsetX * 5.f).v);
-		glVertex3fv((vDotCenter + vOffsetX * 7.f).v);
+		dots.push_back(vDotCenter + vOffsetX);
+		dots.push_back(vDotCenter + vOffsetX * 3.f);
+		dots.push_back(vDotCenter + vOffsetX * 5.f);
+		dots.push_back(vDotCenter + vOffsetX * 7.f);
 
 		vDotCenter.z += distZ;
 	}
-	glEnd();
 
-	glPopAttrib();
-	//glPopMatrix();
+	// Unlit vertex colors and points can't be drawn as packets, so the queue makes the GL calls
+	RenderQueue::Instance().SubmitCustomDraw([corners, dots]
+	{
+		const bool bLighting = GLUtil::GetLighting();
+		const bool bTexturing = GLUtil::GetTexturing();
+		GLUtil::SetLighting(false);
+		GLUtil::SetTexturing(false);
+
+		glBegin(GL_QUADS);
+		{
+			glColor3ub(25, 89, 58);
+			glVertex3fv(corners[0].v);
+			glVertex3fv(corners[1].v);
+
+			glColor3ub(132, 178, 181);
+			glVertex3fv(corners[2].v);
+			glVertex3fv(corners[3].v);
+		}
+		glEnd();
+
+		glPointSize(5.0f);
+		glBegin(GL_POINTS);
+		glColor4f(1.f, 1.f, 1.f, 1.f);
+		for (const Vector3& dot : dots)
+			glVertex3fv(dot.v);
+		glEnd();
+
+		GLUtil::SetLighting(bLighting);
+		GLUtil::SetTexturing(bTexturing);
+	});
 }
@@ -7,7 +7,9 @@
 class GroundComponent : public SceneNodeComponent
 {
 public:
+	// Submits the ground plane and dots to the RenderQueue, as a custom draw
 	virtual void Render();	
+	virtual bool CanRenderInParallel() const { return true; }
 };
 
 #endif // _GROUND_COMPONENT_H_
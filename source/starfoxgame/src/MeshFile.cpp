@@ -0,0 +1,347 @@
+#include "MeshFile.h"
+#include "StaticMesh.h"
+#include "gs/System/BinaryFile.h"
+#include "gs/System/MappedFile.h"
+#include "gs/System/Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Header
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 fileSize;
+		uint32 numSubMeshes;
+		uint32 numMaterials;
+		uint32 numSockets;
+		uint32 subMeshesOffset;
+		uint32 materialsOffset;
+		uint32 socketsOffset;
+		uint32 stringsOffset;
+		uint32 stringsSize;
+		uint32 numLods;
+		uint32 lodScreenSizesOffset;
+		uint32 indexBuffersOffset;
+		float32 boundsMin[3];
+		float32 boundsMax[3];
+	};
+
+	struct SubMeshRecord
+	{
+		uint32 formats[VertexAttribute::NumTypes]; // VertexAttributeFormat::Type
+		uint32 offsets[VertexAttribute::NumTypes];
+		uint32 stride;
+		float32 positionOffset[3];
+		float32 positionScale[3];
+		uint32 numVertices;
+		uint32 indexSize;
+		uint32 materialIndex;
+		uint32 vertexDataOffset;
+	};
+
+	struct IndexBufferRecord
+	{
+		uint32 numIndices;
+		uint32 dataOffset;
+	};
+
+	struct MaterialRecord
+	{
+		uint64 uniqueId;
+		uint32 nameOffset;
+		uint32 filenameOffset;
+		float32 ambient[4];
+		float32 diffuse[4];
+		float32 specular[4];
+		float32 emmissive[4];
+		float32 shininess;
+		uint32 padding;
+	};
+
+	struct SocketRecord
+	{
+		uint32 nameOffset;
+		float32 matrix[4][3];
+	};
+
+	static_assert(sizeof(Header) == 80, "Header layout changed, bump kVersion");
+	static_assert(sizeof(SubMeshRecord) == 76, "SubMeshRecord layout changed, bump kVersion");
+	static_assert(sizeof(IndexBufferRecord) == 8, "IndexBufferRecord layout changed, bump kVersion");
+	static_assert(sizeof(MaterialRecord) == 88, "MaterialRecord layout changed, bump kVersion");
+	static_assert(sizeof(SocketRecord) == 52, "SocketRecord layout changed, bump kVersion");
+
+	class StringTable
+	{
+	public:
+		uint32 Add(const std::string& str)
+		{
+			const uint32 offset = static_cast<uint32>(m_strings.size());
+			m_strings.insert(m_strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+			return offset;
+		}
+
+		const std::vector<char>& GetData() const { return m_strings; }
+
+	private:
+		std::vector<char> m_strings;
+	};
+
+	void CopyFloats(float32* pDst, const float32* pSrc, size_t count)
+	{
+		memcpy(pDst, pSrc, count * sizeof(float32));
+	}
+
+	template <typename IndexType>
+	uint32 GetMaxIndex(const void* pIndices, uint32 numIndices)
+	{
+		const IndexType* pTypedIndices = static_cast<const IndexType*>(pIndices);
+		uint32 maxIndex = 0;
+		for (uint32 i = 0; i < numIndices; ++i)
+			maxIndex = std::max<uint32>(maxIndex, pTypedIndices[i]);
+		return maxIndex;
+	}
+}
+
+void MeshFile::Save(const gfx::StaticMesh& staticMesh, const char* pFileName)
+{
+	BinaryFile::Writer writer;
+	StringTable strings;
+
+	Header header = {};
+	header.magic = kMagic;
+	header.version = kVersion;
+	header.numSubMeshes = static_cast<uint32>(staticMesh.m_subMeshes.size());
+	header.numMaterials = static_cast<uint32>(staticMesh.m_materials.size());
+	header.numSockets = static_cast<uint32>(staticMesh.m_sockets.size());
+	header.numLods = static_cast<uint32>(staticMesh.GetNumLods());
+	CopyFloats(header.boundsMin, staticMesh.m_boundingBox.min.v, 3);
+	CopyFloats(header.boundsMax, staticMesh.m_boundingBox.max.v, 3);
+	writer.Write(&header, sizeof(header));
+
+	// Tables, with offsets to data and strings filled in below
+	const uint32 subMeshesOffset = writer.GetSize();
+	for (const auto& subMesh : staticMesh.m_subMeshes)
+	{
+		SubMeshRecord record = {};
+		const VertexLayout& layout = subMesh.m_vertexLayout;
+		for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+		{
+			record.formats[i] = static_cast<uint32>(layout.formats[i]);
+			record.offsets[i] = layout.offsets[i];
+		}
+		record.stride = layout.stride;
+		CopyFloats(record.positionOffset, layout.positionOffset.v, 3);
+		CopyFloats(record.positionScale, layout.positionScale.v, 3);
+		assert(subMesh.GetNumLods() == header.numLods && "Every submesh must have the same number of LODs");
+		record.numVertices = static_cast<uint32>(subMesh.GetNumVertices());
+		record.indexSize = subMesh.m_indexSize;
+		record.materialIndex = subMesh.m_materialIndex;
+		writer.Write(&record, sizeof(record));
+	}
+
+	const uint32 materialsOffset = writer.GetSize();
+	for (const auto& material : staticMesh.m_materials)
+	{
+		MaterialRecord record = {};
+		record.uniqueId = material.m_uniqueId;
+		record.nameOffset = strings.Add(material.m_name);
+		record.filenameOffset = strings.Add(material.m_filename);
+		CopyFloats(record.ambient, material.m_ambient.v, 4);
+		CopyFloats(record.diffuse, material.m_diffuse.v, 4);
+		CopyFloats(record.specular, material.m_specular.v, 4);
+		CopyFloats(record.emmissive, material.m_emmissive.v, 4);
+		record.shininess = material.m_shininess;
+		writer.Write(&record, sizeof(record));
+	}
+
+	const uint32 socketsOffset = writer.GetSize();
+	for (const auto& socket : staticMesh.m_sockets)
+	{
+		SocketRecord record = {};
+		record.nameOffset = strings.Add(socket.m_name);
+		memcpy(record.matrix, socket.m_matrix.m, sizeof(record.matrix));
+		writer.Write(&record, sizeof(record));
+	}
+
+	// Screen sizes are optional: meshes without them always draw LOD 0
+	const uint32 lodScreenSizesOffset = writer.GetSize();
+	if (staticMesh.m_lodScreenSizes.size() == header.numLods)
+		writer.Write(staticMesh.m_lodScreenSizes.data(), header.numLods * sizeof(float32));
+
+	const uint32 indexBuffersOffset = writer.GetSize();
+	for (size_t i = 0; i < header.numSubMeshes * header.numLods; ++i)
+	{
+		IndexBufferRecord record = {};
+		writer.Write(&record, sizeof(record));
+	}
+
+	const uint32 stringsOffset = writer.GetSize();
+	writer.Write(strings.GetData().data(), strings.GetData().size());
+
+	// Vertex and index blobs
+	for (size_t i = 0; i < staticMesh.m_subMeshes.size(); ++i)
+	{
+		const auto& subMesh = staticMesh.m_subMeshes[i];
+
+		writer.Align(kDataAlignment);
+		const uint32 vertexDataOffset = writer.Write(subMesh.GetVertexData(), subMesh.GetVertexDataSize());
+		writer.At<SubMeshRecord>(subMeshesOffset + static_cast<uint32>(i * sizeof(SubMeshRecord))).vertexDataOffset = vertexDataOffset;
+
+		for (size_t lod = 0; lod < header.numLods; ++lod)
+		{
+			writer.Align(kDataAlignment);
+			const uint32 indexDataOffset = writer.Write(subMesh.GetIndexData(lod), subMesh.GetIndexDataSize(lod));
+
+			IndexBufferRecord& record = writer.At<IndexBufferRecord>(indexBuffersOffset + static_cast<uint32>((i * header.numLods + lod) * sizeof(IndexBufferRecord)));
+			record.numIndices = static_cast<uint32>(subMesh.GetNumIndices(lod));
+			record.dataOffset = indexDataOffset;
+		}
+	}
+	writer.Align(kDataAlignment);
+
+	Header& finalHeader = writer.At<Header>(0);
+	finalHeader.fileSize = writer.GetSize();
+	finalHeader.subMeshesOffset = subMeshesOffset;
+	finalHeader.materialsOffset = materialsOffset;
+	finalHeader.socketsOffset = socketsOffset;
+	finalHeader.lodScreenSizesOffset = staticMesh.m_lodScreenSizes.empty()? 0 : lodScreenSizesOffset;
+	finalHeader.indexBuffersOffset = indexBuffersOffset;
+	finalHeader.stringsOffset = stringsOffset;
+	finalHeader.stringsSize = static_cast<uint32>(strings.GetData().size());
+
+	FILE* pFile = fopen(pFileName, "wb");
+	if (!pFile)
+		throw std::runtime_error("MeshFile::Save: failed to open file for writing");
+
+	const bool bWritten = fwrite(writer.GetData(), 1, writer.GetSize(), pFile) == writer.GetSize();
+	fclose(pFile);
+	if (!bWritten)
+		throw std::runtime_error("MeshFile::Save: failed to write file");
+}
+
+std::shared_ptr<gfx::StaticMesh> MeshFile::Load(const char* pFileName)
+{
+	PROFILE_SCOPE("MeshFile::Load");
+
+	std::shared_ptr<MappedFile> pFile = MappedFile::Open(pFileName);
+	if (!pFile || pFile->GetSize() < sizeof(Header))
+		return nullptr;
+
+	const uint8* pData = pFile->GetData();
+	const uint64 fileSize = pFile->GetSize();
+
+	const Header& header = *reinterpret_cast<const Header*>(pData);
+	if (header.magic != kMagic || header.version != kVersion || header.fileSize != fileSize)
+		return nullptr;
+
+	if (!BinaryFile::InFile(header.subMeshesOffset, (uint64)header.numSubMeshes * sizeof(SubMeshRecord), fileSize) ||
+		!BinaryFile::InFile(header.materialsOffset, (uint64)header.numMaterials * sizeof(MaterialRecord), fileSize) ||
+		!BinaryFile::InFile(header.socketsOffset, (uint64)header.numSockets * sizeof(SocketRecord), fileSize) ||
+		header.numLods == 0 ||
+		!BinaryFile::InFile(header.lodScreenSizesOffset, (uint64)header.numLods * sizeof(float32), fileSize) ||
+		!BinaryFile::InFile(header.indexBuffersOffset, (uint64)header.numSubMeshes * header.numLods * sizeof(IndexBufferRecord), fileSize) ||
+		!BinaryFile::InFile(header.stringsOffset, header.stringsSize, fileSize) ||
+		(header.stringsSize > 0 && pData[header.stringsOffset + header.stringsSize - 1] != 0))
+	{
+		return nullptr;
+	}
+
+	const char* pStrings = reinterpret_cast<const char*>(pData + header.stringsOffset);
+	auto GetString = [&] (uint32 offset) { return offset < header.stringsSize? std::string(pStrings + offset) : std::string(); };
+
+	std::shared_ptr<gfx::StaticMesh> pStaticMesh(new gfx::StaticMesh);
+	gfx::StaticMesh& staticMesh = *pStaticMesh;
+
+	staticMesh.m_boundingBox = AABB(Vector3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]), Vector3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+
+	if (header.lodScreenSizesOffset != 0)
+	{
+		const float32* pLodScreenSizes = reinterpret_cast<const float32*>(pData + header.lodScreenSizesOffset);
+		staticMesh.m_lodScreenSizes.assign(pLodScreenSizes, pLodScreenSizes + header.numLods);
+	}
+
+	const SubMeshRecord* pSubMeshRecords = reinterpret_cast<const SubMeshRecord*>(pData + header.subMeshesOffset);
+	const IndexBufferRecord* pIndexBufferRecords = reinterpret_cast<const IndexBufferRecord*>(pData + header.indexBuffersOffset);
+	staticMesh.m_subMeshes.resize(header.numSubMeshes);
+	for (uint32 i = 0; i < header.numSubMeshes; ++i)
+	{
+		const SubMeshRecord& record = pSubMeshRecords[i];
+
+		VertexLayout layout;
+		for (int a = 0; a < VertexAttribute::NumTypes; ++a)
+		{
+			layout.formats[a] = static_cast<VertexAttributeFormat::Type>(record.formats[a]);
+			layout.offsets[a] = record.offsets[a];
+		}
+		layout.stride = record.stride;
+		layout.positionOffset = Vector3(record.positionOffset[0], record.positionOffset[1], record.positionOffset[2]);
+		layout.positionScale = Vector3(record.positionScale[0], record.positionScale[1], record.positionScale[2]);
+
+		if (!layout.IsValid() ||
+			(record.materialIndex >= header.numMaterials && record.materialIndex != gfx::StaticMesh::INVALID_MATERIAL_INDEX) ||
+			(record.indexSize != sizeof(uint16) && record.indexSize != sizeof(uint32)) ||
+			record.vertexDataOffset % kDataAlignment != 0 ||
+			!BinaryFile::InFile(record.vertexDataOffset, (uint64)record.numVertices * record.stride, fileSize))
+		{
+			return nullptr;
+		}
+
+		gfx::StaticMesh::SubMesh& subMesh = staticMesh.m_subMeshes[i];
+		subMesh.SetVertexData(layout, record.numVertices, MappedFile::GetSharedData<uint8>(pFile, record.vertexDataOffset), record.indexSize);
+		subMesh.m_materialIndex = record.materialIndex;
+
+		for (uint32 lod = 0; lod < header.numLods; ++lod)
+		{
+			const IndexBufferRecord& indexBuffer = pIndexBufferRecords[i * header.numLods + lod];
+			if (indexBuffer.dataOffset % kDataAlignment != 0 || indexBuffer.numIndices % 3 != 0 ||
+				!BinaryFile::InFile(indexBuffer.dataOffset, (uint64)indexBuffer.numIndices * record.indexSize, fileSize))
+			{
+				return nullptr;
+			}
+
+			const void* pIndices = pData + indexBuffer.dataOffset;
+			const uint32 maxIndex = record.indexSize == sizeof(uint32)? GetMaxIndex<uint32>(pIndices, indexBuffer.numIndices) : GetMaxIndex<uint16>(pIndices, indexBuffer.numIndices);
+			if (indexBuffer.numIndices > 0 && maxIndex >= record.numVertices)
+				return nullptr;
+
+			subMesh.SetIndexData(indexBuffer.numIndices, MappedFile::GetSharedData<uint8>(pFile, indexBuffer.dataOffset), lod);
+		}
+	}
+
+	const MaterialRecord* pMaterialRecords = reinterpret_cast<const MaterialRecord*>(pData + header.materialsOffset);
+	staticMesh.m_materials.resize(header.numMaterials);
+	for (uint32 i = 0; i < header.numMaterials; ++i)
+	{
+		const MaterialRecord& record = pMaterialRecords[i];
+		gfx::Material& material = staticMesh.m_materials[i];
+
+		material.m_uniqueId = record.uniqueId;
+		material.m_name = GetString(record.nameOffset);
+		material.m_filename = GetString(record.filenameOffset);
+		material.m_ambient = gfx::Color4(record.ambient[0], record.ambient[1], record.ambient[2], record.ambient[3]);
+		material.m_diffuse = gfx::Color4(record.diffuse[0], record.diffuse[1], record.diffuse[2], record.diffuse[3]);
+		material.m_specular = gfx::Color4(record.specular[0], record.specular[1], record.specular[2], record.specular[3]);
+		material.m_emmissive = gfx::Color4(record.emmissive[0], record.emmissive[1], record.emmissive[2], record.emmissive[3]);
+		material.m_shininess = record.shininess;
+	}
+
+	const SocketRecord* pSocketRecords = reinterpret_cast<const SocketRecord*>(pData + header.socketsOffset);
+	staticMesh.m_sockets.resize(header.numSockets);
+	for (uint32 i = 0; i < header.numSockets; ++i)
+	{
+		const SocketRecord& record = pSocketRecords[i];
+		gfx::StaticMesh::Socket& socket = staticMesh.m_sockets[i];
+
+		socket.m_name = GetString(record.nameOffset);
+		memcpy(socket.m_matrix.m, record.matrix, sizeof(record.matrix));
+	}
+
+	return pStaticMesh;
+}
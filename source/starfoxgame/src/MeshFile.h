@@ -0,0 +1,44 @@
+#ifndef _MESH_FILE_H_
+#define _MESH_FILE_H_
+
+// Cooked static mesh file (.sfmesh). Meshes are imported from FBX once (see FbxLoader) and saved in
+// this format, which the game loads by mapping the file into memory: submesh vertex and index data
+// are referenced in place, so loading does no per-vertex work and doesn't need the FBX SDK.
+//
+// Layout (native endianness, offsets are from the start of the file):
+//
+//   Header
+//   SubMeshRecord[numSubMeshes]
+//   MaterialRecord[numMaterials]
+//   SocketRecord[numSockets]
+//   float32 LOD screen sizes[numLods] (if lodScreenSizesOffset isn't 0)
+//   IndexBufferRecord[numSubMeshes * numLods] (all LODs of submesh 0, then submesh 1, ...)
+//   String table (null terminated, referenced by offset from stringsOffset)
+//   Vertex data and LOD index data of each submesh, each aligned to kDataAlignment bytes
+
+#include "gs/Base/Base.h"
+#include <memory>
+
+namespace gfx
+{
+	struct StaticMesh;
+}
+
+namespace MeshFile
+{
+	const char kExtension[] = "sfmesh";
+
+	const uint32 kMagic = 'S' | ('F' << 8) | ('M' << 16) | ('S' << 24);
+	const uint32 kVersion = 3; // Bump when the layout or any encoding changes (v3: submeshes merged by material)
+	const uint32 kDataAlignment = 16;
+
+	// Throws std::exception if the file can't be written
+	void Save(const gfx::StaticMesh& staticMesh, const char* pFileName);
+
+	// Returns nullptr if the file doesn't exist, is invalid, or was cooked with a different version.
+	// The returned mesh keeps the file mapped for as long as any of its submeshes are alive.
+	std::shared_ptr<gfx::StaticMesh> Load(const char* pFileName);
+
+} // namespace MeshFile
+
+#endif // _MESH_FILE_H_
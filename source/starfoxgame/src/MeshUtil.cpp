@@ -0,0 +1,971 @@
+#include "MeshUtil.h"
+#include "gs/Math/MathEx.h"
+#include "gs/Math/SIMD.h"
+#include "gs/System/Profiler.h"
+#include "gs/Base/string_helpers.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	typedef gfx::StaticMesh::Vertex Vertex;
+
+	const size_t kNumVertexFloats = sizeof(Vertex) / sizeof(float32);
+	static_assert(sizeof(Vertex) == kNumVertexFloats * sizeof(float32), "Vertex must only contain floats");
+
+	// FNV-1a over the bits of each attribute. -0 is hashed as +0 since they compare equal.
+	struct VertexHasher
+	{
+		size_t operator()(const Vertex& vertex) const
+		{
+			const float32* pFloats = reinterpret_cast<const float32*>(&vertex);
+			uint32 hash = 2166136261u;
+			for (size_t i = 0; i < kNumVertexFloats; ++i)
+			{
+				const float32 f = pFloats[i] == 0.f ? 0.f : pFloats[i];
+				uint32 bits;
+				memcpy(&bits, &f, sizeof(bits));
+				hash = (hash ^ bits) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	struct VertexEquals
+	{
+		bool operator()(const Vertex& lhs, const Vertex& rhs) const
+		{
+			const float32* pLhs = reinterpret_cast<const float32*>(&lhs);
+			const float32* pRhs = reinterpret_cast<const float32*>(&rhs);
+			for (size_t i = 0; i < kNumVertexFloats; ++i)
+			{
+				if (pLhs[i] != pRhs[i])
+					return false;
+			}
+			return true;
+		}
+	};
+
+	const uint32 kInvalidIndex = ~0u;
+
+	// FIFO post-transform cache simulation. A vertex is in the cache if it was added less than
+	// size additions ago, so we only need to store when each vertex was added.
+	struct FifoCache
+	{
+		FifoCache(size_t numVertices, uint32 size)
+			: timestamps(numVertices, 0), time(size + 1), size(size) {}
+
+		uint32 GetAge(uint32 vertex) const { return time - timestamps[vertex]; }
+		bool Contains(uint32 vertex) const { return GetAge(vertex) <= size; }
+
+		// Returns true on a cache miss
+		bool Access(uint32 vertex)
+		{
+			if (Contains(vertex))
+				return false;
+			timestamps[vertex] = time++;
+			return true;
+		}
+
+		void Flush() { time += size + 1; }
+
+		std::vector<uint32> timestamps;
+		uint32 time;
+		uint32 size;
+	};
+
+	uint32 AccessTriangle(FifoCache& cache, const std::vector<uint32>& indices, size_t triangle)
+	{
+		uint32 misses = 0;
+		for (size_t c = 0; c < 3; ++c)
+			misses += cache.Access(indices[triangle * 3 + c]) ? 1 : 0;
+		return misses;
+	}
+
+	// Returns the next vertex with live triangles, from the most recently used ones first, then
+	// scanning all vertices in order. Returns kInvalidIndex when all triangles have been emitted.
+	uint32 SkipDeadEnd(const std::vector<uint32>& liveCounts, std::vector<uint32>& deadEndStack, size_t& cursor)
+	{
+		while (!deadEndStack.empty())
+		{
+			const uint32 vertex = deadEndStack.back();
+			deadEndStack.pop_back();
+			if (liveCounts[vertex] > 0)
+				return vertex;
+		}
+
+		for (; cursor < liveCounts.size(); ++cursor)
+		{
+			if (liveCounts[cursor] > 0)
+				return static_cast<uint32>(cursor);
+		}
+
+		return kInvalidIndex;
+	}
+
+	// Sum of weighted squared distances to a set of planes, as p'Ap + 2b'p + c with A symmetric.
+	// Doubles because the terms of planes far from the origin cancel out.
+	struct Quadric
+	{
+		Quadric() : a00(0), a01(0), a02(0), a11(0), a12(0), a22(0), b0(0), b1(0), b2(0), c(0), weight(0) {}
+
+		// Plane n.p + d = 0, n unit length
+		static Quadric FromPlane(const Vector3& n, float32 d, float32 weight)
+		{
+			Quadric q;
+			q.a00 = weight * n.x * n.x; q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z;
+			q.a11 = weight * n.y * n.y; q.a12 = weight * n.y * n.z; q.a22 = weight * n.z * n.z;
+			q.b0 = weight * n.x * d; q.b1 = weight * n.y * d; q.b2 = weight * n.z * d;
+			q.c = weight * d * d;
+			q.weight = weight;
+			return q;
+		}
+
+		Quadric& operator+=(const Quadric& rhs)
+		{
+			a00 += rhs.a00; a01 += rhs.a01; a02 += rhs.a02;
+			a11 += rhs.a11; a12 += rhs.a12; a22 += rhs.a22;
+			b0 += rhs.b0; b1 += rhs.b1; b2 += rhs.b2;
+			c += rhs.c;
+			weight += rhs.weight;
+			return *this;
+		}
+
+		// Mean squared distance to the planes
+		float64 Evaluate(const Vector3& p) const
+		{
+			const float64 x = p.x, y = p.y, z = p.z;
+			const float64 error =
+				a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0? MathEx::Max(error, 0.0) / weight : 0.0;
+		}
+
+		float64 a00, a01, a02, a11, a12, a22;
+		float64 b0, b1, b2;
+		float64 c;
+		float64 weight;
+	};
+
+	struct PositionHasher
+	{
+		size_t operator()(const Vector3& position) const
+		{
+			uint32 hash = 2166136261u;
+			for (size_t i = 0; i < 3; ++i)
+			{
+				const float32 f = position.v[i] == 0.f ? 0.f : position.v[i];
+				uint32 bits;
+				memcpy(&bits, &f, sizeof(bits));
+				hash = (hash ^ bits) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	struct PositionEquals
+	{
+		bool operator()(const Vector3& lhs, const Vector3& rhs) const
+		{
+			return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+		}
+	};
+
+	// Border edges are kept in place by planes through them, perpendicular to their triangle,
+	// weighted this many times more than the triangles' own planes
+	const float32 kBorderWeight = 10.f;
+
+	// Collapses that rotate a triangle's normal by more than acos(kMaxFlipCos) are rejected
+	const float32 kMaxFlipCos = 0.25f;
+
+	// Each LOD aims for this fraction of the triangles of the previous one, and is dropped if it
+	// doesn't get below kLodMinReduction of them
+	const float32 kLodTriangleRatio = 0.5f;
+	const float32 kLodMinReduction = 0.75f;
+
+	Vector3 GetTriangleNormal(const Vector3& p0, const Vector3& p1, const Vector3& p2)
+	{
+		return (p1 - p0).Cross(p2 - p0);
+	}
+
+#if GS_SIMD_SSE
+	// Rows of a Matrix43 with w = 0, except for the translation row's, which is (0, 0, 0, 0) when
+	// transforming directions and (translation, 1) when transforming positions
+	struct SimdMatrix
+	{
+		SimdMatrix(const Matrix43& m, bool bPositions)
+		{
+			for (int i = 0; i < 3; ++i)
+				rows[i] = _mm_setr_ps(m.m[i][0], m.m[i][1], m.m[i][2], 0.f);
+			rows[3] = bPositions? _mm_setr_ps(m.m[3][0], m.m[3][1], m.m[3][2], 1.f) : _mm_setzero_ps();
+		}
+
+		// Row vector times matrix: x * row0 + y * row1 + z * row2 + row3
+		__m128 Transform(__m128 v) const
+		{
+			const __m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+			const __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+			const __m128 z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, rows[0]), _mm_mul_ps(y, rows[1])), _mm_add_ps(_mm_mul_ps(z, rows[2]), rows[3]));
+		}
+
+		__m128 rows[4];
+	};
+
+	inline __m128 LoadDoublesAsFloats(const float64* p)
+	{
+		return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+	}
+#else
+	inline Vector3 LoadDoublesAsVector3(const float64* p)
+	{
+		return Vector3((float32)p[0], (float32)p[1], (float32)p[2]);
+	}
+#endif
+
+	// Inverse of VertexLayout::Create
+	uint32 GetVertexLayoutFlags(const VertexLayout& layout)
+	{
+		uint32 flags = 0;
+		if (layout.Has(VertexAttribute::Normal))
+			flags |= VertexLayoutFlags::Normal;
+		if (layout.Has(VertexAttribute::Color))
+			flags |= VertexLayoutFlags::Color;
+		if (layout.Has(VertexAttribute::TexCoord))
+			flags |= VertexLayoutFlags::TexCoord;
+		if (layout.formats[VertexAttribute::Position] == VertexAttributeFormat::UNorm16x3)
+			flags |= VertexLayoutFlags::QuantizePosition;
+		return flags;
+	}
+}
+
+namespace MeshUtil
+{
+	void TransformPositions(const float64* pPoints, size_t count, const Matrix43& m, Vector4* pOutPositions)
+	{
+#if GS_SIMD_SSE
+		const SimdMatrix simdMatrix(m, true);
+		for (size_t i = 0; i < count; ++i)
+			_mm_storeu_ps(pOutPositions[i].v, simdMatrix.Transform(LoadDoublesAsFloats(pPoints + i * 4)));
+#else
+		for (size_t i = 0; i < count; ++i)
+			pOutPositions[i] = Vector4(PositionVector(LoadDoublesAsVector3(pPoints + i * 4)) * m, 1.f);
+#endif
+	}
+
+	void TransformDirections(const float64* pDirections, size_t count, const Matrix43& m, Vector4* pOutDirections)
+	{
+#if GS_SIMD_SSE
+		const SimdMatrix simdMatrix(m, false);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const __m128 direction = simdMatrix.Transform(LoadDoublesAsFloats(pDirections + i * 4));
+
+			// Zero length directions are left as is, as FBX does
+			const float32 lengthSquared = SIMD::HorizontalAdd(_mm_mul_ps(direction, direction));
+			const __m128 scale = _mm_set1_ps(lengthSquared > 0.f? 1.f / MathEx::Sqrt(lengthSquared) : 1.f);
+			_mm_storeu_ps(pOutDirections[i].v, _mm_mul_ps(direction, scale));
+		}
+#else
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Vector3 direction = DirectionVector(LoadDoublesAsVector3(pDirections + i * 4)) * m;
+			pOutDirections[i] = Vector4(SafeNormalize(direction, direction), 0.f);
+		}
+#endif
+	}
+
+	AABB ComputeBoundingBox(const std::vector<Vertex>& vertices)
+	{
+		if (vertices.empty())
+			return AABB::Empty();
+
+#if GS_SIMD_SSE
+		// xyz lanes hold the bounds; w is ignored
+		__m128 minPosition = _mm_loadu_ps(vertices[0].position.v);
+		__m128 maxPosition = minPosition;
+		for (const Vertex& vertex : vertices)
+		{
+			const __m128 position = _mm_loadu_ps(vertex.position.v);
+			minPosition = SIMD::Min(minPosition, position);
+			maxPosition = SIMD::Max(maxPosition, position);
+		}
+
+		Vector4 min, max;
+		_mm_storeu_ps(min.v, minPosition);
+		_mm_storeu_ps(max.v, maxPosition);
+		return AABB(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
+#else
+		AABB aabb = AABB::Empty();
+		for (const Vertex& vertex : vertices)
+			aabb.Include(Vector3(vertex.position.x, vertex.position.y, vertex.position.z));
+		return aabb;
+#endif
+	}
+
+	void WeldVertices(const std::vector<Vertex>& vertices, std::vector<Vertex>& outVertices, std::vector<uint32>& outIndices)
+	{
+		assert(&vertices != &outVertices);
+
+		outVertices.clear();
+		outIndices.clear();
+		outIndices.reserve(vertices.size());
+
+		std::unordered_map<Vertex, uint32, VertexHasher, VertexEquals> vertexToIndex;
+		vertexToIndex.reserve(vertices.size());
+
+		for (const Vertex& vertex : vertices)
+		{
+			auto result = vertexToIndex.insert(std::make_pair(vertex, static_cast<uint32>(outVertices.size())));
+			if (result.second)
+				outVertices.push_back(vertex);
+
+			outIndices.push_back(result.first->second);
+		}
+
+		outVertices.shrink_to_fit();
+	}
+
+	VertexCacheStats& VertexCacheStats::operator+=(const VertexCacheStats& rhs)
+	{
+		numTriangles += rhs.numTriangles;
+		numVertices += rhs.numVertices;
+		numTransformed += rhs.numTransformed;
+		return *this;
+	}
+
+	VertexCacheStats AnalyzeVertexCache(const std::vector<uint32>& indices, size_t numVertices, uint32 cacheSize)
+	{
+		VertexCacheStats stats;
+		stats.numTriangles = static_cast<uint32>(indices.size() / 3);
+
+		FifoCache cache(numVertices, cacheSize);
+		std::vector<bool> referenced(numVertices, false);
+		for (uint32 index : indices)
+		{
+			assert(index < numVertices);
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				++stats.numVertices;
+			}
+			stats.numTransformed += cache.Access(index) ? 1 : 0;
+		}
+
+		return stats;
+	}
+
+	void OptimizeVertexCache(std::vector<uint32>& indices, size_t numVertices, std::vector<uint32>* pClusters, uint32 cacheSize)
+	{
+		assert(indices.size() % 3 == 0);
+		const size_t numTriangles = indices.size() / 3;
+
+		if (pClusters)
+			pClusters->clear();
+
+		if (numTriangles == 0)
+			return;
+
+		// Triangles adjacent to each vertex, stored contiguously per vertex
+		std::vector<uint32> liveCounts(numVertices, 0);
+		for (uint32 index : indices)
+			++liveCounts[index];
+
+		std::vector<uint32> adjacencyOffsets(numVertices + 1, 0);
+		for (size_t v = 0; v < numVertices; ++v)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveCounts[v];
+
+		std::vector<uint32> adjacency(indices.size());
+		{
+			std::vector<uint32> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); ++i)
+				adjacency[fillOffsets[indices[i]]++] = static_cast<uint32>(i / 3);
+		}
+
+		FifoCache cache(numVertices, cacheSize);
+		std::vector<bool> emitted(numTriangles, false);
+		std::vector<uint32> deadEndStack;
+		deadEndStack.reserve(indices.size());
+		std::vector<uint32> candidates;
+		std::vector<uint32> output;
+		output.reserve(indices.size());
+
+		size_t cursor = 0;
+		uint32 fanVertex = SkipDeadEnd(liveCounts, deadEndStack, cursor);
+		if (pClusters)
+			pClusters->push_back(0);
+
+		while (fanVertex != kInvalidIndex)
+		{
+			// Emit all remaining triangles around the fanning vertex
+			candidates.clear();
+			for (uint32 a = adjacencyOffsets[fanVertex]; a < adjacencyOffsets[fanVertex + 1]; ++a)
+			{
+				const uint32 triangle = adjacency[a];
+				if (emitted[triangle])
+					continue;
+
+				for (size_t c = 0; c < 3; ++c)
+				{
+					const uint32 vertex = indices[triangle * 3 + c];
+					output.push_back(vertex);
+					deadEndStack.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveCounts[vertex];
+					cache.Access(vertex);
+				}
+				emitted[triangle] = true;
+			}
+
+			// Next fanning vertex is the oldest candidate that will still be in the cache once all
+			// of its triangles are emitted
+			fanVertex = kInvalidIndex;
+			int64 bestPriority = -1;
+			for (uint32 vertex : candidates)
+			{
+				if (liveCounts[vertex] == 0)
+					continue;
+
+				int64 priority = 0;
+				if (cache.GetAge(vertex) + 2 * liveCounts[vertex] <= cacheSize)
+					priority = cache.GetAge(vertex);
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanVertex = vertex;
+				}
+			}
+
+			if (fanVertex == kInvalidIndex)
+			{
+				fanVertex = SkipDeadEnd(liveCounts, deadEndStack, cursor);
+				if (fanVertex != kInvalidIndex && pClusters)
+					pClusters->push_back(static_cast<uint32>(output.size() / 3));
+			}
+		}
+
+		assert(output.size() == indices.size());
+		indices.swap(output);
+	}
+
+	void OptimizeOverdraw(std::vector<uint32>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32>& clusters, float32 threshold, uint32 cacheSize)
+	{
+		const size_t numTriangles = indices.size() / 3;
+		if (numTriangles == 0)
+			return;
+
+		assert(!clusters.empty() && clusters[0] == 0);
+
+		// Split clusters wherever the ACMR so far is already as good as the whole cluster's, so
+		// that there are more, smaller clusters to sort at little cost to cache efficiency.
+		std::vector<uint32> softClusters;
+		FifoCache cache(vertices.size(), cacheSize);
+		for (size_t i = 0; i < clusters.size(); ++i)
+		{
+			const uint32 start = clusters[i];
+			const uint32 end = i + 1 < clusters.size() ? clusters[i + 1] : static_cast<uint32>(numTriangles);
+			assert(start < end);
+
+			cache.Flush();
+			uint32 clusterMisses = 0;
+			for (uint32 t = start; t < end; ++t)
+				clusterMisses += AccessTriangle(cache, indices, t);
+			const float32 targetACMR = threshold * clusterMisses / (end - start);
+
+			cache.Flush();
+			softClusters.push_back(start);
+			uint32 runningMisses = 0;
+			uint32 runningTriangles = 0;
+			for (uint32 t = start; t + 1 < end; ++t)
+			{
+				runningMisses += AccessTriangle(cache, indices, t);
+				++runningTriangles;
+				if (runningMisses <= targetACMR * runningTriangles)
+				{
+					softClusters.push_back(t + 1);
+					cache.Flush();
+					runningMisses = 0;
+					runningTriangles = 0;
+				}
+			}
+		}
+
+		Vector3 meshCentroid = Vector3::Zero();
+		for (const Vertex& vertex : vertices)
+			meshCentroid += Vector3(vertex.position);
+		meshCentroid /= static_cast<float32>(vertices.size());
+
+		// Sort key is how much a cluster faces away from the mesh center. We use vertex normals
+		// rather than the winding, which depends on the handedness of the mesh.
+		struct ClusterSortData { uint32 cluster; float32 key; };
+		std::vector<ClusterSortData> sortData(softClusters.size());
+		for (size_t i = 0; i < softClusters.size(); ++i)
+		{
+			const uint32 start = softClusters[i];
+			const uint32 end = i + 1 < softClusters.size() ? softClusters[i + 1] : static_cast<uint32>(numTriangles);
+
+			Vector3 centroid = Vector3::Zero();
+			Vector3 normal = Vector3::Zero();
+			float32 area = 0.f;
+			for (uint32 t = start; t < end; ++t)
+			{
+				const Vertex& v0 = vertices[indices[t * 3 + 0]];
+				const Vertex& v1 = vertices[indices[t * 3 + 1]];
+				const Vertex& v2 = vertices[indices[t * 3 + 2]];
+				const Vector3 p0(v0.position), p1(v1.position), p2(v2.position);
+				const float32 triangleArea = (p1 - p0).Cross(p2 - p0).Length() * 0.5f;
+
+				centroid += (p0 + p1 + p2) * (triangleArea / 3.f);
+				normal += (Vector3(v0.normal) + Vector3(v1.normal) + Vector3(v2.normal)) * triangleArea;
+				area += triangleArea;
+			}
+
+			if (area > 0.f)
+				centroid /= area;
+
+			sortData[i].cluster = static_cast<uint32>(i);
+			sortData[i].key = (centroid - meshCentroid).Dot(SafeNormalize(normal, Vector3::Zero()));
+		}
+
+		std::stable_sort(sortData.begin(), sortData.end(), [] (const ClusterSortData& lhs, const ClusterSortData& rhs) { return lhs.key > rhs.key; });
+
+		std::vector<uint32> output;
+		output.reserve(indices.size());
+		for (const ClusterSortData& data : sortData)
+		{
+			const uint32 start = softClusters[data.cluster];
+			const uint32 end = data.cluster + 1 < softClusters.size() ? softClusters[data.cluster + 1] : static_cast<uint32>(numTriangles);
+			output.insert(output.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+		}
+
+		indices.swap(output);
+	}
+
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32>& indices)
+	{
+		std::vector<uint32> remap(vertices.size(), kInvalidIndex);
+		std::vector<Vertex> output;
+		output.reserve(vertices.size());
+
+		for (uint32& index : indices)
+		{
+			if (remap[index] == kInvalidIndex)
+			{
+				remap[index] = static_cast<uint32>(output.size());
+				output.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices.swap(output);
+	}
+
+	void OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32>& indices)
+	{
+		std::vector<uint32> clusters;
+		OptimizeVertexCache(indices, vertices.size(), &clusters);
+		OptimizeOverdraw(indices, vertices, clusters);
+		OptimizeVertexFetch(vertices, indices);
+	}
+
+	float32 SimplifyMesh(const std::vector<uint32>& indices, const std::vector<Vertex>& vertices, size_t targetIndexCount, float32 maxError, std::vector<uint32>& outIndices)
+	{
+		assert(indices.size() % 3 == 0);
+		assert(&indices != &outIndices);
+
+		const size_t numVertices = vertices.size();
+
+		// Collapses move positions rather than vertices: vertices with the same position (which
+		// differ in other attributes) form a group that collapses together.
+		std::vector<uint32> groups(numVertices);
+		std::vector<Vector3> groupPositions;
+		{
+			std::unordered_map<Vector3, uint32, PositionHasher, PositionEquals> positionToGroup;
+			for (size_t v = 0; v < numVertices; ++v)
+			{
+				const Vector3 position(vertices[v].position);
+				auto result = positionToGroup.insert(std::make_pair(position, static_cast<uint32>(groupPositions.size())));
+				if (result.second)
+					groupPositions.push_back(position);
+				groups[v] = result.first->second;
+			}
+		}
+		const size_t numGroups = groupPositions.size();
+
+		// Vertices of each group, stored contiguously per group
+		std::vector<uint32> groupVertexOffsets(numGroups + 1, 0);
+		std::vector<uint32> groupVertices(numVertices);
+		for (size_t v = 0; v < numVertices; ++v)
+			++groupVertexOffsets[groups[v] + 1];
+		for (size_t g = 0; g < numGroups; ++g)
+			groupVertexOffsets[g + 1] += groupVertexOffsets[g];
+		{
+			std::vector<uint32> fillOffsets(groupVertexOffsets.begin(), groupVertexOffsets.end() - 1);
+			for (size_t v = 0; v < numVertices; ++v)
+				groupVertices[fillOffsets[groups[v]]++] = static_cast<uint32>(v);
+		}
+
+		// Area weighted quadrics of the triangles around each group
+		std::vector<Quadric> quadrics(numGroups);
+		std::unordered_map<uint64, uint32> groupEdgeCounts; // Directed edges between groups
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const uint32 g[3] = { groups[indices[i]], groups[indices[i + 1]], groups[indices[i + 2]] };
+			Vector3 normal = GetTriangleNormal(groupPositions[g[0]], groupPositions[g[1]], groupPositions[g[2]]);
+			const float32 doubleArea = normal.Length();
+			if (doubleArea == 0.f)
+				continue;
+
+			normal /= doubleArea;
+			const Quadric quadric = Quadric::FromPlane(normal, -normal.Dot(groupPositions[g[0]]), doubleArea * 0.5f);
+			for (size_t c = 0; c < 3; ++c)
+			{
+				quadrics[g[c]] += quadric;
+				++groupEdgeCounts[(static_cast<uint64>(g[c]) << 32) | g[(c + 1) % 3]];
+			}
+		}
+
+		// Edges without a matching edge in the opposite direction are on the border of the surface
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const uint32 g[3] = { groups[indices[i]], groups[indices[i + 1]], groups[indices[i + 2]] };
+			const Vector3 normal = SafeNormalize(GetTriangleNormal(groupPositions[g[0]], groupPositions[g[1]], groupPositions[g[2]]), Vector3::Zero());
+			for (size_t c = 0; c < 3; ++c)
+			{
+				const uint32 g0 = g[c];
+				const uint32 g1 = g[(c + 1) % 3];
+				if (g0 == g1 || groupEdgeCounts.count((static_cast<uint64>(g1) << 32) | g0))
+					continue;
+
+				const Vector3 edge = groupPositions[g1] - groupPositions[g0];
+				const Vector3 borderNormal = SafeNormalize(edge.Cross(normal), Vector3::Zero());
+				const Quadric quadric = Quadric::FromPlane(borderNormal, -borderNormal.Dot(groupPositions[g0]), edge.LengthSquared() * kBorderWeight);
+				quadrics[g0] += quadric;
+				quadrics[g1] += quadric;
+			}
+		}
+
+		struct Collapse
+		{
+			uint32 from;
+			uint32 to;
+			float64 error;
+		};
+
+		const float64 maxErrorSquared = static_cast<float64>(maxError) * maxError;
+		float64 resultError = 0.0;
+
+		outIndices = indices;
+		std::vector<uint32> groupTriangleOffsets;
+		std::vector<uint32> groupTriangles;
+		std::vector<Collapse> collapses;
+		std::vector<uint32> vertexRemap(numVertices);
+		std::vector<bool> locked;
+		std::vector<std::pair<uint32, uint32>> wedgeRemap; // (from vertex, to vertex) of a collapse
+
+		// Each pass collapses the cheapest edges that don't touch each other, then rebuilds the triangles
+		while (outIndices.size() > targetIndexCount)
+		{
+			const size_t numTriangles = outIndices.size() / 3;
+
+			// Triangles around each group, stored contiguously per group
+			groupTriangleOffsets.assign(numGroups + 1, 0);
+			for (uint32 index : outIndices)
+				++groupTriangleOffsets[groups[index] + 1];
+			for (size_t g = 0; g < numGroups; ++g)
+				groupTriangleOffsets[g + 1] += groupTriangleOffsets[g];
+			groupTriangles.resize(outIndices.size());
+			{
+				std::vector<uint32> fillOffsets(groupTriangleOffsets.begin(), groupTriangleOffsets.end() - 1);
+				for (size_t i = 0; i < outIndices.size(); ++i)
+					groupTriangles[fillOffsets[groups[outIndices[i]]]++] = static_cast<uint32>(i / 3);
+			}
+
+			// Each edge collapses in the direction with the lower error
+			collapses.clear();
+			for (size_t i = 0; i < outIndices.size(); ++i)
+			{
+				const uint32 g0 = groups[outIndices[i]];
+				const uint32 g1 = groups[outIndices[i - i % 3 + (i + 1) % 3]];
+				if (g0 >= g1) // Visit each edge once (or twice for borders, harmlessly)
+					continue;
+
+				Quadric quadric = quadrics[g0];
+				quadric += quadrics[g1];
+				const float64 error0 = quadric.Evaluate(groupPositions[g0]);
+				const float64 error1 = quadric.Evaluate(groupPositions[g1]);
+				Collapse collapse = { g0, g1, error1 };
+				if (error0 < error1)
+				{
+					collapse.from = g1;
+					collapse.to = g0;
+					collapse.error = error0;
+				}
+				collapses.push_back(collapse);
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [] (const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; });
+
+			for (size_t v = 0; v < numVertices; ++v)
+				vertexRemap[v] = static_cast<uint32>(v);
+			locked.assign(numGroups, false);
+
+			const size_t trianglesToRemove = numTriangles - targetIndexCount / 3;
+			size_t numRemoved = 0;
+			size_t numCollapses = 0;
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (numRemoved >= trianglesToRemove || collapse.error > maxErrorSquared)
+					break;
+
+				if (locked[collapse.from] || locked[collapse.to])
+					continue;
+
+				const uint32* pTrianglesBegin = &groupTriangles[groupTriangleOffsets[collapse.from]];
+				const uint32* pTrianglesEnd = &groupTriangles[0] + groupTriangleOffsets[collapse.from + 1];
+
+				// Each vertex of the collapsed group moves to the vertex of the target group that it
+				// shares an edge with, so that attribute seams stay intact. Vertices with no such
+				// edge (hard edges the collapse crosses) take the target vertex with the closest normal.
+				wedgeRemap.clear();
+				bool bValid = true;
+				for (const uint32* pTriangle = pTrianglesBegin; pTriangle != pTrianglesEnd && bValid; ++pTriangle)
+				{
+					const uint32* pCorners = &outIndices[*pTriangle * 3];
+					for (size_t c = 0; c < 3; ++c)
+					{
+						const uint32 from = pCorners[c];
+						if (groups[from] != collapse.from)
+							continue;
+
+						uint32 to = kInvalidIndex;
+						for (size_t o = 1; o < 3; ++o)
+						{
+							if (groups[pCorners[(c + o) % 3]] == collapse.to)
+								to = pCorners[(c + o) % 3];
+						}
+
+						auto iter = std::find_if(wedgeRemap.begin(), wedgeRemap.end(), [&] (const std::pair<uint32, uint32>& entry) { return entry.first == from; });
+						if (iter == wedgeRemap.end())
+						{
+							wedgeRemap.push_back(std::make_pair(from, to));
+						}
+						else if (to != kInvalidIndex)
+						{
+							if (iter->second != kInvalidIndex && iter->second != to)
+								bValid = false; // Ambiguous: the target group has a seam this vertex spans
+							iter->second = to;
+						}
+					}
+				}
+
+				if (!bValid)
+					continue;
+
+				for (auto& entry : wedgeRemap)
+				{
+					if (entry.second != kInvalidIndex)
+						continue;
+
+					float32 bestDot = -kInfiniteDistance;
+					for (uint32 i = groupVertexOffsets[collapse.to]; i < groupVertexOffsets[collapse.to + 1]; ++i)
+					{
+						const uint32 v = groupVertices[i];
+						const float32 dot = Vector3(vertices[v].normal).Dot(Vector3(vertices[entry.first].normal));
+						if (dot > bestDot)
+						{
+							bestDot = dot;
+							entry.second = v;
+						}
+					}
+				}
+
+				// Reject collapses that flip or badly rotate any triangle that remains
+				size_t numCollapsedTriangles = 0;
+				for (const uint32* pTriangle = pTrianglesBegin; pTriangle != pTrianglesEnd && bValid; ++pTriangle)
+				{
+					const uint32* pCorners = &outIndices[*pTriangle * 3];
+					Vector3 before[3], after[3];
+					bool bCollapsed = false;
+					for (size_t c = 0; c < 3; ++c)
+					{
+						const uint32 group = groups[pCorners[c]];
+						before[c] = groupPositions[group];
+						after[c] = group == collapse.from? groupPositions[collapse.to] : before[c];
+						bCollapsed |= group == collapse.to;
+					}
+
+					if (bCollapsed)
+					{
+						++numCollapsedTriangles;
+						continue;
+					}
+
+					const Vector3 normalBefore = GetTriangleNormal(before[0], before[1], before[2]);
+					const Vector3 normalAfter = GetTriangleNormal(after[0], after[1], after[2]);
+					if (normalBefore.Dot(normalAfter) < kMaxFlipCos * normalBefore.Length() * normalAfter.Length())
+						bValid = false;
+				}
+
+				if (!bValid)
+					continue;
+
+				for (const auto& entry : wedgeRemap)
+					vertexRemap[entry.first] = entry.second;
+
+				quadrics[collapse.to] += quadrics[collapse.from];
+				resultError = MathEx::Max(resultError, collapse.error);
+				numRemoved += numCollapsedTriangles;
+				++numCollapses;
+
+				// Lock the neighborhood, whose triangles and quadrics this pass no longer reflects
+				for (const uint32* pTriangle = pTrianglesBegin; pTriangle != pTrianglesEnd; ++pTriangle)
+				{
+					for (size_t c = 0; c < 3; ++c)
+						locked[groups[outIndices[*pTriangle * 3 + c]]] = true;
+				}
+			}
+
+			if (numCollapses == 0)
+				break;
+
+			// Remap and drop triangles that collapsed
+			size_t numIndices = 0;
+			for (size_t i = 0; i < outIndices.size(); i += 3)
+			{
+				const uint32 v0 = vertexRemap[outIndices[i]];
+				const uint32 v1 = vertexRemap[outIndices[i + 1]];
+				const uint32 v2 = vertexRemap[outIndices[i + 2]];
+				if (groups[v0] == groups[v1] || groups[v1] == groups[v2] || groups[v2] == groups[v0])
+					continue;
+
+				outIndices[numIndices++] = v0;
+				outIndices[numIndices++] = v1;
+				outIndices[numIndices++] = v2;
+			}
+			outIndices.resize(numIndices);
+		}
+
+		return static_cast<float32>(sqrt(resultError));
+	}
+
+	void GenerateLods(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, std::vector<std::vector<uint32>>& lodIndices, std::vector<float32>& lodErrors)
+	{
+		lodIndices.resize(kMaxLods - 1);
+		lodErrors.resize(kMaxLods - 1);
+
+		// Each LOD is simplified from the full detail mesh, so that errors don't compound
+		size_t targetIndexCount = indices.size();
+		for (size_t lod = 0; lod + 1 < kMaxLods; ++lod)
+		{
+			targetIndexCount = static_cast<size_t>(targetIndexCount / 3 * kLodTriangleRatio) * 3;
+			lodErrors[lod] = SimplifyMesh(indices, vertices, targetIndexCount, kInfiniteDistance, lodIndices[lod]);
+			OptimizeVertexCache(lodIndices[lod], vertices.size());
+		}
+	}
+
+	void MergeSubMeshesByMaterial(gfx::StaticMesh& staticMesh)
+	{
+		PROFILE_SCOPE("MeshUtil::MergeSubMeshesByMaterial");
+
+		typedef gfx::StaticMesh::SubMesh SubMesh;
+		const size_t numLods = staticMesh.GetNumLods();
+
+		// Submeshes to merge into each output submesh, grouped by material and layout
+		std::vector<std::vector<const SubMesh*>> groups;
+		std::vector<std::pair<uint32, uint32>> groupKeys;
+		for (const SubMesh& subMesh : staticMesh.m_subMeshes)
+		{
+			const std::pair<uint32, uint32> key(subMesh.m_materialIndex, GetVertexLayoutFlags(subMesh.m_vertexLayout));
+			const size_t group = std::find(groupKeys.begin(), groupKeys.end(), key) - groupKeys.begin();
+			if (group == groupKeys.size())
+			{
+				groupKeys.push_back(key);
+				groups.emplace_back();
+			}
+			groups[group].push_back(&subMesh);
+		}
+
+		if (groups.size() == staticMesh.m_subMeshes.size())
+			return;
+
+		std::vector<SubMesh> mergedSubMeshes(groups.size());
+		std::vector<Vertex> subMeshVertices;
+		for (size_t group = 0; group < groups.size(); ++group)
+		{
+			SubMesh& mergedSubMesh = mergedSubMeshes[group];
+			if (groups[group].size() == 1)
+			{
+				mergedSubMesh = *groups[group][0];
+				continue;
+			}
+
+			std::vector<Vertex> vertices;
+			std::vector<std::vector<uint32>> lodIndices(numLods);
+			for (const SubMesh* pSubMesh : groups[group])
+			{
+				const uint32 firstVertex = static_cast<uint32>(vertices.size());
+				pSubMesh->GetVertices(subMeshVertices);
+				vertices.insert(vertices.end(), subMeshVertices.begin(), subMeshVertices.end());
+
+				for (size_t lod = 0; lod < numLods; ++lod)
+				{
+					for (size_t i = 0; i < pSubMesh->GetNumIndices(lod); ++i)
+						lodIndices[lod].push_back(firstVertex + pSubMesh->GetIndex(i, lod));
+				}
+			}
+
+			mergedSubMesh.m_materialIndex = groupKeys[group].first;
+			mergedSubMesh.SetVertices(vertices, groupKeys[group].second);
+			for (size_t lod = 0; lod < numLods; ++lod)
+				mergedSubMesh.SetIndices(lodIndices[lod], lod);
+		}
+
+		staticMesh.m_subMeshes.swap(mergedSubMeshes);
+	}
+
+	void SetupLods(gfx::StaticMesh& staticMesh, const std::vector<float32>& lodErrors)
+	{
+		PROFILE_SCOPE("MeshUtil::SetupLods");
+
+		const size_t numLods = staticMesh.GetNumLods();
+		assert(lodErrors.size() >= numLods);
+
+		auto GetNumTriangles = [&] (size_t lod)
+		{
+			size_t numTriangles = 0;
+			for (const auto& subMesh : staticMesh.m_subMeshes)
+				numTriangles += subMesh.GetNumIndices(lod) / 3;
+			return numTriangles;
+		};
+
+		// Also stop at LODs with no triangles left, which would make the mesh disappear
+		size_t numKept = 1;
+		while (numKept < numLods && GetNumTriangles(numKept) <= GetNumTriangles(numKept - 1) * kLodMinReduction && GetNumTriangles(numKept) > 0)
+			++numKept;
+
+		for (auto& subMesh : staticMesh.m_subMeshes)
+			subMesh.m_lods.resize(numKept);
+
+		// A LOD's error, in screen height units, is its error over the distance from the camera
+		// times 2 tan(fovY/2), which is also the mesh's screen size over its diameter. LODs without
+		// error are as good as the full detail mesh at any size.
+		const float32 diameter = (staticMesh.m_boundingBox.max - staticMesh.m_boundingBox.min).Length();
+		staticMesh.m_lodScreenSizes.resize(numKept);
+		staticMesh.m_lodScreenSizes[0] = kInfiniteDistance;
+		for (size_t lod = 1; lod < numKept; ++lod)
+			staticMesh.m_lodScreenSizes[lod] = lodErrors[lod] > 0.f? kLodMaxScreenError * diameter / lodErrors[lod] : kInfiniteDistance;
+	}
+
+	std::string GetSettings()
+	{
+		return str_format("vertex cache %u, overdraw threshold %g, lods %u, lod triangle ratio %g, lod min reduction %g, lod error %g, border weight %g, max flip cos %g",
+			kVertexCacheSize, kOverdrawThreshold, kMaxLods, kLodTriangleRatio, kLodMinReduction, kLodMaxScreenError, kBorderWeight, kMaxFlipCos);
+	}
+
+} // namespace MeshUtil
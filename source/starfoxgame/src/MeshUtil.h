@@ -0,0 +1,103 @@
+#ifndef _MESH_UTIL_H_
+#define _MESH_UTIL_H_
+
+// Mesh processing functions run on import (see FbxLoader)
+
+#include "StaticMesh.h"
+#include <string>
+#include <vector>
+
+namespace MeshUtil
+{
+	// Transforms count points stored as consecutive (x, y, z, w) doubles, as FBX stores them, by m
+	// and converts them to float. Positions get the translation and w = 1.
+	void TransformPositions(const float64* pPoints, size_t count, const Matrix43& m, Vector4* pOutPositions);
+
+	// Same as TransformPositions for directions, which ignore the translation and are normalized
+	// (ignoring scale) with w = 0
+	void TransformDirections(const float64* pDirections, size_t count, const Matrix43& m, Vector4* pOutDirections);
+
+	// Bounds of the vertex positions
+	AABB ComputeBoundingBox(const std::vector<gfx::StaticMesh::Vertex>& vertices);
+
+	// Merges vertices that are exactly equal in all attributes, returning the unique vertices in
+	// first-seen order and a triangle list that indexes them (one index per input vertex).
+	void WeldVertices(const std::vector<gfx::StaticMesh::Vertex>& vertices, std::vector<gfx::StaticMesh::Vertex>& outVertices, std::vector<uint32>& outIndices);
+
+	// Size of the FIFO post-transform vertex cache we optimize for and simulate
+	const uint32 kVertexCacheSize = 16;
+
+	// Post-transform vertex cache efficiency of a triangle list
+	struct VertexCacheStats
+	{
+		VertexCacheStats() : numTriangles(0), numVertices(0), numTransformed(0) {}
+
+		uint32 numTriangles;
+		uint32 numVertices;		// Vertices referenced by the triangles
+		uint32 numTransformed;	// Cache misses
+
+		// Average cache miss ratio: transformed vertices per triangle, from 3 (worst) down to ~0.5
+		float32 GetACMR() const { return numTriangles > 0? (float32)numTransformed / numTriangles : 0.f; }
+
+		// Average transform to vertex ratio: 1 means each vertex is transformed exactly once
+		float32 GetATVR() const { return numVertices > 0? (float32)numTransformed / numVertices : 0.f; }
+
+		VertexCacheStats& operator+=(const VertexCacheStats& rhs);
+	};
+
+	VertexCacheStats AnalyzeVertexCache(const std::vector<uint32>& indices, size_t numVertices, uint32 cacheSize = kVertexCacheSize);
+
+	// Reorders triangles for the post-transform vertex cache using Tipsify [Sander et al. 2007].
+	// If pClusters is not null, it receives the first triangle of each cluster of triangles that
+	// were emitted together (boundaries are where the cache was effectively flushed).
+	void OptimizeVertexCache(std::vector<uint32>& indices, size_t numVertices, std::vector<uint32>* pClusters = nullptr, uint32 cacheSize = kVertexCacheSize);
+
+	// ACMR that OptimizeOverdraw may trade for less overdraw, relative to the cache optimized order
+	const float32 kOverdrawThreshold = 1.05f;
+
+	// Reorders the clusters from OptimizeVertexCache so that outward facing ones are drawn first,
+	// which reduces overdraw from any view direction. Clusters are first split where doing so
+	// keeps the ACMR within threshold times that of the cache optimized order.
+	void OptimizeOverdraw(std::vector<uint32>& indices, const std::vector<gfx::StaticMesh::Vertex>& vertices, const std::vector<uint32>& clusters, float32 threshold = kOverdrawThreshold, uint32 cacheSize = kVertexCacheSize);
+
+	// Reorders vertices in the order they are first used by the triangles, for fetch locality, and
+	// removes unused vertices.
+	void OptimizeVertexFetch(std::vector<gfx::StaticMesh::Vertex>& vertices, std::vector<uint32>& indices);
+
+	// Runs all of the above
+	void OptimizeMesh(std::vector<gfx::StaticMesh::Vertex>& vertices, std::vector<uint32>& indices);
+
+	// Simplifies a triangle list with quadric error metric edge collapses [Garland and Heckbert 1997]
+	// until at most targetIndexCount indices remain, or no collapse has an error below maxError.
+	// Vertices are collapsed onto existing ones, so the result indexes the same vertices. Errors are
+	// RMS distances from the original surface, in the units of the positions; returns the error of
+	// the result.
+	float32 SimplifyMesh(const std::vector<uint32>& indices, const std::vector<gfx::StaticMesh::Vertex>& vertices, size_t targetIndexCount, float32 maxError, std::vector<uint32>& outIndices);
+
+	// Maximum number of LODs generated per mesh, including the full detail one
+	const uint32 kMaxLods = 4;
+
+	// Mesh LODs are used once their error covers less than this fraction of the screen height
+	const float32 kLodMaxScreenError = 1.f / 1000.f;
+
+	// Builds the index lists of LODs 1 to kMaxLods-1, each simplified to half the triangles of the
+	// previous one and optimized for the vertex cache. Also returns the error of each LOD.
+	void GenerateLods(const std::vector<gfx::StaticMesh::Vertex>& vertices, const std::vector<uint32>& indices, std::vector<std::vector<uint32>>& lodIndices, std::vector<float32>& lodErrors);
+
+	// Merges the submeshes that use the same material and store the same vertex attributes into one,
+	// so that each material is drawn once per mesh. Vertices are concatenated (and quantized to the
+	// merged bounds) and so are the indices of each LOD. Submeshes keep the order of first use.
+	void MergeSubMeshesByMaterial(gfx::StaticMesh& staticMesh);
+
+	// Sets the mesh's LOD screen sizes from the largest error of each LOD over all submeshes (with
+	// lodErrors[0] for the full detail mesh), after dropping trailing LODs that don't remove enough
+	// triangles to be worth switching to.
+	void SetupLods(gfx::StaticMesh& staticMesh, const std::vector<float32>& lodErrors);
+
+	// Describes every setting that affects the meshes built by the functions above, so that the
+	// cooker can tell when cooked meshes are out of date
+	std::string GetSettings();
+
+} // namespace MeshUtil
+
+#endif // _MESH_UTIL_H_
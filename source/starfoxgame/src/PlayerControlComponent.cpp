@@ -69,12 +69,12 @@ void PlayerControlComponent::UpdateMovement(float32 deltaTime)
 {
 	auto& mLocal = GetSceneNode()->ModifyLocalToParent();
 
-	Vector3 vMoveDelta = mLocal.axisZ * m_speed * deltaTime;
+	Vector3 vMoveDelta = mLocal.AxisZ() * m_speed * deltaTime;
 
 	// Move ship in local xy plane, but apply local z movement to anchor (parent)
 		
-	mLocal.trans.x += vMoveDelta.x;
-	mLocal.trans.y += vMoveDelta.y;
+	mLocal.Translation().x += vMoveDelta.x;
+	mLocal.Translation().y += vMoveDelta.y;
 
 	auto pAnchorComponent = GetSceneNode()->GetParent()->GetComponent<AnchorComponent>();
 	pAnchorComponent->Advance(vMoveDelta.z);
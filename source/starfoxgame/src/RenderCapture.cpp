@@ -0,0 +1,472 @@
+#include "RenderCapture.h"
+#include "gs/Platform/GL/GLUtil.h"
+#include "gs/System/BinaryFile.h"
+#include "gs/System/MappedFile.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace
+{
+	enum HeaderFlags
+	{
+		kLighting = 1 << 0,
+		kWireframe = 1 << 1
+	};
+
+	struct Header
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 fileSize;
+		int32 viewport[4];
+		float32 projection[16];
+		float32 modelView[16];
+		float32 clearColor[4];
+		float32 lightPosition[4];
+		uint32 flags; // HeaderFlags
+		int32 boundTexture;
+		uint32 numCommands;
+		uint32 numMaterials;
+		uint32 numDraws;
+		uint32 numVertexBuffers;
+		uint32 numIndexBuffers;
+		uint32 numTextures;
+		uint32 commandsOffset;
+		uint32 materialsOffset;
+		uint32 drawsOffset;
+		uint32 vertexBuffersOffset;
+		uint32 indexBuffersOffset;
+		uint32 texturesOffset;
+	};
+
+	struct CommandRecord
+	{
+		uint32 type; // RenderCommandType::Type
+		int32 arg;
+	};
+
+	struct DrawRecord
+	{
+		float32 modelToWorld[4][3];
+		uint32 hasTransform;
+		uint32 vertexBuffer;
+		uint32 indexBuffer;
+		uint32 numIndices;
+	};
+
+	struct VertexBufferRecord
+	{
+		uint32 formats[VertexAttribute::NumTypes]; // VertexAttributeFormat::Type
+		uint32 offsets[VertexAttribute::NumTypes];
+		uint32 stride;
+		float32 positionOffset[3];
+		float32 positionScale[3];
+		uint32 numVertices;
+		uint32 dataOffset;
+	};
+
+	struct BufferRecord
+	{
+		uint32 count;
+		uint32 elementSize; // 2 or 4 bytes
+		uint32 dataOffset;
+	};
+
+	struct TextureRecord
+	{
+		int32 textureId;
+		int32 width;
+		int32 height;
+		uint32 dataOffset;
+	};
+
+	static_assert(sizeof(Header) == 244, "Header layout changed, bump kVersion");
+	static_assert(sizeof(CommandRecord) == 8, "CommandRecord layout changed, bump kVersion");
+	static_assert(sizeof(RenderMaterial) == 68, "RenderMaterial layout changed, bump kVersion");
+	static_assert(sizeof(DrawRecord) == 64, "DrawRecord layout changed, bump kVersion");
+	static_assert(sizeof(VertexBufferRecord) == 68, "VertexBufferRecord layout changed, bump kVersion");
+	static_assert(sizeof(BufferRecord) == 12, "BufferRecord layout changed, bump kVersion");
+	static_assert(sizeof(TextureRecord) == 16, "TextureRecord layout changed, bump kVersion");
+
+	const uint32 kDataAlignment = 16;
+
+	// Returns the largest of the first numIndices indices, or 0 if there are none
+	template <typename IndexType>
+	uint32 GetMaxIndex(const void* pIndices, uint32 numIndices)
+	{
+		const IndexType* pTypedIndices = static_cast<const IndexType*>(pIndices);
+		uint32 maxIndex = 0;
+		for (uint32 i = 0; i < numIndices; ++i)
+			maxIndex = std::max<uint32>(maxIndex, pTypedIndices[i]);
+		return maxIndex;
+	}
+
+	// Index buffer referenced by draws, which may draw fewer indices than it has
+	struct IndexBufferInfo
+	{
+		uint32 index;
+		uint32 numIndices; // The most that any draw uses
+		bool b32BitIndices;
+	};
+}
+
+RenderCapture::ViewState RenderCapture::ViewState::Get()
+{
+	ViewState viewState;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	for (int i = 0; i < 4; ++i)
+		viewState.viewport[i] = viewport[i];
+
+	glGetFloatv(GL_PROJECTION_MATRIX, viewState.projection);
+	glGetFloatv(GL_MODELVIEW_MATRIX, viewState.modelView);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, viewState.clearColor);
+	glGetLightfv(GL_LIGHT0, GL_POSITION, viewState.lightPosition);
+	viewState.bLighting = GLUtil::GetLighting();
+
+	GLint polygonMode[2];
+	glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+	viewState.bWireframe = polygonMode[0] == GL_LINE;
+
+	GLint boundTexture;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+	viewState.boundTexture = boundTexture;
+
+	return viewState;
+}
+
+void RenderCapture::ViewState::Apply() const
+{
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+	GLUtil::MatrixMode(MatrixMode::Projection, false);
+	glLoadMatrixf(projection);
+
+	// The light position is in eye space, so it's set with an identity model view matrix
+	GLUtil::MatrixMode(MatrixMode::ModelView);
+	glLightfv(GL_LIGHT0, GL_POSITION, lightPosition);
+	glLoadMatrixf(modelView);
+
+	GLUtil::SetLighting(bLighting);
+	GLUtil::SetWireFrame(bWireframe);
+	GLUtil::SelectTexture(boundTexture);
+	ASSERT_NO_GL_ERROR();
+}
+
+void RenderCapture::Save(const RenderCommandList& commands, const char* pFileName)
+{
+	const ViewState viewState = ViewState::Get();
+
+	std::map<const void*, uint32> vertexBufferIndices;
+	std::vector<const RenderDraw*> vertexBuffers; // The first draw of each buffer
+	std::map<const void*, IndexBufferInfo> indexBufferInfos;
+	std::vector<const void*> indexBuffers;
+	for (const RenderDraw& draw : commands.draws)
+	{
+		if (vertexBufferIndices.insert(std::make_pair(draw.pVertexData, static_cast<uint32>(vertexBuffers.size()))).second)
+			vertexBuffers.push_back(&draw);
+
+		const IndexBufferInfo info = { static_cast<uint32>(indexBuffers.size()), draw.numIndices, draw.b32BitIndices };
+		auto result = indexBufferInfos.insert(std::make_pair(draw.pIndices, info));
+		if (result.second)
+			indexBuffers.push_back(draw.pIndices);
+		else
+			result.first->second.numIndices = std::max(result.first->second.numIndices, draw.numIndices);
+	}
+
+	std::set<TextureId> textureIds;
+	if (viewState.boundTexture > 0)
+		textureIds.insert(viewState.boundTexture);
+	for (const RenderCommand& command : commands.commands)
+	{
+		if (command.type == RenderCommandType::SelectTexture && command.arg > 0)
+			textureIds.insert(command.arg);
+	}
+
+	BinaryFile::Writer writer;
+
+	Header header = {};
+	header.magic = kMagic;
+	header.version = kVersion;
+	memcpy(header.viewport, viewState.viewport, sizeof(header.viewport));
+	memcpy(header.projection, viewState.projection, sizeof(header.projection));
+	memcpy(header.modelView, viewState.modelView, sizeof(header.modelView));
+	memcpy(header.clearColor, viewState.clearColor, sizeof(header.clearColor));
+	memcpy(header.lightPosition, viewState.lightPosition, sizeof(header.lightPosition));
+	header.flags = (viewState.bLighting? kLighting : 0) | (viewState.bWireframe? kWireframe : 0);
+	header.boundTexture = viewState.boundTexture;
+	header.numCommands = static_cast<uint32>(commands.commands.size());
+	header.numMaterials = static_cast<uint32>(commands.materials.size());
+	header.numDraws = static_cast<uint32>(commands.draws.size());
+	header.numVertexBuffers = static_cast<uint32>(vertexBuffers.size());
+	header.numIndexBuffers = static_cast<uint32>(indexBuffers.size());
+	header.numTextures = static_cast<uint32>(textureIds.size());
+	writer.Write(&header, sizeof(header));
+
+	// Tables, with offsets to data filled in below
+	const uint32 commandsOffset = writer.GetSize();
+	for (const RenderCommand& command : commands.commands)
+	{
+		const CommandRecord record = { static_cast<uint32>(command.type), command.arg };
+		writer.Write(&record, sizeof(record));
+	}
+
+	const uint32 materialsOffset = writer.GetSize();
+	if (!commands.materials.empty())
+		writer.Write(commands.materials.data(), commands.materials.size() * sizeof(RenderMaterial));
+
+	const uint32 drawsOffset = writer.GetSize();
+	for (const RenderDraw& draw : commands.draws)
+	{
+		DrawRecord record = {};
+		const Matrix43 mModelToWorld = draw.bHasTransform? draw.mModelToWorld : Matrix43::Identity();
+		memcpy(record.modelToWorld, mModelToWorld.m, sizeof(record.modelToWorld));
+		record.hasTransform = draw.bHasTransform? 1 : 0;
+		record.vertexBuffer = vertexBufferIndices[draw.pVertexData];
+		record.indexBuffer = indexBufferInfos[draw.pIndices].index;
+		record.numIndices = draw.numIndices;
+		writer.Write(&record, sizeof(record));
+	}
+
+	const uint32 vertexBuffersOffset = writer.GetSize();
+	for (const RenderDraw* pDraw : vertexBuffers)
+	{
+		VertexBufferRecord record = {};
+		const VertexLayout& layout = *pDraw->pVertexLayout;
+		for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+		{
+			record.formats[i] = static_cast<uint32>(layout.formats[i]);
+			record.offsets[i] = layout.offsets[i];
+		}
+		record.stride = layout.stride;
+		memcpy(record.positionOffset, layout.positionOffset.v, sizeof(record.positionOffset));
+		memcpy(record.positionScale, layout.positionScale.v, sizeof(record.positionScale));
+		record.numVertices = pDraw->numVertices;
+		writer.Write(&record, sizeof(record));
+	}
+
+	const uint32 indexBuffersOffset = writer.GetSize();
+	for (const void* pIndices : indexBuffers)
+	{
+		const IndexBufferInfo& info = indexBufferInfos[pIndices];
+		const BufferRecord record = { info.numIndices, static_cast<uint32>(info.b32BitIndices? sizeof(uint32) : sizeof(uint16)), 0 };
+		writer.Write(&record, sizeof(record));
+	}
+
+	const uint32 texturesOffset = writer.GetSize();
+	std::vector<std::vector<uint8>> texels;
+	for (TextureId textureId : textureIds)
+	{
+		GLUtil::SelectTexture(textureId);
+
+		TextureRecord record = {};
+		record.textureId = textureId;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &record.width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &record.height);
+		writer.Write(&record, sizeof(record));
+
+		texels.emplace_back(record.width * record.height * 4);
+		if (!texels.back().empty())
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.back().data());
+	}
+	GLUtil::SelectTexture(viewState.boundTexture);
+	ASSERT_NO_GL_ERROR();
+
+	// Data blobs
+	for (size_t i = 0; i < vertexBuffers.size(); ++i)
+	{
+		const RenderDraw& draw = *vertexBuffers[i];
+
+		writer.Align(kDataAlignment);
+		const uint32 dataOffset = writer.Write(draw.pVertexData, draw.numVertices * draw.pVertexLayout->stride);
+		writer.At<VertexBufferRecord>(vertexBuffersOffset + static_cast<uint32>(i * sizeof(VertexBufferRecord))).dataOffset = dataOffset;
+	}
+
+	for (size_t i = 0; i < indexBuffers.size(); ++i)
+	{
+		BufferRecord& record = writer.At<BufferRecord>(indexBuffersOffset + static_cast<uint32>(i * sizeof(BufferRecord)));
+		const size_t size = record.count * record.elementSize;
+
+		writer.Align(kDataAlignment);
+		const uint32 dataOffset = writer.Write(indexBuffers[i], size);
+		writer.At<BufferRecord>(indexBuffersOffset + static_cast<uint32>(i * sizeof(BufferRecord))).dataOffset = dataOffset;
+	}
+
+	for (size_t i = 0; i < texels.size(); ++i)
+	{
+		writer.Align(kDataAlignment);
+		const uint32 dataOffset = writer.Write(texels[i].data(), texels[i].size());
+		writer.At<TextureRecord>(texturesOffset + static_cast<uint32>(i * sizeof(TextureRecord))).dataOffset = dataOffset;
+	}
+	writer.Align(kDataAlignment);
+
+	Header& finalHeader = writer.At<Header>(0);
+	finalHeader.fileSize = writer.GetSize();
+	finalHeader.commandsOffset = commandsOffset;
+	finalHeader.materialsOffset = materialsOffset;
+	finalHeader.drawsOffset = drawsOffset;
+	finalHeader.vertexBuffersOffset = vertexBuffersOffset;
+	finalHeader.indexBuffersOffset = indexBuffersOffset;
+	finalHeader.texturesOffset = texturesOffset;
+
+	FILE* pFile = fopen(pFileName, "wb");
+	if (!pFile)
+		throw std::runtime_error("RenderCapture::Save: failed to open file for writing");
+
+	const bool bWritten = fwrite(writer.GetData(), 1, writer.GetSize(), pFile) == writer.GetSize();
+	fclose(pFile);
+	if (!bWritten)
+		throw std::runtime_error("RenderCapture::Save: failed to write file");
+}
+
+std::unique_ptr<RenderCapture::Frame> RenderCapture::Load(const char* pFileName)
+{
+	std::shared_ptr<MappedFile> pFile = MappedFile::Open(pFileName);
+	if (!pFile || pFile->GetSize() < sizeof(Header))
+		return nullptr;
+
+	const uint8* pData = pFile->GetData();
+	const uint64 fileSize = pFile->GetSize();
+
+	const Header& header = *reinterpret_cast<const Header*>(pData);
+	if (header.magic != kMagic || header.version != kVersion || header.fileSize != fileSize)
+		return nullptr;
+
+	if (!BinaryFile::InFile(header.commandsOffset, (uint64)header.numCommands * sizeof(CommandRecord), fileSize) ||
+		!BinaryFile::InFile(header.materialsOffset, (uint64)header.numMaterials * sizeof(RenderMaterial), fileSize) ||
+		!BinaryFile::InFile(header.drawsOffset, (uint64)header.numDraws * sizeof(DrawRecord), fileSize) ||
+		!BinaryFile::InFile(header.vertexBuffersOffset, (uint64)header.numVertexBuffers * sizeof(VertexBufferRecord), fileSize) ||
+		!BinaryFile::InFile(header.indexBuffersOffset, (uint64)header.numIndexBuffers * sizeof(BufferRecord), fileSize) ||
+		!BinaryFile::InFile(header.texturesOffset, (uint64)header.numTextures * sizeof(TextureRecord), fileSize))
+	{
+		return nullptr;
+	}
+
+	std::unique_ptr<Frame> pFrame(new Frame);
+	Frame& frame = *pFrame;
+
+	ViewState& viewState = frame.viewState;
+	memcpy(viewState.viewport, header.viewport, sizeof(viewState.viewport));
+	memcpy(viewState.projection, header.projection, sizeof(viewState.projection));
+	memcpy(viewState.modelView, header.modelView, sizeof(viewState.modelView));
+	memcpy(viewState.clearColor, header.clearColor, sizeof(viewState.clearColor));
+	memcpy(viewState.lightPosition, header.lightPosition, sizeof(viewState.lightPosition));
+	viewState.bLighting = (header.flags & kLighting) != 0;
+	viewState.bWireframe = (header.flags & kWireframe) != 0;
+	viewState.boundTexture = header.boundTexture;
+
+	const VertexBufferRecord* pVertexBufferRecords = reinterpret_cast<const VertexBufferRecord*>(pData + header.vertexBuffersOffset);
+	for (uint32 i = 0; i < header.numVertexBuffers; ++i)
+	{
+		const VertexBufferRecord& record = pVertexBufferRecords[i];
+
+		VertexBuffer vertexBuffer;
+		VertexLayout& layout = vertexBuffer.layout;
+		for (int a = 0; a < VertexAttribute::NumTypes; ++a)
+		{
+			layout.formats[a] = static_cast<VertexAttributeFormat::Type>(record.formats[a]);
+			layout.offsets[a] = record.offsets[a];
+		}
+		layout.stride = record.stride;
+		layout.positionOffset = Vector3(record.positionOffset[0], record.positionOffset[1], record.positionOffset[2]);
+		layout.positionScale = Vector3(record.positionScale[0], record.positionScale[1], record.positionScale[2]);
+
+		const uint64 dataSize = (uint64)record.numVertices * record.stride;
+		if (!layout.IsValid() || !BinaryFile::InFile(record.dataOffset, dataSize, fileSize))
+			return nullptr;
+
+		vertexBuffer.numVertices = record.numVertices;
+		vertexBuffer.data.assign(pData + record.dataOffset, pData + record.dataOffset + dataSize);
+		frame.vertexBuffers.push_back(std::move(vertexBuffer));
+	}
+
+	const BufferRecord* pIndexBufferRecords = reinterpret_cast<const BufferRecord*>(pData + header.indexBuffersOffset);
+	for (uint32 i = 0; i < header.numIndexBuffers; ++i)
+	{
+		const BufferRecord& record = pIndexBufferRecords[i];
+		if ((record.elementSize != sizeof(uint16) && record.elementSize != sizeof(uint32)) ||
+			!BinaryFile::InFile(record.dataOffset, (uint64)record.count * record.elementSize, fileSize))
+		{
+			return nullptr;
+		}
+
+		const uint8* pIndexData = pData + record.dataOffset;
+		frame.indexBuffers.emplace_back(pIndexData, pIndexData + record.count * record.elementSize);
+	}
+
+	const TextureRecord* pTextureRecords = reinterpret_cast<const TextureRecord*>(pData + header.texturesOffset);
+	for (uint32 i = 0; i < header.numTextures; ++i)
+	{
+		const TextureRecord& record = pTextureRecords[i];
+		if (record.width < 0 || record.height < 0 || !BinaryFile::InFile(record.dataOffset, (uint64)record.width * record.height * 4, fileSize))
+			return nullptr;
+
+		Texture texture;
+		texture.textureId = record.textureId;
+		texture.width = record.width;
+		texture.height = record.height;
+		texture.texels.assign(pData + record.dataOffset, pData + record.dataOffset + record.width * record.height * 4);
+		frame.textures.push_back(std::move(texture));
+	}
+
+	RenderCommandList& commandList = frame.commands;
+	const RenderMaterial* pMaterials = reinterpret_cast<const RenderMaterial*>(pData + header.materialsOffset);
+	commandList.materials.assign(pMaterials, pMaterials + header.numMaterials);
+
+	const DrawRecord* pDrawRecords = reinterpret_cast<const DrawRecord*>(pData + header.drawsOffset);
+	for (uint32 i = 0; i < header.numDraws; ++i)
+	{
+		const DrawRecord& record = pDrawRecords[i];
+		if (record.vertexBuffer >= header.numVertexBuffers || frame.vertexBuffers[record.vertexBuffer].numVertices == 0 ||
+			record.indexBuffer >= header.numIndexBuffers || record.numIndices > pIndexBufferRecords[record.indexBuffer].count ||
+			record.numIndices % 3 != 0)
+		{
+			return nullptr;
+		}
+
+		RenderDraw draw;
+		draw.bHasTransform = record.hasTransform != 0;
+		memcpy(draw.mModelToWorld.m, record.modelToWorld, sizeof(record.modelToWorld));
+		const VertexBuffer& vertexBuffer = frame.vertexBuffers[record.vertexBuffer];
+		draw.pVertexLayout = &vertexBuffer.layout;
+		draw.pVertexData = vertexBuffer.data.data();
+		draw.numVertices = vertexBuffer.numVertices;
+		draw.pIndices = frame.indexBuffers[record.indexBuffer].data();
+		draw.numIndices = record.numIndices;
+		draw.b32BitIndices = pIndexBufferRecords[record.indexBuffer].elementSize == sizeof(uint32);
+
+		// Every index the draw uses must be in its vertex buffer
+		const uint32 maxIndex = draw.b32BitIndices? GetMaxIndex<uint32>(draw.pIndices, draw.numIndices) : GetMaxIndex<uint16>(draw.pIndices, draw.numIndices);
+		if (maxIndex >= draw.numVertices)
+			return nullptr;
+
+		commandList.draws.push_back(draw);
+		commandList.numTriangles += draw.numIndices / 3;
+	}
+
+	const CommandRecord* pCommandRecords = reinterpret_cast<const CommandRecord*>(pData + header.commandsOffset);
+	for (uint32 i = 0; i < header.numCommands; ++i)
+	{
+		const CommandRecord& record = pCommandRecords[i];
+		const bool bValid =
+			(record.type == RenderCommandType::SetMaterial && static_cast<uint32>(record.arg) < header.numMaterials) ||
+			(record.type == RenderCommandType::DrawTriangles && static_cast<uint32>(record.arg) < header.numDraws) ||
+			record.type == RenderCommandType::SetTexturing ||
+			record.type == RenderCommandType::SelectTexture ||
+			record.type == RenderCommandType::SetBlending;
+		if (!bValid)
+			return nullptr;
+
+		const RenderCommand command = { static_cast<RenderCommandType::Type>(record.type), record.arg };
+		commandList.commands.push_back(command);
+	}
+
+	return pFrame;
+}
@@ -0,0 +1,90 @@
+#ifndef _RENDER_CAPTURE_H_
+#define _RENDER_CAPTURE_H_
+
+// Render capture file (.sfcap): the render commands of one frame, along with everything needed to
+// execute them again without the game: the view state they were executed in, and the vertex, index
+// and texture data they reference. Captures are replayed by starfox_replay (see
+// replay/ReplayMain.cpp) to benchmark rendering in isolation from the simulation, and to compare
+// backends on the same workload.
+//
+// Layout (native endianness, offsets are from the start of the file):
+//
+//   Header
+//   CommandRecord[numCommands]
+//   RenderMaterial[numMaterials]
+//   DrawRecord[numDraws]
+//   VertexBufferRecord[numVertexBuffers], BufferRecord[numIndexBuffers]
+//   TextureRecord[numTextures]
+//   Vertex, index and texel data, referenced by the buffer and texture records
+//
+// Each buffer is saved once, however many draws reference it. Vertices are saved packed, as they
+// were drawn, with their layout (see VertexFormat.h), and texels as RGBA8. The headless null
+// renderer doesn't keep texels, so its captures have white textures of the right size.
+
+#include "RenderCommands.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace RenderCapture
+{
+	const char kExtension[] = "sfcap";
+
+	const uint32 kMagic = 'S' | ('F' << 8) | ('C' << 16) | ('P' << 24);
+	const uint32 kVersion = 2; // Bump when the layout or any encoding changes
+
+	// GL state that the commands are executed in, besides the fixed state that the game sets up
+	// once at startup
+	struct ViewState
+	{
+		// Reads the current GL state
+		static ViewState Get();
+
+		// Sets the GL state, leaving the model view matrix current
+		void Apply() const;
+
+		int32 viewport[4];
+		float32 projection[16];
+		float32 modelView[16];
+		float32 clearColor[4];
+		float32 lightPosition[4]; // GL_LIGHT0, in eye space
+		bool bLighting;
+		bool bWireframe;
+		TextureId boundTexture; // Before the first command
+	};
+
+	struct Texture
+	{
+		TextureId textureId; // When it was captured
+		int32 width;
+		int32 height;
+		std::vector<uint8> texels; // RGBA8
+	};
+
+	struct VertexBuffer
+	{
+		VertexLayout layout;
+		uint32 numVertices;
+		std::vector<uint8> data; // Packed with layout
+	};
+
+	// A loaded capture, which owns the data that its commands reference
+	struct Frame
+	{
+		ViewState viewState;
+		RenderCommandList commands;
+		std::vector<Texture> textures;
+		std::deque<VertexBuffer> vertexBuffers;
+		std::deque<std::vector<uint8>> indexBuffers;
+	};
+
+	// Saves commands with the current view state, reading textures back from GL. Call it right
+	// before executing the commands. Throws std::exception if the file can't be written.
+	void Save(const RenderCommandList& commands, const char* pFileName);
+
+	// Returns nullptr if the file doesn't exist, is invalid, or was saved with a different version
+	std::unique_ptr<Frame> Load(const char* pFileName);
+
+} // namespace RenderCapture
+
+#endif // _RENDER_CAPTURE_H_
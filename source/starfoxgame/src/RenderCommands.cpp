@@ -0,0 +1,187 @@
+#include "RenderCommands.h"
+#include "gs/Platform/GL/GLUtil.h"
+#include <cassert>
+
+namespace
+{
+	// Scratch space for the attributes of a draw that GL can't read packed, reused by every draw.
+	// Only used by the thread that owns the GL context.
+	std::vector<float32> g_decodedVertices;
+
+	void DrawElements(const RenderDraw& draw)
+	{
+		if (draw.bHasTransform)
+			GLUtil::PushAndMultMatrix(draw.mModelToWorld);
+
+		// GL reads float attributes and byte colors straight from the packed vertices. Quantized
+		// positions, octahedral normals and half texture coordinates have no fixed function GL
+		// equivalent, so they're decoded first, into 3 + 3 + 2 floats per vertex.
+		const VertexLayout& layout = *draw.pVertexLayout;
+		const uint8* pVertexData = static_cast<const uint8*>(draw.pVertexData);
+		const GLsizei decodedStride = 8 * sizeof(float32);
+
+		VertexStreams decodeStreams;
+		decodeStreams.stride = decodedStride;
+		g_decodedVertices.resize(draw.numVertices * 8);
+		if (layout.formats[VertexAttribute::Position] != VertexAttributeFormat::Float3)
+			decodeStreams.position = &g_decodedVertices[0];
+		if (layout.formats[VertexAttribute::Normal] == VertexAttributeFormat::OctSNorm16x2)
+			decodeStreams.normal = &g_decodedVertices[3];
+		if (layout.formats[VertexAttribute::TexCoord] == VertexAttributeFormat::Half2)
+			decodeStreams.texCoord = &g_decodedVertices[6];
+		if (decodeStreams.position || decodeStreams.normal || decodeStreams.texCoord)
+			UnpackVertices(layout, pVertexData, draw.numVertices, decodeStreams);
+
+		const GLsizei stride = layout.stride;
+		const uint8* pAttributes[VertexAttribute::NumTypes];
+		for (int i = 0; i < VertexAttribute::NumTypes; ++i)
+			pAttributes[i] = pVertexData + layout.offsets[i];
+
+		glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+		glEnableClientState(GL_VERTEX_ARRAY);
+		if (decodeStreams.position)
+			glVertexPointer(3, GL_FLOAT, decodedStride, decodeStreams.position);
+		else
+			glVertexPointer(3, GL_FLOAT, stride, pAttributes[VertexAttribute::Position]);
+
+		// Attributes that aren't stored take the Vertex default values
+		if (layout.Has(VertexAttribute::Normal))
+		{
+			glEnableClientState(GL_NORMAL_ARRAY);
+			if (decodeStreams.normal)
+				glNormalPointer(GL_FLOAT, decodedStride, decodeStreams.normal);
+			else
+				glNormalPointer(GL_FLOAT, stride, pAttributes[VertexAttribute::Normal]);
+		}
+		else
+		{
+			glNormal3f(0.f, 0.f, 0.f);
+		}
+
+		if (layout.Has(VertexAttribute::Color))
+		{
+			glEnableClientState(GL_COLOR_ARRAY);
+			glColorPointer(4, GL_UNSIGNED_BYTE, stride, pAttributes[VertexAttribute::Color]);
+		}
+		else
+		{
+			glColor4f(1.f, 1.f, 1.f, 1.f);
+		}
+
+		if (layout.Has(VertexAttribute::TexCoord))
+		{
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			if (decodeStreams.texCoord)
+				glTexCoordPointer(2, GL_FLOAT, decodedStride, decodeStreams.texCoord);
+			else
+				glTexCoordPointer(2, GL_FLOAT, stride, pAttributes[VertexAttribute::TexCoord]);
+		}
+		else
+		{
+			glTexCoord2f(0.f, 0.f);
+		}
+
+		glDrawElements(GL_TRIANGLES, (GLsizei)draw.numIndices, draw.b32BitIndices? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, draw.pIndices);
+
+		glPopClientAttrib();
+		ASSERT_NO_GL_ERROR();
+
+		if (draw.bHasTransform)
+			glPopMatrix();
+	}
+
+	void CopyColor(float32 dst[4], const gfx::Color4& src)
+	{
+		for (int i = 0; i < 4; ++i)
+			dst[i] = src.v[i];
+	}
+}
+
+void RenderCommandList::Clear()
+{
+	commands.clear();
+	materials.clear();
+	draws.clear();
+	numTriangles = 0;
+}
+
+void RenderCommandList::SetMaterial(const gfx::Material& material)
+{
+	RenderMaterial renderMaterial;
+	CopyColor(renderMaterial.ambient, material.m_ambient);
+	CopyColor(renderMaterial.diffuse, material.m_diffuse);
+	CopyColor(renderMaterial.specular, material.m_specular);
+	CopyColor(renderMaterial.emissive, material.m_emmissive);
+	renderMaterial.shininess = material.m_shininess;
+
+	RenderCommand command = { RenderCommandType::SetMaterial, static_cast<int32>(materials.size()) };
+	commands.push_back(command);
+	materials.push_back(renderMaterial);
+}
+
+void RenderCommandList::SetTexturing(bool bEnable)
+{
+	RenderCommand command = { RenderCommandType::SetTexturing, bEnable? 1 : 0 };
+	commands.push_back(command);
+}
+
+void RenderCommandList::SelectTexture(TextureId textureId)
+{
+	RenderCommand command = { RenderCommandType::SelectTexture, textureId };
+	commands.push_back(command);
+}
+
+void RenderCommandList::SetBlending(bool bEnable)
+{
+	RenderCommand command = { RenderCommandType::SetBlending, bEnable? 1 : 0 };
+	commands.push_back(command);
+}
+
+void RenderCommandList::DrawTriangles(const RenderDraw& draw)
+{
+	if (draw.numIndices == 0)
+		return;
+
+	assert(draw.pVertexLayout && draw.pVertexData && draw.numVertices > 0 && draw.pIndices);
+	RenderCommand command = { RenderCommandType::DrawTriangles, static_cast<int32>(draws.size()) };
+	commands.push_back(command);
+	draws.push_back(draw);
+	numTriangles += draw.numIndices / 3;
+}
+
+void RenderCommandList::Execute() const
+{
+	for (const RenderCommand& command : commands)
+	{
+		switch (command.type)
+		{
+		case RenderCommandType::SetMaterial:
+			{
+				const RenderMaterial& material = materials[command.arg];
+				GLUtil::SetMaterial(material.ambient, material.diffuse, material.specular, material.emissive, material.shininess);
+			}
+			break;
+
+		case RenderCommandType::SetTexturing:
+			GLUtil::SetTexturing(command.arg != 0);
+			break;
+
+		case RenderCommandType::SelectTexture:
+			GLUtil::SelectTexture(command.arg);
+			break;
+
+		case RenderCommandType::SetBlending:
+			GLUtil::SetBlending(command.arg != 0);
+			glDepthMask(command.arg != 0? GL_FALSE : GL_TRUE);
+			break;
+
+		case RenderCommandType::DrawTriangles:
+			DrawElements(draws[command.arg]);
+			break;
+
+		default:
+			assert(false && "Unknown render command");
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef _RENDER_COMMANDS_H_
+#define _RENDER_COMMANDS_H_
+
+#include "gs/Base/Base.h"
+#include "StaticMesh.h"
+#include <vector>
+
+namespace RenderCommandType
+{
+	enum Type
+	{
+		SetMaterial,	// arg: index into RenderCommandList::materials
+		SetTexturing,	// arg: 0 or 1
+		SelectTexture,	// arg: TextureId
+		SetBlending,	// arg: 0 or 1; depth isn't written while blending
+		DrawTriangles,	// arg: index into RenderCommandList::draws
+
+		NumTypes
+	};
+}
+
+struct RenderCommand
+{
+	RenderCommandType::Type type;
+	int32 arg;
+};
+
+// Front face material parameters, copied from a gfx::Material when the command is recorded
+struct RenderMaterial
+{
+	float32 ambient[4];
+	float32 diffuse[4];
+	float32 specular[4];
+	float32 emissive[4];
+	float32 shininess;
+};
+
+// Indexed triangle list, drawn in the current model view space. The vertex and index data must
+// stay valid until the list is executed.
+struct RenderDraw
+{
+	bool bHasTransform; // If false, vertices are in model view space
+	Matrix43 mModelToWorld;
+	const VertexLayout* pVertexLayout;
+	const void* pVertexData; // numVertices vertices, packed with *pVertexLayout (see VertexFormat.h)
+	uint32 numVertices;
+	const void* pIndices;
+	uint32 numIndices;
+	bool b32BitIndices;
+};
+
+// The GL state changes and draw calls of a frame, recorded by the RenderQueue and executed in
+// order. Recording commands instead of making the calls right away separates what a frame draws
+// from drawing it, so that lists can be captured to a file and replayed (see RenderCapture.h).
+struct RenderCommandList
+{
+	RenderCommandList() : numTriangles(0) {}
+
+	void Clear();
+
+	void SetMaterial(const gfx::Material& material);
+	void SetTexturing(bool bEnable);
+	void SelectTexture(TextureId textureId);
+	void SetBlending(bool bEnable);
+	void DrawTriangles(const RenderDraw& draw); // Ignored if there are no indices
+
+	// Makes the GL calls
+	void Execute() const;
+
+	std::vector<RenderCommand> commands;
+	std::vector<RenderMaterial> materials;
+	std::vector<RenderDraw> draws;
+	uint32 numTriangles;
+};
+
+#endif // _RENDER_COMMANDS_H_
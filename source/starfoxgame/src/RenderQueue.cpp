@@ -0,0 +1,355 @@
+#include "RenderQueue.h"
+#include "AssetManager.h"
+#include "RenderCapture.h"
+#include "gs/Platform/GL/GLUtil.h"
+#include "gs/Math/MathEx.h"
+#include "gs/System/JobSystem.h"
+#include "gs/System/Profiler.h"
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+	const uint32 kPassBits = 2;
+	const uint32 kMaterialBits = 20;
+	const uint32 kTextureBits = 20;
+	const uint32 kDepthBits = 21;
+
+	static_assert(1 + kPassBits + kMaterialBits + kTextureBits + kDepthBits == 64, "Sort key must use 64 bits");
+	static_assert(RenderPass::NumTypes <= (1 << kPassBits), "Too many passes for the sort key");
+
+	uint64 MaskBits(uint64 value, uint32 numBits)
+	{
+		return value & ((1ull << numBits) - 1);
+	}
+
+	// Sorts order by keys[order[i]] with an LSD radix sort on bytes, which is linear in the number
+	// of keys. Passes over bytes that are the same in every key are skipped. temp is scratch space,
+	// passed in so that its memory can be reused.
+	void RadixSort(const std::vector<uint64>& keys, std::vector<uint32>& order, std::vector<uint32>& temp)
+	{
+		const size_t count = keys.size();
+		order.resize(count);
+		for (size_t i = 0; i < count; ++i)
+			order[i] = static_cast<uint32>(i);
+
+		temp.resize(count);
+		for (uint32 shift = 0; shift < 64; shift += 8)
+		{
+			size_t offsets[256] = {};
+			for (size_t i = 0; i < count; ++i)
+				++offsets[(keys[i] >> shift) & 0xFF];
+
+			if (count == 0 || offsets[(keys[0] >> shift) & 0xFF] == count)
+				continue;
+
+			size_t offset = 0;
+			for (size_t& bucketOffset : offsets)
+			{
+				const size_t bucketCount = bucketOffset;
+				bucketOffset = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				temp[offsets[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+			order.swap(temp);
+		}
+	}
+
+	// GL state that the backend sets, tracked to skip redundant changes
+	struct RenderState
+	{
+		explicit RenderState(bool bTexturingAllowed)
+			: pMaterial(nullptr)
+			, textureId(INVALID_TEXTURE_ID)
+			, bTexturing(bTexturingAllowed)
+			, bBlending(false)
+			, bTexturingAllowed(bTexturingAllowed)
+		{}
+
+		// Returns the number of state changes needed to draw packet, and records them into
+		// pCommands if it's not null
+		uint32 Set(const DrawPacket& packet, TextureId packetTextureId, RenderCommandList* pCommands)
+		{
+			uint32 numChanges = 0;
+
+			if (packet.pMaterial && packet.pMaterial != pMaterial)
+			{
+				pMaterial = packet.pMaterial;
+				++numChanges;
+				if (pCommands)
+					pCommands->SetMaterial(*pMaterial);
+			}
+
+			// Materials without a texture are drawn untextured, while packets without a material
+			// keep the current texture
+			if (packet.pMaterial)
+			{
+				const bool bPacketTexturing = bTexturingAllowed && packetTextureId != INVALID_TEXTURE_ID;
+				if (bPacketTexturing != bTexturing)
+				{
+					bTexturing = bPacketTexturing;
+					++numChanges;
+					if (pCommands)
+						pCommands->SetTexturing(bTexturing);
+				}
+
+				if (packetTextureId != INVALID_TEXTURE_ID && packetTextureId != textureId)
+				{
+					textureId = packetTextureId;
+					++numChanges;
+					if (pCommands)
+						pCommands->SelectTexture(textureId);
+				}
+			}
+
+			if (packet.bTranslucent != bBlending)
+			{
+				bBlending = packet.bTranslucent;
+				++numChanges;
+				if (pCommands)
+					pCommands->SetBlending(bBlending);
+			}
+
+			return numChanges;
+		}
+
+		// Restores the state the frame started with
+		void Reset(RenderCommandList& commands)
+		{
+			commands.SetTexturing(bTexturingAllowed);
+			commands.SetBlending(false);
+		}
+
+		const gfx::Material* pMaterial;
+		TextureId textureId;
+		bool bTexturing;
+		bool bBlending;
+		const bool bTexturingAllowed; // Texturing can be turned off for the whole frame
+	};
+
+	RenderDraw MakeDraw(const DrawPacket& packet)
+	{
+		RenderDraw draw;
+		draw.bHasTransform = packet.bHasTransform;
+		draw.mModelToWorld = packet.mModelToWorld;
+		draw.pVertexLayout = packet.pVertexLayout;
+		draw.pVertexData = packet.pVertexData;
+		draw.numVertices = packet.numVertices;
+		draw.pIndices = packet.pIndices;
+		draw.numIndices = packet.numIndices;
+		draw.b32BitIndices = packet.b32BitIndices;
+		return draw;
+	}
+}
+
+thread_local RenderQueue::SubmitBuffer* RenderQueue::ms_pJobSubmitBuffer = nullptr;
+
+RenderQueue::RenderQueue()
+	: m_pFrame(nullptr)
+{
+}
+
+void RenderQueue::Begin(Frame& frame, const Vector3& cameraPosition, float32 maxDepth)
+{
+	assert(!m_pFrame && "Previous frame wasn't ended");
+	assert(frame.m_numSubmitBuffersUsed == 0 && "Frame wasn't flushed");
+	assert(maxDepth > 0.f);
+
+	m_pFrame = &frame;
+	frame.m_cameraPosition = cameraPosition;
+	frame.m_maxDepth = maxDepth;
+}
+
+void RenderQueue::End()
+{
+	assert(m_pFrame && "Frame wasn't begun");
+	m_pFrame = nullptr;
+}
+
+RenderQueue::SubmitBuffer& RenderQueue::AcquireSubmitBuffer(bool bParallel)
+{
+	assert(m_pFrame && "Frame wasn't begun");
+	Frame& frame = *m_pFrame;
+	if (frame.m_numSubmitBuffersUsed == frame.m_submitBuffers.size())
+		frame.m_submitBuffers.emplace_back();
+
+	SubmitBuffer& submitBuffer = frame.m_submitBuffers[frame.m_numSubmitBuffersUsed++];
+	assert(submitBuffer.packets.empty() && submitBuffer.customDraws.empty());
+	submitBuffer.bParallel = bParallel;
+	return submitBuffer;
+}
+
+RenderQueue::SubmitBuffer& RenderQueue::GetSubmitBuffer()
+{
+	if (ms_pJobSubmitBuffer)
+		return *ms_pJobSubmitBuffer;
+
+	// Packets submitted outside of render jobs go after those of the jobs started before them
+	assert(m_pFrame && "Frame wasn't begun");
+	Frame& frame = *m_pFrame;
+	if (frame.m_numSubmitBuffersUsed > 0 && !frame.m_submitBuffers[frame.m_numSubmitBuffersUsed - 1].bParallel)
+		return frame.m_submitBuffers[frame.m_numSubmitBuffersUsed - 1];
+	return AcquireSubmitBuffer(false);
+}
+
+void RenderQueue::Retain(std::shared_ptr<const void> pObject)
+{
+	GetSubmitBuffer().retainedObjects.push_back(std::move(pObject));
+}
+
+uint32 RenderQueue::GetMaterialSortId(const gfx::Material* pMaterial)
+{
+	if (!pMaterial)
+		return 0;
+
+	auto result = m_materialSortIds.insert(std::make_pair(pMaterial, static_cast<uint32>(m_materialSortIds.size() + 1)));
+	return result.first->second;
+}
+
+uint64 RenderQueue::MakeSortKey(const QueuedPacket& queuedPacket, float32 maxDepth)
+{
+	const uint64 material = MaskBits(GetMaterialSortId(queuedPacket.packet.pMaterial), kMaterialBits);
+	const uint64 texture = MaskBits(static_cast<uint64>(queuedPacket.textureId - INVALID_TEXTURE_ID), kTextureBits);
+
+	const uint64 maxQuantizedDepth = (1ull << kDepthBits) - 1;
+	const uint64 quantizedDepth = static_cast<uint64>(MathEx::Clamp(queuedPacket.depth / maxDepth, 0.f, 1.f) * maxQuantizedDepth);
+
+	uint64 key = static_cast<uint64>(queuedPacket.pass) << (64 - kPassBits);
+	if (queuedPacket.packet.bTranslucent)
+	{
+		key |= 1ull << (63 - kPassBits);
+		key |= (maxQuantizedDepth - quantizedDepth) << (kMaterialBits + kTextureBits);
+		key |= material << kTextureBits;
+		key |= texture;
+	}
+	else
+	{
+		key |= material << (kTextureBits + kDepthBits);
+		key |= texture << kDepthBits;
+		key |= quantizedDepth;
+	}
+	return key;
+}
+
+void RenderQueue::Submit(const DrawPacket& packet, const Vector3& center, RenderPass::Type pass)
+{
+	assert(packet.pVertexLayout && packet.pVertexData && (packet.pIndices || packet.numIndices == 0));
+
+	QueuedPacket queuedPacket;
+	queuedPacket.packet = packet;
+	queuedPacket.depth = (center - m_pFrame->m_cameraPosition).Length();
+	queuedPacket.pass = pass;
+	queuedPacket.textureId = INVALID_TEXTURE_ID;
+	GetSubmitBuffer().packets.push_back(queuedPacket);
+}
+
+void RenderQueue::SubmitParallel(size_t count, const RenderJob& render)
+{
+	assert(!ms_pJobSubmitBuffer && "SubmitParallel can't be called from a render job");
+	if (count == 0)
+		return;
+
+	// Each job renders a contiguous range into its own buffer, so buffer order is submission order
+	JobSystem& jobSystem = JobSystem::Instance();
+	const size_t numJobs = MathEx::Min<size_t>(count, (jobSystem.GetNumWorkers() + 1) * kJobsPerThread);
+	Frame& frame = *m_pFrame;
+	const size_t firstBuffer = frame.m_numSubmitBuffersUsed;
+	for (size_t i = 0; i < numJobs; ++i)
+		AcquireSubmitBuffer(true);
+
+	jobSystem.ParallelFor(numJobs, [&] (size_t job)
+	{
+		ms_pJobSubmitBuffer = &frame.m_submitBuffers[firstBuffer + job];
+		const size_t end = count * (job + 1) / numJobs;
+		for (size_t i = count * job / numJobs; i < end; ++i)
+			render(i);
+		ms_pJobSubmitBuffer = nullptr;
+	});
+}
+
+void RenderQueue::SubmitCustomDraw(const std::function<void ()>& draw)
+{
+	GetSubmitBuffer().customDraws.push_back(draw);
+}
+
+void RenderQueue::RequestCapture(const std::string& fileName)
+{
+	m_captureFileName = fileName;
+}
+
+void RenderQueue::Flush(Frame& frame)
+{
+	PROFILE_SCOPE("RenderQueue::Flush");
+
+	m_stats = Stats();
+
+	for (size_t i = 0; i < frame.m_numSubmitBuffersUsed; ++i)
+	{
+		for (const auto& draw : frame.m_submitBuffers[i].customDraws)
+			draw();
+	}
+
+	// Textures are looked up and keys made here rather than on Submit, as they aren't thread safe
+	m_materialSortIds.clear();
+	for (size_t i = 0; i < frame.m_numSubmitBuffersUsed; ++i)
+	{
+		for (QueuedPacket& queuedPacket : frame.m_submitBuffers[i].packets)
+		{
+			const gfx::Material* pMaterial = queuedPacket.packet.pMaterial;
+			queuedPacket.textureId = pMaterial? AssetManager::Instance().UseTexture(pMaterial->m_pTexture.get()) : INVALID_TEXTURE_ID;
+			m_sortKeys.push_back(MakeSortKey(queuedPacket, frame.m_maxDepth));
+			m_packets.push_back(&queuedPacket);
+		}
+	}
+
+	const bool bTexturingAllowed = GLUtil::GetTexturing();
+
+	// What the state changes would have been without sorting
+	RenderState unsortedState(bTexturingAllowed);
+	for (const QueuedPacket* pQueuedPacket : m_packets)
+		m_stats.numUnsortedStateChanges += unsortedState.Set(pQueuedPacket->packet, pQueuedPacket->textureId, nullptr);
+
+	RadixSort(m_sortKeys, m_sortOrder, m_sortTemp);
+
+	m_commands.Clear();
+	RenderState state(bTexturingAllowed);
+	for (uint32 index : m_sortOrder)
+	{
+		const QueuedPacket& queuedPacket = *m_packets[index];
+		m_stats.numStateChanges += state.Set(queuedPacket.packet, queuedPacket.textureId, &m_commands);
+		m_commands.DrawTriangles(MakeDraw(queuedPacket.packet));
+	}
+	state.Reset(m_commands);
+
+	if (!m_captureFileName.empty())
+	{
+		try
+		{
+			RenderCapture::Save(m_commands, m_captureFileName.c_str());
+			printf("Captured frame to %s\n", m_captureFileName.c_str());
+		}
+		catch (const std::exception& e)
+		{
+			printf("Failed to capture frame to %s: %s\n", m_captureFileName.c_str(), e.what());
+		}
+		m_captureFileName.clear();
+	}
+
+	m_commands.Execute();
+	m_stats.numDrawCalls = static_cast<uint32>(m_commands.draws.size());
+	m_stats.numTriangles = m_commands.numTriangles;
+
+	for (size_t i = 0; i < frame.m_numSubmitBuffersUsed; ++i)
+	{
+		SubmitBuffer& submitBuffer = frame.m_submitBuffers[i];
+		submitBuffer.packets.clear();
+		submitBuffer.customDraws.clear();
+		submitBuffer.retainedObjects.clear();
+	}
+	frame.m_numSubmitBuffersUsed = 0;
+	m_packets.clear();
+	m_sortKeys.clear();
+}
@@ -0,0 +1,193 @@
+#ifndef _RENDER_QUEUE_H_
+#define _RENDER_QUEUE_H_
+
+#include "gs/Base/Base.h"
+#include "gs/Base/Singleton.h"
+#include "StaticMesh.h"
+#include "RenderCommands.h"
+#include <vector>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace RenderPass
+{
+	enum Type
+	{
+		World,
+
+		NumTypes
+	};
+}
+
+// One draw call: an indexed triangle list with its material and transform. The vertex and index
+// data must stay valid until the queue is flushed.
+struct DrawPacket
+{
+	DrawPacket()
+		: pMaterial(nullptr)
+		, bHasTransform(false)
+		, pVertexLayout(nullptr)
+		, pVertexData(nullptr)
+		, numVertices(0)
+		, pIndices(nullptr)
+		, numIndices(0)
+		, b32BitIndices(false)
+		, bTranslucent(false)
+	{}
+
+	const gfx::Material* pMaterial; // Null to draw with whatever material state is current
+	bool bHasTransform; // If false, vertices are in world space
+	Matrix43 mModelToWorld;
+	const VertexLayout* pVertexLayout;
+	const void* pVertexData; // numVertices vertices, packed with *pVertexLayout (see VertexFormat.h)
+	uint32 numVertices;
+	const void* pIndices;
+	uint32 numIndices;
+	bool b32BitIndices;
+	bool bTranslucent; // Drawn blended, after opaque packets and without writing depth
+};
+
+// Collects the frame's draw packets and draws them sorted to minimize GL state changes. Each packet
+// gets a 64-bit sort key, radix sorted on Flush, made of (most significant first):
+//
+//   pass         2 bits
+//   translucent  1 bit   opaque packets are drawn first
+//   opaque:      material 20 bits, texture 20 bits, depth 21 bits (front to back)
+//   translucent: depth 21 bits (back to front), material 20 bits, texture 20 bits
+//
+// so opaque packets that share a material and texture are drawn together, front to back within
+// them for early depth rejection, while translucent packets are drawn back to front for blending.
+// Flushing records the sorted packets into a RenderCommandList, which only changes the material,
+// texture and blending state when they differ from the previous packet's, then executes it.
+//
+// Packets can be submitted from render jobs running in parallel (see SubmitParallel). Each job
+// submits to its own buffer, and the buffers are merged in order on Flush, by the thread that owns
+// the GL context.
+//
+// Packets are recorded into a Frame, from Begin to End, and drawn from it by Flush. Frames are
+// recorded on the update thread and flushed later on the render thread (see FramePipeline.h), so
+// the thread that records a frame can start on the next one, into another Frame, while the first
+// one is drawn.
+class RenderQueue : public Singleton<RenderQueue>
+{
+private:
+	friend class Singleton<RenderQueue>;
+	RenderQueue();
+
+	struct QueuedPacket
+	{
+		DrawPacket packet;
+		float32 depth;
+		RenderPass::Type pass;
+		TextureId textureId; // Looked up on Flush
+	};
+
+	// Packets of one render job, or of the calling thread between jobs
+	struct SubmitBuffer
+	{
+		SubmitBuffer() : bParallel(false) {}
+
+		std::vector<QueuedPacket> packets;
+		std::vector<std::function<void ()>> customDraws;
+		std::vector<std::shared_ptr<const void>> retainedObjects;
+		bool bParallel; // Belongs to a render job
+	};
+
+public:
+	// The packets of one frame, from Begin until Flush. Its buffers are reused by the next frame
+	// recorded into it.
+	class Frame
+	{
+	public:
+		Frame() : m_cameraPosition(Vector3::Zero()), m_maxDepth(1.f), m_numSubmitBuffersUsed(0) {}
+
+	private:
+		friend class RenderQueue;
+
+		Vector3 m_cameraPosition;
+		float32 m_maxDepth;
+		std::deque<SubmitBuffer> m_submitBuffers; // In submission order
+		size_t m_numSubmitBuffersUsed;
+	};
+
+	// Counts for the last flushed frame
+	struct Stats
+	{
+		Stats() : numDrawCalls(0), numTriangles(0), numStateChanges(0), numUnsortedStateChanges(0) {}
+
+		uint32 numDrawCalls;
+		uint32 numTriangles;
+		uint32 numStateChanges;			// Material, texture, texturing and blending changes
+		uint32 numUnsortedStateChanges;	// State changes if packets were drawn in submission order
+	};
+
+	// Starts recording a frame into frame, which must have been flushed if it was recorded before.
+	// Depth is the distance from cameraPosition, quantized up to maxDepth.
+	void Begin(Frame& frame, const Vector3& cameraPosition, float32 maxDepth);
+
+	// Stops recording the frame started by Begin. It can then be flushed from another thread.
+	void End();
+
+	// Keeps pObject alive until the frame is flushed, for data that packets reference but that its
+	// owner may release or replace before then. Can be called from render jobs.
+	void Retain(std::shared_ptr<const void> pObject);
+
+	// Queues a packet, sorted by the distance from the camera to center (in world space). Can be
+	// called from render jobs.
+	void Submit(const DrawPacket& packet, const Vector3& center, RenderPass::Type pass = RenderPass::World);
+
+	// Calls render(i) for every i in [0, count), in parallel on the JobSystem, and returns once all
+	// calls have completed. Packets are queued in the same order as if render had been called for
+	// each i in order on this thread, so the frame draws the same whatever the number of threads.
+	// render must not make GL calls, and must not call SubmitParallel.
+	typedef std::function<void (size_t index)> RenderJob;
+	void SubmitParallel(size_t count, const RenderJob& render);
+
+	// Queues GL calls to make on Flush, in submission order before the sorted packets, for geometry
+	// that packets can't describe (e.g. points, or unlit vertex colors). draw runs on the thread
+	// that flushes, after this one may have moved on, so it must only use data it owns (e.g.
+	// captured by value). Custom draws aren't captured (see RequestCapture). Can be called from
+	// render jobs.
+	void SubmitCustomDraw(const std::function<void ()>& draw);
+
+	// Draws frame in the current model view space: makes its custom draws, then sorts and draws its
+	// packets. Leaves the frame empty, ready to be recorded into again. Must be called on the thread
+	// that owns the GL context.
+	void Flush(Frame& frame);
+
+	// Saves the commands of the next flushed frame to a capture file (see RenderCapture.h)
+	void RequestCapture(const std::string& fileName);
+
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	// Split each SubmitParallel call into this many jobs per thread, to balance the load
+	static const size_t kJobsPerThread = 4;
+
+	SubmitBuffer& AcquireSubmitBuffer(bool bParallel);
+	SubmitBuffer& GetSubmitBuffer(); // Of the calling render job, or of this thread
+
+	uint32 GetMaterialSortId(const gfx::Material* pMaterial);
+	uint64 MakeSortKey(const QueuedPacket& queuedPacket, float32 maxDepth);
+
+	// Used by the recording thread, from Begin to End
+	Frame* m_pFrame;
+	static thread_local SubmitBuffer* ms_pJobSubmitBuffer; // Set while a render job runs
+
+	// Used by the flushing thread
+	std::vector<QueuedPacket*> m_packets; // Merged from the submit buffers on Flush
+	std::vector<uint64> m_sortKeys;
+	std::vector<uint32> m_sortOrder; // Indices into m_packets, sorted by key
+	std::vector<uint32> m_sortTemp; // Scratch space for sorting
+	std::unordered_map<const gfx::Material*, uint32> m_materialSortIds; // Assigned in order of first use each frame
+
+	RenderCommandList m_commands;
+	std::string m_captureFileName; // Empty unless a capture was requested
+
+	Stats m_stats;
+};
+
+#endif // _RENDER_QUEUE_H_
@@ -0,0 +1,277 @@
+#include "StaticBatcher.h"
+#include "StaticMeshComponent.h"
+#include "RenderQueue.h"
+#include "gs/System/JobSystem.h"
+#include "gs/System/Profiler.h"
+#include "gs/Math/MathEx.h"
+#include <algorithm>
+
+const float32 StaticBatcher::kDefaultChunkSize = 10000.f;
+
+struct StaticBatcher::Chunk
+{
+	Chunk() : bounds(AABB::Empty()), lod(0), bDirty(false) {}
+
+	// Node whose mesh is part of the chunk, with its mesh and transform when it was added
+	struct Member
+	{
+		SceneNodeWeakPtr pwNode;
+		std::shared_ptr<gfx::StaticMesh> pStaticMesh;
+		Matrix43 mMeshToWorld;
+	};
+
+	// Submeshes of every member that use the same material, in world space. Positions aren't
+	// quantized, since a chunk can be much larger than its meshes.
+	struct Batch
+	{
+		const gfx::Material* pMaterial; // Null for submeshes without a material
+		gfx::StaticMesh::SubMesh subMesh;
+	};
+
+	// What the chunk draws. Rebuilding replaces it rather than modifying it, as frames that
+	// reference the previous one may not have been drawn yet.
+	struct Geometry
+	{
+		std::vector<Batch> batches;
+		std::vector<std::shared_ptr<gfx::StaticMesh>> staticMeshes; // Own the batches' materials
+	};
+
+	void Build();
+
+	std::vector<Member> members;
+	std::shared_ptr<const Geometry> pGeometry;
+	AABB bounds;
+	std::vector<float32> lodScreenSizes; // For a bounding sphere diameter of 1 (see Build)
+	size_t lod;
+	bool bDirty;
+};
+
+void StaticBatcher::Chunk::Build()
+{
+	auto pNewGeometry = std::make_shared<Geometry>();
+	std::vector<Batch>& batches = pNewGeometry->batches;
+	bounds.SetEmpty();
+
+	size_t numLods = 1;
+	for (const Member& member : members)
+		numLods = MathEx::Max(numLods, member.pStaticMesh->GetNumLods());
+
+	// A member would draw LOD l while its diameter over the distance to it (times 2 tan(fovY/2)) is
+	// at most its screen size for l. Dividing the screen sizes by the diameter lets the chunk use
+	// the tightest of its members' screen sizes with a diameter of 1.
+	lodScreenSizes.assign(numLods, kInfiniteDistance);
+
+	// Vertices, LOD indices and attributes (VertexLayoutFlags) of each batch, packed once every
+	// member is added
+	struct BatchGeometry
+	{
+		BatchGeometry() : layoutFlags(0) {}
+
+		std::vector<gfx::StaticMesh::Vertex> vertices;
+		std::vector<std::vector<uint32>> lodIndices;
+		uint32 layoutFlags;
+	};
+	std::vector<BatchGeometry> batchGeometries;
+
+	std::vector<gfx::StaticMesh::Vertex> vertices;
+	for (const Member& member : members)
+	{
+		const gfx::StaticMesh& staticMesh = *member.pStaticMesh;
+		const Matrix43& mMeshToWorld = member.mMeshToWorld;
+		pNewGeometry->staticMeshes.push_back(member.pStaticMesh);
+		const size_t numMeshLods = staticMesh.GetNumLods();
+
+		const Vector3 scale = mMeshToWorld.GetScale();
+		const float32 diameter = staticMesh.m_boundingBox.GetSize().Length() * MathEx::Max(scale.x, MathEx::Max(scale.y, scale.z));
+		for (size_t lod = 1; lod < numLods; ++lod)
+		{
+			// Meshes with fewer LODs keep drawing their last one
+			const size_t meshLod = MathEx::Min(lod, numMeshLods - 1);
+			if (meshLod < staticMesh.m_lodScreenSizes.size() && diameter > 0.f)
+				lodScreenSizes[lod] = MathEx::Min(lodScreenSizes[lod], staticMesh.m_lodScreenSizes[meshLod] / diameter);
+		}
+
+		for (const auto& subMesh : staticMesh.m_subMeshes)
+		{
+			const gfx::Material* pMaterial = subMesh.m_materialIndex != gfx::StaticMesh::INVALID_MATERIAL_INDEX? &staticMesh.m_materials[subMesh.m_materialIndex] : nullptr;
+			auto iter = std::find_if(batches.begin(), batches.end(), [&] (const Batch& batch) { return batch.pMaterial == pMaterial; });
+			if (iter == batches.end())
+			{
+				iter = batches.emplace(batches.end());
+				iter->pMaterial = pMaterial;
+				batchGeometries.emplace_back();
+				batchGeometries.back().lodIndices.resize(numLods);
+			}
+			BatchGeometry& batch = batchGeometries[iter - batches.begin()];
+
+			const VertexLayout& layout = subMesh.m_vertexLayout;
+			batch.layoutFlags |= (layout.Has(VertexAttribute::Normal)? VertexLayoutFlags::Normal : 0)
+				| (layout.Has(VertexAttribute::Color)? VertexLayoutFlags::Color : 0)
+				| (layout.Has(VertexAttribute::TexCoord)? VertexLayoutFlags::TexCoord : 0);
+
+			const uint32 firstVertex = static_cast<uint32>(batch.vertices.size());
+			subMesh.GetVertices(vertices);
+			for (auto& vertex : vertices)
+			{
+				const Vector3 position = PositionVector(Vector3(vertex.position)) * mMeshToWorld;
+				const Vector3 normal = SafeNormalize(DirectionVector(Vector3(vertex.normal)) * mMeshToWorld, Vector3::Zero());
+				vertex.position = Vector4(position, 1.f);
+				vertex.normal = Vector4(normal, 0.f);
+				bounds.Include(position);
+			}
+			batch.vertices.insert(batch.vertices.end(), vertices.begin(), vertices.end());
+
+			for (size_t lod = 0; lod < numLods; ++lod)
+			{
+				const size_t meshLod = MathEx::Min(lod, subMesh.GetNumLods() - 1);
+				std::vector<uint32>& indices = batch.lodIndices[lod];
+				for (size_t i = 0; i < subMesh.GetNumIndices(meshLod); ++i)
+					indices.push_back(firstVertex + subMesh.GetIndex(i, meshLod));
+			}
+		}
+	}
+
+	for (size_t i = 0; i < batches.size(); ++i)
+	{
+		const BatchGeometry& batch = batchGeometries[i];
+		batches[i].subMesh.SetVertices(batch.vertices, batch.layoutFlags);
+		for (size_t lod = 0; lod < numLods; ++lod)
+			batches[i].subMesh.SetIndices(batch.lodIndices[lod], lod);
+	}
+
+	pGeometry = pNewGeometry;
+	lod = MathEx::Min(lod, numLods - 1);
+	bDirty = false;
+}
+
+StaticBatcher::StaticBatcher(float32 chunkSize)
+	: m_chunkSize(chunkSize)
+{
+	assert(chunkSize > 0.f);
+}
+
+StaticBatcher::~StaticBatcher()
+{
+	// Nodes that outlive the batcher go back to drawing themselves
+	for (const auto& entry : m_chunks)
+	{
+		for (const auto& member : entry.second->members)
+		{
+			if (const auto& psNode = member.pwNode.lock())
+				psNode->GetComponent<StaticMeshComponent>()->SetBatched(false);
+		}
+	}
+}
+
+std::pair<int, int> StaticBatcher::GetChunkCoords(const Vector3& position) const
+{
+	return std::make_pair((int)MathEx::Floor(position.x / m_chunkSize), (int)MathEx::Floor(position.z / m_chunkSize));
+}
+
+void StaticBatcher::Add(const SceneNodeSharedPtr& psNode)
+{
+	assert(psNode->TryGetComponent<StaticMeshComponent>() && "Node has no mesh to batch");
+	m_pendingNodes.push_back(psNode);
+}
+
+void StaticBatcher::Update()
+{
+	PROFILE_SCOPE("StaticBatcher::Update");
+
+	// Drop the nodes that were destroyed
+	for (const auto& entry : m_chunks)
+	{
+		Chunk& chunk = *entry.second;
+		const size_t numMembers = chunk.members.size();
+		chunk.members.erase(std::remove_if(chunk.members.begin(), chunk.members.end(), [] (const Chunk::Member& member) { return member.pwNode.expired(); }), chunk.members.end());
+		chunk.bDirty |= chunk.members.size() != numMembers;
+	}
+
+	for (auto iter = m_pendingNodes.begin(); iter != m_pendingNodes.end(); )
+	{
+		const auto& psNode = iter->lock();
+		if (!psNode)
+		{
+			iter = m_pendingNodes.erase(iter);
+			continue;
+		}
+
+		StaticMeshComponent* pStaticMeshComponent = psNode->GetComponent<StaticMeshComponent>();
+		if (pStaticMeshComponent->IsLoading())
+		{
+			++iter;
+			continue;
+		}
+
+		Chunk::Member member;
+		member.pwNode = psNode;
+		member.pStaticMesh = pStaticMeshComponent->GetMeshPtr();
+		member.mMeshToWorld = psNode->GetLocalToWorld();
+
+		const Vector3 center = PositionVector(member.pStaticMesh->m_boundingBox.GetCenter()) * member.mMeshToWorld;
+		auto& psChunk = m_chunks[GetChunkCoords(center)];
+		if (!psChunk)
+			psChunk = std::make_shared<Chunk>();
+		psChunk->members.push_back(member);
+		psChunk->bDirty = true;
+
+		pStaticMeshComponent->SetBatched(true);
+		iter = m_pendingNodes.erase(iter);
+	}
+
+	std::vector<Chunk*> dirtyChunks;
+	m_chunkList.clear();
+	for (auto iter = m_chunks.begin(); iter != m_chunks.end(); )
+	{
+		Chunk& chunk = *iter->second;
+		if (chunk.members.empty())
+		{
+			iter = m_chunks.erase(iter);
+			continue;
+		}
+
+		if (chunk.bDirty)
+			dirtyChunks.push_back(&chunk);
+		m_chunkList.push_back(&chunk);
+		++iter;
+	}
+
+	JobSystem::Instance().ParallelFor(dirtyChunks.size(), [&] (size_t i)
+	{
+		dirtyChunks[i]->Build();
+	});
+}
+
+void StaticBatcher::Render()
+{
+	const Vector3& cameraPosition = StaticMeshComponent::GetLodCameraPosition();
+	RenderQueue& renderQueue = RenderQueue::Instance();
+
+	renderQueue.SubmitParallel(m_chunkList.size(), [&] (size_t i)
+	{
+		Chunk& chunk = *m_chunkList[i];
+
+		// LOD for the chunk's point closest to the camera
+		const Vector3 closestPoint(
+			MathEx::Clamp(cameraPosition.x, chunk.bounds.min.x, chunk.bounds.max.x),
+			MathEx::Clamp(cameraPosition.y, chunk.bounds.min.y, chunk.bounds.max.y),
+			MathEx::Clamp(cameraPosition.z, chunk.bounds.min.z, chunk.bounds.max.z));
+		chunk.lod = StaticMeshComponent::SelectLod(chunk.lodScreenSizes, 1.f, closestPoint, chunk.lod);
+
+		renderQueue.Retain(chunk.pGeometry);
+		for (const auto& batch : chunk.pGeometry->batches)
+		{
+			const gfx::StaticMesh::SubMesh& subMesh = batch.subMesh;
+
+			DrawPacket packet;
+			packet.pMaterial = batch.pMaterial;
+			packet.pVertexLayout = &subMesh.m_vertexLayout;
+			packet.pVertexData = subMesh.GetVertexData();
+			packet.numVertices = static_cast<uint32>(subMesh.GetNumVertices());
+			packet.pIndices = subMesh.GetIndexData(chunk.lod);
+			packet.numIndices = static_cast<uint32>(subMesh.GetNumIndices(chunk.lod));
+			packet.b32BitIndices = subMesh.Has32BitIndices();
+			renderQueue.Submit(packet, closestPoint);
+		}
+	});
+}
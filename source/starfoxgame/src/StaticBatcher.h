@@ -0,0 +1,47 @@
+#ifndef _STATIC_BATCHER_H_
+#define _STATIC_BATCHER_H_
+
+#include "gs/Scene/SceneNode.h"
+#include "StaticMesh.h"
+#include <map>
+
+// Draws scene nodes that never move, like the level's buildings, with a few large draw calls. The
+// world is split into square chunks on the XZ plane, and the meshes of the nodes in a chunk are
+// transformed to world space once and combined into one vertex and index buffer per material, so
+// that a chunk takes one draw call per material rather than one per node and submesh.
+//
+// Chunks select their LOD as a whole, conservatively: each chunk draws the coarsest LOD that every
+// one of its meshes would draw if it were at the point of the chunk closest to the camera.
+class StaticBatcher
+{
+public:
+	static const float32 kDefaultChunkSize;
+
+	explicit StaticBatcher(float32 chunkSize = kDefaultChunkSize);
+	~StaticBatcher();
+
+	// Adds a node with a StaticMeshComponent. The node must not move, or change its mesh, once its
+	// mesh is loaded: it's drawn by its component until then, and by its chunk afterwards.
+	void Add(const SceneNodeSharedPtr& psNode);
+
+	// Moves nodes whose meshes have loaded into their chunks, and rebuilds those chunks (in parallel
+	// on the JobSystem). Call once per frame before rendering.
+	void Update();
+
+	// Submits the chunks to the RenderQueue, in parallel on the JobSystem
+	void Render();
+
+	size_t GetNumChunks() const { return m_chunks.size(); }
+
+private:
+	struct Chunk;
+
+	std::pair<int, int> GetChunkCoords(const Vector3& position) const;
+
+	float32 m_chunkSize;
+	std::vector<SceneNodeWeakPtr> m_pendingNodes;
+	std::map<std::pair<int, int>, std::shared_ptr<Chunk>> m_chunks;
+	std::vector<Chunk*> m_chunkList; // The chunks in m_chunks, as of the last Update
+};
+
+#endif // _STATIC_BATCHER_H_
@@ -3,8 +3,12 @@
 
 #include "gs/Base/Base.h"
 #include "gs/Math/Matrix43.h"
+#include "gs/Math/Geometry.h"
+#include "gs/Rendering/VertexFormat.h"
 #include "gs/Platform/GL/GLUtil.h"
 #include <vector>
+#include <memory>
+#include <cstring>
 
 namespace gfx
 {
@@ -29,14 +33,32 @@ struct Vector2
 	};
 };
 
+// GPU texture, shared by every material that references the same file (see AssetManager). Until the
+// texture is loaded, or while it's evicted to stay under the texture budget, m_textureId is a placeholder.
+struct Texture
+{
+	Texture()
+		: m_textureId(INVALID_TEXTURE_ID)
+		, m_bLoaded(false)
+		, m_memorySize(0)
+		, m_lastUsedFrame(0)
+	{}
+
+	TextureId m_textureId;
+	bool m_bLoaded;
+	size_t m_memorySize; // Bytes of texture memory once loaded, including power of 2 padding
+	uint32 m_lastUsedFrame; // AssetManager frame in which the texture was last drawn
+};
+
 struct Material
 {
 	Material() 
 		: m_uniqueId(~0ul)
 		, m_shininess(0.f)
-		, m_textureId(INVALID_TEXTURE_ID)
 	{}
 
+	TextureId GetTextureId() const { return m_pTexture? m_pTexture->m_textureId : INVALID_TEXTURE_ID; }
+
 	uint64 m_uniqueId;
 	std::string m_name;
 	std::string m_filename;
@@ -47,11 +69,16 @@ struct Material
 	Color4 m_emmissive;
 	float32 m_shininess;
 
-	TextureId m_textureId;
+	// Texture of the file referenced by m_filename, if it has one. Meshes are loaded without their
+	// textures (so that they can be imported and cooked without a GL context), and the AssetManager
+	// sets this when it loads the mesh.
+	std::shared_ptr<Texture> m_pTexture;
 };
 
 struct StaticMesh
 {
+	StaticMesh() : m_boundingBox(AABB::Empty()) {}
+
 	struct Vertex
 	{
 		Vertex()
@@ -70,10 +97,55 @@ struct StaticMesh
 
 	static const uint32 INVALID_MATERIAL_INDEX = ~0u;
 
+	// Vertices are stored packed (see VertexFormat.h), and only contain the attributes that the
+	// mesh was imported with. They're drawn packed (see RenderCommands.cpp), so they're only decoded
+	// by GetVertices. Vertex and index data are either owned by the submesh or reference memory kept
+	// alive by its owner (e.g. a cooked mesh file).
+	// Each LOD has its own triangle list indexing the same vertices; LOD 0 is the full detail one.
 	struct SubMesh
 	{
-		SubMesh() : m_materialIndex(INVALID_MATERIAL_INDEX) {}
-		std::vector<Vertex> m_vertices;
+		SubMesh() : m_numVertices(0), m_indexSize(sizeof(uint16)), m_lods(1), m_materialIndex(INVALID_MATERIAL_INDEX) {}
+
+		// Packs vertices using layoutFlags (combination of VertexLayoutFlags). Quantized positions
+		// are relative to the bounds of the vertices.
+		void SetVertices(const std::vector<Vertex>& vertices, uint32 layoutFlags);
+
+		// Decodes the vertices. Attributes that are not stored keep their Vertex default values.
+		void GetVertices(std::vector<Vertex>& vertices) const;
+
+		size_t GetNumVertices() const { return m_numVertices; }
+		const uint8* GetVertexData() const { return m_pVertexData.get(); }
+		size_t GetVertexDataSize() const { return m_numVertices * m_vertexLayout.stride; }
+
+		// Sets the triangle list indices of a LOD, stored as 16-bit when every vertex can be
+		// addressed with 16 bits and as 32-bit otherwise. Vertices must be set first.
+		void SetIndices(const std::vector<uint32>& indices, size_t lod = 0);
+
+		// References already packed vertex and index data without copying it. The index size
+		// (2 or 4 bytes) applies to the indices of every LOD.
+		void SetVertexData(const VertexLayout& vertexLayout, uint32 numVertices, std::shared_ptr<const uint8> pVertexData, uint32 indexSize);
+		void SetIndexData(uint32 numIndices, std::shared_ptr<const uint8> pIndexData, size_t lod = 0);
+
+		size_t GetNumLods() const { return m_lods.size(); }
+		bool Has32BitIndices() const { return m_indexSize == sizeof(uint32); }
+		size_t GetNumIndices(size_t lod = 0) const { return m_lods[lod].m_numIndices; }
+		uint32 GetIndex(size_t i, size_t lod = 0) const { return Has32BitIndices()? reinterpret_cast<const uint32*>(GetIndexData(lod))[i] : reinterpret_cast<const uint16*>(GetIndexData(lod))[i]; }
+		const void* GetIndexData(size_t lod = 0) const { return m_lods[lod].m_pData.get(); }
+		size_t GetIndexDataSize(size_t lod = 0) const { return m_lods[lod].m_numIndices * m_indexSize; }
+
+		struct IndexBuffer
+		{
+			IndexBuffer() : m_numIndices(0) {}
+
+			std::shared_ptr<const uint8> m_pData;
+			uint32 m_numIndices;
+		};
+
+		VertexLayout m_vertexLayout;
+		std::shared_ptr<const uint8> m_pVertexData;
+		uint32 m_numVertices;
+		uint32 m_indexSize; // 2 or 4 bytes
+		std::vector<IndexBuffer> m_lods; // At least one
 		uint32 m_materialIndex;
 	};
 
@@ -87,29 +159,105 @@ struct StaticMesh
 	std::vector<Material> m_materials;
 	std::vector<Socket> m_sockets;
 
-	struct BoundingBox
+	AABB m_boundingBox;
+
+	// LOD i is used while the mesh's projected bounding sphere diameter, as a fraction of the screen
+	// height, is at most m_lodScreenSizes[i] (see MeshUtil::SetupLods). Every submesh has this many LODs.
+	std::vector<float32> m_lodScreenSizes;
+
+	size_t GetNumLods() const { return m_subMeshes.empty()? 1 : m_subMeshes[0].GetNumLods(); }
+};
+
+namespace StaticMeshInternal
+{
+	template <typename Streams, typename VertexT>
+	Streams GetVertexStreams(VertexT* pVertices)
 	{
-		BoundingBox() : m_min(Vector3::Zero()), m_max(Vector3::Zero()) {}
+		Streams streams;
+		streams.position = pVertices->position.v;
+		streams.normal = pVertices->normal.v;
+		streams.color = pVertices->color.v;
+		streams.texCoord = pVertices->textureCoords.v;
+		streams.stride = sizeof(StaticMesh::Vertex);
+		return streams;
+	}
+}
 
-		void Include(const Vector3& v)
-		{
-			m_min.x = MathEx::Min(m_min.x, v.x);
-			m_min.y = MathEx::Min(m_min.y, v.y);
-			m_min.z = MathEx::Min(m_min.z, v.z);
-			m_max.x = MathEx::Max(m_max.x, v.x);
-			m_max.y = MathEx::Max(m_max.y, v.y);
-			m_max.z = MathEx::Max(m_max.z, v.z);
-		}
+inline void StaticMesh::SubMesh::SetVertices(const std::vector<Vertex>& vertices, uint32 layoutFlags)
+{
+	AABB bounds = AABB::Empty();
+	for (const Vertex& vertex : vertices)
+		bounds.Include(Vector3(vertex.position));
+
+	if (vertices.empty())
+		layoutFlags &= ~VertexLayoutFlags::QuantizePosition;
+
+	m_vertexLayout = VertexLayout::Create(layoutFlags, bounds);
+	m_numVertices = static_cast<uint32>(vertices.size());
+
+	auto pBuffer = std::make_shared<std::vector<uint8>>(vertices.size() * m_vertexLayout.stride);
+	if (!vertices.empty())
+		PackVertices(m_vertexLayout, StaticMeshInternal::GetVertexStreams<ConstVertexStreams>(vertices.data()), vertices.size(), pBuffer->data());
+	m_pVertexData = std::shared_ptr<const uint8>(pBuffer, pBuffer->data());
+}
+
+inline void StaticMesh::SubMesh::GetVertices(std::vector<Vertex>& vertices) const
+{
+	vertices.assign(m_numVertices, Vertex());
+	if (m_numVertices > 0)
+		UnpackVertices(m_vertexLayout, GetVertexData(), m_numVertices, StaticMeshInternal::GetVertexStreams<VertexStreams>(vertices.data()));
+}
+
+inline void StaticMesh::SubMesh::SetIndices(const std::vector<uint32>& indices, size_t lod)
+{
+	assert(indices.size() % 3 == 0 && "Expecting a triangle list");
+
+	if (lod >= m_lods.size())
+		m_lods.resize(lod + 1);
 
-		Vector3 GetExtents()
+	const uint32 indexSize = m_numVertices <= 0xFFFF? sizeof(uint16) : sizeof(uint32);
+	assert((lod == 0 || indexSize == m_indexSize) && "Vertices changed after setting LOD 0");
+	m_indexSize = indexSize;
+
+	auto pBuffer = std::make_shared<std::vector<uint8>>(indices.size() * m_indexSize);
+	if (m_indexSize == sizeof(uint16))
+	{
+		uint16* pIndices16 = reinterpret_cast<uint16*>(pBuffer->data());
+		for (size_t i = 0; i < indices.size(); ++i)
 		{
-			return m_max - m_min;
+			assert(indices[i] < m_numVertices);
+			pIndices16[i] = static_cast<uint16>(indices[i]);
 		}
+	}
+	else if (!indices.empty())
+	{
+		memcpy(pBuffer->data(), indices.data(), indices.size() * sizeof(uint32));
+	}
+	m_lods[lod].m_numIndices = static_cast<uint32>(indices.size());
+	m_lods[lod].m_pData = std::shared_ptr<const uint8>(pBuffer, pBuffer->data());
+}
 
-		Vector3 m_min, m_max;
-	};
-	BoundingBox m_boundingBox;
-};
+inline void StaticMesh::SubMesh::SetVertexData(const VertexLayout& vertexLayout, uint32 numVertices, std::shared_ptr<const uint8> pVertexData, uint32 indexSize)
+{
+	assert(indexSize == sizeof(uint16) || indexSize == sizeof(uint32));
+
+	m_vertexLayout = vertexLayout;
+	m_numVertices = numVertices;
+	m_pVertexData = std::move(pVertexData);
+	m_indexSize = indexSize;
+}
+
+inline void StaticMesh::SubMesh::SetIndexData(uint32 numIndices, std::shared_ptr<const uint8> pIndexData, size_t lod)
+{
+	assert(numIndices % 3 == 0 && "Expecting a triangle list");
+	assert(reinterpret_cast<uintptr_t>(pIndexData.get()) % m_indexSize == 0 && "Index data must be aligned");
+
+	if (lod >= m_lods.size())
+		m_lods.resize(lod + 1);
+
+	m_lods[lod].m_numIndices = numIndices;
+	m_lods[lod].m_pData = std::move(pIndexData);
+}
 
 } // namespace gfx
 
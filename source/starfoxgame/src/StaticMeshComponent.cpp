@@ -1,71 +1,67 @@
 #include "StaticMeshComponent.h"
 #include "StaticMesh.h"
 #include "DebugDraw.h"
-#include "gs/Platform/GL/GLUtil.h"
+#include "AssetManager.h"
+#include "RenderQueue.h"
+#include "gs/Math/MathEx.h"
 
 extern bool g_drawNormals;
 extern bool g_drawSockets;
 extern float32 g_normalScale;
+extern int g_forcedLod;
 
-static void DrawStaticMesh(const gfx::StaticMesh& staticMesh, const Matrix43& mMeshToWorld)
+namespace
 {
-	GLUtil::PushAndMultMatrix(mMeshToWorld);
+	// A LOD is only switched to once the screen size is this fraction past its threshold, so that
+	// meshes near a threshold don't switch back and forth every frame
+	const float32 kLodHysteresis = 0.1f;
 
+	Vector3 g_lodCameraPosition = Vector3::Zero();
+	float32 g_lodViewHeightAtUnitDistance = 1.f; // 2 tan(fovY/2)
+}
+
+static void DrawStaticMesh(const gfx::StaticMesh& staticMesh, size_t lod, const Matrix43& mMeshToWorld)
+{
+	RenderQueue& renderQueue = RenderQueue::Instance();
+	const Vector3 center = PositionVector(staticMesh.m_boundingBox.GetCenter()) * mMeshToWorld;
+
+	std::vector<gfx::StaticMesh::Vertex> vertices; // Decoded for debugging only, submeshes are drawn packed
 	for (const auto& subMesh : staticMesh.m_subMeshes)
 	{
-		bool disabledTexturing = false;
-
-		//glBindTexture(GL_TEXTURE_2D, subMesh.m_material.m_textureId);
-		if (subMesh.m_materialIndex != gfx::StaticMesh::INVALID_MATERIAL_INDEX)
+#ifdef _DEBUG
+		if (subMesh.m_vertexLayout.Has(VertexAttribute::Normal))
 		{
-			const gfx::Material& material = staticMesh.m_materials[subMesh.m_materialIndex];
-
-			glMaterialfv(GL_FRONT, GL_AMBIENT, material.m_ambient.v);
-			glMaterialfv(GL_FRONT, GL_DIFFUSE, material.m_diffuse.v);
-			glMaterialfv(GL_FRONT, GL_SPECULAR, material.m_specular.v);
-			glMaterialfv(GL_FRONT, GL_EMISSION, material.m_emmissive.v);
-			glMaterialf(GL_FRONT, GL_SHININESS, material.m_shininess);
-
-			if (material.m_textureId == INVALID_TEXTURE_ID)
+			subMesh.GetVertices(vertices);
+			for (const auto& vertex : vertices)
 			{
-				disabledTexturing = true;
-				glDisable(GL_TEXTURE_2D);
+				assert(Vector3(vertex.normal).IsUnit() && "Normal must be unit length for lighting to work!");
 			}
-			else
-			{			
-				GLUtil::SelectTexture(material.m_textureId);
-			}
-		}
-
-		glBegin(GL_TRIANGLES);
-		for (const auto& vertex : subMesh.m_vertices)
-		{
-			glColor4fv(vertex.color.v);
-			assert(Vector3(vertex.normal).IsUnit() && "Normal must be unit length for lighting to work!");
-			glNormal3fv((vertex.normal /** mMeshToWorld*/).v);
-			glTexCoord2fv(vertex.textureCoords.v);
-			glVertex3fv((vertex.position /** mMeshToWorld*/).v);
 		}
-		glEnd();
+#endif
 
-		if (disabledTexturing)
-			glEnable(GL_TEXTURE_2D);
+		DrawPacket packet;
+		if (subMesh.m_materialIndex != gfx::StaticMesh::INVALID_MATERIAL_INDEX)
+			packet.pMaterial = &staticMesh.m_materials[subMesh.m_materialIndex];
+		packet.bHasTransform = true;
+		packet.mModelToWorld = mMeshToWorld;
+		// Kept alive until the frame is flushed by Render retaining the mesh
+		packet.pVertexLayout = &subMesh.m_vertexLayout;
+		packet.pVertexData = subMesh.GetVertexData();
+		packet.numVertices = static_cast<uint32>(subMesh.GetNumVertices());
+		packet.pIndices = subMesh.GetIndexData(lod);
+		packet.numIndices = static_cast<uint32>(subMesh.GetNumIndices(lod));
+		packet.b32BitIndices = subMesh.Has32BitIndices();
+		renderQueue.Submit(packet, center);
 
-		// Draw normals
+		// Draw normals (as debug lines, since this can run on any thread)
 		if (g_drawNormals)
 		{
-			glPushAttrib(GL_LIGHTING_BIT|GL_TEXTURE_BIT);
-			glDisable(GL_LIGHTING);
-			glDisable(GL_TEXTURE_2D);
-			glBegin(GL_LINES);
-			glColor4f(1.f, 1.f, 1.f, 1.f);
-			for (const auto& vertex : subMesh.m_vertices)
+			subMesh.GetVertices(vertices);
+			for (const auto& vertex : vertices)
 			{
-				glVertex3fv(vertex.position.v);
-				glVertex3f(vertex.position.x + vertex.normal.x * g_normalScale, vertex.position.y + vertex.normal.y * g_normalScale, vertex.position.z + vertex.normal.z * g_normalScale);
+				const Vector3 position(vertex.position);
+				DebugDrawLine(PositionVector(position) * mMeshToWorld, PositionVector(position + Vector3(vertex.normal) * g_normalScale) * mMeshToWorld);
 			}
-			glEnd();
-			glPopAttrib();
 		}
 	}
 
@@ -74,14 +70,81 @@ static void DrawStaticMesh(const gfx::StaticMesh& staticMesh, const Matrix43& mM
 		for (auto& socket : staticMesh.m_sockets)
 		{
 			static float32 scale = 10.f;
-			DebugDrawAxes(socket.m_matrix, scale);
+			DebugDrawAxes(socket.m_matrix * mMeshToWorld, scale);
 		}
 	}
+}
+
+void StaticMeshComponent::Init(const std::shared_future<std::shared_ptr<gfx::StaticMesh>>& pendingStaticMesh)
+{
+	Init(AssetManager::Instance().GetPlaceholderStaticMesh());
+	m_pendingStaticMesh = pendingStaticMesh;
+}
+
+void StaticMeshComponent::SetLodView(const Vector3& cameraPosition, float32 fovYDegrees)
+{
+	g_lodCameraPosition = cameraPosition;
+	g_lodViewHeightAtUnitDistance = 2.f * MathEx::Tan(MathEx::DegToRad(fovYDegrees) * 0.5f);
+}
 
-	glPopMatrix();
+const Vector3& StaticMeshComponent::GetLodCameraPosition()
+{
+	return g_lodCameraPosition;
+}
+
+size_t StaticMeshComponent::SelectLod(const std::vector<float32>& lodScreenSizes, float32 diameter, const Vector3& center, size_t currentLod)
+{
+	if (g_forcedLod >= 0)
+		return MathEx::Min<size_t>(g_forcedLod, MathEx::Max<size_t>(lodScreenSizes.size(), 1) - 1);
+
+	if (lodScreenSizes.size() < 2)
+		return 0;
+
+	// Screen size is the diameter of the bounding sphere over the height of the view at its distance
+	const float32 distance = (center - g_lodCameraPosition).Length();
+	const float32 screenSize = diameter / MathEx::Max(distance * g_lodViewHeightAtUnitDistance, 0.0001f);
+
+	size_t lod = MathEx::Min(currentLod, lodScreenSizes.size() - 1);
+	while (lod + 1 < lodScreenSizes.size() && screenSize < lodScreenSizes[lod + 1] * (1.f - kLodHysteresis))
+		++lod;
+	while (lod > 0 && screenSize > lodScreenSizes[lod] * (1.f + kLodHysteresis))
+		--lod;
+	return lod;
+}
+
+void StaticMeshComponent::UpdateLod()
+{
+	// The mesh's bounding sphere in world space
+	const gfx::StaticMesh& staticMesh = *m_pStaticMesh;
+	const Matrix43& mMeshToWorld = GetSceneNode()->GetLocalToWorld();
+	const Vector3 scale = mMeshToWorld.GetScale();
+	const float32 diameter = staticMesh.m_boundingBox.GetSize().Length() * MathEx::Max(scale.x, MathEx::Max(scale.y, scale.z));
+	const Vector3 center = PositionVector(staticMesh.m_boundingBox.GetCenter()) * mMeshToWorld;
+
+	m_lod = SelectLod(staticMesh.m_lodScreenSizes, diameter, center, m_lod);
 }
 
 void StaticMeshComponent::Render()
 {
-	DrawStaticMesh(*m_pStaticMesh, GetSceneNode()->GetLocalToWorld());
+	if (m_pendingStaticMesh.valid() && m_pendingStaticMesh.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		try
+		{
+			Init(m_pendingStaticMesh.get());
+		}
+		catch (const std::exception&)
+		{
+			m_pendingStaticMesh = std::shared_future<std::shared_ptr<gfx::StaticMesh>>(); // Failures are reported by the AssetManager
+		}
+	}
+
+	// Drawn by the StaticBatcher instead
+	if (m_bBatched)
+		return;
+
+	UpdateLod();
+	DrawStaticMesh(*m_pStaticMesh, m_lod, GetSceneNode()->GetLocalToWorld());
+
+	// The frame may be drawn after the mesh is replaced or this component destroyed
+	RenderQueue::Instance().Retain(m_pStaticMesh);
 }
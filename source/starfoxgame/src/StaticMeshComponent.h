@@ -2,26 +2,62 @@
 #define _STATIC_MESH_COMPONENT_H_
 
 #include "gs/Scene/SceneNode.h"
-
-namespace gfx { struct StaticMesh; }
+#include "StaticMesh.h"
+#include <future>
 
 class StaticMeshComponent : public SceneNodeComponent
 {
 public:
+	StaticMeshComponent() : m_lod(0), m_bBatched(false) {}
+
 	void Init(const std::shared_ptr<gfx::StaticMesh>& psStaticMesh)
 	{
 		m_pStaticMesh = std::move(psStaticMesh);
+		m_pendingStaticMesh = std::shared_future<std::shared_ptr<gfx::StaticMesh>>();
+		m_lod = 0;
 	}
 
+	// Renders the AssetManager's placeholder mesh until the requested mesh is loaded (or keeps it
+	// if the mesh fails to load)
+	void Init(const std::shared_future<std::shared_ptr<gfx::StaticMesh>>& pendingStaticMesh);
+
+	// Submits the mesh's submeshes to the RenderQueue
 	virtual void Render();	
+	virtual bool CanRenderInParallel() const { return true; }
 
 	gfx::StaticMesh& GetMesh()
 	{
 		return *m_pStaticMesh;
 	}
 
+	const std::shared_ptr<gfx::StaticMesh>& GetMeshPtr() const { return m_pStaticMesh; }
+
+	size_t GetLod() const { return m_lod; }
+
+	// True while the requested mesh is still loading (and the placeholder is drawn)
+	bool IsLoading() const { return m_pendingStaticMesh.valid(); }
+
+	// Batched components aren't drawn: their mesh is drawn as part of a StaticBatcher chunk
+	void SetBatched(bool bBatched) { m_bBatched = bBatched; }
+	bool IsBatched() const { return m_bBatched; }
+
+	// Sets the view that meshes select their LOD for: the camera's world position and vertical
+	// field of view. Set each frame before rendering.
+	static void SetLodView(const Vector3& cameraPosition, float32 fovYDegrees);
+	static const Vector3& GetLodCameraPosition();
+
+	// Returns the LOD to draw for a bounding sphere of the given diameter and world space center,
+	// given the screen sizes of each LOD (see gfx::StaticMesh::m_lodScreenSizes) and the LOD drawn
+	// last frame. Applies g_forcedLod.
+	static size_t SelectLod(const std::vector<float32>& lodScreenSizes, float32 diameter, const Vector3& center, size_t currentLod);
+
 private:
+	void UpdateLod();
+
 	std::shared_ptr<gfx::StaticMesh> m_pStaticMesh;
+	std::shared_future<std::shared_ptr<gfx::StaticMesh>> m_pendingStaticMesh;
+	size_t m_lod;
+	bool m_bBatched;
 };
 
 
@@ -0,0 +1,72 @@
+#include "TextureFile.h"
+#include "gs/Image/ImageData.h"
+#include "gs/Image/ImageFuncs.h"
+#include "gs/System/MappedFile.h"
+#include "gs/System/Profiler.h"
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	struct Header
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 width;
+		uint32 height;
+		uint32 channels;
+		uint32 dataOffset;
+		uint32 dataSize;
+		uint32 padding;
+	};
+
+	static_assert(sizeof(Header) == 32, "Header layout changed, bump kVersion");
+}
+
+void TextureFile::Save(const ImageData& imageData, const char* pFileName)
+{
+	ImageInfo imageInfo = imageData.GetImageInfo();
+	std::unique_ptr<UBYTE[]> pPixels(ImageFuncs::GrowToPowerOf2(imageData.GetData(), imageInfo)); // May modify imageInfo
+	const UBYTE* pData = pPixels? pPixels.get() : imageData.GetData();
+
+	Header header = {};
+	header.magic = kMagic;
+	header.version = kVersion;
+	header.width = imageInfo.GetWidth();
+	header.height = imageInfo.GetHeight();
+	header.channels = imageInfo.GetChannels();
+	header.dataOffset = sizeof(Header);
+	header.dataSize = imageInfo.GetDataSize();
+
+	FILE* pFile = fopen(pFileName, "wb");
+	if (!pFile)
+		throw std::runtime_error("TextureFile::Save: failed to open file for writing");
+
+	const bool bWritten = fwrite(&header, sizeof(header), 1, pFile) == 1 && fwrite(pData, 1, header.dataSize, pFile) == header.dataSize;
+	fclose(pFile);
+	if (!bWritten)
+		throw std::runtime_error("TextureFile::Save: failed to write file");
+}
+
+std::shared_ptr<const uint8> TextureFile::Load(const char* pFileName, ImageInfo& imageInfo)
+{
+	PROFILE_SCOPE("TextureFile::Load");
+
+	std::shared_ptr<MappedFile> pFile = MappedFile::Open(pFileName);
+	if (!pFile || pFile->GetSize() < sizeof(Header))
+		return nullptr;
+
+	const Header& header = *reinterpret_cast<const Header*>(pFile->GetData());
+	if (header.magic != kMagic || header.version != kVersion ||
+		(header.channels != 3 && header.channels != 4) ||
+		(uint64)header.width * header.height * header.channels != header.dataSize ||
+		header.dataOffset > pFile->GetSize() || header.dataSize > pFile->GetSize() - header.dataOffset)
+	{
+		return nullptr;
+	}
+
+	imageInfo.iChannels = header.channels;
+	imageInfo.imageSize.Set(header.width, header.height);
+	return MappedFile::GetSharedData<uint8>(pFile, header.dataOffset);
+}
@@ -0,0 +1,30 @@
+#ifndef _TEXTURE_FILE_H_
+#define _TEXTURE_FILE_H_
+
+// Cooked texture file (.sftex): a small header followed by RGB or RGBA pixel rows, already grown to
+// a power of two size so that they can be uploaded straight from the memory mapped file.
+
+#include "gs/Base/Base.h"
+#include <memory>
+
+class ImageData;
+struct ImageInfo;
+
+namespace TextureFile
+{
+	const char kExtension[] = "sftex";
+
+	const uint32 kMagic = 'S' | ('F' << 8) | ('T' << 16) | ('X' << 24);
+	const uint32 kVersion = 1; // Bump when the layout or any encoding changes
+
+	// Throws std::exception if the file can't be written
+	void Save(const ImageData& imageData, const char* pFileName);
+
+	// Returns the pixels of a cooked texture, pointing into the mapped file (which stays mapped
+	// while they're referenced), or nullptr if the file doesn't exist, is invalid, or was cooked
+	// with a different version.
+	std::shared_ptr<const uint8> Load(const char* pFileName, ImageInfo& imageInfo);
+
+} // namespace TextureFile
+
+#endif // _TEXTURE_FILE_H_
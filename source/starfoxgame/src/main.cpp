@@ -1,11 +1,14 @@
 #include "gs/System/System.h"
 #include "gs/Rendering/GraphicsEngine.h"
 #include "gs/System/FrameTimer.h"
+#include "gs/System/Profiler.h"
 #include "gs/Platform/GL/GLHeaders.h"
 #include "gs/Base/string_helpers.h"
 #include "gs/Input/KeyboardMgr.h"
+#include "gs/Math/Random.h"
 
-#include "FbxLoader.h"
+#include "AssetManager.h"
+#include "MeshUtil.h"
 #include "StaticMesh.h"
 #include "DebugDraw.h"
 #include "GameInput.h"
@@ -13,7 +16,13 @@
 #include "PlayerControlComponent.h"
 #include "AnchorComponent.h"
 #include "StaticMeshComponent.h"
+#include "StaticBatcher.h"
+#include "RenderQueue.h"
+#include "RenderCapture.h"
 #include "GroundComponent.h"
+#include "FramePipeline.h"
+#include <cstdio>
+#include <stdexcept>
 
 //const float32 SCREEN_WIDTH_HEIGHT_RATIO = 4.f / 3.f;
 const float32 SCREEN_WIDTH_HEIGHT_RATIO = 16.f / 9.f;
@@ -26,15 +35,29 @@ const float32 SCREEN_WIDTH = 1024.f;
 
 const float32 SCREEN_HEIGHT = SCREEN_WIDTH / SCREEN_WIDTH_HEIGHT_RATIO;
 
+// Textures not drawn recently are evicted from GPU memory to stay under this, and reloaded when needed
+const size_t TEXTURE_BUDGET = 64 * 1024 * 1024;
+
+// Frames updated ahead of the one being rendered (see FramePipeline.h), cycled up to the max with Ctrl+F10
+const uint32 PIPELINE_DEPTH = 1;
+const uint32 MAX_PIPELINE_DEPTH = 2;
+
 bool g_drawNormals = false;
 bool g_drawSockets = false;
 float32 g_normalScale = 10.0f;
 bool g_renderSceneGraph = false;
+int g_forcedLod = -1; // Mesh LOD to render instead of selecting by screen size, -1 for none
 
 int main()
 {
+	PROFILE_THREAD_NAME("Main");
+
 	extern void UnitTest_Math();
 	UnitTest_Math();
+	extern void UnitTest_MeshUtil();
+	UnitTest_MeshUtil();
+	extern void UnitTest_AssetManager();
+	UnitTest_AssetManager();
 
 	ScreenMode::Type screenMode = ScreenMode::Windowed;
 	VertSync::Type vertSync = VertSync::Disable;
@@ -55,8 +78,10 @@ int main()
 	GLUtil::SetShadeModel(ShadeModel::Smooth);
 	GLUtil::SetTexturing(true);
 
+	const float32 fovY = 45.f;
 	ProjectionInfo perspMain;
-	perspMain.SetPerspective(45.f, SCREEN_WIDTH / SCREEN_HEIGHT, 1.0f, 10000.f);
+	const float32 farPlane = 10000.f;
+	perspMain.SetPerspective(fovY, SCREEN_WIDTH / SCREEN_HEIGHT, 1.0f, farPlane);
 	GLUtil::SetProjection(perspMain);
 
 	GLfloat light_position[] = { 1.0, 1.0, 0.5, 0.0 }; // Directional
@@ -68,20 +93,22 @@ int main()
 	//frameTimer.SetMaxFPS(60.f);
 
 	KeyboardMgr& kbMgr = KeyboardMgr::Instance();
+	AssetManager& assetManager = AssetManager::Instance();
+	assetManager.SetTextureBudget(TEXTURE_BUDGET);
 
 	// Create SceneNodes
 
 	SceneNodeWeakPtr pwCamera;
 
-	{
-		FbxLoader fbxLoader;
-		fbxLoader.Init();
+	// Draws the nodes that never move
+	StaticBatcher staticBatcher;
 
+	{
+		// Meshes load in the background, and are drawn as placeholders until they're ready
 		auto psShip = SceneNode::Create("Ship");
-		auto psStaticMesh = fbxLoader.LoadStaticMesh("data/Arwing_001.fbx");
-		psShip->AddComponent<StaticMeshComponent>()->Init(psStaticMesh);
+		psShip->AddComponent<StaticMeshComponent>()->Init(assetManager.RequestStaticMeshAsync("Arwing_001"));
 		psShip->AddComponent<PlayerControlComponent>();
-		psShip->ModifyLocalToWorld().trans.y = 50.f; // The ship starts above the ground
+		psShip->ModifyLocalToWorld().Translation().y = 50.f; // The ship starts above the ground
 
 		auto psGround = SceneNode::Create("Ground");
 		psGround->AddComponent<GroundComponent>();		
@@ -102,37 +129,35 @@ int main()
 			const float32 firstZ = 5000.f;
 			const float32 deltaZ = 2000.f;
 
-			auto psStaticMesh = fbxLoader.LoadStaticMesh("data/Building1.fbx");
+			// All buildings share the same mesh
+			const AssetManager::StaticMeshFuture buildingMesh = assetManager.RequestStaticMeshAsync("Building1");
+
+			// Fixed seed so that the level layout is the same on every run and every machine
+			Random random(0x5eed);
 
 			for (uint32 i = 0; i < 100; ++i)
 			{
 				auto psBuilding = SceneNode::Create(str_format("Building_%d", i));
-				psBuilding->AddComponent<StaticMeshComponent>()->Init(psStaticMesh);
+				psBuilding->AddComponent<StaticMeshComponent>()->Init(buildingMesh);
+				staticBatcher.Add(psBuilding);
 
 				auto& mLocal = psBuilding->ModifyLocalToParent();
-				mLocal.trans.z = firstZ + deltaZ * i;
-				mLocal.trans.x = MathEx::Rand(-500.f, 500.f);
+				mLocal.Translation().z = firstZ + deltaZ * i;
+				mLocal.Translation().x = random.Float(-500.f, 500.f);
 			}
-			psStaticMesh = nullptr;
 		}
-
-		fbxLoader.Shutdown();
 	}
 
 	// Main game loop
 
+	float32 timeScale = 1.f;
 	bool bQuit = false;
-	while (!bQuit)
+
+	// Simulates a frame, and fills in packet with what to render. Runs on the update thread (or on
+	// this one, with a pipeline depth of 0), so it must not make GL calls.
+	auto UpdateFrame = [&] (FramePacket& packet)
 	{
-		// Handle pause
-		if ( !System::IsDebuggerAttached() && !gfxEngine.HasFocus() ) // Auto-pause when we window loses focus
-		{
-			frameTimer.SetPaused(true);
-		}
-		else if (kbMgr[vkeyPause].JustPressed())
-		{
-			frameTimer.TogglePaused();
-		}
+		PROFILE_SCOPE("Update");
 
 		// Frame time update
 		frameTimer.Update();
@@ -143,7 +168,7 @@ int main()
 		static int32 timeScaleIndex = 3;
 		if (kbMgr[vkeyTimeScaleInc].JustPressed())
 		{
-			timeScaleIndex = MathEx::Min(timeScaleIndex+1, (int)ARRAYSIZE(timeScales)-1);
+			timeScaleIndex = MathEx::Min(timeScaleIndex+1, (int)ARRAY_SIZE(timeScales)-1);
 		}
 		else if (kbMgr[vkeyTimeScaleDec].JustPressed())
 		{
@@ -153,59 +178,15 @@ int main()
 		{
 			timeScaleIndex = 3;
 		}
-		const float32 timeScale = timeScales[timeScaleIndex];
+		timeScale = timeScales[timeScaleIndex];
 
 		const float32 deltaTime = timeScale * frameTimer.GetFrameDeltaTime();
 
-		gfxEngine.SetTitle( 
-			str_format("Star Fox (Real Time: %.2f, Game Time: %.2f, GameDT: %.4f (scale: %.2f), FPS: %.2f)",
-			frameTimer.GetRealElapsedTime(),
-			frameTimer.GetElapsedTime(),
-			frameTimer.GetFrameDeltaTime(),
-			timeScale,
-			frameTimer.GetFPS()).c_str() );
-
-		kbMgr.Update(deltaTime);
-
-		if (kbMgr[VK_CONTROL].IsDown())
-		{
-			if (kbMgr[VK_F1].JustPressed())
-			{
-				static bool bLighting = glIsEnabled(GL_LIGHTING) == GL_TRUE;
-				bLighting = !bLighting;
-				bLighting? glEnable(GL_LIGHTING) : glDisable(GL_LIGHTING);
-			}
-			if (kbMgr[VK_F2].JustPressed())
-			{
-				//static bool bSmoothShading = GLUtil::GetShadeModel() == ShadeModel::Smooth;
-				//bSmoothShading = !bSmoothShading;
-				//GLUtil::SetShadeModel(bSmoothShading? ShadeModel::Smooth : ShadeModel::Flat);
-				g_drawSockets = !g_drawSockets;
-			}
-			if (kbMgr[VK_F3].JustPressed())
-			{
-				g_drawNormals = !g_drawNormals;
-			}
-			if (kbMgr[VK_F4].JustPressed())
-			{
-				GLUtil::SetTexturing( !GLUtil::GetTexturing() );
-			}
-			if (kbMgr[VK_F5].JustPressed())
-			{
-				static bool bWireframe = false;
-				bWireframe = !bWireframe;
-				GLUtil::SetWireFrame(bWireframe);
-			}
-			if (kbMgr[VK_F6].JustPressed())
-			{
-				g_renderSceneGraph = !g_renderSceneGraph;
-			}
-		}
-
 		// UPDATE
 		std::vector<SceneNodeWeakPtr> sceneNodeList = SceneNode::GetAllNodesSnapshot();
 		if ( !frameTimer.IsPaused() )
 		{
+			PROFILE_SCOPE("UpdateSceneNodes");
 			for (auto pwNode : sceneNodeList)
 			{
 				if (const auto& psNode = pwNode.lock())
@@ -213,36 +194,46 @@ int main()
 			}
 		}
 
-		SceneNode::ValidateSceneGraph();
+		{
+			PROFILE_SCOPE("ValidateSceneGraph");
+			SceneNode::ValidateSceneGraph();
+		}
+
+		staticBatcher.Update();
 
 
 		// RENDER
-		glClearColor(0.f, 0.f, 0.3f, 0.f);
-		glClearDepth(1.f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		PROFILE_SCOPE("Submit");
 
-		// Load inverse camera matrix so future transforms are in camera space
-		glMatrixMode(GL_MODELVIEW);
-		//glLoadIdentity();
+		// Inverse camera matrix, so that the frame is rendered in camera space
 		Matrix43 mInvCam = pwCamera.lock()->GetLocalToWorld();
 		//assert(mInvCam.IsOrthogonal());
-		mInvCam.axisZ = -mInvCam.axisZ; // Game -> OpenGL (flip Z axis)
+		mInvCam.AxisZ() = -mInvCam.AxisZ(); // Game -> OpenGL (flip Z axis)
 		mInvCam.InvertSRT();
-		GLfloat mCamGL[16];
-		GLUtil::Matrix43ToGLMatrix(mInvCam, mCamGL);
-		glLoadMatrixf(mCamGL);
+		GLUtil::Matrix43ToGLMatrix(mInvCam, packet.mWorldToView);
+
+		const Vector3 cameraPosition = pwCamera.lock()->GetLocalToWorld().Translation();
+		StaticMeshComponent::SetLodView(cameraPosition, fovY);
+		RenderQueue::Instance().Begin(packet.renderQueueFrame, cameraPosition, farPlane);
 
-		// Render scene nodes in camera space
+		// Render scene nodes. Components that are thread safe are rendered in parallel, the others
+		// one at a time on this thread.
+		RenderQueue::Instance().SubmitParallel(sceneNodeList.size(), [&] (size_t i)
+		{
+			if (const auto& psNode = sceneNodeList[i].lock())
+			{
+				psNode->Render(true);
+			}
+		});
 		for (auto pwNode : sceneNodeList)
 		{
 			if (const auto& psNode = pwNode.lock())
 			{
-				psNode->Render();
+				psNode->Render(false);
 			}
 		}
 
-		// Render debug objects
-		g_debugDrawManager.Render();
+		staticBatcher.Render();
 
 		// Render scene graph
 		if (g_renderSceneGraph)
@@ -254,33 +245,22 @@ int main()
 					if (is_weak_to_shared_ptr(pwCamera, psNode))
 						continue;
 
-					GLUtil::PushAndMultMatrix(psNode->GetLocalToWorld());
-
-					auto pQuadric = gluNewQuadric();
-					glColor3f(1.f, 0.f, 0.f);
-					gluSphere(pQuadric, 10.f, 8, 8);
-					gluDeleteQuadric(pQuadric);
+					const Vector3& position = psNode->GetLocalToWorld().Translation();
+					DebugDrawSphere(position, 10.f, Color4F::Red());
 
 					for (const auto& pwChildNode : psNode->GetChildren())
 					{
 						if (const auto& psChildNode = pwChildNode.lock())
 						{
-							const auto& mChildLocal = psChildNode->GetLocalToParent();
-
-							glBegin(GL_LINES);
-							glVertex3fv(Vector3::Zero().v);
-							glVertex3fv(mChildLocal.trans.v);
-							glEnd();
+							DebugDrawLine(position, psChildNode->GetLocalToWorld().Translation(), Color4F::Red());
 						}
 					}
-						
-					glPopMatrix();
 				}
 			}
 		}
 
-		// Flip buffers, process msgs, etc.
-		gfxEngine.Update(bQuit);
+		RenderQueue::Instance().End();
+		g_debugDrawManager.TakeFrame(packet.debugFrame);
 
 		// Handle frame stepping
 		static bool stepFrame = false;
@@ -298,9 +278,170 @@ int main()
 			stepFrame = false;
 			frameTimer.SetPaused(true);
 		}
+	};
+
+	// Renders a frame that was updated by UpdateFrame. Runs on this thread, which owns the window
+	// and the GL context.
+	auto RenderFrame = [&] (FramePacket& packet)
+	{
+		PROFILE_SCOPE("Render");
+
+		glClearColor(0.f, 0.f, 0.3f, 0.f);
+		glClearDepth(1.f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// Load inverse camera matrix so future transforms are in camera space
+		GLUtil::MatrixMode(MatrixMode::ModelView, false);
+		glLoadMatrixf(packet.mWorldToView);
+
+		RenderQueue::Instance().Flush(packet.renderQueueFrame);
+
+		// Render debug objects
+		DebugDrawManager::Render(packet.debugFrame);
+
+		// Flip buffers, process msgs, etc.
+		PROFILE_SCOPE("Present");
+		gfxEngine.Update(bQuit);
+	};
+
+	FramePipeline framePipeline(UpdateFrame, RenderFrame);
+	framePipeline.SetDepth(PIPELINE_DEPTH);
+
+	while (!bQuit)
+	{
+		// The update thread is idle until the next frame's update is started, so this is where
+		// input is read and where anything that updates read is changed
+		{
+			PROFILE_SCOPE("WaitForUpdate");
+			framePipeline.WaitForUpdate();
+		}
+
+		// Handle pause
+		if ( !System::IsDebuggerAttached() && !gfxEngine.HasFocus() ) // Auto-pause when we window loses focus
+		{
+			frameTimer.SetPaused(true);
+		}
+		else if (kbMgr[vkeyPause].JustPressed())
+		{
+			frameTimer.TogglePaused();
+		}
+
+		const RenderQueue::Stats& renderStats = RenderQueue::Instance().GetStats();
+		const GLUtil::StateCacheStats stateCacheStats = GLUtil::ResetStateCacheStats();
+		gfxEngine.SetTitle( 
+			str_format("Star Fox (Real Time: %.2f, Game Time: %.2f, GameDT: %.4f (scale: %.2f), FPS: %.2f, Pipeline: %u (latency: %.1f ms), Tris: %u, Draws: %u, State Changes: %u (unsorted: %u), GL State Calls: %u (elided: %u))",
+			frameTimer.GetRealElapsedTime(),
+			frameTimer.GetElapsedTime(),
+			frameTimer.GetFrameDeltaTime(),
+			timeScale,
+			frameTimer.GetFPS(),
+			framePipeline.GetDepth(),
+			framePipeline.GetLatency() * 1000.f,
+			renderStats.numTriangles,
+			renderStats.numDrawCalls,
+			renderStats.numStateChanges,
+			renderStats.numUnsortedStateChanges,
+			stateCacheStats.numCallsMade,
+			stateCacheStats.numCallsElided).c_str() );
+
+		{
+			PROFILE_SCOPE("Input");
+			kbMgr.Update(timeScale * frameTimer.GetFrameDeltaTime());
+		}
+		assetManager.Update();
+
+		if (kbMgr[VK_CONTROL].IsDown())
+		{
+			if (kbMgr[VK_F1].JustPressed())
+			{
+				GLUtil::SetLighting( !GLUtil::GetLighting() );
+			}
+			if (kbMgr[VK_F2].JustPressed())
+			{
+				//static bool bSmoothShading = GLUtil::GetShadeModel() == ShadeModel::Smooth;
+				//bSmoothShading = !bSmoothShading;
+				//GLUtil::SetShadeModel(bSmoothShading? ShadeModel::Smooth : ShadeModel::Flat);
+				g_drawSockets = !g_drawSockets;
+			}
+			if (kbMgr[VK_F3].JustPressed())
+			{
+				g_drawNormals = !g_drawNormals;
+			}
+			if (kbMgr[VK_F4].JustPressed())
+			{
+				GLUtil::SetTexturing( !GLUtil::GetTexturing() );
+			}
+			if (kbMgr[VK_F5].JustPressed())
+			{
+				static bool bWireframe = false;
+				bWireframe = !bWireframe;
+				GLUtil::SetWireFrame(bWireframe);
+			}
+			if (kbMgr[VK_F6].JustPressed())
+			{
+				g_renderSceneGraph = !g_renderSceneGraph;
+			}
+			if (kbMgr[VK_F7].JustPressed())
+			{
+				// Cycle through forcing each LOD, then back to selecting by screen size
+				g_forcedLod = g_forcedLod + 1 < (int)MeshUtil::kMaxLods? g_forcedLod + 1 : -1;
+			}
+			if (kbMgr[VK_F8].JustPressed())
+			{
+				assetManager.PrintReport();
+			}
+			if (kbMgr[VK_F9].JustPressed())
+			{
+				// Capture the frame's render commands, for replaying with starfox_replay
+				static uint32 captureIndex = 0;
+				RenderQueue::Instance().RequestCapture(str_format("capture_%03u.%s", captureIndex++, RenderCapture::kExtension));
+			}
+			if (kbMgr[VK_F10].JustPressed())
+			{
+				framePipeline.SetDepth((framePipeline.GetDepth() + 1) % (MAX_PIPELINE_DEPTH + 1));
+			}
+			if (kbMgr[VK_F11].JustPressed())
+			{
+				Profiler::Instance().PrintLastFrame();
+			}
+			if (kbMgr[VK_F12].JustPressed())
+			{
+				// Record a trace, for viewing in about:tracing or ui.perfetto.dev
+				static uint32 traceIndex = 0;
+				Profiler& profiler = Profiler::Instance();
+				if (profiler.IsTracing())
+				{
+					const std::string fileName = str_format("profile_%03u.json", traceIndex++);
+					try
+					{
+						profiler.StopTrace(fileName.c_str());
+						printf("Saved trace to %s\n", fileName.c_str());
+					}
+					catch (const std::exception& e)
+					{
+						printf("Failed to save trace to %s: %s\n", fileName.c_str(), e.what());
+					}
+				}
+				else
+				{
+					profiler.StartTrace();
+				}
+			}
+		}
+
+		framePipeline.StartUpdate();
+		framePipeline.Render();
+
+		Profiler::Instance().EndFrame();
 	}
 
+	// Unload the level: render the frames that were updated, so that they release the meshes they
+	// reference, destroy the nodes, then free the assets they used while the GL context still exists
+	framePipeline.WaitForUpdate();
+	framePipeline.SetDepth(0);
 	SceneNode::DestroyAllNodes();
+	staticBatcher.Update();
+	assetManager.ReleaseUnused();
 
 	gfxEngine.Shutdown();
 }
@@ -0,0 +1,46 @@
+#include "gs/Base/UnitTest.h"
+#include "gs/System/IO.h"
+#include "AssetManager.h"
+#include "MeshFile.h"
+#include "StaticMesh.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern void UnitTest_AssetManager()
+{
+	// A cooked mesh of one triangle, in the data directory so that the manager finds it
+	const char kName[] = "UnitTest_AssetManager";
+	const std::string fileName = IO::Path::Combine("data", std::string(kName) + "." + MeshFile::kExtension);
+	{
+		std::vector<gfx::StaticMesh::Vertex> vertices(3);
+		vertices[1].position = Vector4(1.f, 0.f, 0.f, 1.f);
+		vertices[2].position = Vector4(0.f, 1.f, 0.f, 1.f);
+		const std::vector<uint32> indices = { 0, 1, 2 };
+
+		gfx::StaticMesh staticMesh;
+		staticMesh.m_subMeshes.resize(1);
+		staticMesh.m_subMeshes[0].SetVertices(vertices, VertexLayoutFlags::QuantizePosition);
+		staticMesh.m_subMeshes[0].SetIndices(indices);
+		staticMesh.m_boundingBox = AABB(Vector3::Zero(), Vector3(1.f, 1.f, 0.f));
+		MeshFile::Save(staticMesh, fileName.c_str());
+	}
+
+	AssetManager& assetManager = AssetManager::Instance();
+	const size_t memoryUsage = assetManager.GetMemoryUsage();
+	{
+		const AssetManager::StaticMeshPtr pStaticMesh = assetManager.LoadStaticMesh(kName);
+		CHECK(assetManager.GetMemoryUsage() > memoryUsage);
+
+		// Still referenced
+		assetManager.ReleaseUnused();
+		CHECK(assetManager.GetMemoryUsage() > memoryUsage);
+		CHECK(assetManager.RequestStaticMeshAsync(kName).get() == pStaticMesh);
+	}
+
+	// Only referenced by the manager once dropped
+	assetManager.ReleaseUnused();
+	CHECK(assetManager.GetMemoryUsage() == memoryUsage);
+
+	remove(fileName.c_str());
+}
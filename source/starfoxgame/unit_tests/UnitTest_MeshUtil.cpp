@@ -0,0 +1,206 @@
+#include "gs/Base/UnitTest.h"
+#include "gs/Math/Random.h"
+#include "MeshUtil.h"
+#include "StaticMesh.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+typedef gfx::StaticMesh::Vertex Vertex;
+
+// A size x size grid of quads on the XZ plane, with each triangle corner as its own vertex, as FBX
+// stores them
+static std::vector<Vertex> MakeGridTriangleVertices(uint32 size)
+{
+	std::vector<Vertex> vertices;
+	for (uint32 z = 0; z < size; ++z)
+	{
+		for (uint32 x = 0; x < size; ++x)
+		{
+			const uint32 corners[6][2] = { {x, z}, {x, z + 1}, {x + 1, z}, {x + 1, z}, {x, z + 1}, {x + 1, z + 1} };
+			for (const auto& corner : corners)
+			{
+				Vertex vertex;
+				vertex.position = Vector4((float32)corner[0], 0.f, (float32)corner[1], 1.f);
+				vertex.normal = Vector4(0.f, 1.f, 0.f, 0.f);
+				vertex.textureCoords = gfx::Vector2((float32)corner[0] / size, (float32)corner[1] / size);
+				vertices.push_back(vertex);
+			}
+		}
+	}
+	return vertices;
+}
+
+static bool SameVertex(const Vertex& lhs, const Vertex& rhs)
+{
+	return memcmp(&lhs, &rhs, sizeof(Vertex)) == 0;
+}
+
+// Returns the triangles of indices with each one rotated to start at its smallest index (which
+// keeps its winding), sorted, so that lists of the same triangles in any order compare equal
+static std::vector<uint32> GetTriangleSet(const std::vector<uint32>& indices)
+{
+	std::vector<std::vector<uint32>> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		std::vector<uint32> triangle(indices.begin() + i, indices.begin() + i + 3);
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+
+	std::vector<uint32> triangleSet;
+	for (const auto& triangle : triangles)
+		triangleSet.insert(triangleSet.end(), triangle.begin(), triangle.end());
+	return triangleSet;
+}
+
+static bool HasDegenerateTriangles(const std::vector<uint32>& indices)
+{
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		if (indices[i] == indices[i + 1] || indices[i] == indices[i + 2] || indices[i + 1] == indices[i + 2])
+			return true;
+	}
+	return false;
+}
+
+extern void UnitTest_MeshUtil()
+{
+	using namespace MeshUtil;
+
+	const uint32 gridSize = 16;
+	const std::vector<Vertex> triangleVertices = MakeGridTriangleVertices(gridSize);
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32> indices;
+
+	// WeldVertices
+	{
+		WeldVertices(triangleVertices, vertices, indices);
+
+		// One vertex per grid point, each unique
+		CHECK(vertices.size() == (gridSize + 1) * (gridSize + 1));
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			for (size_t j = i + 1; j < vertices.size(); ++j)
+				CHECK(!SameVertex(vertices[i], vertices[j]));
+		}
+
+		// Same triangles, in the same order
+		CHECK(indices.size() == triangleVertices.size());
+		for (size_t i = 0; i < indices.size(); ++i)
+			CHECK(indices[i] < vertices.size() && SameVertex(vertices[indices[i]], triangleVertices[i]));
+	}
+
+	// OptimizeVertexCache, OptimizeOverdraw, OptimizeVertexFetch
+	{
+		// Start from the triangles in a random order, which is close to the worst case for the cache
+		std::vector<uint32> shuffled = indices;
+		Random random(0x5eed);
+		for (size_t triangle = shuffled.size() / 3 - 1; triangle > 0; --triangle)
+		{
+			const size_t other = random.NextUInt32(static_cast<uint32>(triangle + 1));
+			std::swap_ranges(shuffled.begin() + triangle * 3, shuffled.begin() + triangle * 3 + 3, shuffled.begin() + other * 3);
+		}
+		const std::vector<uint32> triangleSet = GetTriangleSet(shuffled);
+		CHECK(GetTriangleSet(indices) == triangleSet);
+
+		std::vector<uint32> optimized = shuffled;
+		std::vector<uint32> clusters;
+		OptimizeVertexCache(optimized, vertices.size(), &clusters);
+		CHECK(GetTriangleSet(optimized) == triangleSet);
+		CHECK(!clusters.empty() && clusters[0] == 0);
+
+		const VertexCacheStats shuffledStats = AnalyzeVertexCache(shuffled, vertices.size());
+		const VertexCacheStats optimizedStats = AnalyzeVertexCache(optimized, vertices.size());
+		CHECK(optimizedStats.numTriangles == shuffledStats.numTriangles);
+		CHECK(optimizedStats.GetACMR() <= shuffledStats.GetACMR());
+
+		// Overdraw optimization keeps the ACMR within its threshold of the cache optimized order
+		const float32 threshold = 1.05f;
+		OptimizeOverdraw(optimized, vertices, clusters, threshold);
+		CHECK(GetTriangleSet(optimized) == triangleSet);
+		CHECK(AnalyzeVertexCache(optimized, vertices.size()).GetACMR() <= optimizedStats.GetACMR() * threshold + 1e-5f);
+
+		// Vertex fetch optimization renumbers vertices in order of first use, and keeps the triangles
+		std::vector<Vertex> fetchVertices = vertices;
+		std::vector<uint32> fetchIndices = optimized;
+		OptimizeVertexFetch(fetchVertices, fetchIndices);
+		CHECK(fetchVertices.size() == vertices.size() && fetchIndices.size() == optimized.size());
+		uint32 nextVertex = 0;
+		for (size_t i = 0; i < fetchIndices.size(); ++i)
+		{
+			CHECK(fetchIndices[i] <= nextVertex);
+			if (fetchIndices[i] == nextVertex)
+				++nextVertex;
+			CHECK(SameVertex(fetchVertices[fetchIndices[i]], vertices[optimized[i]]));
+		}
+	}
+
+	// SimplifyMesh, GenerateLods
+	{
+		const size_t targetIndexCount = indices.size() / 3 / 4 * 3;
+		std::vector<uint32> simplified;
+		const float32 error = SimplifyMesh(indices, vertices, targetIndexCount, 1e10f, simplified);
+		CHECK(!simplified.empty() && simplified.size() <= targetIndexCount && simplified.size() % 3 == 0);
+		CHECK(!HasDegenerateTriangles(simplified));
+		for (uint32 index : simplified)
+			CHECK(index < vertices.size());
+
+		// The grid is flat, so it can be simplified without moving its surface
+		CHECK(error >= 0.f && error < 1e-3f);
+
+		std::vector<std::vector<uint32>> lodIndices;
+		std::vector<float32> lodErrors;
+		GenerateLods(vertices, indices, lodIndices, lodErrors);
+		CHECK(lodIndices.size() == kMaxLods - 1 && lodErrors.size() == kMaxLods - 1);
+		size_t previousIndexCount = indices.size();
+		for (const std::vector<uint32>& lod : lodIndices)
+		{
+			CHECK(!lod.empty() && lod.size() <= previousIndexCount / 3 / 2 * 3);
+			CHECK(!HasDegenerateTriangles(lod));
+			previousIndexCount = lod.size();
+		}
+	}
+
+	// MergeSubMeshesByMaterial
+	{
+		// Two halves of the grid with material 0, and a copy moved up with material 1
+		const size_t half = indices.size() / 6 * 3;
+		const std::vector<uint32> halves[2] = { std::vector<uint32>(indices.begin(), indices.begin() + half), std::vector<uint32>(indices.begin() + half, indices.end()) };
+		std::vector<Vertex> movedVertices = vertices;
+		for (Vertex& vertex : movedVertices)
+			vertex.position.y += 10.f;
+
+		gfx::StaticMesh staticMesh;
+		staticMesh.m_materials.resize(2);
+		staticMesh.m_subMeshes.resize(3);
+		for (size_t i = 0; i < 3; ++i)
+		{
+			gfx::StaticMesh::SubMesh& subMesh = staticMesh.m_subMeshes[i];
+			subMesh.SetVertices(i < 2? vertices : movedVertices, VertexLayoutFlags::All);
+			subMesh.SetIndices(i < 2? halves[i] : indices);
+			subMesh.m_materialIndex = i < 2? 0 : 1;
+		}
+
+		MergeSubMeshesByMaterial(staticMesh);
+		CHECK(staticMesh.m_subMeshes.size() == 2);
+		CHECK(staticMesh.m_subMeshes[0].m_materialIndex == 0 && staticMesh.m_subMeshes[1].m_materialIndex == 1);
+
+		// The merged submesh draws the triangles of both halves, at the same positions
+		const gfx::StaticMesh::SubMesh& merged = staticMesh.m_subMeshes[0];
+		CHECK(merged.GetNumIndices() == indices.size());
+		std::vector<Vertex> mergedVertices;
+		merged.GetVertices(mergedVertices);
+		const float32 positionError = gridSize / 65535.f;
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			const Vector3 position(mergedVertices[merged.GetIndex(i)].position);
+			CHECK(position.AlmostEquals(Vector3(vertices[indices[i]].position), positionError));
+		}
+
+		const gfx::StaticMesh::SubMesh& moved = staticMesh.m_subMeshes[1];
+		CHECK(moved.GetNumIndices() == indices.size() && moved.GetNumVertices() == vertices.size());
+	}
+}